@@ -8,17 +8,23 @@
 #include <sof/audio/buffer.h>
 #include <sof/audio/component.h>
 #include <sof/audio/component_ext.h>
+#include <sof/audio/pcm_converter.h>
 #include <sof/audio/pipeline.h>
 #include <sof/common.h>
 #include <sof/ipc/topology.h>
 #include <sof/ipc/common.h>
+#include <sof/platform.h>
 #include <ipc/dai.h>
 #include <ipc4/gateway.h>
 #include <sof/schedule/ll_schedule.h>
 #include <sof/schedule/schedule.h>
 #include <rtos/task.h>
+#include <rtos/timer.h>
+#include <sof/lib/dai.h>
 #include <sof/lib/dma.h>
+#include <sof/math/numbers.h>
 #include <ipc4/error_status.h>
+#include <ipc4/fw_reg.h>
 #include <ipc4/module.h>
 #include <ipc4/pipeline.h>
 #include <sof/ut.h>
@@ -52,6 +58,8 @@ struct chain_dma_data {
 	enum sof_ipc_stream_direction stream_direction;
 	/* container size in bytes */
 	uint8_t cs;
+	/* link container size in bytes, differs from cs when converting */
+	uint8_t link_cs;
 #if CONFIG_IPC4_XRUN_NOTIFICATIONS_ENABLE
 	bool xrun_notification_sent;
 	struct ipc_msg *msg_xrun;
@@ -70,6 +78,20 @@ struct chain_dma_data {
 	struct dma_block_config dma_block_cfg_link;
 
 	struct comp_buffer *dma_buffer;
+
+	/* separate link DMA buffer and conversion, NULL without conversion */
+	struct comp_buffer *link_buffer;
+	pcm_converter_func convert;
+	uint32_t copy_align;
+
+	/* bytes moved by host and link DMA since start, for delay reporting,
+	 * under lock as 64 bit accesses are not atomic on 32 bit cores
+	 */
+	struct k_spinlock lock;
+	uint64_t host_bytes;
+	uint64_t link_bytes;
+	/* fw registers slot the link position is published to */
+	struct llp_slot_info slot_info;
 };
 
 static int chain_host_start(struct comp_dev *dev)
@@ -168,9 +190,132 @@ static void handle_xrun(struct chain_dma_data *cd)
 }
 #endif
 
+/* Positions in bytes of host containers. The delay of the chain buffers,
+ * the host position minus the link position for playback or vice versa for
+ * capture, is reported as the component position.
+ */
+static void chain_get_position(struct chain_dma_data *cd, struct sof_ipc_stream_posn *posn)
+{
+	k_spinlock_key_t key;
+
+	key = k_spin_lock(&cd->lock);
+	posn->host_posn = cd->host_bytes;
+	posn->dai_posn = cd->link_bytes / cd->link_cs * cd->cs;
+	k_spin_unlock(&cd->lock, key);
+
+	posn->comp_posn = cd->stream_direction == SOF_IPC_STREAM_PLAYBACK ?
+		posn->host_posn - posn->dai_posn : posn->dai_posn - posn->host_posn;
+	posn->wallclock = sof_cycle_get_64();
+}
+
+/* Account the bytes moved by the DMAs and publish the link position in host
+ * container bytes to the llp reading slot of the link node. The host gets
+ * the chain delay by subtracting it from the host DMA position.
+ */
+static void chain_position_update(struct chain_dma_data *cd, size_t host_bytes,
+				  size_t link_bytes)
+{
+	struct ipc4_llp_reading_slot slot;
+	struct sof_ipc_stream_posn posn;
+	k_spinlock_key_t key;
+
+	key = k_spin_lock(&cd->lock);
+	cd->host_bytes += host_bytes;
+	cd->link_bytes += link_bytes;
+	k_spin_unlock(&cd->lock, key);
+
+	if (!cd->slot_info.node_id)
+		return;
+
+	chain_get_position(cd, &posn);
+
+	slot.node_id = cd->slot_info.node_id;
+	slot.reading.llp_l = (uint32_t)posn.dai_posn;
+	slot.reading.llp_u = (uint32_t)(posn.dai_posn >> 32);
+	slot.reading.wclk_l = (uint32_t)posn.wallclock;
+	slot.reading.wclk_u = (uint32_t)(posn.wallclock >> 32);
+
+	mailbox_sw_regs_write(cd->slot_info.reg_offset, &slot, sizeof(slot));
+}
+
+/* Convert from the buffer that the source DMA fills to the buffer that the
+ * sink DMA drains and release the moved bytes to both DMAs.
+ */
+static enum task_state chain_task_run_convert(struct chain_dma_data *cd, size_t src_avail,
+					      size_t dst_free)
+{
+	const bool playback = cd->stream_direction == SOF_IPC_STREAM_PLAYBACK;
+	struct comp_buffer *src_buf = playback ? cd->dma_buffer : cd->link_buffer;
+	struct comp_buffer *dst_buf = playback ? cd->link_buffer : cd->dma_buffer;
+	struct dma_chan_data *src_chan = playback ? cd->chan_host : cd->chan_link;
+	struct dma_chan_data *dst_chan = playback ? cd->chan_link : cd->chan_host;
+	const uint32_t src_cs = playback ? cd->cs : cd->link_cs;
+	const uint32_t dst_cs = playback ? cd->link_cs : cd->cs;
+	struct comp_buffer __sparse_cache *src_c;
+	struct comp_buffer __sparse_cache *dst_c;
+	uint32_t src_bytes;
+	uint32_t dst_bytes;
+	uint32_t samples;
+	int ret;
+
+	src_c = buffer_acquire(src_buf);
+
+	/* As without conversion, playback waits for half of the host buffer
+	 * before the link gets data.
+	 */
+	if (playback && !cd->first_data_received) {
+		if (src_avail <= audio_stream_get_size(&src_c->stream) / 2) {
+			buffer_release(src_c);
+			return SOF_TASK_STATE_RESCHEDULE;
+		}
+		cd->first_data_received = true;
+	}
+
+	/* both DMA increments must be multiples of the copy alignment */
+	samples = MIN(src_avail / src_cs, dst_free / dst_cs);
+	samples = ROUND_DOWN(samples, MAX(cd->copy_align / MIN(src_cs, dst_cs), 1));
+	if (!samples) {
+		buffer_release(src_c);
+		return SOF_TASK_STATE_RESCHEDULE;
+	}
+
+	src_bytes = samples * src_cs;
+	dst_bytes = samples * dst_cs;
+	dst_c = buffer_acquire(dst_buf);
+
+	audio_stream_invalidate(&src_c->stream, src_bytes);
+	cd->convert(&src_c->stream, 0, &dst_c->stream, 0, samples);
+	audio_stream_writeback(&dst_c->stream, dst_bytes);
+	audio_stream_consume(&src_c->stream, src_bytes);
+	audio_stream_produce(&dst_c->stream, dst_bytes);
+
+	buffer_release(dst_c);
+	buffer_release(src_c);
+
+	ret = dma_reload(src_chan->dma->z_dev, src_chan->index, 0, 0, src_bytes);
+	if (ret < 0) {
+		tr_err(&chain_dma_tr, "chain_task_run_convert(): dma_reload() source error, ret = %u",
+		       ret);
+		return SOF_TASK_STATE_COMPLETED;
+	}
+
+	ret = dma_reload(dst_chan->dma->z_dev, dst_chan->index, 0, 0, dst_bytes);
+	if (ret < 0) {
+		tr_err(&chain_dma_tr, "chain_task_run_convert(): dma_reload() sink error, ret = %u",
+		       ret);
+		return SOF_TASK_STATE_COMPLETED;
+	}
+
+	chain_position_update(cd, playback ? src_bytes : dst_bytes,
+			      playback ? dst_bytes : src_bytes);
+
+	return SOF_TASK_STATE_RESCHEDULE;
+}
+
 static enum task_state chain_task_run(void *data)
 {
 	size_t link_avail_bytes, link_free_bytes, host_avail_bytes, host_free_bytes;
+	size_t host_bytes = 0, link_bytes = 0;
 	struct chain_dma_data *cd = data;
 	uint32_t link_read_pos, host_read_pos;
 	struct dma_status stat;
@@ -212,6 +357,13 @@ static enum task_state chain_task_run(void *data)
 	host_read_pos = stat.read_position;
 
 	link_type = cd->link_connector_node_id.f.dma_type;
+	if (cd->convert) {
+		if (link_type == ipc4_hda_link_input_class)
+			return chain_task_run_convert(cd, link_avail_bytes, host_free_bytes);
+
+		return chain_task_run_convert(cd, host_avail_bytes, link_free_bytes);
+	}
+
 	if (link_type == ipc4_hda_link_input_class) {
 		/* CAPTURE:
 		 * When chained Link Input with Host Input immediately start transmitting data
@@ -232,6 +384,9 @@ static enum task_state chain_task_run(void *data)
 			       "chain_task_run(): dma_reload() link error, ret = %u", ret);
 			return SOF_TASK_STATE_COMPLETED;
 		}
+
+		host_bytes = increment;
+		link_bytes = increment;
 	} else {
 		/* PLAYBACK:
 		 * When chained Host Output with Link Output then wait for half buffer full. In this
@@ -254,6 +409,7 @@ static enum task_state chain_task_run(void *data)
 					ret);
 				return SOF_TASK_STATE_COMPLETED;
 			}
+			link_bytes = half_buff_size;
 			cd->first_data_received = true;
 
 		} else if (cd->first_data_received) {
@@ -269,6 +425,7 @@ static enum task_state chain_task_run(void *data)
 				       "chain_task_run(): dma_reload() host error, ret = %u", ret);
 				return SOF_TASK_STATE_COMPLETED;
 			}
+			host_bytes = transferred;
 
 			if (host_avail_bytes >= half_buff_size &&
 			    link_free_bytes >= half_buff_size) {
@@ -279,17 +436,30 @@ static enum task_state chain_task_run(void *data)
 					       "link error, ret = %u", ret);
 					return SOF_TASK_STATE_COMPLETED;
 				}
+				link_bytes = half_buff_size;
 			}
 		}
 	}
+
+	chain_position_update(cd, host_bytes, link_bytes);
+
 	return SOF_TASK_STATE_RESCHEDULE;
 }
 
+static void chain_buffer_reset(struct comp_buffer *buffer)
+{
+	struct comp_buffer __sparse_cache *buffer_c = buffer_acquire(buffer);
+
+	buffer_zero(buffer_c);
+	audio_stream_reset(&buffer_c->stream);
+	buffer_release(buffer_c);
+}
+
 static int chain_task_start(struct comp_dev *dev)
 {
 	struct comp_driver_list *drivers = comp_drivers_get();
 	struct chain_dma_data *cd = comp_get_drvdata(dev);
-	k_spinlock_key_t key;
+	k_spinlock_key_t key, posn_key;
 	int ret;
 
 	comp_info(dev, "chain_task_start(), host_dma_id = 0x%08x", cd->host_connector_node_id.dw);
@@ -311,6 +481,18 @@ static int chain_task_start(struct comp_dev *dev)
 		goto error;
 	}
 
+	posn_key = k_spin_lock(&cd->lock);
+	cd->host_bytes = 0;
+	cd->link_bytes = 0;
+	k_spin_unlock(&cd->lock, posn_key);
+	chain_position_update(cd, 0, 0);
+
+	if (cd->link_buffer) {
+		/* DMAs restart from the buffer start */
+		chain_buffer_reset(cd->dma_buffer);
+		chain_buffer_reset(cd->link_buffer);
+	}
+
 	if (cd->stream_direction == SOF_IPC_STREAM_PLAYBACK) {
 		ret = chain_host_start(dev);
 		if (ret)
@@ -389,10 +571,49 @@ static int chain_task_pause(struct comp_dev *dev)
 	return ret;
 }
 
+/* Reserve the llp reading slot of the link node for position reporting.
+ * The chain works without it, only the position is not published then.
+ */
+static void chain_llp_slot_init(struct comp_dev *dev)
+{
+	struct chain_dma_data *cd = comp_get_drvdata(dev);
+	int ret;
+
+	ret = dai_get_unused_llp_slot(dev, &cd->link_connector_node_id);
+	if (ret < 0) {
+		comp_warn(dev, "chain_llp_slot_init(): no llp slot, position not reported");
+		return;
+	}
+
+	cd->slot_info.node_id = cd->link_connector_node_id.dw & IPC4_NODE_ID_MASK;
+	cd->slot_info.reg_offset = ret;
+}
+
+static void chain_llp_slot_release(struct chain_dma_data *cd)
+{
+	struct ipc4_llp_reading_slot slot;
+	k_spinlock_key_t key;
+
+	if (!cd->slot_info.node_id)
+		return;
+
+	memset_s(&slot, sizeof(slot), 0, sizeof(slot));
+
+	/* clear node id for released llp slot */
+	key = k_spin_lock(&sof_get()->fw_reg_lock);
+	mailbox_sw_regs_write(cd->slot_info.reg_offset, &slot, sizeof(slot));
+	k_spin_unlock(&sof_get()->fw_reg_lock, key);
+
+	cd->slot_info.reg_offset = 0;
+	cd->slot_info.node_id = 0;
+}
+
 static void chain_release(struct comp_dev *dev)
 {
 	struct chain_dma_data *cd = comp_get_drvdata(dev);
 
+	chain_llp_slot_release(cd);
+
 	dma_release_channel(cd->chan_host->dma->z_dev, cd->chan_host->index);
 	dma_put(cd->dma_host);
 	dma_release_channel(cd->chan_link->dma->z_dev, cd->chan_link->index);
@@ -402,6 +623,11 @@ static void chain_release(struct comp_dev *dev)
 		buffer_free(cd->dma_buffer);
 		cd->dma_buffer = NULL;
 	}
+
+	if (cd->link_buffer) {
+		buffer_free(cd->link_buffer);
+		cd->link_buffer = NULL;
+	}
 }
 
 /* Retrieves host connector node id from dma id */
@@ -423,7 +649,8 @@ static int get_connector_node_id(uint32_t dma_id, bool host_type,
 	return 0;
 }
 
-static int chain_init(struct comp_dev *dev, void *addr, size_t length)
+static int chain_init(struct comp_dev *dev, void *addr, size_t length,
+		      void *link_addr, size_t link_length)
 {
 	struct chain_dma_data *cd = comp_get_drvdata(dev);
 	struct dma_block_config *dma_block_cfg_host = &cd->dma_block_cfg_host;
@@ -444,23 +671,23 @@ static int chain_init(struct comp_dev *dev, void *addr, size_t length)
 	memset(dma_cfg_link, 0, sizeof(*dma_cfg_link));
 	memset(dma_block_cfg_link, 0, sizeof(*dma_block_cfg_link));
 	dma_cfg_link->block_count = 1;
-	dma_cfg_link->source_data_size = cd->cs;
-	dma_cfg_link->dest_data_size = cd->cs;
+	dma_cfg_link->source_data_size = cd->link_cs;
+	dma_cfg_link->dest_data_size = cd->link_cs;
 	dma_cfg_link->head_block  = dma_block_cfg_link;
-	dma_block_cfg_link->block_size = length;
+	dma_block_cfg_link->block_size = link_length;
 
 	switch (cd->stream_direction) {
 	case SOF_IPC_STREAM_PLAYBACK:
 		dma_cfg_host->channel_direction = HOST_TO_MEMORY;
 		dma_block_cfg_host->dest_address = (uint32_t)addr;
 		dma_cfg_link->channel_direction = MEMORY_TO_PERIPHERAL;
-		dma_block_cfg_link->source_address = (uint32_t)addr;
+		dma_block_cfg_link->source_address = (uint32_t)link_addr;
 		break;
 	case SOF_IPC_STREAM_CAPTURE:
 		dma_cfg_host->channel_direction = MEMORY_TO_HOST;
 		dma_block_cfg_host->source_address = (uint32_t)addr;
 		dma_cfg_link->channel_direction = PERIPHERAL_TO_MEMORY;
-		dma_block_cfg_link->dest_address = (uint32_t)addr;
+		dma_block_cfg_link->dest_address = (uint32_t)link_addr;
 		break;
 	}
 
@@ -506,12 +733,78 @@ error_host:
 	return err;
 }
 
+/* Allocate the link DMA buffer and select the conversion between the host
+ * and link containers.
+ */
+static int chain_convert_init(struct comp_dev *dev, uint32_t fifo_size, uint32_t addr_align,
+			      bool s24)
+{
+	struct chain_dma_data *cd = comp_get_drvdata(dev);
+	struct comp_buffer __sparse_cache *buffer_c;
+	enum sof_ipc_frame fmt32 = s24 ? SOF_IPC_FRAME_S24_4LE : SOF_IPC_FRAME_S32_LE;
+	enum sof_ipc_frame host_fmt = cd->cs == 2 ? SOF_IPC_FRAME_S16_LE : fmt32;
+	enum sof_ipc_frame link_fmt = cd->link_cs == 2 ? SOF_IPC_FRAME_S16_LE : fmt32;
+	uint32_t link_align;
+	uint32_t link_size;
+	int ret;
+
+	cd->convert = cd->stream_direction == SOF_IPC_STREAM_PLAYBACK ?
+		pcm_get_conversion_function(host_fmt, link_fmt) :
+		pcm_get_conversion_function(link_fmt, host_fmt);
+	if (!cd->convert) {
+		comp_err(dev, "chain_convert_init(): no conversion from host format %d to link format %d",
+			 host_fmt, link_fmt);
+		return -EINVAL;
+	}
+
+	/* each increment reloads both DMAs, so it must suit the stricter one */
+	ret = dma_get_attribute(cd->dma_host->z_dev, DMA_ATTR_COPY_ALIGNMENT, &cd->copy_align);
+	if (ret < 0) {
+		comp_err(dev, "chain_convert_init(): could not get host dma copy alignment, err = %d",
+			 ret);
+		return ret;
+	}
+
+	ret = dma_get_attribute(cd->dma_link->z_dev, DMA_ATTR_COPY_ALIGNMENT, &link_align);
+	if (ret < 0) {
+		comp_err(dev, "chain_convert_init(): could not get link dma copy alignment, err = %d",
+			 ret);
+		return ret;
+	}
+
+	/* the alignments are powers of two, so the larger one suits both */
+	cd->copy_align = MAX(cd->copy_align, link_align);
+
+	/* link buffer holds the same time as the host buffer */
+	link_size = ALIGN_UP_INTERNAL(fifo_size / cd->cs * cd->link_cs, addr_align);
+	cd->link_buffer = buffer_alloc(link_size, SOF_MEM_CAPS_DMA, 0, addr_align);
+	if (!cd->link_buffer) {
+		comp_err(dev, "chain_convert_init(): failed to alloc link dma buffer");
+		return -ENOMEM;
+	}
+
+	buffer_c = buffer_acquire(cd->link_buffer);
+	audio_stream_set_frm_fmt(&buffer_c->stream, link_fmt);
+	buffer_release(buffer_c);
+
+	buffer_c = buffer_acquire(cd->dma_buffer);
+	audio_stream_set_frm_fmt(&buffer_c->stream, host_fmt);
+	buffer_release(buffer_c);
+
+	comp_info(dev, "chain_convert_init(): host format %d, link format %d", host_fmt,
+		  link_fmt);
+
+	return 0;
+}
+
 static int chain_task_init(struct comp_dev *dev, uint8_t host_dma_id, uint8_t link_dma_id,
-		    uint32_t fifo_size)
+		    uint32_t fifo_size, bool convert, bool s24)
 {
 	struct chain_dma_data *cd = comp_get_drvdata(dev);
 	struct comp_buffer __sparse_cache *buffer_c;
 	uint32_t addr_align;
+	size_t link_buff_size;
+	void *link_buff_addr;
 	size_t buff_size;
 	void *buff_addr;
 	uint32_t dir;
@@ -604,16 +897,36 @@ static int chain_task_init(struct comp_dev *dev, uint8_t host_dma_id, uint8_t li
 	buff_size = audio_stream_get_size(&buffer_c->stream);
 	buffer_release(buffer_c);
 
-	ret = chain_init(dev, buff_addr, buff_size);
-	if (ret < 0) {
-		buffer_free(cd->dma_buffer);
-		cd->dma_buffer = NULL;
-		goto error;
+	link_buff_addr = buff_addr;
+	link_buff_size = buff_size;
+	if (convert) {
+		ret = chain_convert_init(dev, buff_size, addr_align, s24);
+		if (ret < 0)
+			goto error_buffers;
+
+		buffer_c = buffer_acquire(cd->link_buffer);
+		buffer_zero(buffer_c);
+		link_buff_addr = audio_stream_get_addr(&buffer_c->stream);
+		link_buff_size = audio_stream_get_size(&buffer_c->stream);
+		buffer_release(buffer_c);
 	}
 
+	ret = chain_init(dev, buff_addr, buff_size, link_buff_addr, link_buff_size);
+	if (ret < 0)
+		goto error_buffers;
+
+	chain_llp_slot_init(dev);
+
 	cd->chain_task.state = SOF_TASK_STATE_INIT;
 
 	return 0;
+error_buffers:
+	buffer_free(cd->dma_buffer);
+	cd->dma_buffer = NULL;
+	if (cd->link_buffer) {
+		buffer_free(cd->link_buffer);
+		cd->link_buffer = NULL;
+	}
 error:
 	dma_put(cd->dma_host);
 	dma_put(cd->dma_link);
@@ -641,6 +954,8 @@ static struct comp_dev *chain_task_create(const struct comp_driver *drv,
 	const uint32_t link_dma_id = cdma->primary.r.link_dma_id;
 	const uint32_t fifo_size = cdma->extension.r.fifo_size;
 	const bool scs = cdma->primary.r.scs;
+	const bool cnv = cdma->primary.r.cnv;
+	const bool cnv_s24 = cdma->primary.r.cnv_s24;
 	struct chain_dma_data *cd;
 	struct comp_dev *dev;
 	int ret;
@@ -648,6 +963,14 @@ static struct comp_dev *chain_task_create(const struct comp_driver *drv,
 	if (host_dma_id >= max_chain_number)
 		return NULL;
 
+	/* the conversion bits must be zero unless conversion is built in */
+	if ((!IS_ENABLED(CONFIG_COMP_CHAIN_DMA_CONVERT) && (cnv || cnv_s24)) ||
+	    (cnv_s24 && !cnv)) {
+		tr_err(&chain_dma_tr, "chain_task_create(): unsupported conversion cnv %d cnv_s24 %d",
+		       cnv, cnv_s24);
+		return NULL;
+	}
+
 	dev = comp_alloc(drv, sizeof(*dev));
 	if (!dev)
 		return NULL;
@@ -658,11 +981,14 @@ static struct comp_dev *chain_task_create(const struct comp_driver *drv,
 
 	cd->first_data_received = false;
 	cd->cs = scs ? 2 : 4;
+	/* with conversion the link uses the other container size */
+	cd->link_cs = cnv ? (scs ? 4 : 2) : cd->cs;
 	cd->chain_task.state = SOF_TASK_STATE_INIT;
+	k_spinlock_init(&cd->lock);
 
 	comp_set_drvdata(dev, cd);
 
-	ret = chain_task_init(dev, host_dma_id, link_dma_id, fifo_size);
+	ret = chain_task_init(dev, host_dma_id, link_dma_id, fifo_size, cnv, cnv_s24);
 	if (ret)
 		goto error_cd;
 
@@ -683,6 +1009,13 @@ error:
 	return NULL;
 }
 
+static int chain_task_position(struct comp_dev *dev, struct sof_ipc_stream_posn *posn)
+{
+	chain_get_position(comp_get_drvdata(dev), posn);
+
+	return 0;
+}
+
 static void chain_task_free(struct comp_dev *dev)
 {
 	struct chain_dma_data *cd = comp_get_drvdata(dev);
@@ -698,6 +1031,7 @@ static const struct comp_driver  comp_chain_dma = {
 	.ops = {
 		.create = chain_task_create,
 		.trigger = chain_task_trigger,
+		.position = chain_task_position,
 		.free = chain_task_free,
 	},
 };
@@ -731,6 +731,7 @@ static int set_attenuation(struct comp_dev *dev, uint32_t data_offset, const cha
 		return -EINVAL;
 	}
 
+	/* a host copier applies it from its DMA callback on the next period */
 	cd->attenuation = attenuation;
 
 	return 0;
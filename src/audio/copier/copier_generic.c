@@ -56,6 +56,133 @@ int apply_attenuation(struct comp_dev *dev, struct copier_data *cd,
 		return -EINVAL;
 	}
 }
+
+/* Shared loop of the fused kernels for 16 bit input. The converted sample is
+ * placed in a 32 bit container with a left shift of 8 (s24) or 16 (s32) and
+ * attenuated in the same pass.
+ */
+static inline int copier_fused_s16(const struct audio_stream __sparse_cache *source,
+				   struct audio_stream __sparse_cache *sink,
+				   uint32_t samples, int lshift, uint32_t attenuation)
+{
+	int16_t *src = audio_stream_get_rptr(source);
+	int32_t *dst = audio_stream_get_wptr(sink);
+	uint32_t processed;
+	uint32_t nmax, i, n;
+
+	for (processed = 0; processed < samples; processed += n) {
+		src = audio_stream_wrap(source, src);
+		dst = audio_stream_wrap(sink, dst);
+		n = samples - processed;
+		nmax = audio_stream_samples_without_wrap_s16(source, src);
+		n = MIN(n, nmax);
+		nmax = audio_stream_samples_without_wrap_s32(sink, dst);
+		n = MIN(n, nmax);
+		for (i = 0; i < n; i++) {
+			*dst = ((int32_t)*src << lshift) >> attenuation;
+			src++;
+			dst++;
+		}
+	}
+
+	return samples;
+}
+
+static int copier_fused_s16_to_s24(const struct audio_stream __sparse_cache *source,
+				   struct audio_stream __sparse_cache *sink,
+				   uint32_t samples, uint32_t attenuation)
+{
+	return copier_fused_s16(source, sink, samples, 8, attenuation);
+}
+
+static int copier_fused_s16_to_s32(const struct audio_stream __sparse_cache *source,
+				   struct audio_stream __sparse_cache *sink,
+				   uint32_t samples, uint32_t attenuation)
+{
+	return copier_fused_s16(source, sink, samples, 16, attenuation);
+}
+
+/* Shared loop of the fused kernels for 32 bit containers on both sides */
+static inline int copier_fused_s32(const struct audio_stream __sparse_cache *source,
+				   struct audio_stream __sparse_cache *sink,
+				   uint32_t samples, enum sof_ipc_frame in,
+				   enum sof_ipc_frame out, uint32_t attenuation)
+{
+	int32_t *src = audio_stream_get_rptr(source);
+	int32_t *dst = audio_stream_get_wptr(sink);
+	uint32_t processed;
+	uint32_t nmax, i, n;
+	int32_t sample;
+
+	for (processed = 0; processed < samples; processed += n) {
+		src = audio_stream_wrap(source, src);
+		dst = audio_stream_wrap(sink, dst);
+		n = samples - processed;
+		nmax = audio_stream_samples_without_wrap_s32(source, src);
+		n = MIN(n, nmax);
+		nmax = audio_stream_samples_without_wrap_s32(sink, dst);
+		n = MIN(n, nmax);
+		for (i = 0; i < n; i++) {
+			sample = *src;
+			if (in == SOF_IPC_FRAME_S24_4LE) {
+				sample = sign_extend_s24(sample);
+				if (out == SOF_IPC_FRAME_S32_LE)
+					sample <<= 8;
+			} else if (out == SOF_IPC_FRAME_S24_4LE) {
+				sample = sat_int24(Q_SHIFT_RND(sample, 31, 23));
+			}
+
+			*dst = sample >> attenuation;
+			src++;
+			dst++;
+		}
+	}
+
+	return samples;
+}
+
+static int copier_fused_s24_to_s24(const struct audio_stream __sparse_cache *source,
+				   struct audio_stream __sparse_cache *sink,
+				   uint32_t samples, uint32_t attenuation)
+{
+	return copier_fused_s32(source, sink, samples, SOF_IPC_FRAME_S24_4LE,
+				SOF_IPC_FRAME_S24_4LE, attenuation);
+}
+
+static int copier_fused_s24_to_s32(const struct audio_stream __sparse_cache *source,
+				   struct audio_stream __sparse_cache *sink,
+				   uint32_t samples, uint32_t attenuation)
+{
+	return copier_fused_s32(source, sink, samples, SOF_IPC_FRAME_S24_4LE,
+				SOF_IPC_FRAME_S32_LE, attenuation);
+}
+
+static int copier_fused_s32_to_s24(const struct audio_stream __sparse_cache *source,
+				   struct audio_stream __sparse_cache *sink,
+				   uint32_t samples, uint32_t attenuation)
+{
+	return copier_fused_s32(source, sink, samples, SOF_IPC_FRAME_S32_LE,
+				SOF_IPC_FRAME_S24_4LE, attenuation);
+}
+
+static int copier_fused_s32_to_s32(const struct audio_stream __sparse_cache *source,
+				   struct audio_stream __sparse_cache *sink,
+				   uint32_t samples, uint32_t attenuation)
+{
+	return copier_fused_s32(source, sink, samples, SOF_IPC_FRAME_S32_LE,
+				SOF_IPC_FRAME_S32_LE, attenuation);
+}
+
+const struct copier_fused_map copier_fused_map[] = {
+	{ SOF_IPC_FRAME_S16_LE, SOF_IPC_FRAME_S24_4LE, copier_fused_s16_to_s24 },
+	{ SOF_IPC_FRAME_S16_LE, SOF_IPC_FRAME_S32_LE, copier_fused_s16_to_s32 },
+	{ SOF_IPC_FRAME_S24_4LE, SOF_IPC_FRAME_S24_4LE, copier_fused_s24_to_s24 },
+	{ SOF_IPC_FRAME_S24_4LE, SOF_IPC_FRAME_S32_LE, copier_fused_s24_to_s32 },
+	{ SOF_IPC_FRAME_S32_LE, SOF_IPC_FRAME_S24_4LE, copier_fused_s32_to_s24 },
+	{ SOF_IPC_FRAME_S32_LE, SOF_IPC_FRAME_S32_LE, copier_fused_s32_to_s32 },
+};
+
+const size_t copier_fused_count = ARRAY_SIZE(copier_fused_map);
 #endif
 
 void copier_update_params(struct copier_data *cd, struct comp_dev *dev,
@@ -295,3 +422,27 @@ pcm_converter_func get_converter_func(const struct ipc4_audio_format *in_fmt,
 	else
 		return pcm_get_conversion_vc_function(in, in_valid, out, out_valid, type, dir);
 }
+
+copier_fused_func get_fused_converter_func(const struct ipc4_audio_format *in_fmt,
+					   const struct ipc4_audio_format *out_fmt)
+{
+	enum sof_ipc_frame in, in_valid, out, out_valid;
+	int i;
+
+	audio_stream_fmt_conversion(in_fmt->depth, in_fmt->valid_bit_depth, &in, &in_valid,
+				    in_fmt->s_type);
+	audio_stream_fmt_conversion(out_fmt->depth, out_fmt->valid_bit_depth, &out, &out_valid,
+				    out_fmt->s_type);
+
+	/* fused kernels exist only for the plain container == sample size path */
+	if (in_fmt->s_type == IPC4_TYPE_MSB_INTEGER || out_fmt->s_type == IPC4_TYPE_MSB_INTEGER ||
+	    !use_no_container_convert_function(in, in_valid, out, out_valid))
+		return NULL;
+
+	for (i = 0; i < copier_fused_count; i++) {
+		if (in == copier_fused_map[i].source && out == copier_fused_map[i].sink)
+			return copier_fused_map[i].func;
+	}
+
+	return NULL;
+}
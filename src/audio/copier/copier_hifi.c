@@ -72,4 +72,156 @@ int apply_attenuation(struct comp_dev *dev, struct copier_data *cd,
 		return -EINVAL;
 	}
 }
+
+/* Shared loop of the fused kernels for 16 bit input. The samples are placed
+ * in 32 bit containers and the container shift (8 for s24, 16 for s32) is
+ * merged with the attenuation into a single arithmetic right shift.
+ */
+static inline int copier_fused_s16(const struct audio_stream __sparse_cache *source,
+				   struct audio_stream __sparse_cache *sink,
+				   uint32_t samples, int rshift)
+{
+	ae_int16x4 sample = AE_ZERO16();
+	uint32_t nmax, i, n, m, left, left_samples;
+	ae_valign inu = AE_ZALIGN64();
+	ae_valign outu = AE_ZALIGN64();
+	ae_int16x4 *in = audio_stream_get_rptr(source);
+	ae_int32x2 *out = audio_stream_get_wptr(sink);
+
+	for (left_samples = samples; left_samples; left_samples -= n) {
+		nmax = audio_stream_samples_without_wrap_s16(source, in);
+		n = MIN(left_samples, nmax);
+		nmax = audio_stream_samples_without_wrap_s32(sink, out);
+		n = MIN(n, nmax);
+		m = n >> 2;
+		left = n & 0x03;
+		inu = AE_LA64_PP(in);
+
+		for (i = 0; i < m; i++) {
+			/* load four 16 bit samples, convert, attenuate and store */
+			AE_LA16X4_IP(sample, inu, in);
+			AE_SA32X2_IP(AE_SRAA32(AE_CVT32X2F16_32(sample), rshift), outu, out);
+			AE_SA32X2_IP(AE_SRAA32(AE_CVT32X2F16_10(sample), rshift), outu, out);
+		}
+		AE_SA64POS_FP(outu, out);
+
+		/* process the left samples one by one to avoid memory access overrun */
+		for (i = 0; i < left; i++) {
+			AE_L16_IP(sample, (ae_int16 *)in, sizeof(ae_int16));
+			AE_S32_L_IP(AE_SRAA32(AE_CVT32X2F16_32(sample), rshift), (ae_int32 *)out,
+				    sizeof(ae_int32));
+		}
+
+		in = audio_stream_wrap(source, in);
+		out = audio_stream_wrap(sink, out);
+	}
+
+	return samples;
+}
+
+static int copier_fused_s16_to_s24(const struct audio_stream __sparse_cache *source,
+				   struct audio_stream __sparse_cache *sink,
+				   uint32_t samples, uint32_t attenuation)
+{
+	return copier_fused_s16(source, sink, samples, 8 + attenuation);
+}
+
+static int copier_fused_s16_to_s32(const struct audio_stream __sparse_cache *source,
+				   struct audio_stream __sparse_cache *sink,
+				   uint32_t samples, uint32_t attenuation)
+{
+	return copier_fused_s16(source, sink, samples, attenuation);
+}
+
+/* Shared loop of the fused kernels for 32 bit containers on both sides. The
+ * sample is shifted left by lshift to align it to MSB, optionally rounded and
+ * saturated to 24 bits, and finally shifted right by rshift, which includes
+ * the attenuation.
+ */
+static inline int copier_fused_s32(const struct audio_stream __sparse_cache *source,
+				   struct audio_stream __sparse_cache *sink,
+				   uint32_t samples, int lshift, int rshift, bool to_s24)
+{
+	ae_int32x2 sample = AE_ZERO32();
+	uint32_t nmax, i, n, m, left_samples;
+	ae_valign inu = AE_ZALIGN64();
+	ae_valign outu = AE_ZALIGN64();
+	ae_int32x2 *in = audio_stream_get_rptr(source);
+	ae_int32x2 *out = audio_stream_get_wptr(sink);
+
+	for (left_samples = samples; left_samples; left_samples -= n) {
+		nmax = audio_stream_samples_without_wrap_s32(source, in);
+		n = MIN(left_samples, nmax);
+		nmax = audio_stream_samples_without_wrap_s32(sink, out);
+		n = MIN(n, nmax);
+		m = n >> 1;
+		inu = AE_LA64_PP(in);
+		for (i = 0; i < m; i++) {
+			AE_LA32X2_IP(sample, inu, in);
+			sample = AE_SLAA32(sample, lshift);
+			if (to_s24) {
+				/* shift with saturation and rounding */
+				sample = AE_SRAI32R(sample, 8);
+				sample = AE_SLAI32S(sample, 8);
+			}
+			AE_SA32X2_IP(AE_SRAA32(sample, rshift), outu, out);
+		}
+		AE_SA64POS_FP(outu, out);
+
+		/* process the left 1 sample to avoid memory access overrun */
+		if (n & 0x01) {
+			AE_L32_IP(sample, (ae_int32 *)in, sizeof(ae_int32));
+			sample = AE_SLAA32(sample, lshift);
+			if (to_s24) {
+				sample = AE_SRAI32R(sample, 8);
+				sample = AE_SLAI32S(sample, 8);
+			}
+			AE_S32_L_IP(AE_SRAA32(sample, rshift), (ae_int32 *)out, sizeof(ae_int32));
+		}
+
+		in = audio_stream_wrap(source, in);
+		out = audio_stream_wrap(sink, out);
+	}
+
+	return samples;
+}
+
+static int copier_fused_s24_to_s24(const struct audio_stream __sparse_cache *source,
+				   struct audio_stream __sparse_cache *sink,
+				   uint32_t samples, uint32_t attenuation)
+{
+	return copier_fused_s32(source, sink, samples, 8, 8 + attenuation, false);
+}
+
+static int copier_fused_s24_to_s32(const struct audio_stream __sparse_cache *source,
+				   struct audio_stream __sparse_cache *sink,
+				   uint32_t samples, uint32_t attenuation)
+{
+	return copier_fused_s32(source, sink, samples, 8, attenuation, false);
+}
+
+static int copier_fused_s32_to_s24(const struct audio_stream __sparse_cache *source,
+				   struct audio_stream __sparse_cache *sink,
+				   uint32_t samples, uint32_t attenuation)
+{
+	return copier_fused_s32(source, sink, samples, 0, 8 + attenuation, true);
+}
+
+static int copier_fused_s32_to_s32(const struct audio_stream __sparse_cache *source,
+				   struct audio_stream __sparse_cache *sink,
+				   uint32_t samples, uint32_t attenuation)
+{
+	return copier_fused_s32(source, sink, samples, 0, attenuation, false);
+}
+
+const struct copier_fused_map copier_fused_map[] = {
+	{ SOF_IPC_FRAME_S16_LE, SOF_IPC_FRAME_S24_4LE, copier_fused_s16_to_s24 },
+	{ SOF_IPC_FRAME_S16_LE, SOF_IPC_FRAME_S32_LE, copier_fused_s16_to_s32 },
+	{ SOF_IPC_FRAME_S24_4LE, SOF_IPC_FRAME_S24_4LE, copier_fused_s24_to_s24 },
+	{ SOF_IPC_FRAME_S24_4LE, SOF_IPC_FRAME_S32_LE, copier_fused_s24_to_s32 },
+	{ SOF_IPC_FRAME_S32_LE, SOF_IPC_FRAME_S24_4LE, copier_fused_s32_to_s24 },
+	{ SOF_IPC_FRAME_S32_LE, SOF_IPC_FRAME_S32_LE, copier_fused_s32_to_s32 },
+};
+
+const size_t copier_fused_count = ARRAY_SIZE(copier_fused_map);
 #endif
@@ -251,6 +251,13 @@ void copier_host_dma_cb(struct comp_dev *dev, size_t bytes)
 
 	comp_dbg(dev, "copier_host_dma_cb() %p", dev);
 
+	/* Pick up a run-time attenuation change here rather than in the IPC
+	 * context, so the kernel and the separate pass are switched between
+	 * periods and a period is never attenuated twice or not at all.
+	 */
+	if (cd->hd->attenuation != cd->attenuation)
+		copier_host_update_attenuation(cd, dev);
+
 	/* update position */
 	host_common_update(cd->hd, dev, bytes);
 
@@ -260,9 +267,11 @@ void copier_host_dma_cb(struct comp_dev *dev, size_t bytes)
 
 	/* Apply attenuation since copier copy missed this with host device
 	 * remove. Attenuation has to be applied in HOST Copier only with
-	 * playback scenario.
+	 * playback scenario. Formats with a fused kernel were already
+	 * attenuated during the conversion in host_common_update().
 	 */
-	if (cd->attenuation && dev->direction == SOF_IPC_STREAM_PLAYBACK) {
+	if (cd->hd->attenuation && dev->direction == SOF_IPC_STREAM_PLAYBACK &&
+	    !cd->hd->fused_process) {
 		source = buffer_acquire(cd->hd->dma_buffer);
 		sink = buffer_acquire(cd->hd->local_buffer);
 		frames = bytes / audio_stream_frame_bytes(&source->stream);
@@ -296,6 +305,27 @@ int copier_host_params(struct copier_data *cd, struct comp_dev *dev,
 				 copier_notifier_cb);
 
 	cd->hd->process = cd->converter[IPC4_COPIER_GATEWAY_PIN];
+	copier_host_update_attenuation(cd, dev);
 
 	return ret;
 }
+
+/* Select the fused conversion and attenuation kernel for host playback. It is
+ * called at params time and from the DMA callback when the attenuation was
+ * changed at run-time.
+ */
+void copier_host_update_attenuation(struct copier_data *cd, struct comp_dev *dev)
+{
+	struct host_data *hd = cd->hd;
+
+	hd->fused_process = NULL;
+	hd->attenuation = cd->attenuation;
+
+	if (!hd->attenuation || dev->direction != SOF_IPC_STREAM_PLAYBACK)
+		return;
+
+	hd->fused_process = get_fused_converter_func(&cd->config.base.audio_fmt,
+						     &cd->config.out_fmt);
+	if (!hd->fused_process)
+		comp_dbg(dev, "no fused attenuation kernel, using separate pass");
+}
@@ -10,80 +10,76 @@
 #include <sof/audio/crossover/crossover.h>
 #include <sof/audio/format.h>
 #include <sof/math/iir_df2t.h>
+#include <stdbool.h>
 #include <stdint.h>
 
 /*
- * \brief Splits x into two based on the coefficients set in the lp
- *        and hp filters. The output of the lp is in y1, the output of
- *        the hp is in y2.
- *
- * As a side effect, this function mutates the delay values of both
- * filters.
+ * \brief Runs an interleaved block of all channels through the LR4 filter
+ *        idx of each channel. Adjacent channels are filtered as pairs.
  */
-static inline void crossover_generic_lr4_split(struct iir_state_df2t *lp,
-					       struct iir_state_df2t *hp,
-					       int32_t x, int32_t *y1,
-					       int32_t *y2)
+static void crossover_generic_lr4_block(struct crossover_state state[], int idx,
+					bool highpass, const int32_t *x,
+					int32_t *y, int frames, int nch)
 {
-	*y1 = crossover_generic_process_lr4(x, lp);
-	*y2 = crossover_generic_process_lr4(x, hp);
+	struct iir_state_df2t *lr4_0;
+	struct iir_state_df2t *lr4_1;
+	int ch;
+
+	for (ch = 0; ch + 1 < nch; ch += 2) {
+		lr4_0 = highpass ? &state[ch].highpass[idx] : &state[ch].lowpass[idx];
+		lr4_1 = highpass ? &state[ch + 1].highpass[idx] : &state[ch + 1].lowpass[idx];
+		iir_df2t_block_x2(lr4_0, lr4_1, x + ch, y + ch, frames, nch);
+	}
+
+	if (ch < nch) {
+		lr4_0 = highpass ? &state[ch].highpass[idx] : &state[ch].lowpass[idx];
+		iir_df2t_block(lr4_0, x + ch, y + ch, frames, nch);
+	}
 }
 
 /*
- * \brief Splits input signal into two and merges it back to it's
- *        original form.
- *
- * With 3-way crossovers, one output goes through only one LR4 filter,
- * whereas the other two go through two LR4 filters. This causes the signals
- * to be out of phase. We need to pass the signal through another set of LR4
- * filters to align back the phase.
+ * \brief Block version of crossover_generic_lr4_merge(), the result is
+ *        returned in x and tmp is used as scratch.
  */
-static inline void crossover_generic_lr4_merge(struct iir_state_df2t *lp,
-					       struct iir_state_df2t *hp,
-					       int32_t x, int32_t *y)
+static void crossover_generic_lr4_merge_block(struct crossover_state state[],
+					      int idx, int32_t *x, int32_t *tmp,
+					      int frames, int nch)
 {
-	int32_t z1, z2;
+	int i;
 
-	z1 = crossover_generic_process_lr4(x, lp);
-	z2 = crossover_generic_process_lr4(x, hp);
-	*y = sat_int32(((int64_t)z1) + z2);
+	crossover_generic_lr4_block(state, idx, false, x, tmp, frames, nch);
+	crossover_generic_lr4_block(state, idx, true, x, x, frames, nch);
+	for (i = 0; i < frames * nch; i++)
+		x[i] = sat_int32((int64_t)x[i] + tmp[i]);
 }
 
-static void crossover_generic_split_2way(int32_t in,
-					 int32_t out[],
-					 struct crossover_state *state)
+static void crossover_generic_split_block_2way(struct crossover_state state[],
+					       int32_t *out[], int frames, int nch)
 {
-	crossover_generic_lr4_split(&state->lowpass[0], &state->highpass[0],
-				    in, &out[0], &out[1]);
+	crossover_generic_lr4_block(state, 0, false, out[1], out[0], frames, nch);
+	crossover_generic_lr4_block(state, 0, true, out[1], out[1], frames, nch);
 }
 
-static void crossover_generic_split_3way(int32_t in,
-					 int32_t out[],
-					 struct crossover_state *state)
+static void crossover_generic_split_block_3way(struct crossover_state state[],
+					       int32_t *out[], int frames, int nch)
 {
-	int32_t z1, z2;
-
-	crossover_generic_lr4_split(&state->lowpass[0], &state->highpass[0],
-				    in, &z1, &z2);
-	/* Realign the phase of z1 */
-	crossover_generic_lr4_merge(&state->lowpass[1], &state->highpass[1],
-				    z1, &out[0]);
-	crossover_generic_lr4_split(&state->lowpass[2], &state->highpass[2],
-				    z2, &out[1], &out[2]);
+	crossover_generic_lr4_block(state, 0, false, out[2], out[0], frames, nch);
+	crossover_generic_lr4_block(state, 0, true, out[2], out[1], frames, nch);
+	/* Realign the phase of the low band */
+	crossover_generic_lr4_merge_block(state, 1, out[0], out[2], frames, nch);
+	crossover_generic_lr4_block(state, 2, true, out[1], out[2], frames, nch);
+	crossover_generic_lr4_block(state, 2, false, out[1], out[1], frames, nch);
 }
 
-static void crossover_generic_split_4way(int32_t in,
-					 int32_t out[],
-					 struct crossover_state *state)
+static void crossover_generic_split_block_4way(struct crossover_state state[],
+					       int32_t *out[], int frames, int nch)
 {
-	int32_t z1, z2;
-
-	crossover_generic_lr4_split(&state->lowpass[1], &state->highpass[1],
-				    in, &z1, &z2);
-	crossover_generic_lr4_split(&state->lowpass[0], &state->highpass[0],
-				    z1, &out[0], &out[1]);
-	crossover_generic_lr4_split(&state->lowpass[2], &state->highpass[2],
-				    z2, &out[2], &out[3]);
+	crossover_generic_lr4_block(state, 1, false, out[3], out[0], frames, nch);
+	crossover_generic_lr4_block(state, 1, true, out[3], out[2], frames, nch);
+	crossover_generic_lr4_block(state, 0, true, out[0], out[1], frames, nch);
+	crossover_generic_lr4_block(state, 0, false, out[0], out[0], frames, nch);
+	crossover_generic_lr4_block(state, 2, true, out[2], out[3], frames, nch);
+	crossover_generic_lr4_block(state, 2, false, out[2], out[2], frames, nch);
 }
 
 #if CONFIG_FORMAT_S16LE
@@ -148,33 +144,40 @@ static void crossover_s16_default(struct comp_data *cd,
 				  int32_t num_sinks,
 				  uint32_t frames)
 {
-	struct crossover_state *state;
 	const struct audio_stream __sparse_cache *source_stream = bsource->data;
 	struct audio_stream __sparse_cache *sink_stream;
+	int32_t *out[SOF_CROSSOVER_MAX_STREAMS];
+	int32_t *in = cd->block[num_sinks - 1];
 	int16_t *x, *y;
-	int ch, i, j;
-	int idx;
+	int i, j, n;
+	int idx = 0;
 	int nch = audio_stream_get_channels(source_stream);
-	int32_t out[num_sinks];
-
-	for (ch = 0; ch < nch; ch++) {
-		idx = ch;
-		state = &cd->state[ch];
-		for (i = 0; i < frames; i++) {
-			x = audio_stream_read_frag_s16(source_stream, idx);
-			cd->crossover_split(*x << 16, out, state);
-
-			for (j = 0; j < num_sinks; j++) {
-				if (!bsinks[j])
-					continue;
-				sink_stream = bsinks[j]->data;
-				y = audio_stream_write_frag_s16(sink_stream,
-								idx);
-				*y = sat_int16(Q_SHIFT_RND(out[j], 31, 15));
-			}
+	int remaining = frames;
+
+	for (j = 0; j < num_sinks; j++)
+		out[j] = cd->block[j];
 
-			idx += nch;
+	while (remaining) {
+		n = MIN(remaining, CROSSOVER_BLOCK_FRAMES);
+		for (i = 0; i < n * nch; i++) {
+			x = audio_stream_read_frag_s16(source_stream, idx + i);
+			in[i] = *x << 16;
 		}
+
+		cd->crossover_split_block(cd->state, out, n, nch);
+
+		for (j = 0; j < num_sinks; j++) {
+			if (!bsinks[j])
+				continue;
+			sink_stream = bsinks[j]->data;
+			for (i = 0; i < n * nch; i++) {
+				y = audio_stream_write_frag_s16(sink_stream, idx + i);
+				*y = sat_int16(Q_SHIFT_RND(out[j][i], 31, 15));
+			}
+		}
+
+		idx += n * nch;
+		remaining -= n;
 	}
 }
 #endif /* CONFIG_FORMAT_S16LE */
@@ -186,33 +189,40 @@ static void crossover_s24_default(struct comp_data *cd,
 				  int32_t num_sinks,
 				  uint32_t frames)
 {
-	struct crossover_state *state;
 	const struct audio_stream __sparse_cache *source_stream = bsource->data;
 	struct audio_stream __sparse_cache *sink_stream;
+	int32_t *out[SOF_CROSSOVER_MAX_STREAMS];
+	int32_t *in = cd->block[num_sinks - 1];
 	int32_t *x, *y;
-	int ch, i, j;
-	int idx;
+	int i, j, n;
+	int idx = 0;
 	int nch = audio_stream_get_channels(source_stream);
-	int32_t out[num_sinks];
-
-	for (ch = 0; ch < nch; ch++) {
-		idx = ch;
-		state = &cd->state[ch];
-		for (i = 0; i < frames; i++) {
-			x = audio_stream_read_frag_s32(source_stream, idx);
-			cd->crossover_split(*x << 8, out, state);
-
-			for (j = 0; j < num_sinks; j++) {
-				if (!bsinks[j])
-					continue;
-				sink_stream = bsinks[j]->data;
-				y = audio_stream_write_frag_s32(sink_stream,
-								idx);
-				*y = sat_int24(Q_SHIFT_RND(out[j], 31, 23));
-			}
+	int remaining = frames;
 
-			idx += nch;
+	for (j = 0; j < num_sinks; j++)
+		out[j] = cd->block[j];
+
+	while (remaining) {
+		n = MIN(remaining, CROSSOVER_BLOCK_FRAMES);
+		for (i = 0; i < n * nch; i++) {
+			x = audio_stream_read_frag_s32(source_stream, idx + i);
+			in[i] = *x << 8;
 		}
+
+		cd->crossover_split_block(cd->state, out, n, nch);
+
+		for (j = 0; j < num_sinks; j++) {
+			if (!bsinks[j])
+				continue;
+			sink_stream = bsinks[j]->data;
+			for (i = 0; i < n * nch; i++) {
+				y = audio_stream_write_frag_s32(sink_stream, idx + i);
+				*y = sat_int24(Q_SHIFT_RND(out[j][i], 31, 23));
+			}
+		}
+
+		idx += n * nch;
+		remaining -= n;
 	}
 }
 #endif /* CONFIG_FORMAT_S24LE */
@@ -224,33 +234,40 @@ static void crossover_s32_default(struct comp_data *cd,
 				  int32_t num_sinks,
 				  uint32_t frames)
 {
-	struct crossover_state *state;
 	const struct audio_stream __sparse_cache *source_stream = bsource->data;
 	struct audio_stream __sparse_cache *sink_stream;
+	int32_t *out[SOF_CROSSOVER_MAX_STREAMS];
+	int32_t *in = cd->block[num_sinks - 1];
 	int32_t *x, *y;
-	int ch, i, j;
-	int idx;
+	int i, j, n;
+	int idx = 0;
 	int nch = audio_stream_get_channels(source_stream);
-	int32_t out[num_sinks];
-
-	for (ch = 0; ch < nch; ch++) {
-		idx = ch;
-		state = &cd->state[ch];
-		for (i = 0; i < frames; i++) {
-			x = audio_stream_read_frag_s32(source_stream, idx);
-			cd->crossover_split(*x, out, state);
-
-			for (j = 0; j < num_sinks; j++) {
-				if (!bsinks[j])
-					continue;
-				sink_stream = bsinks[j]->data;
-				y = audio_stream_write_frag_s32(sink_stream,
-								idx);
-				*y = out[j];
-			}
+	int remaining = frames;
+
+	for (j = 0; j < num_sinks; j++)
+		out[j] = cd->block[j];
+
+	while (remaining) {
+		n = MIN(remaining, CROSSOVER_BLOCK_FRAMES);
+		for (i = 0; i < n * nch; i++) {
+			x = audio_stream_read_frag_s32(source_stream, idx + i);
+			in[i] = *x;
+		}
+
+		cd->crossover_split_block(cd->state, out, n, nch);
 
-			idx += nch;
+		for (j = 0; j < num_sinks; j++) {
+			if (!bsinks[j])
+				continue;
+			sink_stream = bsinks[j]->data;
+			for (i = 0; i < n * nch; i++) {
+				y = audio_stream_write_frag_s32(sink_stream, idx + i);
+				*y = out[j][i];
+			}
 		}
+
+		idx += n * nch;
+		remaining -= n;
 	}
 }
 #endif /* CONFIG_FORMAT_S32LE */
@@ -287,10 +304,8 @@ const struct crossover_proc_fnmap crossover_proc_fnmap_pass[] = {
 
 const size_t crossover_proc_fncount = ARRAY_SIZE(crossover_proc_fnmap);
 
-const crossover_split crossover_split_fnmap[] = {
-	crossover_generic_split_2way,
-	crossover_generic_split_3way,
-	crossover_generic_split_4way,
+const crossover_split_block crossover_split_block_fnmap[] = {
+	crossover_generic_split_block_2way,
+	crossover_generic_split_block_3way,
+	crossover_generic_split_block_4way,
 };
-
-const size_t crossover_split_fncount = ARRAY_SIZE(crossover_split_fnmap);
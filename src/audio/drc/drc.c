@@ -120,6 +120,26 @@ inline int drc_set_pre_delay_time(struct drc_state *state,
 	return 0;
 }
 
+/* Sample the compression curve for drc_gain_lut_lookup(). Point i is at level
+ * (1 + k / 2^DRC_GAIN_LUT_STEPS_SHIFT) * 2^(o - DRC_GAIN_LUT_OCTAVES) where o and
+ * k are the octave and step of the point. The last point is full scale.
+ */
+void drc_init_gain_lut(struct drc_state *state, const struct sof_drc_params *p)
+{
+	const int steps = 1 << DRC_GAIN_LUT_STEPS_SHIFT;
+	int32_t x; /* Q1.31 */
+	int i;
+
+	for (i = 0; i < DRC_GAIN_LUT_SIZE - 1; i++) {
+		x = (steps + (i & (steps - 1))) <<
+			((i >> DRC_GAIN_LUT_STEPS_SHIFT) + DRC_GAIN_LUT_MIN_MSB -
+			 DRC_GAIN_LUT_STEPS_SHIFT);
+		state->gain_lut[i] = drc_volume_gain(p, x);
+	}
+
+	state->gain_lut[DRC_GAIN_LUT_SIZE - 1] = drc_volume_gain(p, INT32_MAX);
+}
+
 static int drc_setup(struct drc_comp_data *cd, uint16_t channels, uint32_t rate)
 {
 	uint32_t sample_bytes = get_sample_bytes(cd->source_format);
@@ -133,6 +153,9 @@ static int drc_setup(struct drc_comp_data *cd, uint16_t channels, uint32_t rate)
 	if (ret < 0)
 		return ret;
 
+	/* Sample the compression curve */
+	drc_init_gain_lut(&cd->state, &cd->config->params);
+
 	/* Set pre-dely time */
 	return drc_set_pre_delay_time(&cd->state, cd->config->params.pre_delay_time, rate);
 }
@@ -41,7 +41,7 @@ static int32_t knee_curveK(const struct sof_drc_params *p, int32_t x)
 
 /* Full compression curve with constant ratio after knee. Returns the ratio of
  * output and input signal. */
-static int32_t volume_gain(const struct sof_drc_params *p, int32_t x)
+int32_t drc_volume_gain(const struct sof_drc_params *p, int32_t x)
 {
 	const int32_t knee_threshold =
 		sat_int32(Q_SHIFT_LEFT((int64_t)p->knee_threshold, 24, 31));
@@ -99,24 +99,23 @@ void drc_update_detector_average(struct drc_state *state,
 	}
 
 	/* The max abs value across all channels for this frame */
+	for (i = 0; i < DRC_DIVISION_FRAMES; i++)
+		abs_input_array[i] = 0;
+
 	if (nbyte == 2) { /* 2 bytes per sample */
-		for (i = 0; i < DRC_DIVISION_FRAMES; i++) {
-			abs_input_array[i] = 0;
-			for (ch = 0; ch < nch; ch++) {
-				sample16_p =
-					(int16_t *)state->pre_delay_buffers[ch] + div_start + i;
-				sample = Q_SHIFT_LEFT((int32_t)*sample16_p, 15, 31);
-				abs_input_array[i] = MAX(abs_input_array[i], ABS(sample));
+		for (ch = 0; ch < nch; ch++) {
+			sample16_p = (int16_t *)state->pre_delay_buffers[ch] + div_start;
+			for (i = 0; i < DRC_DIVISION_FRAMES; i++) {
+				sample = Q_SHIFT_LEFT((int32_t)sample16_p[i], 15, 31);
+				abs_input_array[i] = MAX(abs_input_array[i], drc_abs_sat(sample));
 			}
 		}
 	} else { /* 4 bytes per sample */
-		for (i = 0; i < DRC_DIVISION_FRAMES; i++) {
-			abs_input_array[i] = 0;
-			for (ch = 0; ch < nch; ch++) {
-				sample32_p =
-					(int32_t *)state->pre_delay_buffers[ch] + div_start + i;
-				sample = *sample32_p;
-				abs_input_array[i] = MAX(abs_input_array[i], ABS(sample));
+		for (ch = 0; ch < nch; ch++) {
+			sample32_p = (int32_t *)state->pre_delay_buffers[ch] + div_start;
+			for (i = 0; i < DRC_DIVISION_FRAMES; i++) {
+				sample = sample32_p[i];
+				abs_input_array[i] = MAX(abs_input_array[i], drc_abs_sat(sample));
 			}
 		}
 	}
@@ -129,9 +128,10 @@ void drc_update_detector_average(struct drc_state *state,
 		 * enters a "knee" portion followed by the "ratio" portion. The
 		 * transition from the threshold to the knee is smooth (1st
 		 * derivative matched). The transition from the knee to the
-		 * ratio portion is smooth (1st derivative matched).
+		 * ratio portion is smooth (1st derivative matched). The curve
+		 * is interpolated from the table sampled at setup.
 		 */
-		gain = volume_gain(p, abs_input_array[i]); /* Q2.30 */
+		gain = drc_gain_lut_lookup(state, abs_input_array[i]); /* Q2.30 */
 		gain_diff = gain - detector_average; /* Q2.30 */
 		is_release = (gain_diff > 0);
 		if (is_release) {
@@ -263,18 +263,13 @@ void drc_compress_output(struct drc_state *state,
 			 int nch)
 {
 	const int div_start = state->pre_delay_read_index;
-	int count = DRC_DIVISION_FRAMES >> 2;
-
+	int32_t total_gain[DRC_DIVISION_FRAMES]; /* Q8.24 */
 	int32_t c, base, r, r2, r4; /* Q2.30 */
 	int32_t x[4]; /* Q2.30 */
 	int32_t post_warp_compressor_gain;
-	int32_t total_gain;
-
-	int i, j, ch, inc;
 	int16_t *sample16_p; /* for s16 format case */
 	int32_t *sample32_p; /* for s24 and s32 format cases */
-	int32_t sample;
-	int is_2byte = (nbyte == 2); /* otherwise is 4-bytes */
+	int i, j, ch;
 
 	/* Exponential approach to desired gain. */
 	if (state->envelope_rate < ONE_Q30) {
@@ -289,75 +284,25 @@ void drc_compress_output(struct drc_state *state,
 		r4 = Q_MULTSR_32X32((int64_t)r2, r2, 30, 30, 30);
 
 		i = 0;
-		inc = 0;
-		if (is_2byte) { /* 2 bytes per sample */
-			while (1) {
-				for (j = 0; j < 4; j++) {
-					/* Warp pre-compression gain to smooth out sharp
-					 * exponential transition points.
-					 */
-					post_warp_compressor_gain =
-						drc_sin_fixed(x[j] + base); /* Q1.31 */
-
-					/* Calculate total gain using master gain. */
-					total_gain = Q_MULTSR_32X32((int64_t)p->master_linear_gain,
-								    post_warp_compressor_gain,
-								    24, 31, 24); /* Q8.24 */
-
-					/* Apply final gain. */
-					for (ch = 0; ch < nch; ch++) {
-						sample16_p =
-							(int16_t *)state->pre_delay_buffers[ch] +
-								div_start + inc;
-						sample = (int32_t)*sample16_p;
-						*sample16_p =
-							sat_int16(Q_MULTSR_32X32((int64_t)sample,
-										 total_gain,
-										 15, 24, 15));
-					}
-					inc++;
-				}
-
-				if (++i == count)
-					break;
-
-				for (j = 0; j < 4; j++)
-					x[j] = Q_MULTSR_32X32((int64_t)x[j], r4, 30, 30, 30);
-			}
-		} else { /* 4 bytes per sample */
-			while (1) {
-				for (j = 0; j < 4; j++) {
-					/* Warp pre-compression gain to smooth out sharp
-					 * exponential transition points.
-					 */
-					post_warp_compressor_gain =
-						drc_sin_fixed(x[j] + base); /* Q1.31 */
-
-					/* Calculate total gain using master gain. */
-					total_gain = Q_MULTSR_32X32((int64_t)p->master_linear_gain,
-								    post_warp_compressor_gain,
-								    24, 31, 24); /* Q8.24 */
-
-					/* Apply final gain. */
-					for (ch = 0; ch < nch; ch++) {
-						sample32_p =
-							(int32_t *)state->pre_delay_buffers[ch] +
-								div_start + inc;
-						sample = *sample32_p;
-						*sample32_p =
-							sat_int32(Q_MULTSR_32X32((int64_t)sample,
-										 total_gain,
-										 31, 24, 31));
-					}
-					inc++;
-				}
-
-				if (++i == count)
-					break;
-
-				for (j = 0; j < 4; j++)
-					x[j] = Q_MULTSR_32X32((int64_t)x[j], r4, 30, 30, 30);
+		while (1) {
+			for (j = 0; j < 4; j++) {
+				/* Warp pre-compression gain to smooth out sharp
+				 * exponential transition points.
+				 */
+				post_warp_compressor_gain = drc_sin_fixed(x[j] + base); /* Q1.31 */
+
+				/* Calculate total gain using master gain. */
+				total_gain[i + j] = Q_MULTSR_32X32((int64_t)p->master_linear_gain,
+								   post_warp_compressor_gain,
+								   24, 31, 24); /* Q8.24 */
 			}
+
+			i += 4;
+			if (i == DRC_DIVISION_FRAMES)
+				break;
+
+			for (j = 0; j < 4; j++)
+				x[j] = Q_MULTSR_32X32((int64_t)x[j], r4, 30, 30, 30);
 		}
 
 		state->compressor_gain = x[3] + base;
@@ -372,79 +317,51 @@ void drc_compress_output(struct drc_state *state,
 		r4 = Q_MULTSR_32X32((int64_t)r2, r2, 30, 30, 30);
 
 		i = 0;
-		inc = 0;
-		if (is_2byte) { /* 2 bytes per sample */
-			while (1) {
-				for (j = 0; j < 4; j++) {
-					/* Warp pre-compression gain to smooth out sharp
-					 * exponential transition points.
-					 */
-					post_warp_compressor_gain = drc_sin_fixed(x[j]); /* Q1.31 */
-
-					/* Calculate total gain using master gain. */
-					total_gain = Q_MULTSR_32X32((int64_t)p->master_linear_gain,
-								    post_warp_compressor_gain,
-								    24, 31, 24); /* Q8.24 */
-
-					/* Apply final gain. */
-					for (ch = 0; ch < nch; ch++) {
-						sample16_p =
-							(int16_t *)state->pre_delay_buffers[ch] +
-								div_start + inc;
-						sample = (int32_t)*sample16_p;
-						*sample16_p =
-							sat_int16(Q_MULTSR_32X32((int64_t)sample,
-										 total_gain,
-										 15, 24, 15));
-					}
-					inc++;
-				}
-
-				if (++i == count)
-					break;
-
-				for (j = 0; j < 4; j++)
-					x[j] = MIN(ONE_Q30,
-						   Q_MULTSR_32X32((int64_t)x[j], r4, 30, 30, 30));
-			}
-		} else { /* 4 bytes per sample */
-			while (1) {
-				for (j = 0; j < 4; j++) {
-					/* Warp pre-compression gain to smooth out sharp
-					 * exponential transition points.
-					 */
-					post_warp_compressor_gain = drc_sin_fixed(x[j]); /* Q1.31 */
-
-					/* Calculate total gain using master gain. */
-					total_gain = Q_MULTSR_32X32((int64_t)p->master_linear_gain,
-								    post_warp_compressor_gain,
-								    24, 31, 24); /* Q8.24 */
-
-					/* Apply final gain. */
-					for (ch = 0; ch < nch; ch++) {
-						sample32_p =
-							(int32_t *)state->pre_delay_buffers[ch] +
-								div_start + inc;
-						sample = *sample32_p;
-						*sample32_p =
-							sat_int32(Q_MULTSR_32X32((int64_t)sample,
-										 total_gain,
-										 31, 24, 31));
-					}
-					inc++;
-				}
-
-				if (++i == count)
-					break;
-
-				for (j = 0; j < 4; j++)
-					x[j] = MIN(ONE_Q30,
-						   Q_MULTSR_32X32((int64_t)x[j], r4, 30, 30, 30));
+		while (1) {
+			for (j = 0; j < 4; j++) {
+				/* Warp pre-compression gain to smooth out sharp
+				 * exponential transition points.
+				 */
+				post_warp_compressor_gain = drc_sin_fixed(x[j]); /* Q1.31 */
+
+				/* Calculate total gain using master gain. */
+				total_gain[i + j] = Q_MULTSR_32X32((int64_t)p->master_linear_gain,
+								   post_warp_compressor_gain,
+								   24, 31, 24); /* Q8.24 */
 			}
+
+			i += 4;
+			if (i == DRC_DIVISION_FRAMES)
+				break;
+
+			for (j = 0; j < 4; j++)
+				x[j] = MIN(ONE_Q30,
+					   Q_MULTSR_32X32((int64_t)x[j], r4, 30, 30, 30));
 		}
 
 		state->compressor_gain = x[3];
 	}
+
+	/* Apply final gain. The division is contiguous in the pre-delay buffers
+	 * so each channel is a plain vector product with the gain array.
+	 */
+	if (nbyte == 2) { /* 2 bytes per sample */
+		for (ch = 0; ch < nch; ch++) {
+			sample16_p = (int16_t *)state->pre_delay_buffers[ch] + div_start;
+			for (i = 0; i < DRC_DIVISION_FRAMES; i++)
+				sample16_p[i] =
+					sat_int16(Q_MULTSR_32X32((int64_t)sample16_p[i],
+								 total_gain[i], 15, 24, 15));
+		}
+	} else { /* 4 bytes per sample */
+		for (ch = 0; ch < nch; ch++) {
+			sample32_p = (int32_t *)state->pre_delay_buffers[ch] + div_start;
+			for (i = 0; i < DRC_DIVISION_FRAMES; i++)
+				sample32_p[i] =
+					sat_int32(Q_MULTSR_32X32((int64_t)sample32_p[i],
+								 total_gain[i], 31, 24, 31));
+		}
+	}
 }
 
 #endif /* DRC_GENERIC */
@@ -485,8 +402,8 @@ static void drc_delay_input_sample_s16(struct drc_state *state,
 {
 	int16_t *x1;
 	int16_t *y1;
-	int16_t *pd;
-	int pd_write_index, pd_read_index;
+	int16_t *pd_write;
+	int16_t *pd_read;
 	int nbuf, npcm, nfrm;
 	int ch;
 	int i;
@@ -500,18 +417,39 @@ static void drc_delay_input_sample_s16(struct drc_state *state,
 		npcm = MIN(remaining_samples, nbuf);
 		nbuf = audio_stream_samples_without_wrap_s16(sink, y0);
 		npcm = MIN(npcm, nbuf);
-		nfrm = npcm / nch;
+		/* Limit to a run where neither pre-delay index wraps */
+		nfrm = MIN(npcm / nch, CONFIG_DRC_MAX_PRE_DELAY_FRAMES -
+			   MAX(state->pre_delay_write_index, state->pre_delay_read_index));
+		npcm = nfrm * nch;
+		if (!nfrm) {
+			/* A frame straddles the source or sink wrap, copy it
+			 * sample by sample.
+			 */
+			for (ch = 0; ch < nch; ++ch) {
+				pd_write = (int16_t *)state->pre_delay_buffers[ch] +
+					state->pre_delay_write_index;
+				pd_read = (int16_t *)state->pre_delay_buffers[ch] +
+					state->pre_delay_read_index;
+				*pd_write = *x0;
+				*y0 = *pd_read;
+				x0 = audio_stream_wrap(source, x0 + 1);
+				y0 = audio_stream_wrap(sink, y0 + 1);
+			}
+			remaining_samples -= nch;
+			drc_pre_delay_index_inc(&state->pre_delay_write_index, 1);
+			drc_pre_delay_index_inc(&state->pre_delay_read_index, 1);
+			continue;
+		}
 		for (ch = 0; ch < nch; ++ch) {
-			pd = (int16_t *)state->pre_delay_buffers[ch];
+			pd_write = (int16_t *)state->pre_delay_buffers[ch] +
+				state->pre_delay_write_index;
+			pd_read = (int16_t *)state->pre_delay_buffers[ch] +
+				state->pre_delay_read_index;
 			x1 = x0 + ch;
 			y1 = y0 + ch;
-			pd_write_index = state->pre_delay_write_index;
-			pd_read_index = state->pre_delay_read_index;
 			for (i = 0; i < nfrm; i++) {
-				*(pd + pd_write_index) = *x1;
-				*y1 = *(pd + pd_read_index);
-				drc_pre_delay_index_inc(&pd_write_index, 1);
-				drc_pre_delay_index_inc(&pd_read_index, 1);
+				pd_write[i] = *x1;
+				*y1 = pd_read[i];
 				x1 += nch;
 				y1 += nch;
 			}
@@ -580,8 +518,8 @@ static void drc_delay_input_sample_s32(struct drc_state *state,
 {
 	int32_t *x1;
 	int32_t *y1;
-	int32_t *pd;
-	int pd_write_index, pd_read_index;
+	int32_t *pd_write;
+	int32_t *pd_read;
 	int nbuf, npcm, nfrm;
 	int ch;
 	int i;
@@ -595,18 +533,39 @@ static void drc_delay_input_sample_s32(struct drc_state *state,
 		npcm = MIN(remaining_samples, nbuf);
 		nbuf = audio_stream_samples_without_wrap_s32(sink, y0);
 		npcm = MIN(npcm, nbuf);
-		nfrm = npcm / nch;
+		/* Limit to a run where neither pre-delay index wraps */
+		nfrm = MIN(npcm / nch, CONFIG_DRC_MAX_PRE_DELAY_FRAMES -
+			   MAX(state->pre_delay_write_index, state->pre_delay_read_index));
+		npcm = nfrm * nch;
+		if (!nfrm) {
+			/* A frame straddles the source or sink wrap, copy it
+			 * sample by sample.
+			 */
+			for (ch = 0; ch < nch; ++ch) {
+				pd_write = (int32_t *)state->pre_delay_buffers[ch] +
+					state->pre_delay_write_index;
+				pd_read = (int32_t *)state->pre_delay_buffers[ch] +
+					state->pre_delay_read_index;
+				*pd_write = *x0;
+				*y0 = *pd_read;
+				x0 = audio_stream_wrap(source, x0 + 1);
+				y0 = audio_stream_wrap(sink, y0 + 1);
+			}
+			remaining_samples -= nch;
+			drc_pre_delay_index_inc(&state->pre_delay_write_index, 1);
+			drc_pre_delay_index_inc(&state->pre_delay_read_index, 1);
+			continue;
+		}
 		for (ch = 0; ch < nch; ++ch) {
-			pd = (int32_t *)state->pre_delay_buffers[ch];
+			pd_write = (int32_t *)state->pre_delay_buffers[ch] +
+				state->pre_delay_write_index;
+			pd_read = (int32_t *)state->pre_delay_buffers[ch] +
+				state->pre_delay_read_index;
 			x1 = x0 + ch;
 			y1 = y0 + ch;
-			pd_write_index = state->pre_delay_write_index;
-			pd_read_index = state->pre_delay_read_index;
 			for (i = 0; i < nfrm; i++) {
-				*(pd + pd_write_index) = *x1;
-				*y1 = *(pd + pd_read_index);
-				drc_pre_delay_index_inc(&pd_write_index, 1);
-				drc_pre_delay_index_inc(&pd_read_index, 1);
+				pd_write[i] = *x1;
+				*y1 = pd_read[i];
 				x1 += nch;
 				y1 += nch;
 			}
@@ -631,8 +590,8 @@ static void drc_delay_input_sample_s24(struct drc_state *state,
 {
 	int32_t *x1;
 	int32_t *y1;
-	int32_t *pd;
-	int pd_write_index, pd_read_index;
+	int32_t *pd_write;
+	int32_t *pd_read;
 	int nbuf, npcm, nfrm;
 	int ch;
 	int i;
@@ -646,18 +605,39 @@ static void drc_delay_input_sample_s24(struct drc_state *state,
 		npcm = MIN(remaining_samples, nbuf);
 		nbuf = audio_stream_samples_without_wrap_s24(sink, y0);
 		npcm = MIN(npcm, nbuf);
-		nfrm = npcm / nch;
+		/* Limit to a run where neither pre-delay index wraps */
+		nfrm = MIN(npcm / nch, CONFIG_DRC_MAX_PRE_DELAY_FRAMES -
+			   MAX(state->pre_delay_write_index, state->pre_delay_read_index));
+		npcm = nfrm * nch;
+		if (!nfrm) {
+			/* A frame straddles the source or sink wrap, copy it
+			 * sample by sample.
+			 */
+			for (ch = 0; ch < nch; ++ch) {
+				pd_write = (int32_t *)state->pre_delay_buffers[ch] +
+					state->pre_delay_write_index;
+				pd_read = (int32_t *)state->pre_delay_buffers[ch] +
+					state->pre_delay_read_index;
+				*pd_write = *x0 << 8;
+				*y0 = sat_int24(Q_SHIFT_RND(*pd_read, 31, 23));
+				x0 = audio_stream_wrap(source, x0 + 1);
+				y0 = audio_stream_wrap(sink, y0 + 1);
+			}
+			remaining_samples -= nch;
+			drc_pre_delay_index_inc(&state->pre_delay_write_index, 1);
+			drc_pre_delay_index_inc(&state->pre_delay_read_index, 1);
+			continue;
+		}
 		for (ch = 0; ch < nch; ++ch) {
-			pd = (int32_t *)state->pre_delay_buffers[ch];
+			pd_write = (int32_t *)state->pre_delay_buffers[ch] +
+				state->pre_delay_write_index;
+			pd_read = (int32_t *)state->pre_delay_buffers[ch] +
+				state->pre_delay_read_index;
 			x1 = x0 + ch;
 			y1 = y0 + ch;
-			pd_write_index = state->pre_delay_write_index;
-			pd_read_index = state->pre_delay_read_index;
 			for (i = 0; i < nfrm; i++) {
-				*(pd + pd_write_index) = *x1 << 8;
-				*y1 = sat_int24(Q_SHIFT_RND(*(pd + pd_read_index), 31, 23));
-				drc_pre_delay_index_inc(&pd_write_index, 1);
-				drc_pre_delay_index_inc(&pd_read_index, 1);
+				pd_write[i] = *x1 << 8;
+				*y1 = sat_int24(Q_SHIFT_RND(pd_read[i], 31, 23));
 				x1 += nch;
 				y1 += nch;
 			}
@@ -50,7 +50,7 @@ static int32_t knee_curveK(const struct sof_drc_params *p, int32_t x)
 /* Full compression curve with constant ratio after knee. Returns the ratio of
  * output and input signal.
  */
-static int32_t volume_gain(const struct sof_drc_params *p, int32_t x)
+int32_t drc_volume_gain(const struct sof_drc_params *p, int32_t x)
 {
 	const ae_f32 knee_threshold = AE_SLAI32S(p->knee_threshold, 7); /* Q8.24 -> Q1.31 */
 	const ae_f32 linear_threshold = AE_SLAI32S(p->linear_threshold, 1); /* Q2.30 -> Q1.31 */
@@ -118,7 +118,7 @@ void drc_update_detector_average(struct drc_state *state,
 			sample16_p = (int16_t *)state->pre_delay_buffers[ch] + div_start;
 			for (i = 0; i < DRC_DIVISION_FRAMES; i++) {
 				sample = (int32_t)*sample16_p << 16;
-				*abs_input_array_p = MAX(*abs_input_array_p, ABS(sample));
+				*abs_input_array_p = MAX(*abs_input_array_p, drc_abs_sat(sample));
 				abs_input_array_p++;
 				sample16_p++;
 			}
@@ -129,7 +129,7 @@ void drc_update_detector_average(struct drc_state *state,
 			sample32_p = (int32_t *)state->pre_delay_buffers[ch] + div_start;
 			for (i = 0; i < DRC_DIVISION_FRAMES; i++) {
 				sample = *sample32_p;
-				*abs_input_array_p = MAX(*abs_input_array_p, ABS(sample));
+				*abs_input_array_p = MAX(*abs_input_array_p, drc_abs_sat(sample));
 				abs_input_array_p++;
 				sample32_p++;
 			}
@@ -144,9 +144,10 @@ void drc_update_detector_average(struct drc_state *state,
 		 * enters a "knee" portion followed by the "ratio" portion. The
 		 * transition from the threshold to the knee is smooth (1st
 		 * derivative matched). The transition from the knee to the
-		 * ratio portion is smooth (1st derivative matched).
+		 * ratio portion is smooth (1st derivative matched). The curve
+		 * is interpolated from the table sampled at setup.
 		 */
-		gain = volume_gain(p, abs_input_array[i]); /* Q2.30 */
+		gain = drc_gain_lut_lookup(state, abs_input_array[i]); /* Q2.30 */
 		gain_diff = AE_SUB32(gain, detector_average); /* Q2.30 */
 		is_release = ((int32_t)gain_diff > 0);
 		if (is_release) {
@@ -293,20 +294,17 @@ void drc_compress_output(struct drc_state *state,
 			 int nch)
 {
 	const int div_start = state->pre_delay_read_index;
-	const int count = DRC_DIVISION_FRAMES >> 2;
 
+	ae_f32 total_gain[DRC_DIVISION_FRAMES]; /* Q8.24 */
 	ae_f32 x[4]; /* Q2.30 */
 	ae_f32 c, base, r, r2, r4; /* Q2.30 */
 	ae_f32 post_warp_compressor_gain;
-	ae_f32 total_gain;
 	ae_f32 tmp;
 
-	int i, j, ch, inc;
+	int i, j, ch;
 	int16_t *sample16_p; /* for s16 format case */
 	int32_t *sample32_p; /* for s24 and s32 format cases */
-	int32_t sample;
 	int32_t lshift;
-	int is_2byte = (nbyte == 2); /* otherwise is 4-bytes */
 
 	/* Exponential approach to desired gain. */
 	if (state->envelope_rate < ONE_Q30) {
@@ -322,79 +320,28 @@ void drc_compress_output(struct drc_state *state,
 		r4 = drc_mult_lshift(r2, r2, lshift);
 
 		i = 0;
-		inc = 0;
-		if (is_2byte) { /* 2 bytes per sample */
-			while (1) {
-				for (j = 0; j < 4; j++) {
-					/* Warp pre-compression gain to smooth out sharp
-					 * exponential transition points.
-					 */
-					tmp = AE_ADD32(x[j], base);
-					post_warp_compressor_gain = drc_sin_fixed(tmp); /* Q1.31 */
-
-					/* Calculate total gain using master gain. */
-					lshift = drc_get_lshift(24, 31, 24);
-					total_gain = drc_mult_lshift(p->master_linear_gain,
-								     post_warp_compressor_gain,
-								     lshift); /* Q8.24 */
-
-					/* Apply final gain. */
-					lshift = drc_get_lshift(15, 24, 15);
-					for (ch = 0; ch < nch; ch++) {
-						sample16_p =
-							(int16_t *)state->pre_delay_buffers[ch] +
-								div_start + inc;
-						sample = (int32_t)*sample16_p;
-						sample = drc_mult_lshift(sample, total_gain,
-									 lshift);
-						*sample16_p = sat_int16(sample);
-					}
-					inc++;
-				}
-
-				if (++i == count)
-					break;
-
-				lshift = drc_get_lshift(30, 30, 30);
-				for (j = 0; j < 4; j++)
-					x[j] = drc_mult_lshift(x[j], r4, lshift);
-			}
-		} else { /* 4 bytes per sample */
-			while (1) {
-				for (j = 0; j < 4; j++) {
-					/* Warp pre-compression gain to smooth out sharp
-					 * exponential transition points.
-					 */
-					tmp = AE_ADD32(x[j], base);
-					post_warp_compressor_gain = drc_sin_fixed(tmp); /* Q1.31 */
-
-					/* Calculate total gain using master gain. */
-					lshift = drc_get_lshift(24, 31, 24);
-					total_gain = drc_mult_lshift(p->master_linear_gain,
-								     post_warp_compressor_gain,
-								     lshift); /* Q8.24 */
-
-					/* Apply final gain. */
-					lshift = drc_get_lshift(31, 24, 31);
-					for (ch = 0; ch < nch; ch++) {
-						sample32_p =
-							(int32_t *)state->pre_delay_buffers[ch] +
-								div_start + inc;
-						sample = *sample32_p;
-						sample = drc_mult_lshift(sample, total_gain,
-									 lshift);
-						*sample32_p = sample;
-					}
-					inc++;
-				}
-
-				if (++i == count)
-					break;
-
-				lshift = drc_get_lshift(30, 30, 30);
-				for (j = 0; j < 4; j++)
-					x[j] = drc_mult_lshift(x[j], r4, lshift);
+		while (1) {
+			for (j = 0; j < 4; j++) {
+				/* Warp pre-compression gain to smooth out sharp
+				 * exponential transition points.
+				 */
+				tmp = AE_ADD32(x[j], base);
+				post_warp_compressor_gain = drc_sin_fixed(tmp); /* Q1.31 */
+
+				/* Calculate total gain using master gain. */
+				lshift = drc_get_lshift(24, 31, 24);
+				total_gain[i + j] = drc_mult_lshift(p->master_linear_gain,
+								    post_warp_compressor_gain,
+								    lshift); /* Q8.24 */
 			}
+
+			i += 4;
+			if (i == DRC_DIVISION_FRAMES)
+				break;
+
+			lshift = drc_get_lshift(30, 30, 30);
+			for (j = 0; j < 4; j++)
+				x[j] = drc_mult_lshift(x[j], r4, lshift);
 		}
 
 		tmp = AE_ADD32(x[3], base);
@@ -411,85 +358,54 @@ void drc_compress_output(struct drc_state *state,
 		r4 = drc_mult_lshift(r2, r2, lshift);
 
 		i = 0;
-		inc = 0;
-		if (is_2byte) { /* 2 bytes per sample */
-			while (1) {
-				for (j = 0; j < 4; j++) {
-					/* Warp pre-compression gain to smooth out sharp
-					 * exponential transition points.
-					 */
-					post_warp_compressor_gain = drc_sin_fixed(x[j]); /* Q1.31 */
-
-					/* Calculate total gain using master gain. */
-					lshift = drc_get_lshift(24, 31, 24);
-					total_gain = drc_mult_lshift(p->master_linear_gain,
-								     post_warp_compressor_gain,
-								     lshift); /* Q8.24 */
-
-					/* Apply final gain. */
-					lshift = drc_get_lshift(15, 24, 15);
-					for (ch = 0; ch < nch; ch++) {
-						sample16_p =
-							(int16_t *)state->pre_delay_buffers[ch] +
-								div_start + inc;
-						sample = (int32_t)*sample16_p;
-						sample = drc_mult_lshift(sample, total_gain,
-									 lshift);
-						*sample16_p = sat_int16(sample);
-					}
-					inc++;
-				}
-
-				if (++i == count)
-					break;
-
-				lshift = drc_get_lshift(30, 30, 30);
-				for (j = 0; j < 4; j++) {
-					tmp = drc_mult_lshift(x[j], r4, lshift);
-					x[j] = AE_MIN32(ONE_Q30, tmp);
-				}
+		while (1) {
+			for (j = 0; j < 4; j++) {
+				/* Warp pre-compression gain to smooth out sharp
+				 * exponential transition points.
+				 */
+				post_warp_compressor_gain = drc_sin_fixed(x[j]); /* Q1.31 */
+
+				/* Calculate total gain using master gain. */
+				lshift = drc_get_lshift(24, 31, 24);
+				total_gain[i + j] = drc_mult_lshift(p->master_linear_gain,
+								    post_warp_compressor_gain,
+								    lshift); /* Q8.24 */
 			}
-		} else { /* 4 bytes per sample */
-			while (1) {
-				for (j = 0; j < 4; j++) {
-					/* Warp pre-compression gain to smooth out sharp
-					 * exponential transition points.
-					 */
-					post_warp_compressor_gain = drc_sin_fixed(x[j]); /* Q1.31 */
-
-					/* Calculate total gain using master gain. */
-					lshift = drc_get_lshift(24, 31, 24);
-					total_gain = drc_mult_lshift(p->master_linear_gain,
-								     post_warp_compressor_gain,
-								     lshift); /* Q8.24 */
-
-					/* Apply final gain. */
-					lshift = drc_get_lshift(31, 24, 31);
-					for (ch = 0; ch < nch; ch++) {
-						sample32_p =
-							(int32_t *)state->pre_delay_buffers[ch] +
-								div_start + inc;
-						sample = *sample32_p;
-						sample = drc_mult_lshift(sample, total_gain,
-									 lshift);
-						*sample32_p = sample;
-					}
-					inc++;
-				}
-
-				if (++i == count)
-					break;
-
-				lshift = drc_get_lshift(30, 30, 30);
-				for (j = 0; j < 4; j++) {
-					tmp = drc_mult_lshift(x[j], r4, lshift);
-					x[j] = AE_MIN32(ONE_Q30, tmp);
-				}
+
+			i += 4;
+			if (i == DRC_DIVISION_FRAMES)
+				break;
+
+			lshift = drc_get_lshift(30, 30, 30);
+			for (j = 0; j < 4; j++) {
+				tmp = drc_mult_lshift(x[j], r4, lshift);
+				x[j] = AE_MIN32(ONE_Q30, tmp);
 			}
 		}
 
 		state->compressor_gain = x[3];
 	}
+
+	/* Apply final gain. The division is contiguous in the pre-delay buffers
+	 * so each channel is a plain vector product with the gain array.
+	 */
+	if (nbyte == 2) { /* 2 bytes per sample */
+		lshift = drc_get_lshift(15, 24, 15);
+		for (ch = 0; ch < nch; ch++) {
+			sample16_p = (int16_t *)state->pre_delay_buffers[ch] + div_start;
+			for (i = 0; i < DRC_DIVISION_FRAMES; i++)
+				sample16_p[i] = sat_int16(drc_mult_lshift(sample16_p[i],
+									  total_gain[i], lshift));
+		}
+	} else { /* 4 bytes per sample */
+		lshift = drc_get_lshift(31, 24, 31);
+		for (ch = 0; ch < nch; ch++) {
+			sample32_p = (int32_t *)state->pre_delay_buffers[ch] + div_start;
+			for (i = 0; i < DRC_DIVISION_FRAMES; i++)
+				sample32_p[i] = drc_mult_lshift(sample32_p[i], total_gain[i],
+								lshift);
+		}
+	}
 }
 
 #endif /* DRC_HIFI3 */
@@ -52,30 +52,43 @@ struct comp_data {
 	int32_t *iir_delay;			/**< pointer to allocated RAM */
 	size_t iir_delay_size;			/**< allocated size */
 	eq_iir_func eq_iir_func;		/**< processing function */
+	int32_t block[EQ_IIR_BLOCK_FRAMES * PLATFORM_MAX_CHANNELS]; /**< Q1.31 block */
 };
 
-#if CONFIG_FORMAT_S16LE
-
 /*
  * EQ IIR algorithm code
  */
 
+/* Filter an interleaved Q1.31 block, adjacent channel pairs are run
+ * together with the two lane version of the biquad cascade.
+ */
+static void eq_iir_block(struct comp_data *cd, const int32_t *x, int32_t *y,
+			 int frames, int nch)
+{
+	int i;
+
+	for (i = 0; i + 1 < nch; i += 2)
+		iir_df1_block_x2(&cd->iir[i], &cd->iir[i + 1], x + i, y + i, frames, nch);
+
+	if (i < nch)
+		iir_df1_block(&cd->iir[i], x + i, y + i, frames, nch);
+}
+
+#if CONFIG_FORMAT_S16LE
+
 static void eq_iir_s16_default(struct processing_module *mod, struct input_stream_buffer *bsource,
 			       struct output_stream_buffer *bsink, uint32_t frames)
 {
 	struct comp_data *cd = module_get_private_data(mod);
 	struct audio_stream __sparse_cache *source = bsource->data;
 	struct audio_stream __sparse_cache *sink = bsink->data;
-	struct iir_state_df1 *filter;
-	int16_t *x0;
-	int16_t *y0;
+	int32_t *buf = cd->block;
 	int16_t *x;
 	int16_t *y;
 	int nmax;
 	int n1;
 	int n2;
 	int i;
-	int j;
 	int n;
 	const int nch = audio_stream_get_channels(source);
 	const int samples = frames * nch;
@@ -89,16 +102,14 @@ static void eq_iir_s16_default(struct processing_module *mod, struct input_strea
 		n2 = audio_stream_bytes_without_wrap(sink, y) >> 1;
 		n = MIN(n1, n2);
 		n = MIN(n, nmax);
-		for (i = 0; i < nch; i++) {
-			x0 = x + i;
-			y0 = y + i;
-			filter = &cd->iir[i];
-			for (j = 0; j < n; j += nch) {
-				*y0 = iir_df1_s16(filter, *x0);
-				x0 += nch;
-				y0 += nch;
-			}
-		}
+		n = MIN(n, EQ_IIR_BLOCK_FRAMES * nch);
+		for (i = 0; i < n; i++)
+			buf[i] = (int32_t)x[i] << 16;
+
+		eq_iir_block(cd, buf, buf, n / nch, nch);
+		for (i = 0; i < n; i++)
+			y[i] = sat_int16(Q_SHIFT_RND(buf[i], 31, 15));
+
 		processed += n;
 		x = audio_stream_wrap(source, x + n);
 		y = audio_stream_wrap(sink, y + n);
@@ -114,16 +125,13 @@ static void eq_iir_s24_default(struct processing_module *mod, struct input_strea
 	struct comp_data *cd = module_get_private_data(mod);
 	struct audio_stream __sparse_cache *source = bsource->data;
 	struct audio_stream __sparse_cache *sink = bsink->data;
-	struct iir_state_df1 *filter;
-	int32_t *x0;
-	int32_t *y0;
+	int32_t *buf = cd->block;
 	int32_t *x;
 	int32_t *y;
 	int nmax;
 	int n1;
 	int n2;
 	int i;
-	int j;
 	int n;
 	const int nch = audio_stream_get_channels(source);
 	const int samples = frames * nch;
@@ -137,16 +145,14 @@ static void eq_iir_s24_default(struct processing_module *mod, struct input_strea
 		n2 = audio_stream_bytes_without_wrap(sink, y) >> 2;
 		n = MIN(n1, n2);
 		n = MIN(n, nmax);
-		for (i = 0; i < nch; i++) {
-			x0 = x + i;
-			y0 = y + i;
-			filter = &cd->iir[i];
-			for (j = 0; j < n; j += nch) {
-				*y0 = iir_df1_s24(filter, *x0);
-				x0 += nch;
-				y0 += nch;
-			}
-		}
+		n = MIN(n, EQ_IIR_BLOCK_FRAMES * nch);
+		for (i = 0; i < n; i++)
+			buf[i] = x[i] << 8;
+
+		eq_iir_block(cd, buf, buf, n / nch, nch);
+		for (i = 0; i < n; i++)
+			y[i] = sat_int24(Q_SHIFT_RND(buf[i], 31, 23));
+
 		processed += n;
 		x = audio_stream_wrap(source, x + n);
 		y = audio_stream_wrap(sink, y + n);
@@ -162,16 +168,11 @@ static void eq_iir_s32_default(struct processing_module *mod, struct input_strea
 	struct comp_data *cd = module_get_private_data(mod);
 	struct audio_stream __sparse_cache *source = bsource->data;
 	struct audio_stream __sparse_cache *sink = bsink->data;
-	struct iir_state_df1 *filter;
-	int32_t *x0;
-	int32_t *y0;
 	int32_t *x;
 	int32_t *y;
 	int nmax;
 	int n1;
 	int n2;
-	int i;
-	int j;
 	int n;
 	const int nch = audio_stream_get_channels(source);
 	const int samples = frames * nch;
@@ -185,16 +186,7 @@ static void eq_iir_s32_default(struct processing_module *mod, struct input_strea
 		n2 = audio_stream_bytes_without_wrap(sink, y) >> 2;
 		n = MIN(n1, n2);
 		n = MIN(n, nmax);
-		for (i = 0; i < nch; i++) {
-			x0 = x + i;
-			y0 = y + i;
-			filter = &cd->iir[i];
-			for (j = 0; j < n; j += nch) {
-				*y0 = iir_df1(filter, *x0);
-				x0 += nch;
-				y0 += nch;
-			}
-		}
+		eq_iir_block(cd, x, y, n / nch, nch);
 		processed += n;
 		x = audio_stream_wrap(source, x + n);
 		y = audio_stream_wrap(sink, y + n);
@@ -211,16 +203,13 @@ static void eq_iir_s32_16_default(struct processing_module *mod,
 	struct comp_data *cd = module_get_private_data(mod);
 	struct audio_stream __sparse_cache *source = bsource->data;
 	struct audio_stream __sparse_cache *sink = bsink->data;
-	struct iir_state_df1 *filter;
-	int32_t *x0;
-	int16_t *y0;
+	int32_t *buf = cd->block;
 	int32_t *x;
 	int16_t *y;
 	int nmax;
 	int n1;
 	int n2;
 	int i;
-	int j;
 	int n;
 	const int nch = audio_stream_get_channels(source);
 	const int samples = frames * nch;
@@ -230,20 +219,15 @@ static void eq_iir_s32_16_default(struct processing_module *mod,
 	y = audio_stream_get_wptr(sink);
 	while (processed < samples) {
 		nmax = samples - processed;
-		n1 = audio_stream_bytes_without_wrap(source, x) >> 2; /* divide 4 */
-		n2 = audio_stream_bytes_without_wrap(sink, y) >> 1; /* divide 2 */
+		n1 = audio_stream_bytes_without_wrap(source, x) >> 2;
+		n2 = audio_stream_bytes_without_wrap(sink, y) >> 1;
 		n = MIN(n1, n2);
 		n = MIN(n, nmax);
-		for (i = 0; i < nch; i++) {
-			x0 = x + i;
-			y0 = y + i;
-			filter = &cd->iir[i];
-			for (j = 0; j < n; j += nch) {
-				*y0 = iir_df1_s32_s16(filter, *x0);
-				x0 += nch;
-				y0 += nch;
-			}
-		}
+		n = MIN(n, EQ_IIR_BLOCK_FRAMES * nch);
+		eq_iir_block(cd, x, buf, n / nch, nch);
+		for (i = 0; i < n; i++)
+			y[i] = sat_int16(Q_SHIFT_RND(buf[i], 31, 15));
+
 		processed += n;
 		x = audio_stream_wrap(source, x + n);
 		y = audio_stream_wrap(sink, y + n);
@@ -259,16 +243,13 @@ static void eq_iir_s32_24_default(struct processing_module *mod,
 	struct comp_data *cd = module_get_private_data(mod);
 	struct audio_stream __sparse_cache *source = bsource->data;
 	struct audio_stream __sparse_cache *sink = bsink->data;
-	struct iir_state_df1 *filter;
-	int32_t *x0;
-	int32_t *y0;
+	int32_t *buf = cd->block;
 	int32_t *x;
 	int32_t *y;
 	int nmax;
 	int n1;
 	int n2;
 	int i;
-	int j;
 	int n;
 	const int nch = audio_stream_get_channels(source);
 	const int samples = frames * nch;
@@ -282,16 +263,11 @@ static void eq_iir_s32_24_default(struct processing_module *mod,
 		n2 = audio_stream_bytes_without_wrap(sink, y) >> 2;
 		n = MIN(n1, n2);
 		n = MIN(n, nmax);
-		for (i = 0; i < nch; i++) {
-			x0 = x + i;
-			y0 = y + i;
-			filter = &cd->iir[i];
-			for (j = 0; j < n; j += nch) {
-				*y0 = iir_df1_s32_s24(filter, *x0);
-				x0 += nch;
-				y0 += nch;
-			}
-		}
+		n = MIN(n, EQ_IIR_BLOCK_FRAMES * nch);
+		eq_iir_block(cd, x, buf, n / nch, nch);
+		for (i = 0; i < n; i++)
+			y[i] = sat_int24(Q_SHIFT_RND(buf[i], 31, 23));
+
 		processed += n;
 		x = audio_stream_wrap(source, x + n);
 		y = audio_stream_wrap(sink, y + n);
@@ -241,7 +241,10 @@ void host_common_update(struct host_data *hd, struct comp_dev *dev, uint32_t byt
 	if (dev->direction == SOF_IPC_STREAM_PLAYBACK) {
 		source = buffer_acquire(hd->dma_buffer);
 		sink = buffer_acquire(hd->local_buffer);
-		ret = dma_buffer_copy_from(source, sink, hd->process, bytes);
+		if (hd->fused_process)
+			ret = host_dma_buffer_copy_fused(hd, source, sink, bytes);
+		else
+			ret = dma_buffer_copy_from(source, sink, hd->process, bytes);
 	} else {
 		source = buffer_acquire(hd->local_buffer);
 		sink = buffer_acquire(hd->dma_buffer);
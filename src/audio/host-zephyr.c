@@ -250,7 +250,10 @@ void host_common_update(struct host_data *hd, struct comp_dev *dev, uint32_t byt
 	if (hd->ipc_host.direction == SOF_IPC_STREAM_PLAYBACK) {
 		source = buffer_acquire(hd->dma_buffer);
 		sink = buffer_acquire(hd->local_buffer);
-		ret = dma_buffer_copy_from(source, sink, hd->process, bytes);
+		if (hd->fused_process)
+			ret = host_dma_buffer_copy_fused(hd, source, sink, bytes);
+		else
+			ret = dma_buffer_copy_from(source, sink, hd->process, bytes);
 	} else {
 		source = buffer_acquire(hd->local_buffer);
 		sink = buffer_acquire(hd->dma_buffer);
@@ -414,6 +417,22 @@ static uint32_t host_get_copy_bytes_normal(struct host_data *hd, struct comp_dev
 
 	dma_copy_bytes = MIN(avail_samples, free_samples) * dma_sample_bytes;
 
+#if CONFIG_HOST_DMA_BATCH
+	/* in batch mode the local buffer runs across several periods and
+	 * data is moved in one burst only when its free space for playback
+	 * or its available data for capture crosses the watermark
+	 */
+	if (hd->batch_bytes) {
+		if ((dev->direction == SOF_IPC_STREAM_PLAYBACK ?
+		     audio_stream_get_free_bytes(&buffer_c->stream) :
+		     audio_stream_get_avail_bytes(&buffer_c->stream)) < hd->batch_bytes)
+			dma_copy_bytes = 0;
+
+		buffer_release(buffer_c);
+		return ALIGN_DOWN(dma_copy_bytes, hd->dma_copy_align);
+	}
+#endif
+
 	/* limit bytes per copy to one period for the whole pipeline
 	 * in order to avoid high load spike
 	 * if FAST_MODE is enabled, then one period limitation is omitted
@@ -982,6 +1001,23 @@ int host_common_params(struct host_data *hd, struct comp_dev *dev,
 	hd->copy = hd->copy_type == COMP_COPY_ONE_SHOT ? host_copy_one_shot :
 		host_copy_normal;
 
+#if CONFIG_HOST_DMA_BATCH
+	/* The batch must leave a period in the local buffer for the
+	 * pipeline and two periods in the DMA buffer for the host side.
+	 */
+	hd->batch_bytes = MIN(CONFIG_HOST_DMA_BATCH_WATERMARK * hd->period_bytes,
+			      audio_stream_get_size(&host_buf_c->stream) - hd->period_bytes);
+	hd->batch_bytes = MIN(hd->batch_bytes, buffer_size - 2 * hd->period_bytes);
+	if (hd->copy_type == COMP_COPY_ONE_SHOT ||
+	    hd->ipc_host.feature_mask & BIT(IPC4_COPIER_FAST_MODE) ||
+	    audio_stream_get_size(&host_buf_c->stream) < 3 * hd->period_bytes ||
+	    buffer_size < 4 * hd->period_bytes ||
+	    hd->batch_bytes < 2 * hd->period_bytes)
+		hd->batch_bytes = 0;
+
+	comp_info(dev, "host_params(): batch bytes %u", hd->batch_bytes);
+#endif
+
 out:
 	buffer_release(host_buf_c);
 	return err;
@@ -135,6 +135,16 @@ static void kpb_buffer_samples(const struct audio_stream __sparse_cache *source,
 			       int offset, void *sink, size_t size,
 			       size_t sample_width);
 static void kpb_reset_history_buffer(struct history_buffer *buff);
+#if CONFIG_KPB_HISTORY_COMPRESSION
+static void kpb_compress_samples(struct history_buffer *hb,
+				 const struct audio_stream __sparse_cache *source,
+				 int offset, int16_t *sink, size_t size,
+				 size_t sample_width);
+static void kpb_decompress_samples(const struct history_buffer *hb,
+				   const int16_t *source,
+				   struct audio_stream __sparse_cache *sink,
+				   size_t size);
+#endif
 static inline bool validate_host_params(struct comp_dev *dev,
 					size_t host_period_size,
 					size_t host_buffer_size,
@@ -147,6 +157,29 @@ static uint64_t kpb_task_deadline(void *data)
 	return SOF_TASK_DEADLINE_ALMOST_IDLE;
 }
 
+static inline bool kpb_is_history_compressed(const struct history_buffer *hb)
+{
+#if CONFIG_KPB_HISTORY_COMPRESSION
+	return hb->exponents;
+#else
+	return false;
+#endif
+}
+
+/* History bytes of samples to bytes in history buffer memory */
+static inline size_t kpb_history_to_storage(const struct history_buffer *hb,
+					    size_t size)
+{
+	return kpb_is_history_compressed(hb) ? size >> 1 : size;
+}
+
+/* Bytes in history buffer memory to history bytes of samples */
+static inline size_t kpb_storage_to_history(const struct history_buffer *hb,
+					    size_t size)
+{
+	return kpb_is_history_compressed(hb) ? size << 1 : size;
+}
+
 #if CONFIG_AMS
 
 /* Key-phrase detected message*/
@@ -495,7 +528,6 @@ static struct comp_dev *kpb_new(const struct comp_driver *drv,
 			       0); /* no flags */
 
 	/* Init basic component data */
-	kpb->hd.c_hb = NULL;
 	kpb->kpb_no_of_clients = 0;
 	kpb->state_log = 0;
 
@@ -515,133 +547,79 @@ static struct comp_dev *kpb_new(const struct comp_driver *drv,
 /**
  * \brief Allocate history buffer.
  * \param[in] kpb - KPB component data pointer.
+ * \param[in] hb_size_req - requested size in bytes.
  *
- * \return: none.
+ * \return: allocated size in bytes, zero on failure.
  */
 static size_t kpb_allocate_history_buffer(struct comp_data *kpb,
 					  size_t hb_size_req)
 {
-	struct history_buffer *hb;
-	struct history_buffer *new_hb = NULL;
-	/*! Total allocation size */
-	size_t hb_size = hb_size_req;
-	/*! Current allocation size */
-	size_t ca_size = hb_size;
+	struct history_buffer *hb = &kpb->hd.hb;
 	/*! Memory caps priorites for history buffer */
 	int hb_mcp[KPB_NO_OF_MEM_POOLS] = {SOF_MEM_CAPS_LP, SOF_MEM_CAPS_HP,
 					   SOF_MEM_CAPS_RAM };
 	void *new_mem_block = NULL;
-	size_t temp_ca_size;
-	int i = 0;
-	size_t allocated_size = 0;
+	size_t data_size = hb_size_req;
+	size_t exp_size = 0;
+	int i;
 
 	comp_cl_info(&comp_kpb, "kpb_allocate_history_buffer()");
 
-	/* Initialize history buffer */
-	kpb->hd.c_hb = rzalloc(SOF_MEM_ZONE_RUNTIME, 0, SOF_MEM_CAPS_RAM,
-			       sizeof(struct history_buffer));
-	if (!kpb->hd.c_hb)
-		return 0;
-	kpb->hd.c_hb->next = kpb->hd.c_hb;
-	kpb->hd.c_hb->prev = kpb->hd.c_hb;
-	hb = kpb->hd.c_hb;
-
-	/* Allocate history buffer/s. KPB history buffer has a size of
-	 * KPB_MAX_BUFFER_SIZE, since there is no single memory block
-	 * that big, we need to allocate couple smaller blocks which
-	 * linked together will form history buffer.
+#if CONFIG_KPB_HISTORY_COMPRESSION
+	/* 24 and 32 bit samples are stored as 16 bit mantissas, followed
+	 * by an exponent byte per block of samples.
 	 */
-	while (hb_size > 0 && i < ARRAY_SIZE(hb_mcp)) {
-		/* Try to allocate ca_size (current allocation size). At first
-		 * attempt it will be equal to hb_size (history buffer size).
-		 */
-		new_mem_block = rballoc(0, hb_mcp[i], ca_size);
+	if (kpb->config.sampling_width != 16) {
+		data_size = hb_size_req >> 1;
+		exp_size = KPB_BYTES_TO_S32_SAMPLES(hb_size_req) / KPB_BFP_BLOCK_SAMPLES;
+	}
+#endif
 
-		if (new_mem_block) {
-			/* We managed to allocate a block of ca_size.
-			 * Now we initialize it.
-			 */
-			comp_cl_info(&comp_kpb, "kpb new memory block: %d",
-				     ca_size);
-			allocated_size += ca_size;
-			hb->start_addr = new_mem_block;
-			hb->end_addr = (char *)new_mem_block +
-				ca_size;
-			hb->w_ptr = new_mem_block;
-			hb->r_ptr = new_mem_block;
-			hb->state = KPB_BUFFER_FREE;
-			hb_size -= ca_size;
-			hb->next = kpb->hd.c_hb;
-			/* Do we need another buffer? */
-			if (hb_size > 0) {
-				/* Yes, we still need at least one more buffer.
-				 * Let's first create new container for it.
-				 */
-				new_hb = rzalloc(SOF_MEM_ZONE_RUNTIME, 0,
-						 SOF_MEM_CAPS_RAM,
-						 sizeof(struct history_buffer));
-				if (!new_hb)
-					return 0;
-				hb->next = new_hb;
-				new_hb->next = kpb->hd.c_hb;
-				new_hb->state = KPB_BUFFER_OFF;
-				new_hb->prev = hb;
-				hb = new_hb;
-				kpb->hd.c_hb->prev = new_hb;
-				ca_size = hb_size;
-				i++;
-			}
-		} else {
-			/* We've failed to allocate ca_size of that hb_mcp
-			 * let's try again with some smaller size.
-			 * NOTE! If we decrement by some small value,
-			 * the allocation will take significant time.
-			 * However, bigger values like
-			 * HEAP_HP_BUFFER_BLOCK_SIZE will result in lower
-			 * accuracy of allocation.
-			 */
-			temp_ca_size = ca_size - KPB_ALLOCATION_STEP;
-			ca_size = (ca_size < temp_ca_size) ? 0 : temp_ca_size;
-			if (ca_size == 0) {
-				ca_size = hb_size;
-				i++;
-			}
-			continue;
-		}
+	/* The history is kept in a single ring so that draining can copy
+	 * it to the host sink in at most two contiguous blocks. Try the
+	 * memory pools in order of preference.
+	 */
+	for (i = 0; i < ARRAY_SIZE(hb_mcp) && !new_mem_block; i++)
+		new_mem_block = rballoc(0, hb_mcp[i], data_size + exp_size);
+
+	if (!new_mem_block) {
+		comp_cl_err(&comp_kpb, "kpb_allocate_history_buffer(): failed to allocate %d bytes",
+			    data_size + exp_size);
+		return 0;
 	}
 
+	hb->start_addr = new_mem_block;
+	hb->end_addr = (char *)new_mem_block + data_size;
+	hb->w_ptr = new_mem_block;
+	hb->r_ptr = new_mem_block;
+#if CONFIG_KPB_HISTORY_COMPRESSION
+	hb->exponents = exp_size ? hb->end_addr : NULL;
+#endif
+
 	comp_cl_info(&comp_kpb, "kpb_allocate_history_buffer(): allocated %d bytes",
-		     allocated_size);
+		     data_size + exp_size);
 
-	return allocated_size;
+	return hb_size_req;
 }
 
 /**
- * \brief Reclaim memory of a history buffer.
- * \param[in] buff - pointer to current history buffer.
+ * \brief Reclaim memory of the history buffer.
+ * \param[in] buff - pointer to history buffer.
  *
  * \return none.
  */
 static void kpb_free_history_buffer(struct history_buffer *buff)
 {
-	struct history_buffer *_buff;
-	struct history_buffer *first_buff = buff;
-
 	comp_cl_info(&comp_kpb, "kpb_free_history_buffer()");
 
-	if (!buff)
-		return;
-
-	/* Free history buffer/s */
-	do {
-		/* First reclaim HB internal memory, then HB itself */
-		if (buff->start_addr)
-			rfree(buff->start_addr);
-
-		_buff = buff->next;
-		rfree(buff);
-		buff = _buff;
-	} while (buff && buff != first_buff);
+	rfree(buff->start_addr);
+	buff->start_addr = NULL;
+	buff->end_addr = NULL;
+	buff->w_ptr = NULL;
+	buff->r_ptr = NULL;
+#if CONFIG_KPB_HISTORY_COMPRESSION
+	buff->exponents = NULL;
+#endif
 }
 
 /**
@@ -670,8 +648,7 @@ static void kpb_free(struct comp_dev *dev)
 #endif/* CONFIG_AMS */
 
 	/* Reclaim memory occupied by history buffer */
-	kpb_free_history_buffer(kpb->hd.c_hb);
-	kpb->hd.c_hb = NULL;
+	kpb_free_history_buffer(&kpb->hd.hb);
 	kpb->hd.buffer_size = 0;
 
 	/* remove scheduling */
@@ -792,13 +769,18 @@ static int kpb_prepare(struct comp_dev *dev)
 	kpb->kpb_no_of_clients = 0;
 	kpb->hd.buffered = 0;
 
-	if (kpb->hd.c_hb && kpb->hd.buffer_size < hb_size_req) {
-		/* Host params has changed, we need to allocate new buffer */
-		kpb_free_history_buffer(kpb->hd.c_hb);
-		kpb->hd.c_hb = NULL;
+	if (kpb->hd.hb.start_addr &&
+	    (kpb->hd.buffer_size < hb_size_req ||
+	     kpb_is_history_compressed(&kpb->hd.hb) !=
+	     (IS_ENABLED(CONFIG_KPB_HISTORY_COMPRESSION) &&
+	      kpb->config.sampling_width != 16))) {
+		/* Host params or format has changed, we need to allocate
+		 * new buffer.
+		 */
+		kpb_free_history_buffer(&kpb->hd.hb);
 	}
 
-	if (!kpb->hd.c_hb) {
+	if (!kpb->hd.hb.start_addr) {
 		/* Allocate history buffer */
 		kpb->hd.buffer_size = kpb_allocate_history_buffer(kpb,
 								  hb_size_req);
@@ -806,14 +788,13 @@ static int kpb_prepare(struct comp_dev *dev)
 		/* Have we allocated what we requested? */
 		if (kpb->hd.buffer_size < hb_size_req) {
 			comp_cl_err(&comp_kpb, "kpb_prepare(): failed to allocate space for KPB buffer");
-			kpb_free_history_buffer(kpb->hd.c_hb);
-			kpb->hd.c_hb = NULL;
+			kpb_free_history_buffer(&kpb->hd.hb);
 			kpb->hd.buffer_size = 0;
 			return -EINVAL;
 		}
 	}
 	/* Init history buffer */
-	kpb_reset_history_buffer(kpb->hd.c_hb);
+	kpb_reset_history_buffer(&kpb->hd.hb);
 	kpb->hd.free = kpb->hd.buffer_size;
 
 	/* Initialize clients data */
@@ -834,8 +815,8 @@ static int kpb_prepare(struct comp_dev *dev)
 #endif /* CONFIG_AMS */
 
 	if (ret < 0) {
-		kpb_free_history_buffer(kpb->hd.c_hb);
-		kpb->hd.c_hb = NULL;
+		kpb_free_history_buffer(&kpb->hd.hb);
+		kpb->hd.buffer_size = 0;
 		return -ENOMEM;
 	}
 
@@ -968,12 +949,8 @@ static int kpb_reset(struct comp_dev *dev)
 			kpb->clients[i].r_ptr = NULL;
 		}
 
-		if (kpb->hd.c_hb) {
-			/* Reset history buffer - zero its data, reset pointers
-			 * and states.
-			 */
-			kpb_reset_history_buffer(kpb->hd.c_hb);
-		}
+		/* Reset history buffer - zero its data and reset pointers */
+		kpb_reset_history_buffer(&kpb->hd.hb);
 
 #ifndef CONFIG_AMS
 		/* Unregister KPB from notifications */
@@ -1371,7 +1348,8 @@ static int kpb_buffer_data(struct comp_dev *dev,
 	size_t size_to_copy = size;
 	size_t space_avail;
 	struct comp_data *kpb = comp_get_drvdata(dev);
-	struct history_buffer *buff = kpb->hd.c_hb;
+	struct history_buffer *buff = &kpb->hd.hb;
+	size_t size_now;
 	uint32_t offset = 0;
 	uint64_t timeout = 0;
 	uint64_t current_time;
@@ -1423,59 +1401,24 @@ static int kpb_buffer_data(struct comp_dev *dev,
 			return -ETIME;
 		}
 
-		/* Check how much space there is in current write buffer */
-		space_avail = (uintptr_t)buff->end_addr - (uintptr_t)buff->w_ptr;
-
-		if (size_to_copy > space_avail) {
-			/* We have more data to copy than available space
-			 * in this buffer, copy what's available and continue
-			 * with next buffer.
-			 */
-			kpb_buffer_samples(&source->stream, offset, buff->w_ptr,
-					   space_avail, sample_width);
-			/* Update write pointer & requested copy size */
-			buff->w_ptr = (char *)buff->w_ptr + space_avail;
-			size_to_copy = size_to_copy - space_avail;
-			/* Update read pointer's offset before continuing
-			 * with next buffer.
-			 */
-			offset += space_avail;
-		} else {
-			/* Requested size is smaller or equal to the space
-			 * available in this buffer. In this scenario simply
-			 * copy what was requested.
-			 */
+		/* Copy up to the end of the ring, then continue from its start */
+		space_avail = kpb_storage_to_history(buff, (uintptr_t)buff->end_addr -
+						     (uintptr_t)buff->w_ptr);
+		size_now = MIN(size_to_copy, space_avail);
+#if CONFIG_KPB_HISTORY_COMPRESSION
+		if (kpb_is_history_compressed(buff))
+			kpb_compress_samples(buff, &source->stream, offset,
+					     buff->w_ptr, size_now, sample_width);
+		else
+#endif
 			kpb_buffer_samples(&source->stream, offset, buff->w_ptr,
-					   size_to_copy, sample_width);
-			/* Update write pointer & requested copy size */
-			buff->w_ptr = (char *)buff->w_ptr + size_to_copy;
-			/* Reset requested copy size */
-			size_to_copy = 0;
-		}
-		/* Have we filled whole buffer? */
-		if (buff->w_ptr == buff->end_addr) {
-			/* Reset write pointer back to the beginning
-			 * of the buffer.
-			 */
+					   size_now, sample_width);
+		buff->w_ptr = (char *)buff->w_ptr + kpb_history_to_storage(buff, size_now);
+		if (buff->w_ptr == buff->end_addr)
 			buff->w_ptr = buff->start_addr;
-			/* If we have more buffers use them */
-			if (buff->next && buff->next != buff) {
-				/* Mark current buffer FULL */
-				buff->state = KPB_BUFFER_FULL;
-				/* Use next buffer available on the list
-				 * of buffers.
-				 */
-				buff = buff->next;
-				/* Update also component container,
-				 * so next time we enter buffering function
-				 * we will know right away what is the current
-				 * write buffer
-				 */
-				kpb->hd.c_hb = buff;
-			}
-			/* Mark buffer as FREE */
-			buff->state = KPB_BUFFER_FREE;
-		}
+
+		size_to_copy -= size_now;
+		offset += size_now;
 	}
 
 	kpb_change_state(kpb, state_preserved);
@@ -1579,10 +1522,8 @@ static void kpb_init_draining(struct comp_dev *dev, struct kpb_client *cli)
 	size_t drain_req = cli->drain_req * kpb->config.channels *
 			       (kpb->config.sampling_freq / 1000) *
 			       (KPB_SAMPLE_CONTAINER_SIZE(sample_width) / 8);
-	struct history_buffer *buff = kpb->hd.c_hb;
-	struct history_buffer *first_buff = buff;
-	size_t buffered = 0;
-	size_t local_buffered;
+	struct history_buffer *buff = &kpb->hd.hb;
+	size_t drain_bytes;
 	size_t drain_interval;
 	size_t host_period_size = kpb->host_period_size;
 	size_t bytes_per_ms = KPB_SAMPLES_PER_MS *
@@ -1601,7 +1542,7 @@ static void kpb_init_draining(struct comp_dev *dev, struct kpb_client *cli)
 	} else if (!is_sink_ready) {
 		comp_err(dev, "kpb_init_draining(): sink not ready for draining");
 	} else if (kpb->hd.buffered < drain_req ||
-		   cli->drain_req > KPB_MAX_DRAINING_REQ) {
+		   cli->drain_req > KPB_MAX_DRAINING_REQ(kpb->config.sampling_width)) {
 		comp_cl_err(&comp_kpb, "kpb_init_draining(): not enough data in history buffer");
 	} else {
 		/* Draining accepted, find proper buffer to start reading
@@ -1618,54 +1559,14 @@ static void kpb_init_draining(struct comp_dev *dev, struct kpb_client *cli)
 		 */
 		kpb->hd.free = kpb->hd.buffer_size - drain_req;
 
-		/* Find buffer to start draining from */
-		do {
-			/* Calculate how much data we have stored in
-			 * current buffer.
-			 */
-			buff->r_ptr = buff->start_addr;
-			if (buff->state == KPB_BUFFER_FREE) {
-				local_buffered = (uintptr_t)buff->w_ptr -
-						 (uintptr_t)buff->start_addr;
-				buffered += local_buffered;
-			} else if (buff->state == KPB_BUFFER_FULL) {
-				local_buffered = (uintptr_t)buff->end_addr -
-						 (uintptr_t)buff->start_addr;
-				buffered += local_buffered;
-			} else {
-				comp_err(dev, "kpb_init_draining(): incorrect buffer label");
-			}
-			/* Check if this is already sufficient to start draining
-			 * if not, go to previous buffer and continue
-			 * calculations.
-			 */
-			if (drain_req > buffered) {
-				if (buff->prev == first_buff) {
-					/* We went full circle and still don't
-					 * have sufficient data for draining.
-					 * That means we need to look up the
-					 * first buffer again. Our read pointer
-					 * is somewhere between write pointer
-					 * and buffer's end address.
-					 */
-					buff = buff->prev;
-					buffered += (uintptr_t)buff->end_addr -
-						    (uintptr_t)buff->w_ptr;
-					buff->r_ptr = (char *)buff->w_ptr +
-						      (buffered - drain_req);
-					break;
-				}
-				buff = buff->prev;
-			} else if (drain_req == buffered) {
-				buff->r_ptr = buff->start_addr;
-				break;
-			} else {
-				buff->r_ptr = (char *)buff->start_addr +
-					      (buffered - drain_req);
-				break;
-			}
-
-		} while (buff != first_buff);
+		/* Draining starts drain_req bytes behind the write pointer */
+		drain_bytes = kpb_history_to_storage(buff, drain_req);
+		if ((uintptr_t)buff->w_ptr - (uintptr_t)buff->start_addr >= drain_bytes)
+			buff->r_ptr = (char *)buff->w_ptr - drain_bytes;
+		else
+			buff->r_ptr = (char *)buff->end_addr -
+				      (drain_bytes - ((uintptr_t)buff->w_ptr -
+						      (uintptr_t)buff->start_addr));
 
 		kpb_unlock(kpb);
 
@@ -1735,7 +1636,6 @@ static enum task_state kpb_draining_task(void *arg)
 	size_t sample_width = draining_data->sample_width;
 	size_t size_to_read;
 	size_t size_to_copy;
-	bool move_buffer = false;
 	uint32_t drained = 0;
 	uint64_t draining_time_start;
 	uint64_t draining_time_end;
@@ -1783,38 +1683,34 @@ static enum task_state kpb_draining_task(void *arg)
 			period_copy_start = sof_cycle_get_64();
 		}
 
-		size_to_read = (uintptr_t)buff->end_addr - (uintptr_t)buff->r_ptr;
-
-		if (size_to_read > audio_stream_get_free_bytes(&sink->stream)) {
-			if (audio_stream_get_free_bytes(&sink->stream) >= drain_req)
-				size_to_copy = drain_req;
-			else
-				size_to_copy = audio_stream_get_free_bytes(&sink->stream);
-		} else {
-			if (size_to_read > drain_req) {
-				size_to_copy = drain_req;
-			} else {
-				size_to_copy = size_to_read;
-				move_buffer = true;
-			}
-		}
+		/* Copy straight from the ring to the host sink, up to the end
+		 * of the ring per iteration.
+		 */
+		size_to_read = kpb_storage_to_history(buff, (uintptr_t)buff->end_addr -
+						      (uintptr_t)buff->r_ptr);
+		size_to_copy = MIN(size_to_read, drain_req);
+		size_to_copy = MIN(size_to_copy, audio_stream_get_free_bytes(&sink->stream));
+
+#if CONFIG_KPB_HISTORY_COMPRESSION
+		if (kpb_is_history_compressed(buff))
+			kpb_decompress_samples(buff, buff->r_ptr, &sink->stream,
+					       size_to_copy);
+		else
+#endif
+			kpb_drain_samples(buff->r_ptr, &sink->stream, size_to_copy,
+					  sample_width);
 
-		kpb_drain_samples(buff->r_ptr, &sink->stream, size_to_copy,
-				  sample_width);
+		buff->r_ptr = (char *)buff->r_ptr +
+			      (uint32_t)kpb_history_to_storage(buff, size_to_copy);
+		if (buff->r_ptr == buff->end_addr)
+			buff->r_ptr = buff->start_addr;
 
-		buff->r_ptr = (char *)buff->r_ptr + (uint32_t)size_to_copy;
 		drain_req -= size_to_copy;
 		drained += size_to_copy;
 		period_bytes += size_to_copy;
 		kpb->hd.free += MIN(kpb->hd.buffer_size -
 				    kpb->hd.free, size_to_copy);
 
-		if (move_buffer) {
-			buff->r_ptr = buff->start_addr;
-			buff = buff->next;
-			move_buffer = false;
-		}
-
 		if (size_to_copy) {
 			comp_update_buffer_produce(sink, size_to_copy);
 			comp_copy(sink->sink);
@@ -1878,79 +1774,6 @@ out:
 	return SOF_TASK_STATE_COMPLETED;
 }
 
-#ifdef KPB_HIFI3
-static void kpb_convert_24b_to_32b(const void *linear_source, int ioffset,
-				   struct audio_stream __sparse_cache *sink, int ooffset,
-				   unsigned int n_samples)
-{
-	int ssize = audio_stream_sample_bytes(sink);
-	uint8_t *in = (uint8_t *)linear_source + ioffset * ssize;
-	uint8_t *out = audio_stream_wrap(sink, (uint8_t *)audio_stream_get_wptr(sink) +
-					 ooffset * ssize);
-	ae_int32x2 *buf_end;
-	ae_int32x2 *buf;
-
-	buf = (ae_int32x2 *)(audio_stream_get_addr(sink));
-	buf_end = audio_stream_get_end_addr(sink);
-	ae_int32x2 *out_ptr = (ae_int32x2 *)buf;
-
-	AE_SETCBEGIN0(buf);
-	AE_SETCEND0(buf_end);
-	out_ptr = (ae_int32x2 *)out;
-
-	ae_valign align_in = AE_LA64_PP(in);
-	int i = 0;
-	ae_int24x2 d24 = AE_ZERO24();
-
-	if (!IS_ALIGNED((uintptr_t)out_ptr, 8)) {
-		AE_LA24_IP(d24, align_in, in);
-		ae_int32x2 d320 = d24;
-		int higher = AE_MOVAD32_H(d320);
-		*(ae_int32 *)(out_ptr) = higher << 8;
-		out_ptr = (ae_int32x2 *)(out + 4);
-		++i;
-	}
-	/* process two samples in single iteration to increase performance */
-	while (i < (int)n_samples - 1) {
-		AE_LA24X2_IP(d24, align_in, in);
-		ae_int32x2 d320 = d24;
-
-		d320 = AE_SLAI32(d320, 8);
-		AE_S32X2_XC(d320, out_ptr, 8);
-		i += 2;
-	}
-	if (i != (int)n_samples) {
-		AE_LA24X2_IP(d24, align_in, in);
-		ae_int32x2 d320 = d24;
-		int higher = AE_MOVAD32_H(d320);
-		*(ae_int32 *)(out_ptr) = higher << 8;
-	}
-}
-#else
-static void kpb_convert_24b_to_32b(const void *source, int ioffset,
-				   struct audio_stream __sparse_cache *sink,
-				   int ooffset, unsigned int samples)
-{
-	int ssize = audio_stream_sample_bytes(sink);
-	uint8_t *src = (uint8_t *)source + ioffset * 3;
-	int32_t *dst = audio_stream_wrap(sink, (uint8_t *)audio_stream_get_wptr(sink) +
-					 ooffset * ssize);
-	int processed;
-	int nmax, i, n;
-
-	for (processed = 0; processed < samples; processed += n) {
-		dst = audio_stream_wrap(sink, dst);
-		n = samples - processed;
-		nmax = KPB_BYTES_TO_S32_SAMPLES(audio_stream_bytes_without_wrap(sink, dst));
-		n = MIN(n, nmax);
-		for (i = 0; i < n; i += 1) {
-			*dst = (src[2] << 16) | (src[1] << 8) | src[0];
-			dst++;
-			src += 3;
-		}
-	}
-}
-#endif
 /**
  * \brief Drain data samples safe, according to configuration.
  *
@@ -1974,9 +1797,6 @@ static void kpb_drain_samples(void *source, struct audio_stream __sparse_cache *
 #endif /* CONFIG_FORMAT_S16LE */
 #if CONFIG_FORMAT_S24LE || CONFIG_FORMAT_S32LE
 	case 24:
-		samples = size / ((sample_width >> 3) * audio_stream_get_channels(sink));
-		kpb_convert_24b_to_32b(source, 0, sink, 0, samples);
-		break;
 	case 32:
 		samples = KPB_BYTES_TO_S32_SAMPLES(size);
 		audio_stream_copy_from_linear(source, 0, sink, 0, samples);
@@ -1988,70 +1808,6 @@ static void kpb_drain_samples(void *source, struct audio_stream __sparse_cache *
 	}
 }
 
-#ifdef KPB_HIFI3
-static void kpb_convert_32b_to_24b(const struct audio_stream __sparse_cache *source, int ioffset,
-				   void *linear_sink, int ooffset, unsigned int n_samples)
-{
-	int ssize = audio_stream_sample_bytes(source);
-	uint8_t *in = audio_stream_wrap(source, (uint8_t *)audio_stream_get_rptr(source) +
-					ioffset * ssize);
-	uint8_t *out = (uint8_t *)linear_sink + ooffset * ssize;
-
-	const ae_f24x2 *sin = (const ae_f24x2 *)in;
-	ae_f24x2 *sout = (ae_f24x2 *)out;
-
-	ae_f24x2 vs = AE_ZERO24();
-	ae_valign align_out = AE_ZALIGN64();
-
-	if (!IS_ALIGNED((uintptr_t)sin, 8)) {
-		AE_L32F24_XC(vs, (const ae_f24 *)sin, 4);
-		AE_SA24_IP(vs, align_out, sout);
-		n_samples--;
-	}
-
-	unsigned int size = n_samples >> 1;
-	size_t i;
-
-	for (i = 0; i < size; i++) {
-		AE_L32X2F24_XC(vs, sin, 8);
-		AE_SA24X2_IP(vs, align_out, sout);
-	}
-	AE_SA64POS_FP(align_out, sout);
-
-	if (n_samples & 1) {
-		AE_L32X2F24_XC(vs, sin, 4);
-		ae_f24 tmp = AE_MOVAD32_H(AE_MOVINT24X2_FROMF24X2(vs));
-
-		AE_SA24_IP(tmp, align_out, sout);
-		AE_SA64POS_FP(align_out, sout);
-	}
-}
-#else
-static void kpb_convert_32b_to_24b(const struct audio_stream __sparse_cache *source, int ioffset,
-				   void *sink, int ooffset, unsigned int samples)
-{
-	int ssize = audio_stream_sample_bytes(source);
-	int32_t *src = audio_stream_wrap(source, (uint8_t *)audio_stream_get_rptr(source) +
-					 ioffset * ssize);
-	uint8_t *dst = (uint8_t *)sink + ooffset * 3;
-	int processed;
-	int nmax, i, n;
-
-	for (processed = 0; processed < samples; processed += n) {
-		src = audio_stream_wrap(source, src);
-		n = samples - processed;
-		nmax = KPB_BYTES_TO_S32_SAMPLES(audio_stream_bytes_without_wrap(source, src));
-		n = MIN(n, nmax);
-		for (i = 0; i < n; i += 1) {
-			dst[0] = *src & 0xFF;
-			dst[1] = (*src >> 8) & 0xFF;
-			dst[2] = (*src >> 16) & 0xFF;
-			dst += 3;
-			src++;
-		}
-	}
-}
-#endif
 /**
  * \brief Buffers data samples safe, according to configuration.
  * \param[in,out] source Pointer to source buffer.
@@ -2078,11 +1834,6 @@ static void kpb_buffer_samples(const struct audio_stream __sparse_cache *source,
 #endif
 #if CONFIG_FORMAT_S24LE || CONFIG_FORMAT_S32LE
 	case 24:
-		samples_count =  size / ((sample_width >> 3) * audio_stream_get_channels(source));
-		samples_offset = offset / ((sample_width >> 3) * audio_stream_get_channels(source));
-		kpb_convert_32b_to_24b(source, samples_offset,
-				       sink, 0, samples_count);
-		break;
 	case 32:
 		samples_count = KPB_BYTES_TO_S32_SAMPLES(size);
 		samples_offset = KPB_BYTES_TO_S32_SAMPLES(offset);
@@ -2096,6 +1847,120 @@ static void kpb_buffer_samples(const struct audio_stream __sparse_cache *source,
 	}
 }
 
+#if CONFIG_KPB_HISTORY_COMPRESSION
+/* Round a sample to a mantissa with the given right shift */
+static inline int16_t kpb_bfp_mantissa(int32_t x, int shift)
+{
+	if (!shift)
+		return x;
+
+	return sat_int16(((x >> (shift - 1)) + 1) >> 1);
+}
+
+/**
+ * \brief Stores 24 or 32 bit samples to history as block floating point.
+ *
+ * Each block of KPB_BFP_BLOCK_SAMPLES samples shares an exponent that
+ * fits the block peak to a 16 bit mantissa. A block that was partially
+ * written by the previous call is continued with its exponent, or the
+ * already stored mantissas are rescaled if the new samples need more
+ * headroom.
+ *
+ * \param[in,out] hb History buffer.
+ * \param[in] source Pointer to source buffer.
+ * \param[in] offset Start offset of source buffer in bytes.
+ * \param[in,out] sink Write position in history buffer.
+ * \param[in] size Requested copy size in bytes of 32 bit samples.
+ * \param[in] sample_width Sample size.
+ */
+static void kpb_compress_samples(struct history_buffer *hb,
+				 const struct audio_stream __sparse_cache *source,
+				 int offset, int16_t *sink, size_t size,
+				 size_t sample_width)
+{
+	int32_t x[KPB_BFP_BLOCK_SAMPLES];
+	int samples = KPB_BYTES_TO_S32_SAMPLES(size);
+	int ioffset = KPB_BYTES_TO_S32_SAMPLES(offset);
+	int index = sink - (int16_t *)hb->start_addr;
+	uint8_t *exponent;
+	int32_t peak;
+	int shift;
+	int first;
+	int n;
+	int i;
+
+	while (samples > 0) {
+		first = index % KPB_BFP_BLOCK_SAMPLES;
+		n = MIN(samples, KPB_BFP_BLOCK_SAMPLES - first);
+		exponent = &hb->exponents[index / KPB_BFP_BLOCK_SAMPLES];
+		audio_stream_copy_to_linear(source, ioffset, x, 0, n);
+
+		peak = 0;
+		for (i = 0; i < n; i++) {
+			if (sample_width == 24)
+				x[i] = sign_extend_s24(x[i]);
+
+			/* OR of magnitudes has the same leading bit as the max */
+			peak |= x[i] ^ (x[i] >> 31);
+		}
+
+		shift = MAX(16 - norm_int32(peak), 0);
+		if (!first) {
+			*exponent = shift;
+		} else if (shift > *exponent) {
+			for (i = -first; i < 0; i++)
+				sink[i] >>= shift - *exponent;
+
+			*exponent = shift;
+		} else {
+			shift = *exponent;
+		}
+
+		for (i = 0; i < n; i++)
+			sink[i] = kpb_bfp_mantissa(x[i], shift);
+
+		sink += n;
+		index += n;
+		ioffset += n;
+		samples -= n;
+	}
+}
+
+/**
+ * \brief Drains block floating point history to 32 bit samples.
+ * \param[in] hb History buffer.
+ * \param[in] source Read position in history buffer.
+ * \param[in,out] sink Pointer to sink buffer.
+ * \param[in] size Requested copy size in bytes of 32 bit samples.
+ */
+static void kpb_decompress_samples(const struct history_buffer *hb,
+				   const int16_t *source,
+				   struct audio_stream __sparse_cache *sink,
+				   size_t size)
+{
+	int32_t x[KPB_BFP_BLOCK_SAMPLES];
+	int samples = KPB_BYTES_TO_S32_SAMPLES(size);
+	int index = source - (int16_t *)hb->start_addr;
+	int ooffset = 0;
+	int shift;
+	int n;
+	int i;
+
+	while (samples > 0) {
+		n = MIN(samples, KPB_BFP_BLOCK_SAMPLES - index % KPB_BFP_BLOCK_SAMPLES);
+		shift = hb->exponents[index / KPB_BFP_BLOCK_SAMPLES];
+		for (i = 0; i < n; i++)
+			x[i] = (int32_t)source[i] << shift;
+
+		audio_stream_copy_from_linear(x, 0, sink, ooffset, n);
+		source += n;
+		index += n;
+		ooffset += n;
+		samples -= n;
+	}
+}
+#endif /* CONFIG_KPB_HISTORY_COMPRESSION */
+
 /**
  * \brief Initialize history buffer by zeroing its memory.
  * \param[in] buff - pointer to current history buffer.
@@ -2104,20 +1969,15 @@ static void kpb_buffer_samples(const struct audio_stream __sparse_cache *source,
  */
 static void kpb_clear_history_buffer(struct history_buffer *buff)
 {
-	struct history_buffer *first_buff = buff;
-	void *start_addr;
-	size_t size;
+	size_t size = (uintptr_t)buff->end_addr - (uintptr_t)buff->start_addr;
 
 	comp_cl_info(&comp_kpb, "kpb_clear_history_buffer()");
 
-	do {
-		start_addr = buff->start_addr;
-		size = (uintptr_t)buff->end_addr - (uintptr_t)start_addr;
-
-		bzero(start_addr, size);
-
-		buff = buff->next;
-	} while (buff != first_buff);
+	bzero(buff->start_addr, size);
+#if CONFIG_KPB_HISTORY_COMPRESSION
+	if (buff->exponents)
+		bzero(buff->exponents, KPB_BYTES_TO_S16_SAMPLES(size) / KPB_BFP_BLOCK_SAMPLES);
+#endif
 }
 
 static inline bool kpb_is_sample_width_supported(uint32_t sampling_width)
@@ -2257,23 +2117,14 @@ static void kpb_copy_samples(struct comp_buffer __sparse_cache *sink,
  */
 static void kpb_reset_history_buffer(struct history_buffer *buff)
 {
-	struct history_buffer *first_buff = buff;
-
 	comp_cl_info(&comp_kpb, "kpb_reset_history_buffer()");
 
-	if (!buff)
+	if (!buff->start_addr)
 		return;
 
 	kpb_clear_history_buffer(buff);
-
-	do {
-		buff->w_ptr = buff->start_addr;
-		buff->r_ptr = buff->start_addr;
-		buff->state = KPB_BUFFER_FREE;
-
-		buff = buff->next;
-
-	} while (buff != first_buff);
+	buff->w_ptr = buff->start_addr;
+	buff->r_ptr = buff->start_addr;
 }
 
 static inline bool validate_host_params(struct comp_dev *dev,
@@ -20,123 +20,113 @@
 #include <stdint.h>
 
 LOG_MODULE_REGISTER(mfcc_common, CONFIG_SOF_LOG_LEVEL);
-/* MFCC with 16 bit FFT benefits from data normalize, for 32 bits there's no
- * significant impact. The amount of left shifts for FFT input is limited to
- * 10 that equals about 60 dB boost. The boost is compensated in Mel energy
- * calculation.
+
+/* Fused DCT and cepstral lifter for a batch of Mel spectra. The result is
+ * written directly to the feature ring slots.
  */
-#if MFCC_FFT_BITS == 16
-#define MFCC_NORMALIZE_FFT
-#else
-#undef MFCC_NORMALIZE_FFT
-#endif
-#define MFCC_NORMALIZE_MAX_SHIFT	10
+static void mfcc_dct_lifter_batch(struct mfcc_state *state, int num_frames)
+{
+	struct mfcc_feature_ring *ring = &state->features;
+	struct mat_matrix_16b *m = state->dct_lifter;
+	const int num_in = m->rows;
+	const int num_out = m->columns;
+	const int shift = m->fractions;
+	int16_t *mel = state->mel_batch;
+	int16_t *ceps;
+	int16_t *y;
+	int64_t s;
+	int w_idx;
+	int f;
+	int i;
+	int j;
+
+	for (f = 0; f < num_frames; f++, mel += num_in) {
+		/* Drop the frame if the consumer has not kept up */
+		if (mfcc_feature_ring_avail(ring) == ring->slots) {
+			ring->overruns++;
+			continue;
+		}
+
+		w_idx = atomic_read(&ring->w_idx);
+		ceps = mfcc_feature_ring_slot(ring, w_idx);
+		for (j = 0; j < num_out; j++) {
+			s = 0;
+			y = m->data + j;
+			for (i = 0; i < num_in; i++) {
+				s += (int32_t)mel[i] * *y;
+				y += num_out;
+			}
+
+			ceps[j] = sat_int16(Q_SHIFT_RND(s, 7 + shift, 7)); /* Q8.7 */
+		}
+
+		/* publish the frame to the consumer after its data */
+		atomic_set(&ring->w_idx, mfcc_feature_ring_next(ring, w_idx));
+	}
+}
 
 /*
  * The main processing function for MFCC
  */
 
-static int mfcc_stft_process(const struct comp_dev *dev, struct mfcc_state *state)
+static void mfcc_stft_process(const struct comp_dev *dev, struct mfcc_state *state)
 {
-	struct mfcc_buffer *buf = &state->buf;
-	struct mfcc_fft *fft = &state->fft;
+	struct stft_plan *st = &state->stft;
+	const int num_mel = state->dct.num_in;
 	int mel_scale_shift;
-	int input_shift;
-	int i;
-	int m;
-	int cc_count = 0;
+	int num_frames;
 
-	/* Phase 1, wait until whole fft_size is filled with valid data. This way
+	/* The STFT waits until whole frame is filled with valid data. This way
 	 * first output cepstral coefficients originate from streamed data and not
-	 * from buffers with zero data.
+	 * from buffers with zero data. After that a frame is analyzed for every
+	 * hop of new samples. The Mel spectra of all ready frames are collected
+	 * and then converted to cepstral coefficients in one pass.
 	 */
-	comp_dbg(dev, "mfcc_stft_process(), avail = %d", buf->s_avail);
-	if (state->waiting_fill) {
-		if (buf->s_avail < fft->fft_size)
-			return 0;
-
-		state->waiting_fill = false;
-	}
-
-	/* Phase 2, move first prev_size data to previous data buffer, remove
-	 * samples from input buffer.
-	 */
-	if (!state->prev_samples_valid) {
-		mfcc_fill_prev_samples(buf, state->prev_data, state->prev_data_size);
-		state->prev_samples_valid = true;
-	}
-
-	/* Check if enough samples in buffer for FFT hop */
-	m = buf->s_avail / fft->fft_hop_size;
-	for (i = 0; i < m; i++) {
-		/* Clear FFT input buffer because it has been used as scratch */
-		bzero(fft->fft_buf, fft->fft_buffer_size);
-
-		/* Copy data to FFT input buffer from overlap buffer and from new samples buffer */
-		mfcc_fill_fft_buffer(state);
-
-		/* TODO: remove_dc_offset */
-
-		/* TODO: use_energy & raw_energy */
-
-#ifdef MFCC_NORMALIZE_FFT
-		/* Find block scale left shift for FFT input */
-		input_shift = mfcc_normalize_fft_buffer(state);
-#else
-		input_shift = 0;
-#endif
-
-		/* Window function */
-		mfcc_apply_window(state, input_shift);
-
-		/* TODO: use_energy & !raw_energy */
-
-		/* The FFT out buffer needs to be cleared to avoid to corrupt
-		 * the output. TODO: check moving it to FFT lib.
-		 */
-		bzero(fft->fft_out, fft->fft_buffer_size);
-
-		/* Compute FFT */
+	comp_dbg(dev, "mfcc_stft_process(), avail = %d", st->ibuf.s_avail);
+	do {
+		num_frames = 0;
+		while (num_frames < state->max_batch && stft_analysis(st)) {
+			/* TODO: remove_dc_offset */
+
+			/* TODO: use_energy & raw_energy */
+
+			/* Compensate FFT lib scaling to Mel log values, e.g. for 512 long
+			 * FFT the fft_plan->len is 9. The scaling is 1/512. Subtract from
+			 * input_shift it to add the missing "gain".
+			 */
+			mel_scale_shift = st->input_shift - st->fft_plan->len;
 #if MFCC_FFT_BITS == 16
-		fft_execute_16(fft->fft_plan, false);
+			psy_apply_mel_filterbank_16(&state->melfb, st->fft_out,
+						    state->power_spectra,
+						    state->mel_batch + num_frames * num_mel,
+						    mel_scale_shift);
 #else
-		fft_execute_32(fft->fft_plan, false);
+			psy_apply_mel_filterbank_32(&state->melfb, st->fft_out,
+						    state->power_spectra,
+						    state->mel_batch + num_frames * num_mel,
+						    mel_scale_shift);
 #endif
+			num_frames++;
+		}
 
-		/* Convert powerspectrum to Mel band logarithmic spectrum */
-		mat_init_16b(state->mel_spectra, 1, state->dct.num_in, 7); /* Q8.7 */
-
-		/* Compensate FFT lib scaling to Mel log values, e.g. for 512 long FFT
-		 * the fft_plan->len is 9. The scaling is 1/512. Subtract from input_shift it
-		 * to add the missing "gain".
+		/* Multiply Mel spectra with the DCT and lifter matrix to get cepstral
+		 * coefficients
 		 */
-		mel_scale_shift = input_shift - fft->fft_plan->len;
-#if MFCC_FFT_BITS == 16
-		psy_apply_mel_filterbank_16(&state->melfb, fft->fft_out, state->power_spectra,
-					    state->mel_spectra->data, mel_scale_shift);
-#else
-		psy_apply_mel_filterbank_32(&state->melfb, fft->fft_out, state->power_spectra,
-					    state->mel_spectra->data, mel_scale_shift);
-#endif
-
-		/* Multiply Mel spectra with DCT matrix to get cepstral coefficients */
-		mat_init_16b(state->cepstral_coef, 1, state->dct.num_out, 7); /* Q8.7 */
-		mat_multiply(state->mel_spectra, state->dct.matrix, state->cepstral_coef);
-
-		/* Apply cepstral lifter */
-		if (state->lifter.cepstral_lifter != 0)
-			mat_multiply_elementwise(state->cepstral_coef, state->lifter.matrix,
-						 state->cepstral_coef);
+		mfcc_dct_lifter_batch(state, num_frames);
+	} while (num_frames == state->max_batch);
+}
 
-		cc_count += state->dct.num_out;
+/* Returns the number of feature frames with the magic word that fit to
+ * the sink samples.
+ */
+static int mfcc_sink_feature_frames(struct mfcc_state *state, int samples)
+{
+	const int frame_samples = state->features.num_ceps + MFCC_MAGIC_SAMPLES;
 
-		/* Output to sink buffer */
-	}
+	if (!state->features.sink_consumer)
+		return 0;
 
-	/* TODO: This version handles only one FFT run per copy(). How to pass multiple
-	 * cepstral coefficients sets return is an open.
-	 */
-	return cc_count;
+	return MIN(mfcc_feature_ring_avail(&state->features), samples / frame_samples);
 }
 
 #if CONFIG_FORMAT_S16LE
@@ -146,38 +136,81 @@ void mfcc_s16_default(struct processing_module *mod, struct input_stream_buffer
 	struct audio_stream __sparse_cache *sink = bsink->data;
 	struct mfcc_comp_data *cd = module_get_private_data(mod);
 	struct mfcc_state *state = &cd->state;
-	struct mfcc_buffer *buf = &cd->state.buf;
+	struct mfcc_feature_ring *ring = &state->features;
 	uint32_t magic = MFCC_MAGIC;
 	int16_t *w_ptr = audio_stream_get_wptr(sink);
-	// int num_magic = sizeof(magic) / sizeof(int16_t);
-	const int num_magic = 2;
-	int num_ceps;
-	int zero_samples;
+	int samples = frames * audio_stream_get_channels(sink);
+	int n;
 
 	/* Get samples from source buffer */
-	mfcc_source_copy_s16(bsource, buf, &state->emph, frames, state->source_channel);
+	mfcc_source_copy_s16(bsource, &state->stft.ibuf, &state->emph, frames,
+			     state->source_channel);
 
-	/* Run STFT and processing after FFT: Mel auditory filter and DCT. The sink
-	 * buffer is updated during STDF processing.
+	/* Run STFT and processing after FFT: Mel auditory filter and DCT. The
+	 * cepstral coefficients are stored to the feature ring.
 	 */
-	num_ceps = mfcc_stft_process(mod->dev, state);
+	mfcc_stft_process(mod->dev, state);
 
-	/* Done, copy data to sink. This works only if the period has room for magic (2)
-	 * plus num_ceps int16_t samples. TODO: split ceps over multiple periods.
+	/* Copy to sink as many feature frames as fit, each preceded by magic
+	 * word, the rest of period is zeros.
 	 */
-	zero_samples = frames * audio_stream_get_channels(sink);
-	if (num_ceps > 0) {
-		zero_samples -= num_ceps + num_magic;
-		w_ptr = mfcc_sink_copy_data_s16(sink, w_ptr, num_magic, (int16_t *)&magic);
-		w_ptr = mfcc_sink_copy_data_s16(sink, w_ptr, num_ceps, state->cepstral_coef->data);
+	for (n = mfcc_sink_feature_frames(state, samples); n > 0; n--) {
+		w_ptr = mfcc_sink_copy_data_s16(sink, w_ptr, MFCC_MAGIC_SAMPLES,
+						(int16_t *)&magic);
+		w_ptr = mfcc_sink_copy_data_s16(sink, w_ptr, ring->num_ceps,
+						mfcc_feature_ring_peek(ring));
+		mfcc_feature_ring_release(ring);
+		samples -= ring->num_ceps + MFCC_MAGIC_SAMPLES;
 	}
 
-	w_ptr = mfcc_sink_copy_zero_s16(sink, w_ptr, zero_samples);
+	mfcc_sink_copy_zero_s16(sink, w_ptr, samples);
 }
 #endif /* CONFIG_FORMAT_S16LE */
 
+#if CONFIG_FORMAT_S24LE || CONFIG_FORMAT_S32LE
+static void mfcc_s32_process(struct processing_module *mod, struct input_stream_buffer *bsource,
+			     struct output_stream_buffer *bsink, int frames, int shift)
+{
+	struct audio_stream __sparse_cache *sink = bsink->data;
+	struct mfcc_comp_data *cd = module_get_private_data(mod);
+	struct mfcc_state *state = &cd->state;
+	struct mfcc_feature_ring *ring = &state->features;
+	uint32_t magic = MFCC_MAGIC;
+	int32_t *w_ptr = audio_stream_get_wptr(sink);
+	int samples = frames * audio_stream_get_channels(sink);
+	const int sink_shift = 16 - shift;
+	int n;
+
+	mfcc_source_copy_s32(bsource, &state->stft.ibuf, &state->emph, frames,
+			     state->source_channel, shift);
+
+	mfcc_stft_process(mod->dev, state);
+
+	for (n = mfcc_sink_feature_frames(state, samples); n > 0; n--) {
+		w_ptr = mfcc_sink_copy_data_s32(sink, w_ptr, MFCC_MAGIC_SAMPLES,
+						(int16_t *)&magic, sink_shift);
+		w_ptr = mfcc_sink_copy_data_s32(sink, w_ptr, ring->num_ceps,
+						mfcc_feature_ring_peek(ring), sink_shift);
+		mfcc_feature_ring_release(ring);
+		samples -= ring->num_ceps + MFCC_MAGIC_SAMPLES;
+	}
+
+	mfcc_sink_copy_zero_s32(sink, w_ptr, samples);
+}
+#endif
+
 #if CONFIG_FORMAT_S24LE
+void mfcc_s24_default(struct processing_module *mod, struct input_stream_buffer *bsource,
+		      struct output_stream_buffer *bsink, int frames)
+{
+	mfcc_s32_process(mod, bsource, bsink, frames, 8);
+}
 #endif /* CONFIG_FORMAT_S24LE */
 
 #if CONFIG_FORMAT_S32LE
+void mfcc_s32_default(struct processing_module *mod, struct input_stream_buffer *bsource,
+		      struct output_stream_buffer *bsink, int frames)
+{
+	mfcc_s32_process(mod, bsource, bsink, frames, 0);
+}
 #endif /* CONFIG_FORMAT_S32LE */
@@ -0,0 +1,33 @@
+// SPDX-License-Identifier: BSD-3-Clause
+//
+// Copyright(c) 2023 Intel Corporation. All rights reserved.
+
+#include <sof/audio/mfcc/mfcc_comp.h>
+#include <errno.h>
+#include <stdint.h>
+
+int mfcc_feature_read(struct mfcc_state *state, int16_t *dst, int max_frames)
+{
+	struct mfcc_feature_ring *ring = &state->features;
+	int16_t *ceps;
+	int n;
+	int j;
+
+	/* The ring has a single consumer */
+	if (ring->sink_consumer)
+		return -EBUSY;
+
+	for (n = 0; n < max_frames; n++) {
+		ceps = mfcc_feature_ring_peek(ring);
+		if (!ceps)
+			break;
+
+		for (j = 0; j < ring->num_ceps; j++)
+			*dst++ = ceps[j];
+
+		/* the slot can be overwritten after this */
+		mfcc_feature_ring_release(ring);
+	}
+
+	return n;
+}
@@ -24,14 +24,14 @@
  * MFCC algorithm code
  */
 
-void mfcc_source_copy_s16(struct input_stream_buffer *bsource, struct mfcc_buffer *buf,
+void mfcc_source_copy_s16(struct input_stream_buffer *bsource, struct stft_buffer *buf,
 			  struct mfcc_pre_emph *emph, int frames, int source_channel)
 {
 	struct audio_stream __sparse_cache *source = bsource->data;
 	int32_t s;
 	int16_t *x0;
 	int16_t *x = audio_stream_get_rptr(source);
-	int16_t *w = buf->w_ptr;
+	int32_t *w = buf->w_ptr;
 	int copied;
 	int nmax;
 	int n1;
@@ -40,13 +40,13 @@ void mfcc_source_copy_s16(struct input_stream_buffer *bsource, struct mfcc_buffe
 	int i;
 	int num_channels = audio_stream_get_channels(source);
 
-	/* Copy from source to pre-buffer for FFT.
+	/* Copy from source to STFT input buffer as Q1.31.
 	 * The pre-emphasis filter is done in this step.
 	 */
 	for (copied = 0; copied < frames; copied += n) {
 		nmax = frames - copied;
 		n1 = audio_stream_frames_without_wrap(source, x);
-		n2 = mfcc_buffer_samples_without_wrap(buf, w);
+		n2 = stft_buffer_samples_without_wrap(buf, w);
 		n = MIN(n1, n2);
 		n = MIN(n, nmax);
 		x0 = x + source_channel;
@@ -54,142 +54,129 @@ void mfcc_source_copy_s16(struct input_stream_buffer *bsource, struct mfcc_buffe
 			if (emph->enable) {
 				/* Q1.15 x Q1.15 -> Q2.30 */
 				s = (int32_t)emph->delay * emph->coef + Q_SHIFT_LEFT(*x0, 15, 30);
-				*w = sat_int16(Q_SHIFT_RND(s, 30, 15));
+				*w = (int32_t)sat_int16(Q_SHIFT_RND(s, 30, 15)) << 16;
 				emph->delay = *x0;
 			} else {
-				*w = *x0;
+				*w = (int32_t)*x0 << 16;
 			}
 			x0 += num_channels;
 			w++;
 		}
 
 		x = audio_stream_wrap(source, x + n * audio_stream_get_channels(source));
-		w = mfcc_buffer_wrap(buf, w);
+		w = stft_buffer_wrap(buf, w);
 	}
 	buf->s_avail += copied;
 	buf->s_free -= copied;
 	buf->w_ptr = w;
 }
 
-void mfcc_fill_prev_samples(struct mfcc_buffer *buf, int16_t *prev_data,
-			    int prev_data_length)
+void mfcc_source_copy_s32(struct input_stream_buffer *bsource, struct stft_buffer *buf,
+			  struct mfcc_pre_emph *emph, int frames, int source_channel,
+			  int shift)
 {
-	/* Fill prev_data from input buffer */
-	int16_t *r = buf->r_ptr;
-	int16_t *p = prev_data;
+	struct audio_stream __sparse_cache *source = bsource->data;
+	int64_t s;
+	int32_t x;
+	int32_t *x0;
+	int32_t *xp = audio_stream_get_rptr(source);
+	int32_t *w = buf->w_ptr;
 	int copied;
 	int nmax;
+	int n1;
+	int n2;
 	int n;
+	int i;
+	int num_channels = audio_stream_get_channels(source);
 
-	for (copied = 0; copied < prev_data_length; copied += n) {
-		nmax = prev_data_length - copied;
-		n = mfcc_buffer_samples_without_wrap(buf, r);
+	/* Copy from source to STFT input buffer as Q1.31. The 24 bit samples
+	 * are shifted left to Q1.31. The pre-emphasis filter is done in this step.
+	 */
+	for (copied = 0; copied < frames; copied += n) {
+		nmax = frames - copied;
+		n1 = audio_stream_frames_without_wrap(source, xp);
+		n2 = stft_buffer_samples_without_wrap(buf, w);
+		n = MIN(n1, n2);
 		n = MIN(n, nmax);
-		memcpy(p, r, sizeof(int16_t) * n); /* Not using memcpy_s() due to speed need */
-		p += n;
-		r += n;
-		r = mfcc_buffer_wrap(buf, r);
-	}
+		x0 = xp + source_channel;
+		for (i = 0; i < n; i++) {
+			x = *x0 << shift;
+			if (emph->enable) {
+				/* Q1.31 x Q1.15 -> Q2.46 */
+				s = (int64_t)emph->delay32 * emph->coef +
+					Q_SHIFT_LEFT((int64_t)x, 31, 46);
+				*w = sat_int32(Q_SHIFT_RND(s, 46, 31));
+				emph->delay32 = x;
+			} else {
+				*w = x;
+			}
+			x0 += num_channels;
+			w++;
+		}
 
-	buf->s_avail -= copied;
-	buf->s_free += copied;
-	buf->r_ptr = r;
+		xp = audio_stream_wrap(source, xp + n * num_channels);
+		w = stft_buffer_wrap(buf, w);
+	}
+	buf->s_avail += copied;
+	buf->s_free -= copied;
+	buf->w_ptr = w;
 }
 
-void mfcc_fill_fft_buffer(struct mfcc_state *state)
+#if CONFIG_FORMAT_S16LE
+
+int16_t *mfcc_sink_copy_zero_s16(const struct audio_stream *sink,
+				 int16_t *w_ptr, int samples)
 {
-	struct mfcc_buffer *buf = &state->buf;
-	struct mfcc_fft *fft = &state->fft;
-	int16_t *r = buf->r_ptr;
 	int copied;
 	int nmax;
-	int idx = fft->fft_fill_start_idx;
-	int j;
+	int i;
 	int n;
 
-	/* Copy overlapped samples from state buffer. Imaginary part of input
-	 * remains zero.
-	 */
-	for (j = 0; j < state->prev_data_size; j++)
-		fft->fft_buf[idx + j].real = state->prev_data[j];
-
-	/* Copy hop size of new data from circular buffer */
-	idx += state->prev_data_size;
-	for (copied = 0; copied < fft->fft_hop_size; copied += n) {
-		nmax = fft->fft_hop_size - copied;
-		n = mfcc_buffer_samples_without_wrap(buf, r);
+	for (copied = 0; copied < samples; copied += n) {
+		nmax = samples - copied;
+		n = audio_stream_samples_without_wrap_s16(sink, w_ptr);
 		n = MIN(n, nmax);
-		for (j = 0; j < n; j++) {
-			fft->fft_buf[idx].real = *r;
-			r++;
-			idx++;
+		for (i = 0; i < n; i++) {
+			*w_ptr = 0;
+			w_ptr++;
 		}
-		r = mfcc_buffer_wrap(buf, r);
-	}
 
-	buf->s_avail -= copied;
-	buf->s_free += copied;
-	buf->r_ptr = r;
-
-	/* Copy for next time data back to overlap buffer */
-	idx = fft->fft_fill_start_idx + fft->fft_hop_size;
-	for (j = 0; j < state->prev_data_size; j++)
-		state->prev_data[j] = fft->fft_buf[idx + j].real;
-}
-
-#ifdef MFCC_NORMALIZE_FFT
-int mfcc_normalize_fft_buffer(struct mfcc_state *state)
-{
-	struct mfcc_fft *fft = &state->fft;
-	int32_t absx;
-	int32_t smax = 0;
-	int32_t x;
-	int shift;
-	int j;
-	int i = fft->fft_fill_start_idx;
-
-	for (j = 0; j < fft->fft_size; j++) {
-		x = fft->fft_buf[i + j].real;
-		absx = (x < 0) ? -x : x;
-		if (smax < absx)
-			smax = absx;
+		w_ptr = audio_stream_wrap(sink, w_ptr);
 	}
 
-	shift = norm_int32(smax << 15) - 1; /* 16 bit data */
-	shift = MAX(shift, 0);
-	shift = MIN(shift, MFCC_NORMALIZE_MAX_SHIFT);
-	return shift;
+	return w_ptr;
 }
-#endif
 
-void mfcc_apply_window(struct mfcc_state *state, int input_shift)
+int16_t *mfcc_sink_copy_data_s16(const struct audio_stream *sink, int16_t *w_ptr,
+				 int samples, int16_t *r_ptr)
 {
-	struct mfcc_fft *fft = &state->fft;
-	int j;
-	int i = fft->fft_fill_start_idx;
+	int copied;
+	int nmax;
+	int i;
+	int n;
 
-#if MFCC_FFT_BITS == 16
-	/* TODO: Use proper multiply and saturate function to make sure no overflows */
-	int32_t x;
-	int s = 14 - input_shift; /* Q1.15 x Q1.15 -> Q30 -> Q15, shift by 15 - 1 for round */
+	for (copied = 0; copied < samples; copied += n) {
+		nmax = samples - copied;
+		n = audio_stream_samples_without_wrap_s16(sink, w_ptr);
+		n = MIN(n, nmax);
+		for (i = 0; i < n; i++) {
+			*w_ptr = *r_ptr;
+			r_ptr++;
+			w_ptr++;
+		}
 
-	for (j = 0; j < fft->fft_size; j++) {
-		x = (int32_t)fft->fft_buf[i + j].real * state->window[j];
-		fft->fft_buf[i + j].real = ((x >> s) + 1) >> 1;
+		w_ptr = audio_stream_wrap(sink, w_ptr);
 	}
-#else
-	/* TODO: Use proper multiply and saturate function to make sure no overflows */
-	int s = input_shift + 1; /* To convert 16 -> 32 with Q1.15 x Q1.15 -> Q30 -> Q31 */
 
-	for (j = 0; j < fft->fft_size; j++)
-		fft->fft_buf[i + j].real = (fft->fft_buf[i + j].real * state->window[j]) << s;
-#endif
+	return w_ptr;
 }
 
-#if CONFIG_FORMAT_S16LE
+#endif /* CONFIG_FORMAT_S16LE */
 
-int16_t *mfcc_sink_copy_zero_s16(const struct audio_stream *sink,
-				 int16_t *w_ptr, int samples)
+#if CONFIG_FORMAT_S24LE || CONFIG_FORMAT_S32LE
+
+int32_t *mfcc_sink_copy_zero_s32(const struct audio_stream *sink,
+				 int32_t *w_ptr, int samples)
 {
 	int copied;
 	int nmax;
@@ -198,7 +185,7 @@ int16_t *mfcc_sink_copy_zero_s16(const struct audio_stream *sink,
 
 	for (copied = 0; copied < samples; copied += n) {
 		nmax = samples - copied;
-		n = audio_stream_samples_without_wrap_s16(sink, w_ptr);
+		n = audio_stream_samples_without_wrap_s32(sink, w_ptr);
 		n = MIN(n, nmax);
 		for (i = 0; i < n; i++) {
 			*w_ptr = 0;
@@ -211,8 +198,8 @@ int16_t *mfcc_sink_copy_zero_s16(const struct audio_stream *sink,
 	return w_ptr;
 }
 
-int16_t *mfcc_sink_copy_data_s16(const struct audio_stream *sink, int16_t *w_ptr,
-				 int samples, int16_t *r_ptr)
+int32_t *mfcc_sink_copy_data_s32(const struct audio_stream *sink, int32_t *w_ptr,
+				 int samples, int16_t *r_ptr, int shift)
 {
 	int copied;
 	int nmax;
@@ -221,10 +208,10 @@ int16_t *mfcc_sink_copy_data_s16(const struct audio_stream *sink, int16_t *w_ptr
 
 	for (copied = 0; copied < samples; copied += n) {
 		nmax = samples - copied;
-		n = audio_stream_samples_without_wrap_s16(sink, w_ptr);
+		n = audio_stream_samples_without_wrap_s32(sink, w_ptr);
 		n = MIN(n, nmax);
 		for (i = 0; i < n; i++) {
-			*w_ptr = *r_ptr;
+			*w_ptr = (int32_t)*r_ptr << shift;
 			r_ptr++;
 			w_ptr++;
 		}
@@ -235,5 +222,5 @@ int16_t *mfcc_sink_copy_data_s16(const struct audio_stream *sink, int16_t *w_ptr
 	return w_ptr;
 }
 
-#endif /* CONFIG_FORMAT_S16LE */
+#endif /* CONFIG_FORMAT_S24LE || CONFIG_FORMAT_S32LE */
 #endif
@@ -33,7 +33,7 @@ static inline void set_circular_buf0(const void *start, const void *end)
  * MFCC algorithm code
  */
 
-void mfcc_source_copy_s16(struct input_stream_buffer *bsource, struct mfcc_buffer *buf,
+void mfcc_source_copy_s16(struct input_stream_buffer *bsource, struct stft_buffer *buf,
 			  struct mfcc_pre_emph *emph, int frames, int source_channel)
 {
 	struct audio_stream __sparse_cache *source = bsource->data;
@@ -44,21 +44,21 @@ void mfcc_source_copy_s16(struct input_stream_buffer *bsource, struct mfcc_buffe
 	int num_channels = audio_stream_get_channels(source);
 	ae_int16 *in;
 	ae_int16 *x = (ae_int16 *)audio_stream_get_rptr(source);
-	ae_int16 *out = (ae_int16 *)buf->w_ptr;
+	ae_int32 *out = (ae_int32 *)buf->w_ptr;
 	ae_int16x4 sample;
 	ae_int32x2 temp;
 	ae_int16x4 coef = emph->coef;
 	ae_int16x4 delay;
 	const int in_inc = sizeof(ae_int16) * num_channels;
 
-	/* Copy from source to pre-buffer for FFT.
+	/* Copy from source to STFT input buffer as Q1.31.
 	 * The pre-emphasis filter is done in this step.
 	 */
 	for (copied = 0; copied < frames; copied += n) {
 		nmax = frames - copied;
 		n = audio_stream_frames_without_wrap(source, x);
 		n = MIN(n, nmax);
-		nmax = mfcc_buffer_samples_without_wrap(buf, (int16_t *)out);
+		nmax = stft_buffer_samples_without_wrap(buf, (int32_t *)out);
 		n = MIN(n, nmax);
 		in = x + source_channel;
 		if (emph->enable) {
@@ -70,161 +70,86 @@ void mfcc_source_copy_s16(struct input_stream_buffer *bsource, struct mfcc_buffe
 				AE_MULAF16SS_00(temp, delay, coef);
 				delay = sample;
 				sample = AE_ROUND16X4F32SSYM(temp, temp);
-				/* 2 = sizeof(ae_int16)*/
-				AE_S16_0_IP(sample, out, 2);
+				temp = AE_CVT32X2F16_10(sample);
+				/* 4 = sizeof(ae_int32)*/
+				AE_S32_L_IP(temp, out, 4);
 			}
 			emph->delay = delay;
 
 		} else {
 			for (i = 0; i < n; i++) {
 				AE_L16_XP(sample, in, in_inc);
-				/* 2 = sizeof(ae_int16)*/
-				AE_S16_0_IP(sample, out, 2);
+				temp = AE_CVT32X2F16_10(sample);
+				/* 4 = sizeof(ae_int32)*/
+				AE_S32_L_IP(temp, out, 4);
 			}
 		}
 
 		x = audio_stream_wrap(source, x + n * num_channels);
-		out = (ae_int16 *)mfcc_buffer_wrap(buf, (int16_t *)out);
+		out = (ae_int32 *)stft_buffer_wrap(buf, (int32_t *)out);
 	}
 	buf->s_avail += copied;
 	buf->s_free -= copied;
-	buf->w_ptr = out;
+	buf->w_ptr = (int32_t *)out;
 }
 
-void mfcc_fill_prev_samples(struct mfcc_buffer *buf, int16_t *prev_data,
-			    int prev_data_length)
+void mfcc_source_copy_s32(struct input_stream_buffer *bsource, struct stft_buffer *buf,
+			  struct mfcc_pre_emph *emph, int frames, int source_channel,
+			  int shift)
 {
-	/* Fill prev_data from input buffer */
-	ae_int32 *out = (ae_int32 *)prev_data;
-	ae_int32 *in = (ae_int32 *)buf->r_ptr;
-	ae_int32x2 in_sample;
-	ae_int16x4 sample;
-	const int inc = sizeof(ae_int32);
-	int n = prev_data_length >> 1;
+	struct audio_stream __sparse_cache *source = bsource->data;
+	int copied;
+	int nmax;
+	int n;
 	int i;
-
-	/* Set buf as circular buffer 0 */
-	set_circular_buf0(buf->addr, buf->end_addr);
-
-	/* very strange this align load is unexpected
-	 * so use load a 32bit to replace 16x4 align load.
-	 */
-	for (i = 0; i < n; i++) {
-		AE_L32_XC(in_sample, in, inc);
-		/* sizeof(ae_int32) = 4 */
-		AE_S32_L_IP(in_sample, out, 4);
-	}
-	if (prev_data_length & 0x01) {
-		AE_L16_XC(sample, (ae_int16 *)in, sizeof(ae_int16));
-		AE_S16_0_IP(sample, (ae_int16 *)out, sizeof(ae_int16));
-	}
-
-	buf->s_avail -= prev_data_length;
-	buf->s_free += prev_data_length;
-	buf->r_ptr = in;
-}
-
-void mfcc_fill_fft_buffer(struct mfcc_state *state)
-{
-	struct mfcc_buffer *buf = &state->buf;
-	struct mfcc_fft *fft = &state->fft;
-	int idx = fft->fft_fill_start_idx;
-	ae_int16 *out = (ae_int16 *)&fft->fft_buf[idx].real;
-	ae_int16 *in = (ae_int16 *)state->prev_data;
-	ae_int16x4 sample;
-	const int buf_inc = sizeof(ae_int16);
-	const int fft_inc = sizeof(fft->fft_buf[0]);
-	int j;
-
-	/* Copy overlapped samples from state buffer. Imaginary part of input
-	 * remains zero.
-	 */
-	for (j = 0; j < state->prev_data_size; j++) {
-		AE_L16_XP(sample, in, buf_inc);
-		AE_S16_0_XP(sample, out, fft_inc);
-	}
-
-	/* Copy hop size of new data from circular buffer */
-	idx += state->prev_data_size;
-	in = (ae_int16 *)buf->r_ptr;
-	out = (ae_int16 *)&fft->fft_buf[idx].real;
-	set_circular_buf0(buf->addr, buf->end_addr);
-	for (j = 0; j < fft->fft_hop_size; j++) {
-		AE_L16_XC(sample, in, buf_inc);
-		AE_S16_0_XP(sample, out, fft_inc);
-	}
-
-	buf->s_avail -= fft->fft_hop_size;
-	buf->s_free += fft->fft_hop_size;
-	buf->r_ptr = in;
-
-	/* Copy for next time data back to overlap buffer */
-	idx = fft->fft_fill_start_idx + fft->fft_hop_size;
-	in = (ae_int16 *)&fft->fft_buf[idx].real;
-	out = (ae_int16 *)state->prev_data;
-	for (j = 0; j < state->prev_data_size; j++) {
-		AE_L16_XP(sample, in, fft_inc);
-		AE_S16_0_XP(sample, out, buf_inc);
-	}
-}
-
-#ifdef MFCC_NORMALIZE_FFT
-int mfcc_normalize_fft_buffer(struct mfcc_state *state)
-{
-	struct mfcc_fft *fft = &state->fft;
-	ae_p16s *in = (ae_p16s *)&fft->fft_buf[fft->fft_fill_start_idx].real;
+	int num_channels = audio_stream_get_channels(source);
+	ae_int32 *in;
+	ae_int32 *x = (ae_int32 *)audio_stream_get_rptr(source);
+	ae_int32 *out = (ae_int32 *)buf->w_ptr;
 	ae_int32x2 sample;
-	ae_int32x2 max = AE_ZERO32();
-	const int fft_inc = sizeof(fft->fft_buf[0]);
-	int shift;
-	int j;
-
-	for (j = 0; j < fft->fft_size; j++) {
-		/* load 16-bit data to middle of 32-bit container*/
-		AE_L16M_XU(sample, in, fft_inc);
-		max = AE_MAXABS32S(max, sample);
-	}
-	shift = AE_NSAZ32_L(max) - 8;/* 16 bit data */
-	shift = MAX(shift, 0);
-	shift = MIN(shift, MFCC_NORMALIZE_MAX_SHIFT);
-	return shift;
-}
-#endif
-void mfcc_apply_window(struct mfcc_state *state, int input_shift)
-{
-	struct mfcc_fft *fft = &state->fft;
-	const int fft_inc = sizeof(fft->fft_buf[0]);
-	ae_int16 *win_in = (ae_int16 *)state->window;
-	const int win_inc = sizeof(ae_int16);
 	ae_int32x2 temp;
-	ae_int16x4 win;
-	int j;
-
-#if MFCC_FFT_BITS == 16
-	ae_int16 *fft_in = (ae_int16 *)&fft->fft_buf[fft->fft_fill_start_idx].real;
-	ae_int16x4 sample;
+	ae_int16x4 coef = emph->coef;
+	ae_int32x2 delay;
+	const int in_inc = sizeof(ae_int32) * num_channels;
 
-	for (j = 0; j < fft->fft_size; j++) {
-		AE_L16_IP(sample, fft_in, 0);
-		AE_L16_XP(win, win_in, win_inc);
-		temp = AE_MULF16SS_00(sample, win);
-		temp = AE_SLAA32S(temp, input_shift);
-		sample = AE_ROUND16X4F32SASYM(temp, temp);
-		AE_S16_0_XP(sample, fft_in, fft_inc);
-	}
-#else
-	ae_int32 *fft_in = (ae_int32 *)&fft->fft_buf[fft->fft_fill_start_idx].real;
-	ae_int32x2 sample;
+	/* Copy from source to STFT input buffer as Q1.31. The 24 bit samples
+	 * are shifted left to Q1.31. The pre-emphasis filter is done in this step.
+	 */
+	for (copied = 0; copied < frames; copied += n) {
+		nmax = frames - copied;
+		n = audio_stream_frames_without_wrap(source, x);
+		n = MIN(n, nmax);
+		nmax = stft_buffer_samples_without_wrap(buf, (int32_t *)out);
+		n = MIN(n, nmax);
+		in = x + source_channel;
+		if (emph->enable) {
+			delay = emph->delay32;
+			for (i = 0; i < n; i++) {
+				AE_L32_XP(sample, in, in_inc);
+				sample = AE_SLAA32(sample, shift);
+				/* Q1.31 x Q1.15 -> Q1.31 */
+				temp = AE_MULFP32X16X2RS_L(delay, coef);
+				temp = AE_ADD32S(temp, sample);
+				delay = sample;
+				/* 4 = sizeof(ae_int32)*/
+				AE_S32_L_IP(temp, out, 4);
+			}
+			emph->delay32 = AE_MOVAD32_L(delay);
+		} else {
+			for (i = 0; i < n; i++) {
+				AE_L32_XP(sample, in, in_inc);
+				sample = AE_SLAA32(sample, shift);
+				/* 4 = sizeof(ae_int32)*/
+				AE_S32_L_IP(sample, out, 4);
+			}
+		}
 
-	for (j = 0; j < fft->fft_size; j++) {
-		AE_L32_IP(sample, fft_in, 0);
-		AE_L16_XP(win, win_in, win_inc);
-		temp = AE_MULFP32X16X2RS_H(sample, win);
-		temp = AE_MULFP32X16X2RS_L(sample, win);
-		temp = AE_SLAA32S(temp, input_shift);
-		AE_S32_L_XP(temp, fft_in, fft_inc);
+		x = audio_stream_wrap(source, x + n * num_channels);
+		out = (ae_int32 *)stft_buffer_wrap(buf, (int32_t *)out);
 	}
-#endif
+	buf->s_avail += copied;
+	buf->s_free -= copied;
+	buf->w_ptr = (int32_t *)out;
 }
 
 #if CONFIG_FORMAT_S16LE
@@ -288,4 +213,57 @@ int16_t *mfcc_sink_copy_data_s16(const struct audio_stream *sink, int16_t *w_ptr
 }
 
 #endif /* CONFIG_FORMAT_S16LE */
+
+#if CONFIG_FORMAT_S24LE || CONFIG_FORMAT_S32LE
+
+int32_t *mfcc_sink_copy_zero_s32(const struct audio_stream *sink,
+				 int32_t *w_ptr, int samples)
+{
+	int i;
+	int n = samples >> 1;
+	int m = samples & 0x01;
+	ae_int32x2 *out = (ae_int32x2 *)w_ptr;
+	const int inc = sizeof(ae_int32);
+	ae_valign outu = AE_ZALIGN64();
+	ae_int32x2 zero = AE_ZERO32();
+
+	set_circular_buf0(sink->addr, sink->end_addr);
+
+	for (i = 0; i < n; i++)
+		AE_SA32X2_IC(zero, outu, out);
+
+	AE_SA64POS_FP(outu, out);
+	/* process the left sample one by one to avoid memory access overrun */
+	for (i = 0; i < m ; i++)
+		AE_S32_L_XC(zero, (ae_int32 *)out, inc);
+
+	return (int32_t *)out;
+}
+
+int32_t *mfcc_sink_copy_data_s32(const struct audio_stream *sink, int32_t *w_ptr,
+				 int samples, int16_t *r_ptr, int shift)
+{
+	ae_int32 *out = (ae_int32 *)w_ptr;
+	ae_int16 *in = (ae_int16 *)r_ptr;
+	const int in_inc = sizeof(ae_int16);
+	const int out_inc = sizeof(ae_int32);
+	const int rshift = 16 - shift;
+	ae_int16x4 in_sample;
+	ae_int32x2 sample;
+	int i;
+
+	set_circular_buf0(sink->addr, sink->end_addr);
+
+	for (i = 0; i < samples; i++) {
+		AE_L16_XP(in_sample, in, in_inc);
+		/* Q1.15 -> Q1.31, then right shift to the sink alignment */
+		sample = AE_CVT32X2F16_10(in_sample);
+		sample = AE_SRAA32(sample, rshift);
+		AE_S32_L_XC(sample, out, out_inc);
+	}
+
+	return (int32_t *)out;
+}
+
+#endif /* CONFIG_FORMAT_S24LE || CONFIG_FORMAT_S32LE */
 #endif
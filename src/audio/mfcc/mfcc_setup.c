@@ -23,33 +23,21 @@
 
 LOG_MODULE_REGISTER(mfcc_setup, CONFIG_SOF_LOG_LEVEL);
 
-static void mfcc_init_buffer(struct mfcc_buffer *buf, int16_t *base, int size)
+static int mfcc_get_window(struct mfcc_state *state, enum sof_mfcc_fft_window_type name,
+			   int length)
 {
-	buf->addr = base;
-	buf->end_addr = base + size;
-	buf->r_ptr = base;
-	buf->w_ptr = base;
-	buf->s_free = size;
-	buf->s_avail = 0;
-	buf->s_length = size;
-}
-
-static int mfcc_get_window(struct mfcc_state *state, enum sof_mfcc_fft_window_type name)
-{
-	struct mfcc_fft *fft = &state->fft;
-
 	switch (name) {
 	case MFCC_RECTANGULAR_WINDOW:
-		win_rectangular_16b(state->window, fft->fft_size);
+		win_rectangular_16b(state->window, length);
 		return 0;
 	case MFCC_BLACKMAN_WINDOW:
-		win_blackman_16b(state->window, fft->fft_size, MFCC_BLACKMAN_A0);
+		win_blackman_16b(state->window, length, MFCC_BLACKMAN_A0);
 		return 0;
 	case MFCC_HAMMING_WINDOW:
-		win_hamming_16b(state->window, fft->fft_size);
+		win_hamming_16b(state->window, length);
 		return 0;
 	case MFCC_POVEY_WINDOW:
-		win_povey_16b(state->window, fft->fft_size);
+		win_povey_16b(state->window, length);
 		return 0;
 
 	default:
@@ -94,6 +82,49 @@ static int mfcc_get_cepstral_lifter(struct mfcc_cepstral_lifter *cl)
 	return 0;
 }
 
+/* The cepstral lifter is applied to the DCT output with an elementwise multiply.
+ * It is folded into DCT matrix columns so that the cepstral coefficients are
+ * computed with one matrix multiply. The fractional bits of the output matrix
+ * are set to fit the largest coefficient to 16 bits.
+ */
+static int mfcc_get_dct_lifter(struct mfcc_state *state)
+{
+	struct mat_matrix_16b *dct = state->dct.matrix;
+	struct mat_matrix_16b *lifter = state->lifter.matrix;
+	int32_t max_abs = 0;
+	int32_t coef;
+	int32_t v;
+	int fractions = 15;
+	int i;
+	int j;
+
+	for (i = 0; i < dct->rows; i++) {
+		for (j = 0; j < dct->columns; j++) {
+			coef = lifter ? mat_get_scalar_16b(lifter, 0, j) : ONE_Q9;
+			v = (int32_t)mat_get_scalar_16b(dct, i, j) * coef; /* Q8.24 */
+			max_abs = MAX(max_abs, ABS(v));
+		}
+	}
+
+	while (fractions > 0 && Q_SHIFT_RND(max_abs, 24, fractions) > INT16_MAX)
+		fractions--;
+
+	state->dct_lifter = mat_matrix_alloc_16b(dct->rows, dct->columns, fractions);
+	if (!state->dct_lifter)
+		return -ENOMEM;
+
+	for (i = 0; i < dct->rows; i++) {
+		for (j = 0; j < dct->columns; j++) {
+			coef = lifter ? mat_get_scalar_16b(lifter, 0, j) : ONE_Q9;
+			v = (int32_t)mat_get_scalar_16b(dct, i, j) * coef;
+			mat_set_scalar_16b(state->dct_lifter, i, j,
+					   sat_int16(Q_SHIFT_RND(v, 24, fractions)));
+		}
+	}
+
+	return 0;
+}
+
 /* TODO mfcc setup needs to use the config blob, not hard coded parameters.
  * Also this is a too long function. Split to STFT, Mel filter, etc. parts.
  */
@@ -103,7 +134,7 @@ int mfcc_setup(struct processing_module *mod, int max_frames, int sample_rate, i
 	struct comp_dev *dev = mod->dev;
 	struct sof_mfcc_config *config = cd->config;
 	struct mfcc_state *state = &cd->state;
-	struct mfcc_fft *fft = &state->fft;
+	struct stft_plan *st = &state->stft;
 	struct psy_mel_filterbank *fb = &state->melfb;
 	struct dct_plan_16 *dct = &state->dct;
 	int ret;
@@ -151,67 +182,17 @@ int mfcc_setup(struct processing_module *mod, int max_frames, int sample_rate, i
 
 	state->emph.enable = config->preemphasis_coefficient > 0;
 	state->emph.coef = -config->preemphasis_coefficient; /* Negate config parameter */
-	fft->fft_size = config->frame_length;
-	fft->fft_padded_size = 1 << (31 - norm_int32(fft->fft_size)); /* Round up to nearest 2^N */
-	fft->fft_hop_size = config->frame_shift;
-	fft->half_fft_size = (fft->fft_padded_size >> 1) + 1;
-
-	comp_info(dev, "mfcc_setup(), emphasis = %d, fft_size = %d, fft_padded_size = %d, fft_hop_size = %d",
-		  config->preemphasis_coefficient,
-		  fft->fft_size, fft->fft_padded_size, fft->fft_hop_size);
-
-	/* Calculated parameters */
-	state->prev_data_size = fft->fft_size - fft->fft_hop_size;
-	state->buffer_size = fft->fft_size + max_frames;
-
-	/* Allocate buffer input samples and overlap buffer */
-	state->sample_buffers_size = sizeof(int16_t) *
-		(state->buffer_size + state->prev_data_size + fft->fft_size);
-
-	comp_info(dev, "mfcc_setup(), buffer_size = %d, prev_size = %d",
-		  state->buffer_size, state->prev_data_size);
-
-	state->buffers = rzalloc(SOF_MEM_ZONE_RUNTIME, 0, SOF_MEM_CAPS_RAM,
-				 state->sample_buffers_size);
-	if (!state->buffers) {
-		comp_err(dev, "mfcc_setup(): Failed buffer allocate");
-		ret = -ENOMEM;
-		goto exit;
-	}
-
-	mfcc_init_buffer(&state->buf, state->buffers, state->buffer_size);
-	state->prev_data = state->buffers + state->buffer_size;
-	state->window = state->prev_data + state->prev_data_size;
 
-	/* Allocate buffers for FFT input and output data */
-#if MFCC_FFT_BITS == 16
-	fft->fft_buffer_size = fft->fft_padded_size * sizeof(struct icomplex16);
-#else
-	fft->fft_buffer_size = fft->fft_padded_size * sizeof(struct icomplex32);
-#endif
-	fft->fft_buf = rzalloc(SOF_MEM_ZONE_RUNTIME, 0, SOF_MEM_CAPS_RAM, fft->fft_buffer_size);
-	if (!fft->fft_buf) {
-		comp_err(dev, "mfcc_setup(): Failed FFT buffer allocate");
-		ret = -ENOMEM;
-		goto free_buffers;
-	}
+	comp_info(dev, "mfcc_setup(), emphasis = %d, frame_length = %d, frame_shift = %d",
+		  config->preemphasis_coefficient, config->frame_length, config->frame_shift);
 
-	fft->fft_out = rzalloc(SOF_MEM_ZONE_RUNTIME, 0, SOF_MEM_CAPS_RAM, fft->fft_buffer_size);
-	if (!fft->fft_out) {
-		comp_err(dev, "mfcc_setup(): Failed FFT output allocate");
+	/* Allocate window function */
+	state->window = rzalloc(SOF_MEM_ZONE_RUNTIME, 0, SOF_MEM_CAPS_RAM,
+				sizeof(int16_t) * config->frame_length);
+	if (!state->window) {
+		comp_err(dev, "mfcc_setup(): Failed window allocate");
 		ret = -ENOMEM;
-		goto free_fft_buf;
-	}
-
-	fft->fft_fill_start_idx = 0; /* From config pad_type */
-
-	/* Setup FFT */
-	fft->fft_plan = fft_plan_new(fft->fft_buf, fft->fft_out, fft->fft_padded_size,
-				     MFCC_FFT_BITS);
-	if (!fft->fft_plan) {
-		comp_err(dev, "mfcc_setup(): Failed FFT init");
-		ret = -EINVAL;
-		goto free_fft_out;
+		goto exit;
 	}
 
 	comp_info(dev, "mfcc_setup(), window = %d, num_mel_bins = %d, num_ceps = %d, norm = %d",
@@ -220,12 +201,26 @@ int mfcc_setup(struct processing_module *mod, int max_frames, int sample_rate, i
 		  state->low_freq, state->high_freq);
 
 	/* Setup window */
-	ret = mfcc_get_window(state, config->window);
+	ret = mfcc_get_window(state, config->window, config->frame_length);
 	if (ret < 0) {
 		comp_err(dev, "mfcc_setup(): Failed Window function");
-		goto free_fft_out;
+		goto free_window;
+	}
+
+	/* Setup STFT, the input buffer, FFT buffers and FFT plan */
+	ret = stft_plan_init(st, config->frame_length, config->frame_shift, MFCC_FFT_BITS,
+			     max_frames, state->window, false);
+	if (ret < 0) {
+		comp_err(dev, "mfcc_setup(): Failed STFT init");
+		goto free_window;
 	}
 
+#ifndef MFCC_NORMALIZE_FFT
+	st->max_shift = 0;
+#endif
+
+	comp_info(dev, "mfcc_setup(), fft_padded_size = %d", st->fft_padded_size);
+
 	/* Setup Mel auditory filterbank. FFT input and output buffers are used
 	 * as scratch in Mel filterbank initialization. Filterbank get function will
 	 * return error if not sufficient size.
@@ -236,16 +231,16 @@ int mfcc_setup(struct processing_module *mod, int max_frames, int sample_rate, i
 	fb->mel_bins = config->num_mel_bins;
 	fb->slaney_normalize = config->norm == MFCC_MEL_NORM_SLANEY; /* True if slaney */
 	fb->mel_log_scale = (enum psy_mel_log_scale)((int)config->mel_log);  /* LOG, LOG10 or DB */
-	fb->fft_bins = fft->fft_padded_size;
-	fb->half_fft_bins = (fft->fft_padded_size >> 1) + 1;
-	fb->scratch_data1 = (int16_t *)fft->fft_buf;
-	fb->scratch_data2 = (int16_t *)fft->fft_out;
-	fb->scratch_length1 = fft->fft_buffer_size / sizeof(int16_t);
-	fb->scratch_length2 = fft->fft_buffer_size / sizeof(int16_t);
+	fb->fft_bins = st->fft_padded_size;
+	fb->half_fft_bins = (st->fft_padded_size >> 1) + 1;
+	fb->scratch_data1 = st->fft_buf;
+	fb->scratch_data2 = st->fft_out;
+	fb->scratch_length1 = st->fft_buffer_size / sizeof(int16_t);
+	fb->scratch_length2 = st->fft_buffer_size / sizeof(int16_t);
 	ret = psy_get_mel_filterbank(fb);
 	if (ret < 0) {
 		comp_err(dev, "mfcc_setup(): Failed Mel filterbank");
-		goto free_fft_out;
+		goto free_stft;
 	}
 
 	/* Setup DCT */
@@ -261,57 +256,92 @@ int mfcc_setup(struct processing_module *mod, int max_frames, int sample_rate, i
 
 	state->lifter.num_ceps = config->num_ceps;
 	state->lifter.cepstral_lifter = config->cepstral_lifter; /* Q7.9 max 64.0*/
-	ret = mfcc_get_cepstral_lifter(&state->lifter);
+	if (state->lifter.cepstral_lifter != 0) {
+		ret = mfcc_get_cepstral_lifter(&state->lifter);
+		if (ret < 0) {
+			comp_err(dev, "mfcc_setup(): Failed cepstral lifter");
+			goto free_dct_matrix;
+		}
+	}
+
+	ret = mfcc_get_dct_lifter(state);
 	if (ret < 0) {
-		comp_err(dev, "mfcc_setup(): Failed cepstral lifter");
-		goto free_dct_matrix;
+		comp_err(dev, "mfcc_setup(): Failed DCT lifter matrix");
+		goto free_lifter_matrix;
+	}
+
+	/* Mel spectra for all frames that can become ready in one process call, and
+	 * the ring for cepstral coefficients output.
+	 */
+	state->max_batch = max_frames / config->frame_shift + 1;
+	state->mel_batch = rzalloc(SOF_MEM_ZONE_RUNTIME, 0, SOF_MEM_CAPS_RAM,
+				   sizeof(int16_t) * state->max_batch * dct->num_in);
+	if (!state->mel_batch) {
+		comp_err(dev, "mfcc_setup(): Failed Mel batch allocate");
+		ret = -ENOMEM;
+		goto free_dct_lifter;
+	}
+
+	state->features.num_ceps = dct->num_out;
+	state->features.slots = CONFIG_COMP_MFCC_FEATURE_FRAMES;
+	atomic_init(&state->features.w_idx, 0);
+	atomic_init(&state->features.r_idx, 0);
+	state->features.overruns = 0;
+	state->features.sink_consumer = IS_ENABLED(CONFIG_COMP_MFCC_FEATURE_SINK);
+	state->features.data = rzalloc(SOF_MEM_ZONE_RUNTIME, 0, SOF_MEM_CAPS_RAM,
+				       sizeof(int16_t) * state->features.slots * dct->num_out);
+	if (!state->features.data) {
+		comp_err(dev, "mfcc_setup(): Failed feature ring allocate");
+		ret = -ENOMEM;
+		goto free_mel_batch;
 	}
 
+	comp_info(dev, "mfcc_setup(), max_batch = %d, feature_frames = %d",
+		  state->max_batch, state->features.slots);
+
 	/* Scratch overlay during runtime
 	 *
 	 *  +--------------------------------------------------------+
 	 *  | 1. fft_buf[], 16 bits,size x 4, e.g. 512 -> 2048 bytes |
 	 *  +-------------------------------------+------------------+
-	 *  | 3. power_spectra[],                 |
+	 *  | 2. power_spectra[],                 |
 	 *  |    32 bits, e.g. x257 -> 1028 bytes |
 	 *  +-------------------------------------+
 	 *
-	 *  +---------------------------------------------------------------------------------+
-	 *  | 2. fft_out[], 16 bits,size x 4, e.g. 512 -> 2048 bytes                          |
-	 *  +----------------------------------+----------------------------------+-----------+
-	 *  | 4. mel_spectra[],                | 5. cepstral_coef[],              |
-	 *  |    16 bits, e.g. x23 -> 46 bytes |    16 bits, e.g. 13x -> 26 bytes |
-	 *  +----------------------------------+----------------------------------+
-	 *
 	 */
 
 	/* Use FFT buffer as scratch for later computed data */
-	state->power_spectra = (int32_t *)&fft->fft_buf[0];
-	state->mel_spectra = (struct mat_matrix_16b *)&fft->fft_out[0];
-	state->cepstral_coef = (struct mat_matrix_16b *)
-		&state->mel_spectra->data[state->dct.num_in];
+	state->power_spectra = st->fft_buf;
 
-	/* Set initial state for STFT */
-	state->waiting_fill = true;
-	state->prev_samples_valid = false;
+	/* The separate DCT and lifter matrices are not needed in processing */
+	rfree(state->lifter.matrix);
+	rfree(dct->matrix);
+	state->lifter.matrix = NULL;
+	dct->matrix = NULL;
 
 	comp_dbg(dev, "mfcc_setup(), done");
 	return 0;
 
+free_mel_batch:
+	rfree(state->mel_batch);
+
+free_dct_lifter:
+	rfree(state->dct_lifter);
+
+free_lifter_matrix:
+	rfree(state->lifter.matrix);
+
 free_dct_matrix:
 	rfree(state->dct.matrix);
 
 free_melfb_data:
 	rfree(fb->data);
 
-free_fft_out:
-	rfree(fft->fft_out);
-
-free_fft_buf:
-	rfree(fft->fft_buf);
+free_stft:
+	stft_plan_free(st);
 
-free_buffers:
-	rfree(state->buffers);
+free_window:
+	rfree(state->window);
 
 exit:
 	return ret;
@@ -319,11 +349,10 @@ exit:
 
 void mfcc_free_buffers(struct mfcc_comp_data *cd)
 {
-	fft_plan_free(cd->state.fft.fft_plan);
-	rfree(cd->state.fft.fft_buf);
-	rfree(cd->state.fft.fft_out);
-	rfree(cd->state.buffers);
+	stft_plan_free(&cd->state.stft);
+	rfree(cd->state.window);
 	rfree(cd->state.melfb.data);
-	rfree(cd->state.dct.matrix);
-	rfree(cd->state.lifter.matrix);
+	rfree(cd->state.dct_lifter);
+	rfree(cd->state.mel_batch);
+	rfree(cd->state.features.data);
 }
@@ -194,6 +194,8 @@ static int multiband_drc_init_coef(struct processing_module *mod, int16_t nch, u
 			comp_err(dev, "multiband_drc_init_coef(), could not set pre delay time");
 			goto err;
 		}
+
+		drc_init_gain_lut(&state->drc[i], &cd->config->drc_coef[i]);
 	}
 
 	return 0;
@@ -249,7 +251,7 @@ static int multiband_drc_init(struct processing_module *mod)
 
 	md->private = cd;
 	cd->multiband_drc_func = NULL;
-	cd->crossover_split = NULL;
+	cd->crossover_split_block = NULL;
 #if CONFIG_IPC_MAJOR_4
 	/* Note: Currently there is no ALSA switch control in IPC4 to control
 	 * processing on/off. This workaround can be removed after is available.
@@ -518,8 +520,9 @@ static int multiband_drc_prepare(struct processing_module *mod,
 			return -EINVAL;
 		}
 
-		cd->crossover_split = crossover_find_split_func(cd->config->num_bands);
-		if (!cd->crossover_split) {
+		cd->crossover_split_block =
+			crossover_find_split_block_func(cd->config->num_bands);
+		if (!cd->crossover_split_block) {
 			comp_err(dev, "multiband_drc_prepare(), No crossover_split for band num %i",
 				 cd->config->num_bands);
 			return -EINVAL;
@@ -546,7 +549,7 @@ static int multiband_drc_reset(struct processing_module *mod)
 
 	cd->source_format = 0;
 	cd->multiband_drc_func = NULL;
-	cd->crossover_split = NULL;
+	cd->crossover_split_block = NULL;
 
 	return 0;
 }
@@ -18,188 +18,160 @@ static void multiband_drc_default_pass(const struct processing_module *mod,
 	audio_stream_copy(source, 0, sink, 0, audio_stream_get_channels(source) * frames);
 }
 
-static void multiband_drc_process_emp_crossover(struct multiband_drc_state *state,
-						crossover_split split_func,
-						int32_t *buf_src,
-						int32_t *buf_sink,
-						int enable_emp,
-						int nch,
-						int nband)
+/* Run emphasis or deemphasis filter of all channels for an interleaved
+ * block, adjacent channels are filtered as pairs.
+ */
+static void multiband_drc_process_iir_block(struct iir_state_df2t iir[],
+					    int32_t *buf, int frames, int nch)
 {
-	struct iir_state_df2t *emp_s;
-	struct crossover_state *crossover_s;
-	int32_t *buf_sink_band;
-	int ch, band;
-	int32_t emp_out;
-	int32_t crossover_out[nband];
-
-	for (ch = 0; ch < nch; ch++) {
-		emp_s = &state->emphasis[ch];
-		crossover_s = &state->crossover[ch];
-
-		if (enable_emp)
-			emp_out = iir_df2t(emp_s, *buf_src);
-		else
-			emp_out = *buf_src;
-
-		split_func(emp_out, crossover_out, crossover_s);
-		buf_sink_band = buf_sink;
-		for (band = 0; band < nband; band++) {
-			*buf_sink_band = crossover_out[band];
-			buf_sink_band += PLATFORM_MAX_CHANNELS;
-		}
+	int ch;
 
-		buf_src++;
-		buf_sink++;
-	}
+	for (ch = 0; ch + 1 < nch; ch += 2)
+		iir_df2t_block_x2(&iir[ch], &iir[ch + 1], buf + ch, buf + ch, frames, nch);
+
+	if (ch < nch)
+		iir_df2t_block(&iir[ch], buf + ch, buf + ch, frames, nch);
 }
 
-#if CONFIG_FORMAT_S16LE
-static void multiband_drc_s16_process_drc(struct drc_state *state,
-					  const struct sof_drc_params *p,
-					  int32_t *buf_src,
-					  int32_t *buf_sink,
-					  int nch)
+/* Compressor state update that is done before the first frame */
+static void multiband_drc_process_start(struct multiband_drc_state *state,
+					const struct sof_drc_params *params,
+					int nbyte, int nch, int nband)
 {
-	int16_t *pd_write;
-	int16_t *pd_read;
-	int ch;
-	int pd_write_index;
-	int pd_read_index;
+	struct drc_state *drc;
+	int band;
 
-	if (p->enabled && !state->processed) {
-		drc_update_envelope(state, p);
-		drc_compress_output(state, p, 2, nch);
-		state->processed = 1;
+	for (band = 0; band < nband; band++) {
+		drc = &state->drc[band];
+		if (params[band].enabled && !drc->processed) {
+			drc_update_envelope(drc, &params[band]);
+			drc_compress_output(drc, &params[band], nbyte, nch);
+			drc->processed = 1;
+		}
 	}
+}
 
-	pd_write_index = state->pre_delay_write_index;
-	pd_read_index = state->pre_delay_read_index;
-
-	for (ch = 0; ch < nch; ++ch) {
-		pd_write = (int16_t *)state->pre_delay_buffers[ch] + pd_write_index;
-		pd_read = (int16_t *)state->pre_delay_buffers[ch] + pd_read_index;
-		*pd_write = sat_int16(Q_SHIFT_RND(*buf_src, 31, 15));
-		*buf_sink = *pd_read << 16;
-
-		buf_src++;
-		buf_sink++;
-	}
+/* Advance the pre-delay of a band by one frame and process the input
+ * division (32 frames) when it is complete.
+ */
+static inline void multiband_drc_band_advance(struct drc_state *state,
+					      const struct sof_drc_params *p,
+					      int nbyte, int nch)
+{
+	int pd_write_index;
 
-	pd_write_index = (pd_write_index + 1) & DRC_MAX_PRE_DELAY_FRAMES_MASK;
-	pd_read_index = (pd_read_index + 1) & DRC_MAX_PRE_DELAY_FRAMES_MASK;
+	pd_write_index = (state->pre_delay_write_index + 1) & DRC_MAX_PRE_DELAY_FRAMES_MASK;
 	state->pre_delay_write_index = pd_write_index;
-	state->pre_delay_read_index = pd_read_index;
+	state->pre_delay_read_index = (state->pre_delay_read_index + 1) &
+				      DRC_MAX_PRE_DELAY_FRAMES_MASK;
 
-	/* Only perform delay frames by early return here if not enabled */
+	/* Only perform delay frames if not enabled */
 	if (!p->enabled)
 		return;
 
-	/* Process the input division (32 frames). */
 	if (!(pd_write_index & DRC_DIVISION_FRAMES_MASK)) {
-		drc_update_detector_average(state, p, 2, nch);
+		drc_update_detector_average(state, p, nbyte, nch);
 		drc_update_envelope(state, p);
-		drc_compress_output(state, p, 2, nch);
+		drc_compress_output(state, p, nbyte, nch);
 	}
 }
-#endif /* CONFIG_FORMAT_S16LE */
 
-#if CONFIG_FORMAT_S24LE || CONFIG_FORMAT_S32LE
-static void multiband_drc_s32_process_drc(struct drc_state *state,
-					  const struct sof_drc_params *p,
-					  int32_t *buf_src,
-					  int32_t *buf_sink,
-					  int nch)
+#if CONFIG_FORMAT_S16LE
+/* Run the DRCs of all bands for a block of crossover output. For each
+ * frame all bands are pushed to their pre-delay and the delayed outputs
+ * are mixed in the same pass.
+ */
+static void multiband_drc_s16_process_bands(struct multiband_drc_state *state,
+					    const struct sof_drc_params *params,
+					    int32_t *band_buf[], int32_t *mix,
+					    int frames, int nch, int nband)
 {
-	int32_t *pd_write;
-	int32_t *pd_read;
-	int ch;
-	int pd_write_index;
-	int pd_read_index;
-
-	if (p->enabled && !state->processed) {
-		drc_update_envelope(state, p);
-		drc_compress_output(state, p, 4, nch);
-		state->processed = 1;
-	}
-
-	pd_write_index = state->pre_delay_write_index;
-	pd_read_index = state->pre_delay_read_index;
+	struct drc_state *drc;
+	int32_t *src;
+	int16_t *pd;
+	int band, ch, i;
+	int rd, wr;
 
-	for (ch = 0; ch < nch; ++ch) {
-		pd_write = (int32_t *)state->pre_delay_buffers[ch] + pd_write_index;
-		pd_read = (int32_t *)state->pre_delay_buffers[ch] + pd_read_index;
-		*pd_write = *buf_src;
-		*buf_sink = *pd_read;
+	multiband_drc_process_start(state, params, 2, nch, nband);
 
-		buf_src++;
-		buf_sink++;
-	}
+	for (i = 0; i < frames; i++) {
+		for (ch = 0; ch < nch; ch++)
+			mix[ch] = 0;
 
-	pd_write_index = (pd_write_index + 1) & DRC_MAX_PRE_DELAY_FRAMES_MASK;
-	pd_read_index = (pd_read_index + 1) & DRC_MAX_PRE_DELAY_FRAMES_MASK;
-	state->pre_delay_write_index = pd_write_index;
-	state->pre_delay_read_index = pd_read_index;
+		for (band = 0; band < nband; band++) {
+			drc = &state->drc[band];
+			src = band_buf[band] + i * nch;
+			wr = drc->pre_delay_write_index;
+			rd = drc->pre_delay_read_index;
+			for (ch = 0; ch < nch; ch++) {
+				pd = (int16_t *)drc->pre_delay_buffers[ch];
+				pd[wr] = sat_int16(Q_SHIFT_RND(src[ch], 31, 15));
+				mix[ch] = sat_int32((int64_t)mix[ch] + (pd[rd] << 16));
+			}
 
-	/* Only perform delay frames by early return here if not enabled */
-	if (!p->enabled)
-		return;
+			multiband_drc_band_advance(drc, &params[band], 2, nch);
+		}
 
-	/* Process the input division (32 frames). */
-	if (!(pd_write_index & DRC_DIVISION_FRAMES_MASK)) {
-		drc_update_detector_average(state, p, 4, nch);
-		drc_update_envelope(state, p);
-		drc_compress_output(state, p, 4, nch);
+		mix += nch;
 	}
 }
-#endif /* CONFIG_FORMAT_S24LE || CONFIG_FORMAT_S32LE */
+#endif /* CONFIG_FORMAT_S16LE */
 
-static void multiband_drc_process_deemp(struct multiband_drc_state *state,
-					int32_t *buf_src,
-					int32_t *buf_sink,
-					int enable_deemp,
-					int nch,
-					int nband)
+#if CONFIG_FORMAT_S24LE || CONFIG_FORMAT_S32LE
+static void multiband_drc_s32_process_bands(struct multiband_drc_state *state,
+					    const struct sof_drc_params *params,
+					    int32_t *band_buf[], int32_t *mix,
+					    int frames, int nch, int nband)
 {
-	struct iir_state_df2t *deemp_s;
-	int32_t *buf_src_band;
-	int ch, band;
-	int32_t mix_out;
+	struct drc_state *drc;
+	int32_t *src;
+	int32_t *pd;
+	int band, ch, i;
+	int rd, wr;
+
+	multiband_drc_process_start(state, params, 4, nch, nband);
 
-	for (ch = 0; ch < nch; ch++) {
-		deemp_s = &state->deemphasis[ch];
+	for (i = 0; i < frames; i++) {
+		for (ch = 0; ch < nch; ch++)
+			mix[ch] = 0;
 
-		buf_src_band = buf_src;
-		mix_out = 0;
 		for (band = 0; band < nband; band++) {
-			mix_out = sat_int32((int64_t)mix_out + *buf_src_band);
-			buf_src_band += PLATFORM_MAX_CHANNELS;
-		}
+			drc = &state->drc[band];
+			src = band_buf[band] + i * nch;
+			wr = drc->pre_delay_write_index;
+			rd = drc->pre_delay_read_index;
+			for (ch = 0; ch < nch; ch++) {
+				pd = (int32_t *)drc->pre_delay_buffers[ch];
+				pd[wr] = src[ch];
+				mix[ch] = sat_int32((int64_t)mix[ch] + pd[rd]);
+			}
 
-		if (enable_deemp)
-			*buf_sink = iir_df2t(deemp_s, mix_out);
-		else
-			*buf_sink = mix_out;
+			multiband_drc_band_advance(drc, &params[band], 4, nch);
+		}
 
-		buf_src++;
-		buf_sink++;
+		mix += nch;
 	}
 }
+#endif /* CONFIG_FORMAT_S24LE || CONFIG_FORMAT_S32LE */
 
- /* This graph illustrates the buffers declared in the following default functions, as the example
+ /* This graph illustrates the buffers used in the following default functions, as the example
   * of a 3-band Multiband DRC:
   *
-  *            :buf_src[nch]                            :buf_drc_sink[nch*nband]
+  *            :band_block[nband - 1]                   :block
   *            :                                        :
-  *            :                           o-[]-> DRC0 -[]--o
-  *            :                           | :          :   |
-  *            :                 3-WAY     | :          :   |
-  *    source -[]-> EQ EMP --> CROSSOVER --o-[]-> DRC1 -[]-(+)--> EQ DEEMP -[]-> sink
-  *                                        | :          :   |               :
-  *                                        | :          :   |               :
-  *                                        o-[]-> DRC2 -[]--o               :
-  *                                          :                              :
-  *                                          :buf_drc_src[nch*nband]        :buf_sink[nch]
+  *            :                           o-[]-> DRC0 -+   :
+  *            :                           | :          |   :
+  *            :                 3-WAY     | :          |   :
+  *    source -[]-> EQ EMP --> CROSSOVER --o-[]-> DRC1 -(+)-[]-> EQ DEEMP -[]-> sink
+  *                                        | :          |                 :
+  *                                        | :          |                 :
+  *                                        o-[]-> DRC2 -+                 :
+  *                                          :                            :
+  *                                          :band_block[0 .. nband - 1]  :block
+  *
+  * The crossover is the block band split of the crossover component and
+  * works in place in band_block[]. The DRCs of all bands and the mix run
+  * in one pass per frame.
   */
 #if CONFIG_FORMAT_S16LE
 static void multiband_drc_s16_default(const struct processing_module *mod,
@@ -209,61 +181,50 @@ static void multiband_drc_s16_default(const struct processing_module *mod,
 {
 	struct multiband_drc_comp_data *cd = module_get_private_data(mod);
 	struct multiband_drc_state *state = &cd->state;
-	int32_t buf_src[PLATFORM_MAX_CHANNELS];
-	int32_t buf_sink[PLATFORM_MAX_CHANNELS];
-	int32_t buf_drc_src[PLATFORM_MAX_CHANNELS * SOF_MULTIBAND_DRC_MAX_BANDS];
-	int32_t buf_drc_sink[PLATFORM_MAX_CHANNELS * SOF_MULTIBAND_DRC_MAX_BANDS];
-	int32_t *band_buf_drc_src;
-	int32_t *band_buf_drc_sink;
+	int32_t *band_buf[SOF_MULTIBAND_DRC_MAX_BANDS];
+	int32_t *buf = cd->block;
+	int32_t *in;
 	int16_t *x = audio_stream_get_rptr(source);
 	int16_t *y = audio_stream_get_wptr(sink);
 	int band;
 	int nbuf;
 	int npcm;
-	int ch;
 	int i;
 	int nch = audio_stream_get_channels(source);
 	int nband = cd->config->num_bands;
 	int enable_emp_deemp = cd->config->enable_emp_deemp;
 	int samples = frames * nch;
 
+	for (band = 0; band < nband; band++)
+		band_buf[band] = cd->band_block[band];
+
+	/* The crossover input is the last band buffer */
+	in = band_buf[nband - 1];
 	while (samples) {
 		nbuf = audio_stream_samples_without_wrap_s16(source, x);
 		npcm = MIN(samples, nbuf);
 		nbuf = audio_stream_samples_without_wrap_s16(sink, y);
 		npcm = MIN(npcm, nbuf);
-		for (i = 0; i < npcm; i += nch) {
-			for (ch = 0; ch < nch; ch++) {
-				buf_src[ch] = *x << 16;
-				x++;
-			}
+		npcm = MIN(npcm, MULTIBAND_DRC_BLOCK_FRAMES * nch);
+		for (i = 0; i < npcm; i++)
+			in[i] = x[i] << 16;
 
-			multiband_drc_process_emp_crossover(state, cd->crossover_split,
-							    buf_src, buf_drc_src,
-							    enable_emp_deemp, nch, nband);
-
-			band_buf_drc_src = buf_drc_src;
-			band_buf_drc_sink = buf_drc_sink;
-			for (band = 0; band < nband; ++band) {
-				multiband_drc_s16_process_drc(&state->drc[band],
-							      &cd->config->drc_coef[band],
-							      band_buf_drc_src, band_buf_drc_sink,
-							      nch);
-				band_buf_drc_src += PLATFORM_MAX_CHANNELS;
-				band_buf_drc_sink += PLATFORM_MAX_CHANNELS;
-			}
+		if (enable_emp_deemp)
+			multiband_drc_process_iir_block(state->emphasis, in, npcm / nch, nch);
 
-			multiband_drc_process_deemp(state, buf_drc_sink, buf_sink,
-						    enable_emp_deemp, nch, nband);
+		cd->crossover_split_block(state->crossover, band_buf, npcm / nch, nch);
+		multiband_drc_s16_process_bands(state, cd->config->drc_coef, band_buf, buf,
+						npcm / nch, nch, nband);
+
+		if (enable_emp_deemp)
+			multiband_drc_process_iir_block(state->deemphasis, buf, npcm / nch, nch);
+
+		for (i = 0; i < npcm; i++)
+			y[i] = sat_int16(Q_SHIFT_RND(buf[i], 31, 15));
 
-			for (ch = 0; ch < nch; ch++) {
-				*y = sat_int16(Q_SHIFT_RND(buf_sink[ch], 31, 15));
-				y++;
-			}
-		}
 		samples -= npcm;
-		x = audio_stream_wrap(source, x);
-		y = audio_stream_wrap(sink, y);
+		x = audio_stream_wrap(source, x + npcm);
+		y = audio_stream_wrap(sink, y + npcm);
 	}
 }
 #endif /* CONFIG_FORMAT_S16LE */
@@ -276,61 +237,50 @@ static void multiband_drc_s24_default(const struct processing_module *mod,
 {
 	struct multiband_drc_comp_data *cd = module_get_private_data(mod);
 	struct multiband_drc_state *state = &cd->state;
-	int32_t buf_src[PLATFORM_MAX_CHANNELS];
-	int32_t buf_sink[PLATFORM_MAX_CHANNELS];
-	int32_t buf_drc_src[PLATFORM_MAX_CHANNELS * SOF_MULTIBAND_DRC_MAX_BANDS];
-	int32_t buf_drc_sink[PLATFORM_MAX_CHANNELS * SOF_MULTIBAND_DRC_MAX_BANDS];
-	int32_t *band_buf_drc_src;
-	int32_t *band_buf_drc_sink;
+	int32_t *band_buf[SOF_MULTIBAND_DRC_MAX_BANDS];
+	int32_t *buf = cd->block;
+	int32_t *in;
 	int32_t *x = audio_stream_get_rptr(source);
 	int32_t *y = audio_stream_get_wptr(sink);
 	int band;
 	int nbuf;
 	int npcm;
-	int ch;
 	int i;
 	int nch = audio_stream_get_channels(source);
 	int nband = cd->config->num_bands;
 	int enable_emp_deemp = cd->config->enable_emp_deemp;
 	int samples = frames * nch;
 
+	for (band = 0; band < nband; band++)
+		band_buf[band] = cd->band_block[band];
+
+	/* The crossover input is the last band buffer */
+	in = band_buf[nband - 1];
 	while (samples) {
 		nbuf = audio_stream_samples_without_wrap_s24(source, x);
 		npcm = MIN(samples, nbuf);
 		nbuf = audio_stream_samples_without_wrap_s24(sink, y);
 		npcm = MIN(npcm, nbuf);
-		for (i = 0; i < npcm; i += nch) {
-			for (ch = 0; ch < nch; ch++) {
-				buf_src[ch] = *x << 8;
-				x++;
-			}
+		npcm = MIN(npcm, MULTIBAND_DRC_BLOCK_FRAMES * nch);
+		for (i = 0; i < npcm; i++)
+			in[i] = x[i] << 8;
 
-			multiband_drc_process_emp_crossover(state, cd->crossover_split,
-							    buf_src, buf_drc_src,
-							    enable_emp_deemp, nch, nband);
-
-			band_buf_drc_src = buf_drc_src;
-			band_buf_drc_sink = buf_drc_sink;
-			for (band = 0; band < nband; ++band) {
-				multiband_drc_s32_process_drc(&state->drc[band],
-							      &cd->config->drc_coef[band],
-							      band_buf_drc_src, band_buf_drc_sink,
-							      nch);
-				band_buf_drc_src += PLATFORM_MAX_CHANNELS;
-				band_buf_drc_sink += PLATFORM_MAX_CHANNELS;
-			}
+		if (enable_emp_deemp)
+			multiband_drc_process_iir_block(state->emphasis, in, npcm / nch, nch);
 
-			multiband_drc_process_deemp(state, buf_drc_sink, buf_sink,
-						    enable_emp_deemp, nch, nband);
+		cd->crossover_split_block(state->crossover, band_buf, npcm / nch, nch);
+		multiband_drc_s32_process_bands(state, cd->config->drc_coef, band_buf, buf,
+						npcm / nch, nch, nband);
+
+		if (enable_emp_deemp)
+			multiband_drc_process_iir_block(state->deemphasis, buf, npcm / nch, nch);
+
+		for (i = 0; i < npcm; i++)
+			y[i] = sat_int24(Q_SHIFT_RND(buf[i], 31, 23));
 
-			for (ch = 0; ch < nch; ch++) {
-				*y = sat_int24(Q_SHIFT_RND(buf_sink[ch], 31, 23));
-				y++;
-			}
-		}
 		samples -= npcm;
-		x = audio_stream_wrap(source, x);
-		y = audio_stream_wrap(sink, y);
+		x = audio_stream_wrap(source, x + npcm);
+		y = audio_stream_wrap(sink, y + npcm);
 	}
 }
 #endif /* CONFIG_FORMAT_S24LE */
@@ -343,61 +293,50 @@ static void multiband_drc_s32_default(const struct processing_module *mod,
 {
 	struct multiband_drc_comp_data *cd = module_get_private_data(mod);
 	struct multiband_drc_state *state = &cd->state;
-	int32_t buf_src[PLATFORM_MAX_CHANNELS];
-	int32_t buf_sink[PLATFORM_MAX_CHANNELS];
-	int32_t buf_drc_src[PLATFORM_MAX_CHANNELS * SOF_MULTIBAND_DRC_MAX_BANDS];
-	int32_t buf_drc_sink[PLATFORM_MAX_CHANNELS * SOF_MULTIBAND_DRC_MAX_BANDS];
-	int32_t *band_buf_drc_src;
-	int32_t *band_buf_drc_sink;
+	int32_t *band_buf[SOF_MULTIBAND_DRC_MAX_BANDS];
+	int32_t *buf = cd->block;
+	int32_t *in;
 	int32_t *x = audio_stream_get_rptr(source);
 	int32_t *y = audio_stream_get_wptr(sink);
 	int band;
 	int nbuf;
 	int npcm;
-	int ch;
 	int i;
 	int nch = audio_stream_get_channels(source);
 	int nband = cd->config->num_bands;
 	int enable_emp_deemp = cd->config->enable_emp_deemp;
 	int samples = frames * nch;
 
+	for (band = 0; band < nband; band++)
+		band_buf[band] = cd->band_block[band];
+
+	/* The crossover input is the last band buffer */
+	in = band_buf[nband - 1];
 	while (samples) {
 		nbuf = audio_stream_samples_without_wrap_s32(source, x);
 		npcm = MIN(samples, nbuf);
 		nbuf = audio_stream_samples_without_wrap_s32(sink, y);
 		npcm = MIN(npcm, nbuf);
-		for (i = 0; i < npcm; i += nch) {
-			for (ch = 0; ch < nch; ch++) {
-				buf_src[ch] = *x;
-				x++;
-			}
+		npcm = MIN(npcm, MULTIBAND_DRC_BLOCK_FRAMES * nch);
+		for (i = 0; i < npcm; i++)
+			in[i] = x[i];
 
-			multiband_drc_process_emp_crossover(state, cd->crossover_split,
-							    buf_src, buf_drc_src,
-							    enable_emp_deemp, nch, nband);
-
-			band_buf_drc_src = buf_drc_src;
-			band_buf_drc_sink = buf_drc_sink;
-			for (band = 0; band < nband; ++band) {
-				multiband_drc_s32_process_drc(&state->drc[band],
-							      &cd->config->drc_coef[band],
-							      band_buf_drc_src, band_buf_drc_sink,
-							      nch);
-				band_buf_drc_src += PLATFORM_MAX_CHANNELS;
-				band_buf_drc_sink += PLATFORM_MAX_CHANNELS;
-			}
+		if (enable_emp_deemp)
+			multiband_drc_process_iir_block(state->emphasis, in, npcm / nch, nch);
 
-			multiband_drc_process_deemp(state, buf_drc_sink, buf_sink,
-						    enable_emp_deemp, nch, nband);
+		cd->crossover_split_block(state->crossover, band_buf, npcm / nch, nch);
+		multiband_drc_s32_process_bands(state, cd->config->drc_coef, band_buf, buf,
+						npcm / nch, nch, nband);
+
+		if (enable_emp_deemp)
+			multiband_drc_process_iir_block(state->deemphasis, buf, npcm / nch, nch);
+
+		for (i = 0; i < npcm; i++)
+			y[i] = buf[i];
 
-			for (ch = 0; ch < nch; ch++) {
-				*y = buf_sink[ch];
-				y++;
-			}
-		}
 		samples -= npcm;
-		x = audio_stream_wrap(source, x);
-		y = audio_stream_wrap(sink, y);
+		x = audio_stream_wrap(source, x + npcm);
+		y = audio_stream_wrap(sink, y + npcm);
 	}
 }
 #endif /* CONFIG_FORMAT_S32LE */
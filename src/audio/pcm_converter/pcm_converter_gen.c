@@ -0,0 +1,247 @@
+// SPDX-License-Identifier: BSD-3-Clause
+//
+// Copyright(c) 2023 Intel Corporation. All rights reserved.
+
+/**
+ * \file audio/pcm_converter/pcm_converter_gen.c
+ * \brief Table driven PCM converters for all format and container pairs
+ *
+ * Every supported sample layout is described by a load and a store helper
+ * working on a Q1.31 intermediate value. The PCM_GEN_CONVERTER() macro
+ * expands a converter for one input/output pair and PCM_GEN_FOR_EACH_IN() lists
+ * all layouts, so the complete matrix is emitted by the preprocessor. The
+ * generated converters are only used when no hand written (or HiFi
+ * optimized) function is found in pcm_func_map or pcm_func_vc_map.
+ *
+ * Only generic C converters are generated, also on HiFi builds. The pairs
+ * that matter for performance have hand written HiFi versions in
+ * pcm_converter_hifi3.c, the generated ones cover the remaining pairs.
+ */
+
+#include <sof/audio/pcm_converter.h>
+#include <sof/audio/audio_stream.h>
+#include <sof/audio/format.h>
+#include <sof/common.h>
+#include <sof/compiler_attributes.h>
+#include <ipc/stream.h>
+
+#include <stddef.h>
+#include <stdint.h>
+
+/* layout name, container format, valid format, container bytes, valid bits */
+#define PCM_GEN_LAYOUT_c8_u8		c8_u8, SOF_IPC_FRAME_U8, SOF_IPC_FRAME_U8, 1, 8
+#define PCM_GEN_LAYOUT_c16_s16		c16_s16, SOF_IPC_FRAME_S16_LE, SOF_IPC_FRAME_S16_LE, 2, 16
+#define PCM_GEN_LAYOUT_c32_s16		c32_s16, SOF_IPC_FRAME_S32_LE, SOF_IPC_FRAME_S16_LE, 4, 16
+#define PCM_GEN_LAYOUT_c24_s24		c24_s24, SOF_IPC_FRAME_S24_3LE, SOF_IPC_FRAME_S24_3LE, 3, 24
+#define PCM_GEN_LAYOUT_c32_s24		c32_s24, SOF_IPC_FRAME_S32_LE, SOF_IPC_FRAME_S24_4LE, 4, 24
+#define PCM_GEN_LAYOUT_c32_s24msb	c32_s24msb, SOF_IPC_FRAME_S32_LE, \
+					SOF_IPC_FRAME_S24_4LE_MSB, 4, 24
+#define PCM_GEN_LAYOUT_c32_s32		c32_s32, SOF_IPC_FRAME_S32_LE, SOF_IPC_FRAME_S32_LE, 4, 32
+
+/* Applies M to every layout. The list and the call helper have to be spelled
+ * twice since a macro can't expand itself, and the matrix needs one list
+ * nested in the other.
+ */
+#define PCM_GEN_CALL_IN(M, ...) M(__VA_ARGS__)
+#define PCM_GEN_CALL_OUT(M, ...) M(__VA_ARGS__)
+#define PCM_GEN_FOR_EACH_IN(M, ...) \
+	PCM_GEN_CALL_IN(M, PCM_GEN_LAYOUT_c8_u8, __VA_ARGS__) \
+	PCM_GEN_CALL_IN(M, PCM_GEN_LAYOUT_c16_s16, __VA_ARGS__) \
+	PCM_GEN_CALL_IN(M, PCM_GEN_LAYOUT_c32_s16, __VA_ARGS__) \
+	PCM_GEN_CALL_IN(M, PCM_GEN_LAYOUT_c24_s24, __VA_ARGS__) \
+	PCM_GEN_CALL_IN(M, PCM_GEN_LAYOUT_c32_s24, __VA_ARGS__) \
+	PCM_GEN_CALL_IN(M, PCM_GEN_LAYOUT_c32_s24msb, __VA_ARGS__) \
+	PCM_GEN_CALL_IN(M, PCM_GEN_LAYOUT_c32_s32, __VA_ARGS__)
+#define PCM_GEN_FOR_EACH_OUT(M, ...) \
+	PCM_GEN_CALL_OUT(M, __VA_ARGS__, PCM_GEN_LAYOUT_c8_u8) \
+	PCM_GEN_CALL_OUT(M, __VA_ARGS__, PCM_GEN_LAYOUT_c16_s16) \
+	PCM_GEN_CALL_OUT(M, __VA_ARGS__, PCM_GEN_LAYOUT_c32_s16) \
+	PCM_GEN_CALL_OUT(M, __VA_ARGS__, PCM_GEN_LAYOUT_c24_s24) \
+	PCM_GEN_CALL_OUT(M, __VA_ARGS__, PCM_GEN_LAYOUT_c32_s24) \
+	PCM_GEN_CALL_OUT(M, __VA_ARGS__, PCM_GEN_LAYOUT_c32_s24msb) \
+	PCM_GEN_CALL_OUT(M, __VA_ARGS__, PCM_GEN_LAYOUT_c32_s32)
+
+/* layouts are only usable when the matching format is enabled */
+#define PCM_GEN_ENABLED_c8_u8		IS_ENABLED(CONFIG_PCM_CONVERTER_FORMAT_U8)
+#define PCM_GEN_ENABLED_c16_s16		IS_ENABLED(CONFIG_PCM_CONVERTER_FORMAT_S16LE)
+#define PCM_GEN_ENABLED_c32_s16		IS_ENABLED(CONFIG_PCM_CONVERTER_FORMAT_S16LE)
+#define PCM_GEN_ENABLED_c24_s24		IS_ENABLED(CONFIG_PCM_CONVERTER_FORMAT_S24_3LE)
+#define PCM_GEN_ENABLED_c32_s24		IS_ENABLED(CONFIG_PCM_CONVERTER_FORMAT_S24LE)
+#define PCM_GEN_ENABLED_c32_s24msb	IS_ENABLED(CONFIG_PCM_CONVERTER_FORMAT_S24_4LE_MSB)
+#define PCM_GEN_ENABLED_c32_s32		IS_ENABLED(CONFIG_PCM_CONVERTER_FORMAT_S32LE)
+
+static inline int32_t pcm_gen_load_c8_u8(const uint8_t *p)
+{
+	return (INT8_MIN + *p) << 24;
+}
+
+static inline void pcm_gen_store_c8_u8(uint8_t *p, int32_t q31)
+{
+	*p = sat_int8(Q_SHIFT_RND(q31, 31, 7)) - INT8_MIN;
+}
+
+static inline int32_t pcm_gen_load_c16_s16(const uint8_t *p)
+{
+	return *(const int16_t *)p << 16;
+}
+
+static inline void pcm_gen_store_c16_s16(uint8_t *p, int32_t q31)
+{
+	*(int16_t *)p = sat_int16(Q_SHIFT_RND(q31, 31, 15));
+}
+
+static inline int32_t pcm_gen_load_c32_s16(const uint8_t *p)
+{
+	return *(const int32_t *)p << 16;
+}
+
+static inline void pcm_gen_store_c32_s16(uint8_t *p, int32_t q31)
+{
+	*(int32_t *)p = sat_int16(Q_SHIFT_RND(q31, 31, 15));
+}
+
+static inline int32_t pcm_gen_load_c24_s24(const uint8_t *p)
+{
+	return (p[2] << 24) | (p[1] << 16) | (p[0] << 8);
+}
+
+static inline void pcm_gen_store_c24_s24(uint8_t *p, int32_t q31)
+{
+	int32_t x = sat_int24(Q_SHIFT_RND(q31, 31, 23));
+
+	p[0] = x & 0xff;
+	p[1] = (x >> 8) & 0xff;
+	p[2] = (x >> 16) & 0xff;
+}
+
+static inline int32_t pcm_gen_load_c32_s24(const uint8_t *p)
+{
+	return *(const int32_t *)p << 8;
+}
+
+static inline void pcm_gen_store_c32_s24(uint8_t *p, int32_t q31)
+{
+	*(int32_t *)p = sat_int24(Q_SHIFT_RND(q31, 31, 23));
+}
+
+static inline int32_t pcm_gen_load_c32_s24msb(const uint8_t *p)
+{
+	return *(const int32_t *)p & 0xffffff00;
+}
+
+static inline void pcm_gen_store_c32_s24msb(uint8_t *p, int32_t q31)
+{
+	*(int32_t *)p = sat_int24(Q_SHIFT_RND(q31, 31, 23)) << 8;
+}
+
+static inline int32_t pcm_gen_load_c32_s32(const uint8_t *p)
+{
+	return *(const int32_t *)p;
+}
+
+static inline void pcm_gen_store_c32_s32(uint8_t *p, int32_t q31)
+{
+	*(int32_t *)p = q31;
+}
+
+#if CONFIG_PCM_CONVERTER_DITHER
+/*
+ * Adds triangular PDF dither of +/- 1 LSB of the output word length. The
+ * generator state lives on the stack of a single converter call and is seeded
+ * from the sink write position, so no state is kept between periods.
+ */
+static inline int32_t pcm_gen_dither(uint32_t *seed, int32_t q31, int out_bits)
+{
+	int32_t r1, r2;
+
+	*seed = *seed * 1664525u + 1013904223u;
+	r1 = (int32_t)*seed >> out_bits;
+	*seed = *seed * 1664525u + 1013904223u;
+	r2 = (int32_t)*seed >> out_bits;
+
+	return sat_int32((int64_t)q31 + r1 + r2);
+}
+
+#define PCM_GEN_DITHER(seed, q31, in_bits, out_bits) \
+	((out_bits) < (in_bits) ? pcm_gen_dither(seed, q31, out_bits) : (q31))
+#else
+#define PCM_GEN_DITHER(seed, q31, in_bits, out_bits) (q31)
+#endif
+
+#define PCM_GEN_CONVERTER(in, in_c, in_v, in_bytes, in_bits, out, out_c, out_v, out_bytes, \
+			  out_bits) \
+static int pcm_convert_gen_##in##_to_##out(const struct audio_stream __sparse_cache *source, \
+					   uint32_t ioffset, \
+					   struct audio_stream __sparse_cache *sink, \
+					   uint32_t ooffset, uint32_t samples) \
+{ \
+	uint8_t *src = audio_stream_get_rptr(source); \
+	uint8_t *dst = audio_stream_get_wptr(sink); \
+	uint32_t seed = (uintptr_t)dst; \
+	uint32_t processed; \
+	uint32_t nmax, i, n; \
+	int32_t q31; \
+	\
+	(void)seed; \
+	src += ioffset * (in_bytes); \
+	dst += ooffset * (out_bytes); \
+	for (processed = 0; processed < samples; processed += n) { \
+		src = audio_stream_wrap(source, src); \
+		dst = audio_stream_wrap(sink, dst); \
+		n = samples - processed; \
+		nmax = audio_stream_bytes_without_wrap(source, src) / (in_bytes); \
+		n = MIN(n, nmax); \
+		nmax = audio_stream_bytes_without_wrap(sink, dst) / (out_bytes); \
+		n = MIN(n, nmax); \
+		for (i = 0; i < n; i++) { \
+			q31 = pcm_gen_load_##in(src); \
+			q31 = PCM_GEN_DITHER(&seed, q31, in_bits, out_bits); \
+			pcm_gen_store_##out(dst, q31); \
+			src += (in_bytes); \
+			dst += (out_bytes); \
+		} \
+	} \
+	\
+	return samples; \
+}
+
+#define PCM_GEN_MAP_ENTRY(in, in_c, in_v, in_bytes, in_bits, out, out_c, out_v, out_bytes, \
+			  out_bits) \
+	{ in_c, in_v, out_c, out_v, \
+	  PCM_GEN_ENABLED_##in && PCM_GEN_ENABLED_##out ? pcm_convert_gen_##in##_to_##out : NULL },
+
+/* expand the inner loop over output layouts for one input layout */
+#define PCM_GEN_ROW(in, in_c, in_v, in_bytes, in_bits, M) \
+	PCM_GEN_FOR_EACH_OUT(M, in, in_c, in_v, in_bytes, in_bits)
+
+/* all pairs, including same layout on both sides which is a plain copy */
+PCM_GEN_FOR_EACH_IN(PCM_GEN_ROW, PCM_GEN_CONVERTER)
+
+const struct pcm_func_vc_map pcm_func_gen_map[] = {
+	PCM_GEN_FOR_EACH_IN(PCM_GEN_ROW, PCM_GEN_MAP_ENTRY)
+};
+
+const size_t pcm_func_gen_count = ARRAY_SIZE(pcm_func_gen_map);
+
+pcm_converter_func pcm_get_generated_function(enum sof_ipc_frame in_bits,
+					      enum sof_ipc_frame valid_in_bits,
+					      enum sof_ipc_frame out_bits,
+					      enum sof_ipc_frame valid_out_bits)
+{
+	size_t i;
+
+	for (i = 0; i < pcm_func_gen_count; i++) {
+		if (in_bits != pcm_func_gen_map[i].source)
+			continue;
+		if (valid_in_bits != pcm_func_gen_map[i].valid_src_bits)
+			continue;
+		if (out_bits != pcm_func_gen_map[i].sink)
+			continue;
+		if (valid_out_bits != pcm_func_gen_map[i].valid_sink_bits)
+			continue;
+
+		return pcm_func_gen_map[i].func;
+	}
+
+	return NULL;
+}
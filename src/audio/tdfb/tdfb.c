@@ -103,18 +103,36 @@ static void send_get_ctl_ipc(struct processing_module *mod)
 #if CONFIG_FORMAT_S16LE
 static inline void set_s16_fir(struct tdfb_comp_data *cd)
 {
+#if CONFIG_COMP_TDFB_FREQ_DOMAIN
+	if (cd->fd_active) {
+		cd->tdfb_func = tdfb_fd_s16;
+		return;
+	}
+#endif
 	cd->tdfb_func = tdfb_fir_s16;
 }
 #endif /* CONFIG_FORMAT_S16LE */
 #if CONFIG_FORMAT_S24LE
 static inline void set_s24_fir(struct tdfb_comp_data *cd)
 {
+#if CONFIG_COMP_TDFB_FREQ_DOMAIN
+	if (cd->fd_active) {
+		cd->tdfb_func = tdfb_fd_s24;
+		return;
+	}
+#endif
 	cd->tdfb_func = tdfb_fir_s24;
 }
 #endif /* CONFIG_FORMAT_S24LE */
 #if CONFIG_FORMAT_S32LE
 static inline void set_s32_fir(struct tdfb_comp_data *cd)
 {
+#if CONFIG_COMP_TDFB_FREQ_DOMAIN
+	if (cd->fd_active) {
+		cd->tdfb_func = tdfb_fd_s32;
+		return;
+	}
+#endif
 	cd->tdfb_func = tdfb_fir_s32;
 }
 #endif /* CONFIG_FORMAT_S32LE */
@@ -319,6 +337,7 @@ static int tdfb_init_coef(struct processing_module *mod, int source_nch,
 
 	/* Seek to proper filter for requested angle or beam off configuration */
 	coefp = tdfb_filter_seek(config, idx);
+	cd->fir_coef = coefp;
 
 	/* Initialize filter bank */
 	for (i = 0; i < config->num_filters; i++) {
@@ -375,12 +394,29 @@ static int tdfb_setup(struct processing_module *mod, int source_nch, int sink_nc
 {
 	struct tdfb_comp_data *cd = module_get_private_data(mod);
 	int delay_size;
+#if CONFIG_COMP_TDFB_FREQ_DOMAIN
+	int ret;
+#endif
 
 	/* Set coefficients for each channel from coefficient blob */
 	delay_size = tdfb_init_coef(mod, source_nch, sink_nch);
 	if (delay_size < 0)
 		return delay_size; /* Contains error code */
 
+#if CONFIG_COMP_TDFB_FREQ_DOMAIN
+	/* The FIR delay lines are not needed if the filter bank is run
+	 * in frequency domain.
+	 */
+	ret = tdfb_fd_setup(cd, source_nch, sink_nch);
+	if (ret < 0)
+		return ret;
+
+	if (cd->fd_active) {
+		tdfb_free_delaylines(cd);
+		return 0;
+	}
+#endif
+
 	/* If all channels were set to bypass there's no need to
 	 * allocate delay. Just return with success.
 	 */
@@ -492,6 +528,9 @@ static int tdfb_free(struct processing_module *mod)
 
 	ipc_msg_free(cd->msg);
 	tdfb_free_delaylines(cd);
+#if CONFIG_COMP_TDFB_FREQ_DOMAIN
+	tdfb_fd_free(cd);
+#endif
 	comp_data_blob_handler_free(cd->model_handler);
 	tdfb_direction_free(cd);
 	rfree(cd->ctrl_data);
@@ -676,6 +715,11 @@ static int tdfb_process(struct processing_module *mod,
 			comp_err(dev, "tdfb_process(), failed FIR setup");
 			return ret;
 		}
+
+		/* Filtering may switch between time and frequency domain */
+		ret = set_func(mod, audio_stream_get_frm_fmt(source));
+		if (ret)
+			return ret;
 	}
 
 	/* Handle enum controls */
@@ -687,6 +731,11 @@ static int tdfb_process(struct processing_module *mod,
 			comp_err(dev, "tdfb_process(), failed FIR setup");
 			return ret;
 		}
+
+		/* Filtering may switch between time and frequency domain */
+		ret = set_func(mod, audio_stream_get_frm_fmt(source));
+		if (ret)
+			return ret;
 	}
 
 	/*
@@ -771,6 +820,11 @@ static int tdfb_prepare(struct processing_module *mod,
 	/* Clear in/out buffers */
 	memset(cd->in, 0, TDFB_IN_BUF_LENGTH * sizeof(int32_t));
 	memset(cd->out, 0, TDFB_IN_BUF_LENGTH * sizeof(int32_t));
+#if CONFIG_COMP_TDFB_FREQ_DOMAIN
+	tdfb_fd_reset(cd);
+	comp_info(dev, "tdfb_prepare(), frequency domain %d, fft_size %d",
+		  (int)cd->fd_active, cd->fd.fft_size);
+#endif
 
 	ret = set_func(mod, frame_fmt);
 	if (ret)
@@ -807,6 +861,9 @@ static int tdfb_reset(struct processing_module *mod)
 	comp_info(mod->dev, "tdfb_reset()");
 
 	tdfb_free_delaylines(cd);
+#if CONFIG_COMP_TDFB_FREQ_DOMAIN
+	tdfb_fd_free(cd);
+#endif
 
 	cd->tdfb_func = NULL;
 	for (i = 0; i < PLATFORM_MAX_CHANNELS; i++)
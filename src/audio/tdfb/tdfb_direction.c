@@ -28,13 +28,16 @@
 #define FAST_LEVEL_SHIFT	1
 #define POWER_THRESHOLD		Q_CONVERT_FLOAT(15.849, 10)	/* 12 dB, value is 10^(dB/10) */
 
-/* Iteration parameters, smaller step and larger iterations is more accurate but
- * consumes more cycles.
+/* Search parameters. The theoretical time differences are tabulated in init for
+ * DIRECTION_ANGLES azimuth angles. The best matching angle is found from the table
+ * and refined with parabolic interpolation of the error from the neighbor angles.
  */
-#define AZ_STEP			Q_CONVERT_FLOAT(0.6, 12)	/* Radians as Q4.12 (~34 deg) */
-#define AZ_ITERATIONS		8				/* loops in min err search */
+#define DIRECTION_ANGLES	72				/* 5 degrees step */
 #define SOURCE_DISTANCE		Q_CONVERT_FLOAT(3.0, 12)	/* source distance in m Q4.12 */
 
+/* Cross correlation is averaged over updates, weight of new data is 2^-XCORR_AVG_SHIFT */
+#define XCORR_AVG_SHIFT		1
+
 /* Sound direction angle filtering */
 #define SLOW_AZ_C1		Q_CONVERT_FLOAT(0.02, 15)
 #define SLOW_AZ_C2		Q_CONVERT_FLOAT(0.98, 15)
@@ -126,7 +129,7 @@ static int16_t max_mic_distance(struct tdfb_comp_data *cd)
 
 	/* Max lag based on largest array dimension. Microphone coordinates are Q4.12 meters */
 	for (i = 0; i < cd->config->num_mic_locations; i++) {
-		for (j = 0; i < cd->config->num_mic_locations; i++) {
+		for (j = 0; j < cd->config->num_mic_locations; j++) {
 			if (j == i)
 				continue;
 
@@ -177,6 +180,83 @@ static bool line_array_mode_check(struct tdfb_comp_data *cd)
 	return true;
 }
 
+static int16_t distance_from_source(struct tdfb_comp_data *cd, int mic_n,
+				    int16_t x, int16_t y, int16_t z)
+{
+	int32_t d2;
+	int16_t dx;
+	int16_t dy;
+	int16_t dz;
+	int16_t d;
+
+	dx = x - cd->mic_locations[mic_n].x;
+	dy = y - cd->mic_locations[mic_n].y;
+	dz = z - cd->mic_locations[mic_n].z;
+
+	/* d2 is Q8.24 meters */
+	d2 = dx * dx + dy * dy + dz * dz;
+
+	/* Squared distance is Q8.24, return Q4.12 meters */
+	d = tdfb_mic_distance_sqrt(d2);
+	return d;
+}
+
+static void theoretical_time_differences(struct tdfb_comp_data *cd, int16_t az)
+{
+	int16_t d[PLATFORM_MAX_CHANNELS];
+	int16_t src_x;
+	int16_t src_y;
+	int16_t sin_az;
+	int16_t cos_az;
+	int32_t delta_d;
+	int n_mic = cd->direction.num_mics;
+	int i;
+
+	sin_az = sin_fixed_16b(Q_SHIFT_LEFT((int32_t)az, 12, 28)); /* Q1.15 */
+	cos_az = cos_fixed_16b(Q_SHIFT_LEFT((int32_t)az, 12, 28)); /* Q1.15 */
+	src_x = Q_MULTSR_16X16((int32_t)cos_az, SOURCE_DISTANCE, 15, 12, 12);
+	src_y = Q_MULTSR_16X16((int32_t)sin_az, SOURCE_DISTANCE, 15, 12, 12);
+
+	for (i = 0; i < n_mic; i++)
+		d[i] = distance_from_source(cd, i, src_x, src_y, 0);
+
+	for (i = 0; i < n_mic - 1; i++) {
+		delta_d = d[i + 1] - d[0]; /* Meters Q4.12 */
+		cd->direction.timediff_iter[i] =
+			(int32_t)((((int64_t)delta_d) << 19) / SPEED_OF_SOUND);
+	}
+}
+
+static int16_t angle_from_index(int idx)
+{
+	return -PI_Q12 + idx * PIMUL2_Q12 / DIRECTION_ANGLES;
+}
+
+static void init_time_differences_table(struct tdfb_comp_data *cd)
+{
+	struct tdfb_direction_data *dir = &cd->direction;
+	int32_t *t = dir->tdoa;
+	int a;
+	int i;
+
+	for (a = 0; a < DIRECTION_ANGLES; a++) {
+		theoretical_time_differences(cd, angle_from_index(a));
+		for (i = 0; i < dir->num_mics - 1; i++)
+			*t++ = dir->timediff_iter[i];
+	}
+
+	/* Line array azimuth angle is -90 .. +90 */
+	dir->angle_first = 0;
+	dir->angle_last = DIRECTION_ANGLES - 1;
+	if (dir->line_array) {
+		while (angle_from_index(dir->angle_first) < -PIDIV2_Q12)
+			dir->angle_first++;
+
+		while (angle_from_index(dir->angle_last) > PIDIV2_Q12)
+			dir->angle_last--;
+	}
+}
+
 int tdfb_direction_init(struct tdfb_comp_data *cd, int32_t fs, int ch_count)
 {
 	struct sof_eq_iir_header *filt;
@@ -199,6 +279,9 @@ int tdfb_direction_init(struct tdfb_comp_data *cd, int32_t fs, int ch_count)
 		return -EINVAL;
 	}
 
+	/* Free buffers from previous prepare */
+	tdfb_direction_free(cd);
+
 	/* Allocate delay lines for IIR filters and initialize them */
 	size = ch_count * iir_delay_size_df1(filt);
 	delay = rzalloc(SOF_MEM_ZONE_RUNTIME, 0, SOF_MEM_CAPS_RAM, size);
@@ -237,23 +320,42 @@ int tdfb_direction_init(struct tdfb_comp_data *cd, int32_t fs, int ch_count)
 	cd->direction.rp = cd->direction.d;
 	cd->direction.wp = cd->direction.d + ch_count * (cd->direction.max_lag + 1);
 
-	/* xcorr result is temporary but too large for stack so it is allocated here */
-	cd->direction.r_size = (2 * cd->direction.max_lag + 1) * sizeof(int32_t);
+	/* The xcorr for each microphone vs. first microphone is averaged over updates */
+	cd->direction.r_size = MAX(ch_count - 1, 1) * (2 * cd->direction.max_lag + 1) *
+		sizeof(int32_t);
 	cd->direction.r = rzalloc(SOF_MEM_ZONE_RUNTIME, 0, SOF_MEM_CAPS_RAM, cd->direction.r_size);
 	if (!cd->direction.r)
 		goto err_free_all;
 
+	/* Linear buffers for reference microphone and the other microphone with lags */
+	size = (2 * cd->max_frames + 2 * cd->direction.max_lag) * sizeof(int16_t);
+	cd->direction.x_ref = rzalloc(SOF_MEM_ZONE_RUNTIME, 0, SOF_MEM_CAPS_RAM, size);
+	if (!cd->direction.x_ref)
+		goto err_free_all;
+
+	cd->direction.x_mic = cd->direction.x_ref + cd->max_frames;
+
 	/* Check for line array mode */
 	cd->direction.line_array = line_array_mode_check(cd);
 
-	/* Initialize direction to zero radians, set initial step sign to +1 */
+	/* Tabulate time differences for the search */
+	cd->direction.num_mics = MIN(cd->config->num_mic_locations, PLATFORM_MAX_CHANNELS);
+	if (cd->direction.num_mics > 1) {
+		size = DIRECTION_ANGLES * (cd->direction.num_mics - 1) * sizeof(int32_t);
+		cd->direction.tdoa = rballoc(0, SOF_MEM_CAPS_RAM, size);
+		if (!cd->direction.tdoa)
+			goto err_free_all;
+
+		init_time_differences_table(cd);
+	}
+
+	/* Initialize direction to zero radians */
 	cd->direction.az = 0;
-	cd->direction.step_sign = 1;
 	return 0;
 
 err_free_all:
-	rfree(cd->direction.d);
-	cd->direction.d = NULL;
+	tdfb_direction_free(cd);
+	return -ENOMEM;
 
 err_free_iir:
 	rfree(cd->direction.df1_delay);
@@ -266,6 +368,14 @@ void tdfb_direction_free(struct tdfb_comp_data *cd)
 	rfree(cd->direction.df1_delay);
 	rfree(cd->direction.d);
 	rfree(cd->direction.r);
+	rfree(cd->direction.x_ref);
+	rfree(cd->direction.tdoa);
+	cd->direction.df1_delay = NULL;
+	cd->direction.d = NULL;
+	cd->direction.r = NULL;
+	cd->direction.x_ref = NULL;
+	cd->direction.x_mic = NULL;
+	cd->direction.tdoa = NULL;
 }
 
 /* Measure level of one channel */
@@ -321,106 +431,125 @@ static int find_max_value_index(int32_t *v, int length)
 	return idx;
 }
 
+/* Copy one channel from the circular interleaved xcorr delay line to linear buffer */
+static void copy_channel(struct tdfb_direction_data *dir, int16_t *dst, int16_t *src,
+			 int frames, int ch_count)
+{
+	int i;
+
+	for (i = 0; i < frames; i++) {
+		dst[i] = *src;
+		src += ch_count;
+		tdfb_cinc_s16(&src, dir->d_end, dir->d_size);
+	}
+}
+
 static void time_differences(struct tdfb_comp_data *cd, int frames, int ch_count)
 {
+	struct tdfb_direction_data *dir = &cd->direction;
 	int64_t r;
+	int32_t *r_avg;
 	int16_t *x;
-	int16_t *y;
 	int r_max_idx;
-	int max_lag = cd->direction.max_lag;
+	int max_lag = dir->max_lag;
+	int num_lags = 2 * max_lag + 1;
 	int c;
 	int k;
 	int i;
-	int32_t maxval = 0;
+
+	/* The reference channel and the other channel with -max_lag .. +max_lag
+	 * margins are copied to linear buffers so that every lag is a simple
+	 * dot product.
+	 */
+	copy_channel(dir, dir->x_ref, dir->rp, frames, ch_count);
 
 	/* Calculate xcorr for channel 0 vs. 1 .. (ch_count-1). Scan -maxlag .. +maxlag*/
 	for (c = 1; c < ch_count; c++) {
-		for (k = -max_lag; k <= max_lag; k++) {
-			y = cd->direction.rp; /* First channel */
-			x = y + k * ch_count + c; /* other channel C */
-			tdfb_cinc_s16(&x, cd->direction.d_end, cd->direction.d_size);
-			tdfb_cdec_s16(&x, cd->direction.d, cd->direction.d_size);
+		x = dir->rp + c - max_lag * ch_count;
+		tdfb_cdec_s16(&x, dir->d, dir->d_size);
+		copy_channel(dir, dir->x_mic, x, frames + 2 * max_lag, ch_count);
+		r_avg = &dir->r[(c - 1) * num_lags];
+		for (k = 0; k < num_lags; k++) {
+			x = &dir->x_mic[k];
 			r = 0;
-			for (i = 0; i < frames; i++) {
-				if (maxval < *y)
-					maxval = *y;
-
-				r += (int32_t)*x * *y;
-				y += ch_count;
-				tdfb_cinc_s16(&y, cd->direction.d_end, cd->direction.d_size);
-				x += ch_count;
-				tdfb_cinc_s16(&x, cd->direction.d_end, cd->direction.d_size);
-			}
-			/* Scale for max. 20 ms 48 kHz frame */
-			cd->direction.r[k + max_lag] = sat_int32(((r >> 8) + 1) >> 1);
+			for (i = 0; i < frames; i++)
+				r += (int32_t)x[i] * dir->x_ref[i];
+
+			/* Scale for max. 20 ms 48 kHz frame and average with previous */
+			r = sat_int32(((r >> 8) + 1) >> 1);
+			r_avg[k] += ((int32_t)r >> XCORR_AVG_SHIFT) - (r_avg[k] >> XCORR_AVG_SHIFT);
 		}
-		r_max_idx = find_max_value_index(&cd->direction.r[0], 2 * max_lag + 1);
-		cd->direction.timediff[c - 1] = (int32_t)(r_max_idx - max_lag) *
-			cd->direction.unit_delay;
+		r_max_idx = find_max_value_index(r_avg, num_lags);
+		dir->timediff[c - 1] = (int32_t)(r_max_idx - max_lag) * dir->unit_delay;
 	}
-	cd->direction.rp += frames * ch_count;
-	tdfb_cinc_s16(&cd->direction.rp, cd->direction.d_end, cd->direction.d_size);
+	dir->rp += frames * ch_count;
+	tdfb_cinc_s16(&dir->rp, dir->d_end, dir->d_size);
 }
 
-static int16_t distance_from_source(struct tdfb_comp_data *cd, int mic_n,
-				    int16_t x, int16_t y, int16_t z)
+static int64_t time_difference_err(struct tdfb_direction_data *dir, int idx)
 {
-	int32_t d2;
-	int16_t dx;
-	int16_t dy;
-	int16_t dz;
-	int16_t d;
-
-	dx = x - cd->mic_locations[mic_n].x;
-	dy = y - cd->mic_locations[mic_n].y;
-	dz = z - cd->mic_locations[mic_n].z;
+	int32_t *t = &dir->tdoa[idx * (dir->num_mics - 1)];
+	int64_t err = 0;
+	int32_t delta;
+	int i;
 
-	/* d2 is Q8.24 meters */
-	d2 = dx * dx + dy * dy + dz * dz;
+	for (i = 0; i < dir->num_mics - 1; i++) {
+		delta = dir->timediff[i] - t[i];
+		err += (int64_t)delta * delta;
+	}
 
-	/* Squared distance is Q8.24, return Q4.12 meters */
-	d = tdfb_mic_distance_sqrt(d2);
-	return d;
+	return err;
 }
 
-static void theoretical_time_differences(struct tdfb_comp_data *cd, int16_t az)
+/* Find the table angle with least mean square time differences error and
+ * refine it with the vertex of parabola fitted to the neighbor angles errors.
+ */
+static int search_source_angle(struct tdfb_direction_data *dir)
 {
-	int16_t d[PLATFORM_MAX_CHANNELS];
-	int16_t src_x;
-	int16_t src_y;
-	int16_t sin_az;
-	int16_t cos_az;
-	int32_t delta_d;
-	int n_mic = cd->config->num_mic_locations;
+	int64_t err_min = INT64_MAX;
+	int64_t err_prev;
+	int64_t err_next;
+	int64_t den;
+	int64_t offs;
+	int64_t err;
+	const int step = PIMUL2_Q12 / DIRECTION_ANGLES;
+	int idx_min = dir->angle_first;
+	int prev;
+	int next;
 	int i;
 
-	sin_az = sin_fixed_16b(Q_SHIFT_LEFT((int32_t)az, 12, 28)); /* Q1.15 */
-	cos_az = cos_fixed_16b(Q_SHIFT_LEFT((int32_t)az, 12, 28)); /* Q1.15 */
-	src_x = Q_MULTSR_16X16((int32_t)cos_az, SOURCE_DISTANCE, 15, 12, 12);
-	src_y = Q_MULTSR_16X16((int32_t)sin_az, SOURCE_DISTANCE, 15, 12, 12);
-
-	for (i = 0; i < n_mic; i++)
-		d[i] = distance_from_source(cd, i, src_x, src_y, 0);
-
-	for (i = 0; i < n_mic - 1; i++) {
-		delta_d = d[i + 1] - d[0]; /* Meters Q4.12 */
-		cd->direction.timediff_iter[i] =
-			(int32_t)((((int64_t)delta_d) << 19) / SPEED_OF_SOUND);
+	for (i = dir->angle_first; i <= dir->angle_last; i++) {
+		err = time_difference_err(dir, i);
+		if (err < err_min) {
+			err_min = err;
+			idx_min = i;
+		}
 	}
-}
 
-static int64_t mean_square_time_difference_err(struct tdfb_comp_data *cd)
-{
-	int64_t err = 0;
-	int32_t delta;
-	int i;
+	/* The table is circular for other than line arrays */
+	prev = idx_min - 1;
+	next = idx_min + 1;
+	if (dir->line_array) {
+		if (prev < dir->angle_first || next > dir->angle_last)
+			return angle_from_index(idx_min);
+	} else {
+		if (prev < 0)
+			prev += DIRECTION_ANGLES;
 
-	for (i = 0; i < cd->config->num_mic_locations - 1; i++) {
-		delta = cd->direction.timediff[i] - cd->direction.timediff_iter[i];
-		err +=  (int64_t)delta * delta;
+		if (next == DIRECTION_ANGLES)
+			next = 0;
 	}
 
-	return err;
+	err_prev = time_difference_err(dir, prev);
+	err_next = time_difference_err(dir, next);
+	den = 2 * (err_prev - 2 * err_min + err_next);
+	if (den <= 0)
+		return angle_from_index(idx_min);
+
+	offs = step * (err_prev - err_next) / den;
+	offs = MIN(offs, step / 2);
+	offs = MAX(offs, -step / 2);
+	return angle_from_index(idx_min) + (int)offs;
 }
 
 static int unwrap_radians(int radians)
@@ -438,45 +567,12 @@ static int unwrap_radians(int radians)
 
 static void iterate_source_angle(struct tdfb_comp_data *cd)
 {
-	int64_t err_prev;
-	int64_t err;
 	int32_t ds1;
 	int32_t ds2;
 	int az_slow;
-	int i;
-	int az_step = AZ_STEP * cd->direction.step_sign;
-	int az = cd->direction.az_slow;
-
-	/* Start next iteration opposite direction */
-	cd->direction.step_sign *= -1;
-
-	/* Get theoretical time differences for previous angle */
-	theoretical_time_differences(cd, az);
-	err_prev = mean_square_time_difference_err(cd);
-
-	for (i = 0; i < AZ_ITERATIONS; i++) {
-		az += az_step;
-		theoretical_time_differences(cd, az);
-		err = mean_square_time_difference_err(cd);
-		if (err > err_prev) {
-			az_step = -(az_step >> 1);
-			if (az_step == 0)
-				break;
-		}
-
-		err_prev = err;
-	}
-
-	az = unwrap_radians(az);
-	if (cd->direction.line_array) {
-		/* Line array azimuth angle is -90 .. +90 */
-		if (az > PIDIV2_Q12)
-			az = PI_Q12 - az;
-
-		if (az < -PIDIV2_Q12)
-			az = -PI_Q12  - az;
-	}
+	int az;
 
+	az = unwrap_radians(search_source_angle(&cd->direction));
 	cd->direction.az = az;
 
 	/* Avoid low-pass filtering to zero the angle in 360 degree arrays
@@ -537,9 +633,11 @@ void tdfb_direction_estimate(struct tdfb_comp_data *cd, int frames, int ch_count
 	if (!cd->direction_updates)
 		return;
 
-	/* Update levels, skip rest of estimation if level does not exceed well ambient */
+	/* Update levels, skip rest of estimation if level does not exceed well ambient
+	 * or if there are no microphone locations for the search.
+	 */
 	level_update(cd, frames, ch_count, 0);
-	if (!(cd->direction.trigger & 1)) {
+	if (!(cd->direction.trigger & 1) || !cd->direction.tdoa) {
 		updates_when_no_trigger(cd, frames, ch_count);
 		return;
 	}
@@ -0,0 +1,505 @@
+// SPDX-License-Identifier: BSD-3-Clause
+//
+// Copyright(c) 2023 Intel Corporation. All rights reserved.
+
+/* Frequency domain overlap-save version of the TDFB filter bank. With FFT
+ * size N the filters of up to N / 2 taps are applied with hop of N / 2
+ * frames. The cost per frame is the transforms of the microphones and the
+ * output channels plus one complex multiply per bin for each filter, so it
+ * grows only logarithmically with filter length. The processing adds a
+ * latency of one hop.
+ *
+ * Two real channels are transformed with one complex FFT, the microphones
+ * spectra are split after transform and output channel pairs are combined
+ * before inverse transform.
+ */
+
+#include <sof/audio/audio_stream.h>
+#include <sof/audio/format.h>
+#include <sof/audio/tdfb/tdfb_comp.h>
+#include <sof/math/fft.h>
+#include <sof/math/numbers.h>
+#include <sof/common.h>
+#include <rtos/alloc.h>
+#include <ipc/topology.h>
+#include <user/fir.h>
+#include <user/tdfb.h>
+#include <errno.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <string.h>
+
+#if CONFIG_COMP_TDFB_FREQ_DOMAIN
+
+/* Sum of filters to output channel spectrum is scaled down by this like the
+ * Q5.27 mix of the time domain version.
+ */
+#define TDFB_FD_MIX_SHIFT	4
+
+/* Weighted rough count of multiplications per FFT butterfly */
+#define TDFB_FD_BUTTERFLY_COST	4
+
+static void tdfb_fd_split(struct tdfb_fd_data *fd, int ch)
+{
+	struct icomplex32 *z = fd->fft_out;
+	struct icomplex32 *x0 = &fd->spectra[ch * fd->num_bins];
+	struct icomplex32 *x1 = x0 + fd->num_bins;
+	const int mask = fd->fft_size - 1;
+	int j;
+	int k;
+
+	/* Single channel in real part, the spectrum is used as such */
+	if (ch + 1 == fd->num_in) {
+		for (k = 0; k < fd->num_bins; k++)
+			x0[k] = z[k];
+
+		return;
+	}
+
+	/* Channel pair x0 + j * x1: X0(k) = (Z(k) + Z*(N - k)) / 2 and
+	 * X1(k) = (Z(k) - Z*(N - k)) / 2j
+	 */
+	for (k = 0; k < fd->num_bins; k++) {
+		j = (fd->fft_size - k) & mask;
+		x0[k].real = ((int64_t)z[k].real + z[j].real) >> 1;
+		x0[k].imag = ((int64_t)z[k].imag - z[j].imag) >> 1;
+		x1[k].real = ((int64_t)z[k].imag + z[j].imag) >> 1;
+		x1[k].imag = ((int64_t)z[j].real - z[k].real) >> 1;
+	}
+}
+
+static void tdfb_fd_mix(struct tdfb_comp_data *cd, int out_ch)
+{
+	struct tdfb_fd_data *fd = &cd->fd;
+	struct icomplex32 *m0 = fd->mix;
+	struct icomplex32 *m1 = fd->mix + fd->num_bins;
+	struct icomplex32 *x;
+	struct icomplex32 *w;
+	int64_t re;
+	int64_t im;
+	int om;
+	int i;
+	int k;
+	const int shift = 31 + TDFB_FD_MIX_SHIFT;
+	const int pair_mask = out_ch + 1 < fd->num_out ? 3 : 1;
+
+	memset(fd->mix, 0, 2 * fd->num_bins * sizeof(struct icomplex32));
+	for (i = 0; i < cd->config->num_filters; i++) {
+		om = (cd->output_channel_mix[i] >> out_ch) & pair_mask;
+		if (!om)
+			continue;
+
+		x = &fd->spectra[cd->input_channel_select[i] * fd->num_bins];
+		w = &fd->weights[i * fd->num_bins];
+		for (k = 0; k < fd->num_bins; k++) {
+			re = ((int64_t)x[k].real * w[k].real -
+			      (int64_t)x[k].imag * w[k].imag) >> shift;
+			im = ((int64_t)x[k].real * w[k].imag +
+			      (int64_t)x[k].imag * w[k].real) >> shift;
+			/* saturate like the Q5.27 mix of the FIR version */
+			if (om & 1) {
+				m0[k].real = sat_int32(m0[k].real + re);
+				m0[k].imag = sat_int32(m0[k].imag + im);
+			}
+			if (om & 2) {
+				m1[k].real = sat_int32(m1[k].real + re);
+				m1[k].imag = sat_int32(m1[k].imag + im);
+			}
+		}
+	}
+}
+
+static void tdfb_fd_block(struct tdfb_comp_data *cd)
+{
+	struct tdfb_fd_data *fd = &cd->fd;
+	struct icomplex32 *m0 = fd->mix;
+	struct icomplex32 *m1 = fd->mix + fd->num_bins;
+	struct icomplex32 *z = fd->fft_buf;
+	int32_t *x0;
+	int32_t *x1;
+	int32_t *y0;
+	int32_t *y1;
+	int ch;
+	int k;
+	const int size = fd->fft_size;
+	const int hop = fd->hop;
+
+	/* Transform the microphones in pairs */
+	for (ch = 0; ch < fd->num_in; ch += 2) {
+		x0 = &fd->in_buf[ch * size];
+		if (ch + 1 < fd->num_in) {
+			x1 = x0 + size;
+			for (k = 0; k < size; k++) {
+				z[k].real = x0[k];
+				z[k].imag = x1[k];
+			}
+		} else {
+			for (k = 0; k < size; k++) {
+				z[k].real = x0[k];
+				z[k].imag = 0;
+			}
+		}
+
+		fft_execute_32(fd->fft_plan, false);
+		tdfb_fd_split(fd, ch);
+	}
+
+	/* The newest hop becomes the oldest half of next block */
+	for (ch = 0; ch < fd->num_in; ch++) {
+		x0 = &fd->in_buf[ch * size];
+		for (k = 0; k < hop; k++)
+			x0[k] = x0[k + hop];
+	}
+
+	/* Output channels pair y0 + j * y1 is built from the non-negative
+	 * frequencies of the two real signals spectra.
+	 */
+	for (ch = 0; ch < fd->num_out; ch += 2) {
+		tdfb_fd_mix(cd, ch);
+		for (k = 0; k < fd->num_bins; k++) {
+			z[k].real = sat_int32((int64_t)m0[k].real - m1[k].imag);
+			z[k].imag = sat_int32((int64_t)m0[k].imag + m1[k].real);
+		}
+
+		for (k = 1; k < hop; k++) {
+			z[size - k].real = sat_int32((int64_t)m0[k].real + m1[k].imag);
+			z[size - k].imag = sat_int32((int64_t)m1[k].real - m0[k].imag);
+		}
+
+		/* The inverse transform returns the complex conjugate. The
+		 * last hop of output is free from circular convolution wrap.
+		 */
+		fft_execute_32(fd->fft_plan, true);
+		y0 = &fd->out_buf[ch * hop];
+		for (k = 0; k < hop; k++)
+			y0[k] = sat_int32((int64_t)fd->fft_out[hop + k].real << fd->out_shift);
+
+		if (ch + 1 < fd->num_out) {
+			y1 = y0 + hop;
+			for (k = 0; k < hop; k++)
+				y1[k] = sat_int32(-(int64_t)fd->fft_out[hop + k].imag <<
+						  fd->out_shift);
+		}
+	}
+}
+
+/* Exchange one frame with the block buffers, the output is Q5.27 in cd->out */
+static inline void tdfb_fd_frame(struct tdfb_comp_data *cd)
+{
+	struct tdfb_fd_data *fd = &cd->fd;
+	int32_t *x = &fd->in_buf[fd->pos];
+	int32_t *y = &fd->out_buf[fd->pos - fd->hop];
+	int ch;
+
+	for (ch = 0; ch < fd->num_in; ch++) {
+		*x = cd->in[ch];
+		x += fd->fft_size;
+	}
+
+	for (ch = 0; ch < fd->num_out; ch++) {
+		cd->out[ch] = *y;
+		y += fd->hop;
+	}
+
+	if (++fd->pos == fd->fft_size) {
+		tdfb_fd_block(cd);
+		fd->pos = fd->hop;
+	}
+}
+
+/* The weights are the FIR spectra with a common scale that is compensated
+ * in the output shift. The taps and shifts are read from the setup blob since
+ * the FIR state layout depends on the FIR implementation.
+ */
+static void tdfb_fd_init_weights(struct tdfb_comp_data *cd)
+{
+	struct tdfb_fd_data *fd = &cd->fd;
+	struct sof_fir_coef_data *coef_data;
+	struct icomplex32 *w;
+	int16_t *coefp;
+	int32_t peak;
+	int shift;
+	int s = fd->fft_len;
+	int i;
+	int k;
+
+	coefp = cd->fir_coef;
+	for (i = 0; i < cd->config->num_filters; i++) {
+		coef_data = (struct sof_fir_coef_data *)coefp;
+		coefp = coef_data->coef + coef_data->length;
+		memset(fd->fft_buf, 0, fd->fft_size * sizeof(struct icomplex32));
+		for (k = 0; k < coef_data->length; k++)
+			fd->fft_buf[k].real = (int32_t)coef_data->coef[k] << 16;
+
+		fft_execute_32(fd->fft_plan, false);
+		w = &fd->weights[i * fd->num_bins];
+		peak = 0;
+		for (k = 0; k < fd->num_bins; k++) {
+			w[k] = fd->fft_out[k];
+			peak = MAX(peak, ABS(w[k].real));
+			peak = MAX(peak, ABS(w[k].imag));
+		}
+
+		s = MIN(s, norm_int32(peak) + coef_data->out_shift);
+	}
+
+	coefp = cd->fir_coef;
+	for (i = 0; i < cd->config->num_filters; i++) {
+		coef_data = (struct sof_fir_coef_data *)coefp;
+		coefp = coef_data->coef + coef_data->length;
+		shift = s - coef_data->out_shift;
+		w = &cd->fd.weights[i * fd->num_bins];
+		for (k = 0; k < fd->num_bins; k++) {
+			if (shift > 0) {
+				w[k].real <<= shift;
+				w[k].imag <<= shift;
+			} else {
+				w[k].real >>= -shift;
+				w[k].imag >>= -shift;
+			}
+		}
+	}
+
+	/* Spectrum is FFT / N and weights are FIR spectrum * 2^s / N, the
+	 * inverse FFT returns the product spectrum multiplied by N.
+	 */
+	fd->out_shift = fd->fft_len - s;
+}
+
+void tdfb_fd_reset(struct tdfb_comp_data *cd)
+{
+	struct tdfb_fd_data *fd = &cd->fd;
+
+	if (!fd->data)
+		return;
+
+	memset(fd->in_buf, 0, fd->num_in * fd->fft_size * sizeof(int32_t));
+	memset(fd->out_buf, 0, fd->num_out * fd->hop * sizeof(int32_t));
+	fd->pos = fd->hop;
+}
+
+void tdfb_fd_free(struct tdfb_comp_data *cd)
+{
+	struct tdfb_fd_data *fd = &cd->fd;
+
+	fft_plan_free(fd->fft_plan);
+	rfree(fd->data);
+	memset(fd, 0, sizeof(*fd));
+	cd->fd_active = false;
+}
+
+int tdfb_fd_setup(struct tdfb_comp_data *cd, int source_nch, int sink_nch)
+{
+	struct tdfb_fd_data *fd = &cd->fd;
+	struct sof_fir_coef_data *coef_data;
+	int16_t *coefp = cd->fir_coef;
+	size_t size;
+	int32_t *p;
+	int num_filters = cd->config->num_filters;
+	int max_taps = 0;
+	int td_cost = 0;
+	int fd_cost;
+	int fft_size = 1;
+	int fft_len = 0;
+	int num_bins;
+	int num_in = 0;
+	int i;
+
+	for (i = 0; i < num_filters; i++) {
+		coef_data = (struct sof_fir_coef_data *)coefp;
+		coefp = coef_data->coef + coef_data->length;
+		max_taps = MAX(max_taps, coef_data->length);
+		td_cost += coef_data->length;
+		num_in = MAX(num_in, cd->input_channel_select[i] + 1);
+	}
+
+	while (fft_size < 2 * max_taps) {
+		fft_size <<= 1;
+		fft_len++;
+	}
+
+	/* Use the frequency domain filter bank only if it needs fewer
+	 * multiplications per frame than the FIR filters.
+	 */
+	num_bins = fft_size / 2 + 1;
+	fd_cost = ((num_in + 1) / 2 + (sink_nch + 1) / 2) *
+		TDFB_FD_BUTTERFLY_COST * fft_size / 2 * fft_len;
+	fd_cost = (fd_cost + num_filters * TDFB_FD_BUTTERFLY_COST * num_bins) / (fft_size / 2);
+	if (fft_size > FFT_SIZE_MAX || fd_cost >= td_cost) {
+		tdfb_fd_free(cd);
+		return 0;
+	}
+
+	size = 2 * fft_size * sizeof(struct icomplex32) +
+		(num_filters + num_in + 2) * num_bins * sizeof(struct icomplex32) +
+		(num_in * fft_size + sink_nch * fft_size / 2) * sizeof(int32_t);
+
+	/* Keep the buffers and history if only the beam angle changed */
+	if (fd->data && fd->data_size == size && fd->fft_size == fft_size &&
+	    fd->num_in == num_in && fd->num_out == sink_nch) {
+		tdfb_fd_init_weights(cd);
+		cd->fd_active = true;
+		return 0;
+	}
+
+	tdfb_fd_free(cd);
+	fd->data = rballoc(0, SOF_MEM_CAPS_RAM, size);
+	if (!fd->data)
+		return -ENOMEM;
+
+	fd->data_size = size;
+	fd->fft_size = fft_size;
+	fd->fft_len = fft_len;
+	fd->num_bins = num_bins;
+	fd->hop = fft_size / 2;
+	fd->num_in = num_in;
+	fd->num_out = sink_nch;
+
+	fd->fft_buf = (struct icomplex32 *)fd->data;
+	fd->fft_out = fd->fft_buf + fft_size;
+	fd->weights = fd->fft_out + fft_size;
+	fd->spectra = fd->weights + num_filters * num_bins;
+	fd->mix = fd->spectra + num_in * num_bins;
+	p = (int32_t *)(fd->mix + 2 * num_bins);
+	fd->in_buf = p;
+	fd->out_buf = p + num_in * fft_size;
+
+	fd->fft_plan = fft_plan_new(fd->fft_buf, fd->fft_out, fft_size, 32);
+	if (!fd->fft_plan) {
+		tdfb_fd_free(cd);
+		return -ENOMEM;
+	}
+
+	tdfb_fd_init_weights(cd);
+	tdfb_fd_reset(cd);
+	cd->fd_active = true;
+	return 0;
+}
+
+#if CONFIG_FORMAT_S16LE
+void tdfb_fd_s16(struct tdfb_comp_data *cd, struct input_stream_buffer *bsource,
+		 struct output_stream_buffer *bsink, int frames)
+{
+	struct audio_stream __sparse_cache *source = bsource->data;
+	struct audio_stream __sparse_cache *sink = bsink->data;
+	int16_t *x = audio_stream_get_rptr(source);
+	int16_t *y = audio_stream_get_wptr(sink);
+	int fmax;
+	int i;
+	int j;
+	int f;
+	const int in_nch = audio_stream_get_channels(source);
+	const int out_nch = audio_stream_get_channels(sink);
+	int remaining_frames = frames;
+	int emp_ch = 0;
+
+	while (remaining_frames) {
+		fmax = audio_stream_frames_without_wrap(source, x);
+		f = MIN(remaining_frames, fmax);
+		fmax = audio_stream_frames_without_wrap(sink, y);
+		f = MIN(f, fmax);
+		for (j = 0; j < f; j++) {
+			for (i = 0; i < in_nch; i++) {
+				cd->in[i] = *x << 16;
+				tdfb_direction_copy_emphasis(cd, in_nch, &emp_ch, *x << 16);
+				x++;
+			}
+
+			tdfb_fd_frame(cd);
+			for (i = 0; i < out_nch; i++) {
+				*y = sat_int16(Q_SHIFT_RND(cd->out[i], 27, 15));
+				y++;
+			}
+		}
+		remaining_frames -= f;
+		x = audio_stream_wrap(source, x);
+		y = audio_stream_wrap(sink, y);
+	}
+}
+#endif
+
+#if CONFIG_FORMAT_S24LE
+void tdfb_fd_s24(struct tdfb_comp_data *cd, struct input_stream_buffer *bsource,
+		 struct output_stream_buffer *bsink, int frames)
+{
+	struct audio_stream __sparse_cache *source = bsource->data;
+	struct audio_stream __sparse_cache *sink = bsink->data;
+	int32_t *x = audio_stream_get_rptr(source);
+	int32_t *y = audio_stream_get_wptr(sink);
+	int fmax;
+	int i;
+	int j;
+	int f;
+	const int in_nch = audio_stream_get_channels(source);
+	const int out_nch = audio_stream_get_channels(sink);
+	int remaining_frames = frames;
+	int emp_ch = 0;
+
+	while (remaining_frames) {
+		fmax = audio_stream_frames_without_wrap(source, x);
+		f = MIN(remaining_frames, fmax);
+		fmax = audio_stream_frames_without_wrap(sink, y);
+		f = MIN(f, fmax);
+		for (j = 0; j < f; j++) {
+			for (i = 0; i < in_nch; i++) {
+				cd->in[i] = *x << 8;
+				tdfb_direction_copy_emphasis(cd, in_nch, &emp_ch, *x << 8);
+				x++;
+			}
+
+			tdfb_fd_frame(cd);
+			for (i = 0; i < out_nch; i++) {
+				*y = sat_int24(Q_SHIFT_RND(cd->out[i], 27, 23));
+				y++;
+			}
+		}
+		remaining_frames -= f;
+		x = audio_stream_wrap(source, x);
+		y = audio_stream_wrap(sink, y);
+	}
+}
+#endif
+
+#if CONFIG_FORMAT_S32LE
+void tdfb_fd_s32(struct tdfb_comp_data *cd, struct input_stream_buffer *bsource,
+		 struct output_stream_buffer *bsink, int frames)
+{
+	struct audio_stream __sparse_cache *source = bsource->data;
+	struct audio_stream __sparse_cache *sink = bsink->data;
+	int32_t *x = audio_stream_get_rptr(source);
+	int32_t *y = audio_stream_get_wptr(sink);
+	int fmax;
+	int i;
+	int j;
+	int f;
+	const int in_nch = audio_stream_get_channels(source);
+	const int out_nch = audio_stream_get_channels(sink);
+	int remaining_frames = frames;
+	int emp_ch = 0;
+
+	while (remaining_frames) {
+		fmax = audio_stream_frames_without_wrap(source, x);
+		f = MIN(remaining_frames, fmax);
+		fmax = audio_stream_frames_without_wrap(sink, y);
+		f = MIN(f, fmax);
+		for (j = 0; j < f; j++) {
+			for (i = 0; i < in_nch; i++) {
+				cd->in[i] = *x;
+				tdfb_direction_copy_emphasis(cd, in_nch, &emp_ch, *x);
+				x++;
+			}
+
+			tdfb_fd_frame(cd);
+			for (i = 0; i < out_nch; i++) {
+				*y = sat_int32((int64_t)cd->out[i] << 4);
+				y++;
+			}
+		}
+		remaining_frames -= f;
+		x = audio_stream_wrap(source, x);
+		y = audio_stream_wrap(sink, y);
+	}
+}
+#endif
+
+#endif /* CONFIG_COMP_TDFB_FREQ_DOMAIN */
@@ -49,7 +49,7 @@ static int set_downmix_coefficients(struct processing_module *mod,
 	struct comp_dev *dev = mod->dev;
 	int ret;
 
-	if (cd->downmix_coefficients) {
+	if (downmix_coefficients) {
 		ret = memcpy_s(&custom_coeffs, sizeof(custom_coeffs), downmix_coefficients,
 			       sizeof(int32_t) * UP_DOWN_MIX_COEFFS_LENGTH);
 
@@ -130,12 +130,7 @@ static up_down_mixer_routine select_mix_out_stereo(struct comp_dev *dev,
 			return downmix16bit_5_1;
 		case IPC4_CHANNEL_CONFIG_INVALID:
 		default:
-			comp_err(dev, "select_mix_out_stereo(): invalid channel config.");
-			/*
-			 * This is a strange situation. We will allow to process it
-			 * in the release code (hoping for the best) with downmix16bit,
-			 * but will log err in debug to double check if everything is ok
-			 */
+			comp_dbg(dev, "select_mix_out_stereo(): no specialized routine.");
 			return NULL;
 		}
 	} else {
@@ -163,12 +158,7 @@ static up_down_mixer_routine select_mix_out_stereo(struct comp_dev *dev,
 			return downmix32bit_7_1;
 		case IPC4_CHANNEL_CONFIG_INVALID:
 		default:
-			comp_err(dev, "select_mix_out_stereo(): invalid channel config.");
-			/*
-			 * This is a strange situation. We will allow to process it
-			 * in the release code (hoping for the best) with downmix32bit,
-			 * but will log err in debug to double check if everything is ok.
-			 */
+			comp_dbg(dev, "select_mix_out_stereo(): no specialized routine.");
 			return NULL;
 		}
 	}
@@ -187,12 +177,7 @@ static up_down_mixer_routine select_mix_out_mono(struct comp_dev *dev,
 			return downmix16bit_4ch_mono;
 		case IPC4_CHANNEL_CONFIG_INVALID:
 		default:
-			comp_err(dev, "select_mix_out_mono(): invalid channel config.");
-			/*
-			 * This is a strange situation. We will allow to process it
-			 * in the release code (hoping for the best) with downmix16bit,
-			 * but will log err in debug to double check if everything is ok
-			 */
+			comp_dbg(dev, "select_mix_out_mono(): no specialized routine.");
 			return NULL;
 		}
 	} else {
@@ -214,12 +199,7 @@ static up_down_mixer_routine select_mix_out_mono(struct comp_dev *dev,
 			return downmix32bit_7_1_mono;
 		case IPC4_CHANNEL_CONFIG_INVALID:
 		default:
-			comp_err(dev, "select_mix_out_mono(): invalid channel config.");
-			/*
-			 * This is a strange situation. We will allow to process it
-			 * in the release code (hoping for the best) with downmix32bit,
-			 * but will log err in debug to double check if everything is ok.
-			 */
+			comp_dbg(dev, "select_mix_out_mono(): no specialized routine.");
 			return NULL;
 		}
 	}
@@ -236,7 +216,7 @@ static up_down_mixer_routine select_mix_out_5_1(struct comp_dev *dev,
 			return upmix16bit_2_0_to_5_1;
 		case IPC4_CHANNEL_CONFIG_INVALID:
 		default:
-			comp_err(dev, "select_mix_out_5_1(): invalid channel config.");
+			comp_dbg(dev, "select_mix_out_5_1(): no specialized routine.");
 			return NULL;
 		}
 	} else {
@@ -253,19 +233,79 @@ static up_down_mixer_routine select_mix_out_5_1(struct comp_dev *dev,
 			return downmix32bit_7_1_to_5_1;
 		case IPC4_CHANNEL_CONFIG_INVALID:
 		default:
-			comp_err(dev, "select_mix_out_5_1(): invalid channel config.");
+			comp_dbg(dev, "select_mix_out_5_1(): no specialized routine.");
 			return NULL;
 		}
 	}
 }
 
+static bool is_q15_coefficients(const downmix_coefficients coefficients)
+{
+	return coefficients == k_lo_ro_downmix16bit ||
+	       coefficients == k_scaled_lo_ro_downmix16bit ||
+	       coefficients == k_half_scaled_lo_ro_downmix16bit ||
+	       coefficients == k_quatro_mono_scaled_lo_ro_downmix16bit;
+}
+
+static int init_matrix_mix(struct processing_module *mod,
+			   const struct ipc4_audio_format *format,
+			   enum ipc4_channel_config out_channel_config,
+			   const int32_t *matrix, size_t matrix_size)
+{
+	struct up_down_mixer_data *cd = module_get_private_data(mod);
+	int32_t coefficients[UP_DOWN_MIX_COEFFS_LENGTH];
+	size_t out_channels = 0;
+	int shift = 0;
+	int i;
+
+	if (format->interleaving_style != IPC4_CHANNELS_INTERLEAVED)
+		return -EINVAL;
+
+	if (format->depth == IPC4_DEPTH_16BIT)
+		cd->mix_routine = mix_matrix16bit;
+	else if (format->depth == IPC4_DEPTH_32BIT)
+		cd->mix_routine = mix_matrix32bit;
+	else
+		return -EINVAL;
+
+	/* Output has the channels up to the last valid position of the map */
+	for (i = 0; i < UP_DOWN_MIXER_MAX_CHANNELS; i++)
+		if (get_channel_index(cd->out_channel_map, i) != CHANNEL_INVALID)
+			out_channels = i + 1;
+
+	cd->out_fmt[0].channels_count = out_channels;
+	cd->out_fmt[0].ch_cfg = out_channel_config;
+	cd->out_fmt[0].ch_map = cd->out_channel_map;
+
+	if (matrix) {
+		if (matrix_size < out_channels * format->channels_count * sizeof(int32_t))
+			return -EINVAL;
+
+		return up_down_mixer_set_matrix(cd, matrix, format->channels_count,
+						out_channels);
+	}
+
+	/* The matrix is in Q1.31, 16 bit streams may come with Q1.15 coefficients */
+	if (format->depth == IPC4_DEPTH_16BIT &&
+	    (cd->downmix_coefficients == custom_coeffs ||
+	     is_q15_coefficients(cd->downmix_coefficients)))
+		shift = 16;
+
+	for (i = 0; i < UP_DOWN_MIX_COEFFS_LENGTH; i++)
+		coefficients[i] = sat_int32((int64_t)cd->downmix_coefficients[i] << shift);
+
+	return up_down_mixer_map_matrix(cd, coefficients, format->channels_count, out_channels);
+}
+
 static int init_mix(struct processing_module *mod,
 		    const struct ipc4_audio_format *format,
 		    enum ipc4_channel_config out_channel_config,
-		    const downmix_coefficients downmix_coefficients)
+		    const downmix_coefficients downmix_coefficients,
+		    const int32_t *matrix, size_t matrix_size)
 {
 	struct up_down_mixer_data *cd = module_get_private_data(mod);
 	struct comp_dev *dev = mod->dev;
+	int ret;
 
 	if (!format)
 		return -EINVAL;
@@ -303,14 +343,10 @@ static int init_mix(struct processing_module *mod,
 		cd->out_fmt[0].ch_map = create_channel_map(IPC4_CHANNEL_CONFIG_5_POINT_1);
 
 	} else if (out_channel_config == IPC4_CHANNEL_CONFIG_7_POINT_1 &&
-		   format->ch_cfg == IPC4_CHANNEL_CONFIG_STEREO) {
+		   format->ch_cfg == IPC4_CHANNEL_CONFIG_STEREO &&
+		   format->depth != IPC4_DEPTH_16BIT) {
 		/* Select up mixing routine. */
 		cd->mix_routine = upmix32bit_2_0_to_7_1;
-
-		if (format->depth == IPC4_DEPTH_16BIT)
-			return -EINVAL;
-	} else {
-		return -EINVAL;
 	}
 
 	/* Update audio format. */
@@ -321,7 +357,23 @@ static int init_mix(struct processing_module *mod,
 	cd->in_channel_map = format->ch_map;
 	cd->in_channel_config = format->ch_cfg;
 
-	return set_downmix_coefficients(mod, format, out_channel_config, downmix_coefficients);
+	if (matrix)
+		return init_matrix_mix(mod, format, out_channel_config, matrix, matrix_size);
+
+	ret = set_downmix_coefficients(mod, format, out_channel_config, downmix_coefficients);
+	if (ret < 0)
+		return ret;
+
+#ifdef UP_DOWN_MIXER_GENERIC
+	/* The specialized routines are implemented only for HiFi3 */
+	cd->mix_routine = NULL;
+#endif
+
+	/* Other layouts get the matrix mixer */
+	if (!cd->mix_routine)
+		return init_matrix_mix(mod, format, out_channel_config, NULL, 0);
+
+	return 0;
 }
 
 static int up_down_mixer_free(struct processing_module *mod)
@@ -339,6 +391,7 @@ static int up_down_mixer_init(struct processing_module *mod)
 {
 	struct module_config *dst = &mod->priv.cfg;
 	const struct ipc4_up_down_mixer_module_cfg *up_down_mixer = dst->init_data;
+	const struct ipc4_up_down_mixer_matrix_cfg *matrix_cfg = dst->init_data;
 	struct module_data *mod_data = &mod->priv;
 	struct comp_dev *dev = mod->dev;
 	struct up_down_mixer_data *cd;
@@ -363,22 +416,35 @@ static int up_down_mixer_init(struct processing_module *mod)
 	case DEFAULT_COEFFICIENTS:
 		cd->out_channel_map = create_channel_map(up_down_mixer->out_channel_config);
 		ret = init_mix(mod, &mod->priv.cfg.base_cfg.audio_fmt,
-			       up_down_mixer->out_channel_config, NULL);
+			       up_down_mixer->out_channel_config, NULL, NULL, 0);
 		break;
 	case CUSTOM_COEFFICIENTS:
 		cd->out_channel_map = create_channel_map(up_down_mixer->out_channel_config);
 		ret = init_mix(mod, &mod->priv.cfg.base_cfg.audio_fmt,
-			       up_down_mixer->out_channel_config, up_down_mixer->coefficients);
+			       up_down_mixer->out_channel_config, up_down_mixer->coefficients,
+			       NULL, 0);
 		break;
 	case DEFAULT_COEFFICIENTS_WITH_CHANNEL_MAP:
 		cd->out_channel_map = up_down_mixer->channel_map;
 		ret = init_mix(mod, &mod->priv.cfg.base_cfg.audio_fmt,
-			       up_down_mixer->out_channel_config, NULL);
+			       up_down_mixer->out_channel_config, NULL, NULL, 0);
 		break;
 	case CUSTOM_COEFFICIENTS_WITH_CHANNEL_MAP:
 		cd->out_channel_map = up_down_mixer->channel_map;
 		ret = init_mix(mod, &mod->priv.cfg.base_cfg.audio_fmt,
-			       up_down_mixer->out_channel_config, up_down_mixer->coefficients);
+			       up_down_mixer->out_channel_config, up_down_mixer->coefficients,
+			       NULL, 0);
+		break;
+	case CUSTOM_MATRIX_WITH_CHANNEL_MAP:
+		if (dst->size < sizeof(*matrix_cfg)) {
+			ret = -EINVAL;
+			break;
+		}
+
+		cd->out_channel_map = up_down_mixer->channel_map;
+		ret = init_mix(mod, &mod->priv.cfg.base_cfg.audio_fmt,
+			       up_down_mixer->out_channel_config, NULL, matrix_cfg->matrix,
+			       dst->size - sizeof(*matrix_cfg));
 		break;
 	default:
 		comp_err(dev, "up_down_mixer_init(): unsupported coefficient type");
@@ -0,0 +1,331 @@
+// SPDX-License-Identifier: BSD-3-Clause
+//
+// Copyright(c) 2023 Intel Corporation. All rights reserved.
+
+#include <sof/audio/up_down_mixer/up_down_mixer.h>
+#include <sof/audio/format.h>
+#include <errno.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <string.h>
+
+#ifndef UP_DOWN_MIXER_GENERIC
+#include <xtensa/tie/xt_hifi3.h>
+#endif
+
+#define UNITY_GAIN	INT32_MAX
+
+static bool has_position(channel_map map, size_t channels, enum ipc4_channel_index pos)
+{
+	return get_channel_location(map, pos) < channels;
+}
+
+/* Sets the gains of one input channel to output positions. The gain is
+ * direct_gain if the output has the same position, otherwise the channel
+ * is folded with fold_gain to the nearest position that exists.
+ */
+static void route_position(channel_map map, size_t channels, enum ipc4_channel_index pos,
+			   int32_t direct_gain, int32_t fold_gain, int32_t *pos_gain)
+{
+	if (has_position(map, channels, pos)) {
+		pos_gain[pos] = direct_gain;
+		return;
+	}
+
+	switch (pos) {
+	case CHANNEL_LEFT_SURROUND:
+	case CHANNEL_LEFT_SIDE:
+		if (pos == CHANNEL_LEFT_SURROUND &&
+		    has_position(map, channels, CHANNEL_LEFT_SIDE))
+			pos_gain[CHANNEL_LEFT_SIDE] = fold_gain;
+		else if (pos == CHANNEL_LEFT_SIDE &&
+			 has_position(map, channels, CHANNEL_LEFT_SURROUND))
+			pos_gain[CHANNEL_LEFT_SURROUND] = fold_gain;
+		else
+			route_position(map, channels, CHANNEL_LEFT, fold_gain, fold_gain,
+				       pos_gain);
+		break;
+	case CHANNEL_RIGHT_SURROUND:
+	case CHANNEL_RIGHT_SIDE:
+		if (pos == CHANNEL_RIGHT_SURROUND &&
+		    has_position(map, channels, CHANNEL_RIGHT_SIDE))
+			pos_gain[CHANNEL_RIGHT_SIDE] = fold_gain;
+		else if (pos == CHANNEL_RIGHT_SIDE &&
+			 has_position(map, channels, CHANNEL_RIGHT_SURROUND))
+			pos_gain[CHANNEL_RIGHT_SURROUND] = fold_gain;
+		else
+			route_position(map, channels, CHANNEL_RIGHT, fold_gain, fold_gain,
+				       pos_gain);
+		break;
+	case CHANNEL_LEFT:
+	case CHANNEL_RIGHT:
+		/* The front pair sums to center with half gain */
+		if (has_position(map, channels, CHANNEL_CENTER))
+			pos_gain[CHANNEL_CENTER] = fold_gain >> 1;
+		break;
+	case CHANNEL_CENTER:
+	case CHANNEL_LFE:
+		if (has_position(map, channels, CHANNEL_LEFT) &&
+		    has_position(map, channels, CHANNEL_RIGHT)) {
+			pos_gain[CHANNEL_LEFT] = fold_gain;
+			pos_gain[CHANNEL_RIGHT] = fold_gain;
+		} else if (has_position(map, channels, CHANNEL_CENTER)) {
+			pos_gain[CHANNEL_CENTER] = fold_gain;
+		}
+		break;
+	default:
+		break;
+	}
+}
+
+/* Repeats the front pair in an empty output row of the surround pair, or
+ * of the side pair if the output has no surround pair.
+ */
+static void fill_rear_row(int32_t *matrix, channel_map map, size_t in_channels,
+			  size_t out_channels, enum ipc4_channel_index front,
+			  enum ipc4_channel_index surround, enum ipc4_channel_index side)
+{
+	uint8_t src = get_channel_location(map, front);
+	uint8_t dst = get_channel_location(map, surround);
+	size_t i;
+
+	if (src >= out_channels)
+		return;
+
+	if (dst >= out_channels)
+		dst = get_channel_location(map, side);
+
+	if (dst >= out_channels)
+		return;
+
+	for (i = 0; i < in_channels; i++)
+		if (matrix[dst * in_channels + i])
+			return;
+
+	for (i = 0; i < in_channels; i++)
+		matrix[dst * in_channels + i] = matrix[src * in_channels + i];
+}
+
+int up_down_mixer_map_matrix(struct up_down_mixer_data *cd, const int32_t *coefficients,
+			     size_t in_channels, size_t out_channels)
+{
+	int32_t matrix[UP_DOWN_MIXER_MAX_CHANNELS * UP_DOWN_MIXER_MAX_CHANNELS] = { 0 };
+	int32_t pos_gain[UP_DOWN_MIXER_MAX_CHANNELS];
+	channel_map out_map = cd->out_channel_map;
+	channel_map in_map = cd->in_channel_map;
+	bool downmix = out_channels < in_channels;
+	enum ipc4_channel_index pos;
+	int32_t direct_gain;
+	int32_t fold_gain;
+	size_t i, o;
+
+	if (!in_channels || in_channels > UP_DOWN_MIXER_MAX_CHANNELS ||
+	    !out_channels || out_channels > UP_DOWN_MIXER_MAX_CHANNELS)
+		return -EINVAL;
+
+	for (i = 0; i < in_channels; i++) {
+		pos = get_channel_index(in_map, i);
+		if (pos >= UP_DOWN_MIXER_MAX_CHANNELS)
+			continue;
+
+		fold_gain = coefficients[pos];
+		direct_gain = downmix ? fold_gain : UNITY_GAIN;
+		memset(pos_gain, 0, sizeof(pos_gain));
+
+		if (pos == CHANNEL_CENTER && in_channels == 1 &&
+		    has_position(out_map, out_channels, CHANNEL_LEFT) &&
+		    has_position(out_map, out_channels, CHANNEL_RIGHT)) {
+			/* Mono feeds the front pair */
+			pos_gain[CHANNEL_LEFT] = direct_gain;
+			pos_gain[CHANNEL_RIGHT] = direct_gain;
+		} else if (pos == CHANNEL_CENTER_SURROUND &&
+			   !has_position(in_map, in_channels, CHANNEL_RIGHT_SURROUND) &&
+			   (has_position(out_map, out_channels, CHANNEL_RIGHT_SURROUND) ||
+			    !has_position(out_map, out_channels, CHANNEL_CENTER_SURROUND))) {
+			/* Lone center surround goes to both sides */
+			route_position(out_map, out_channels, CHANNEL_LEFT_SURROUND,
+				       direct_gain, fold_gain, pos_gain);
+			route_position(out_map, out_channels, CHANNEL_RIGHT_SURROUND,
+				       direct_gain, fold_gain, pos_gain);
+		} else {
+			route_position(out_map, out_channels, pos, direct_gain, fold_gain,
+				       pos_gain);
+		}
+
+		for (o = 0; o < out_channels; o++) {
+			pos = get_channel_index(out_map, o);
+			if (pos < UP_DOWN_MIXER_MAX_CHANNELS)
+				matrix[o * in_channels + i] = pos_gain[pos];
+		}
+	}
+
+	if (out_channels > in_channels) {
+		fill_rear_row(matrix, out_map, in_channels, out_channels, CHANNEL_LEFT,
+			      CHANNEL_LEFT_SURROUND, CHANNEL_LEFT_SIDE);
+		fill_rear_row(matrix, out_map, in_channels, out_channels, CHANNEL_RIGHT,
+			      CHANNEL_RIGHT_SURROUND, CHANNEL_RIGHT_SIDE);
+	}
+
+	return up_down_mixer_set_matrix(cd, matrix, in_channels, out_channels);
+}
+
+int up_down_mixer_set_matrix(struct up_down_mixer_data *cd, const int32_t *matrix,
+			     size_t in_channels, size_t out_channels)
+{
+	int32_t coef;
+	size_t i, o;
+	int n;
+
+	if (!in_channels || in_channels > UP_DOWN_MIXER_MAX_CHANNELS ||
+	    !out_channels || out_channels > UP_DOWN_MIXER_MAX_CHANNELS)
+		return -EINVAL;
+
+	for (o = 0; o < out_channels; o++) {
+		n = 0;
+		for (i = 0; i < in_channels; i++) {
+			coef = matrix[o * in_channels + i];
+			if (!coef)
+				continue;
+
+			cd->taps[o][n].coef = coef;
+			cd->taps[o][n].in = i;
+			n++;
+		}
+
+		cd->num_taps[o] = n;
+	}
+
+	cd->in_channel_no = in_channels;
+	cd->out_channel_no = out_channels;
+
+	return 0;
+}
+
+#ifdef UP_DOWN_MIXER_GENERIC
+
+/* The Q2.62 products are summed as Q5.59 to not overflow with 8 taps */
+static void mix_row32(const int32_t *x, int32_t *y, const struct up_down_mixer_tap *taps,
+		      int num_taps, int in_channels, int out_channels, int frames)
+{
+	const int32_t c0 = taps[0].coef;
+	const int32_t c1 = taps[1].coef;
+	const int i0 = taps[0].in;
+	const int i1 = taps[1].in;
+	int64_t acc;
+	int i, j;
+
+	switch (num_taps) {
+	case 1:
+		for (i = 0; i < frames; i++) {
+			*y = sat_int32(Q_SHIFT_RND((int64_t)x[i0] * c0, 62, 31));
+			x += in_channels;
+			y += out_channels;
+		}
+		break;
+	case 2:
+		for (i = 0; i < frames; i++) {
+			acc = ((int64_t)x[i0] * c0 >> 3) + ((int64_t)x[i1] * c1 >> 3);
+			*y = sat_int32(Q_SHIFT_RND(acc, 59, 31));
+			x += in_channels;
+			y += out_channels;
+		}
+		break;
+	default:
+		for (i = 0; i < frames; i++) {
+			acc = 0;
+			for (j = 0; j < num_taps; j++)
+				acc += (int64_t)x[taps[j].in] * taps[j].coef >> 3;
+
+			*y = sat_int32(Q_SHIFT_RND(acc, 59, 31));
+			x += in_channels;
+			y += out_channels;
+		}
+		break;
+	}
+}
+
+#else
+
+static void mix_row32(const int32_t *x, int32_t *y, const struct up_down_mixer_tap *taps,
+		      int num_taps, int in_channels, int out_channels, int frames)
+{
+	const int in_offset = in_channels * sizeof(ae_int32);
+	const int out_offset = out_channels * sizeof(ae_int32);
+	const ae_int32 *in = (const ae_int32 *)x;
+	ae_int32 *out = (ae_int32 *)y;
+	ae_int32x2 P_coefficient;
+	ae_int32x2 P_input;
+	ae_int32x2 P_output;
+	ae_f64 Q_tmp;
+	int i, j;
+
+	for (i = 0; i < frames; i++) {
+		Q_tmp = AE_ZERO64();
+		for (j = 0; j < num_taps; j++) {
+			P_coefficient = AE_L32_X((ae_int32 *)&taps[j].coef, 0);
+			P_input = AE_L32_X(in, taps[j].in << 2);
+			AE_MULAF32S_LL(Q_tmp, P_input, P_coefficient);
+		}
+
+		P_output = AE_ROUND32F64SSYM(Q_tmp);
+		AE_S32_L_IP(P_output, out, out_offset);
+		in = (const ae_int32 *)((const uint8_t *)in + in_offset);
+	}
+}
+
+#endif /* UP_DOWN_MIXER_GENERIC */
+
+void mix_matrix32bit(struct up_down_mixer_data *cd, const uint8_t * const in_data,
+		     const uint32_t in_size, uint8_t * const out_data)
+{
+	const int in_channels = cd->in_channel_no;
+	const int out_channels = cd->out_channel_no;
+	const int frames = in_size / (in_channels * sizeof(int32_t));
+	const int32_t *x = (const int32_t *)in_data;
+	int32_t *y;
+	int i, o;
+
+	for (o = 0; o < out_channels; o++) {
+		y = (int32_t *)out_data + o;
+		if (!cd->num_taps[o]) {
+			for (i = 0; i < frames; i++)
+				y[i * out_channels] = 0;
+		} else if (cd->num_taps[o] == 1 && cd->taps[o][0].coef == UNITY_GAIN) {
+			/* Copy exactly, unity gain in Q1.31 would attenuate a bit */
+			for (i = 0; i < frames; i++)
+				y[i * out_channels] = x[i * in_channels + cd->taps[o][0].in];
+		} else {
+			mix_row32(x, y, cd->taps[o], cd->num_taps[o], in_channels,
+				  out_channels, frames);
+		}
+	}
+}
+
+void mix_matrix16bit(struct up_down_mixer_data *cd, const uint8_t * const in_data,
+		     const uint32_t in_size, uint8_t * const out_data)
+{
+	const int in_channels = cd->in_channel_no;
+	const int out_channels = cd->out_channel_no;
+	const int frames = in_size / (in_channels * sizeof(int16_t));
+	const struct up_down_mixer_tap *taps;
+	const int16_t *x;
+	int32_t *y;
+	int64_t acc;
+	int i, j, o;
+
+	for (o = 0; o < out_channels; o++) {
+		taps = cd->taps[o];
+		x = (const int16_t *)in_data;
+		y = (int32_t *)out_data + o;
+		for (i = 0; i < frames; i++) {
+			acc = 0;
+			for (j = 0; j < cd->num_taps[o]; j++)
+				acc += (int64_t)x[taps[j].in] * taps[j].coef;
+
+			/* Q1.15 x Q1.31 to Q1.31 */
+			*y = sat_int32(Q_SHIFT_RND(acc, 46, 31));
+			x += in_channels;
+			y += out_channels;
+		}
+	}
+}
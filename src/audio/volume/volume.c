@@ -30,6 +30,8 @@
 #include <sof/lib/memory.h>
 #include <sof/lib/uuid.h>
 #include <sof/list.h>
+#include <sof/math/decibels.h>
+#include <sof/math/log.h>
 #include <sof/math/numbers.h>
 #include <sof/platform.h>
 #include <rtos/string.h>
@@ -243,6 +245,61 @@ static inline int32_t volume_windows_fade_ramp(struct vol_data *cd, int32_t ramp
 }
 #endif
 
+#if CONFIG_COMP_VOLUME_LOG_RAMP
+/**
+ * \brief Convert volume gain to decibels
+ * \param[in] gain Volume gain as Qx.y
+ * \return Gain in decibels as Q8.24, limited to VOL_RAMP_LOG_FLOOR_DB
+ */
+static int32_t volume_gain_to_db(int32_t gain)
+{
+	int64_t db;
+	int32_t log2_gain; /* Q16.16 */
+
+	if (gain <= 0)
+		return VOL_RAMP_LOG_FLOOR_DB;
+
+	/* 20 * log10(x) = 20 * log10(2) * log2(x) */
+	log2_gain = base2_logarithm((uint32_t)gain) - (VOL_QXY_Y << 16);
+	db = Q_MULTSR_32X32((int64_t)log2_gain, Q_CONVERT_FLOAT(6.0205999, 26), 16, 26, 24);
+
+	return MAX(db, VOL_RAMP_LOG_FLOOR_DB);
+}
+
+/**
+ * \brief Calculate logarithmic ramp function
+ * \param[in,out] cd Component data: ramp start and target gains in dB, ramp duration
+ * \param[in] ramp_time Time spent since ramp start as milliseconds Q29.3
+ * \param[in] channel Current channel to update
+ *
+ * The gain in decibels changes linearly during the ramp. It sounds
+ * more even than a linear gain ramp, especially for fade-in from mute.
+ */
+static inline int32_t volume_log_ramp(struct vol_data *cd, int32_t ramp_time, int channel)
+{
+	int64_t time_ratio; /* Q2.30 */
+	int32_t db; /* Q8.24 */
+	int32_t gain; /* Q12.20 */
+
+	if (!cd->initial_ramp)
+		return cd->tvolume[channel];
+
+	time_ratio = (((int64_t)ramp_time) << 30) / (cd->initial_ramp << 3);
+	if (time_ratio >= ONE_Q2_30)
+		return cd->tvolume[channel];
+
+	db = cd->ramp_db[channel] +
+	     Q_MULTSR_32X32((int64_t)(cd->ramp_tdb[channel] - cd->ramp_db[channel]),
+			    time_ratio, 24, 30, 24);
+	gain = db2lin_fixed(db);
+#if VOL_QXY_Y > 20
+	return sat_int32(Q_SHIFT_LEFT((int64_t)gain, 20, VOL_QXY_Y));
+#else
+	return Q_SHIFT_RND(gain, 20, VOL_QXY_Y);
+#endif
+}
+#endif
+
 /**
  * \brief Ramps volume changes over time.
  * \param[in,out] vol_data Volume component data
@@ -266,7 +323,8 @@ static inline void volume_ramp(struct processing_module *mod)
 	 * exceeding int32_t range. Inverse of sample rate is 1000/sample_rate
 	 * for milliseconds.
 	 */
-#if defined CONFIG_COMP_VOLUME_WINDOWS_FADE || defined CONFIG_COMP_VOLUME_LINEAR_RAMP
+#if defined CONFIG_COMP_VOLUME_WINDOWS_FADE || defined CONFIG_COMP_VOLUME_LINEAR_RAMP || \
+	defined CONFIG_COMP_VOLUME_LOG_RAMP
 	int32_t ramp_time = Q_MULTSR_32X32((int64_t)cd->vol_ramp_elapsed_frames,
 					   cd->sample_rate_inv, 0, 31, 3);
 #endif
@@ -294,6 +352,10 @@ static inline void volume_ramp(struct processing_module *mod)
 		new_vol = volume_linear_ramp(cd, ramp_time, i);
 #else
 		new_vol = tvolume;
+#endif
+#if CONFIG_COMP_VOLUME_LOG_RAMP
+		if (cd->ramp_type == SOF_VOLUME_LOG || cd->ramp_type == SOF_VOLUME_LOG_ZC)
+			new_vol = volume_log_ramp(cd, ramp_time, i);
 #endif
 		if (volume < tvolume) {
 			/* ramp up, check if ramp completed */
@@ -322,6 +384,41 @@ static inline void volume_ramp(struct processing_module *mod)
 	set_volume_process(cd, dev, true);
 }
 
+#if CONFIG_COMP_VOLUME_SMOOTH_RAMP
+/**
+ * \brief Advances volume ramp and sets up per-sample gain interpolation.
+ * \param[in,out] mod Volume processing module handle
+ * \param[in] frames Number of frames to advance the ramp.
+ * \return True if gain of some channel changes during the frames.
+ *
+ * The ramp shape function is evaluated at the end of the frames and
+ * the gain is interpolated linearly per sample from the current gain.
+ */
+static bool volume_ramp_interp(struct processing_module *mod, uint32_t frames)
+{
+	struct vol_data *cd = module_get_private_data(mod);
+	int32_t start[SOF_IPC_MAX_CHANNELS];
+	bool changed = false;
+	int i;
+
+	for (i = 0; i < cd->channels; i++)
+		start[i] = cd->volume[i];
+
+	cd->vol_ramp_elapsed_frames += frames;
+	volume_ramp(mod);
+
+	for (i = 0; i < cd->channels; i++) {
+		cd->ramp_acc[i] = (int64_t)start[i] << VOL_RAMP_STEP_SHIFT;
+		cd->ramp_step[i] = ((int64_t)(cd->volume[i] - start[i]) << VOL_RAMP_STEP_SHIFT) /
+				   (int32_t)frames;
+		if (cd->volume[i] != start[i])
+			changed = true;
+	}
+
+	return changed;
+}
+#endif
+
 /**
  * \brief Reset state except controls.
  */
@@ -360,6 +457,14 @@ void volume_prepare_ramp(struct comp_dev *dev, struct vol_data *cd)
 	else
 		ramp_update_us = VOL_RAMP_UPDATE_SLOWEST_US;
 
+#if CONFIG_COMP_VOLUME_SMOOTH_RAMP
+	/* With per-sample interpolation a linear ramp is exact regardless of
+	 * the update rate so it is updated only once per copy().
+	 */
+	if (cd->ramp_type == SOF_VOLUME_LINEAR)
+		ramp_update_us = dev->period;
+#endif
+
 	/* The volume ramp is updated at least once per copy(). If the ramp update
 	 * period is larger than schedule period the frames count for update is set
 	 * to copy schedule equivalent number of frames. This also prevents a divide
@@ -478,6 +583,13 @@ int volume_set_chan(struct processing_module *mod, int chan,
 		comp_dbg(mod->dev, "cd->ramp_coef[%d] = %d", chan, cd->ramp_coef[chan]);
 	}
 
+#if CONFIG_COMP_VOLUME_LOG_RAMP
+	if (cd->ramp_type == SOF_VOLUME_LOG || cd->ramp_type == SOF_VOLUME_LOG_ZC) {
+		cd->ramp_db[chan] = volume_gain_to_db(cd->volume[chan]);
+		cd->ramp_tdb[chan] = volume_gain_to_db(cd->tvolume[chan]);
+	}
+#endif
+
 	return 0;
 }
 
@@ -528,6 +640,7 @@ static int volume_process(struct processing_module *mod,
 	uint32_t avail_frames = input_buffers[0].size;
 	uint32_t frames;
 	int64_t prev_sum = 0;
+	vol_scale_func scale_vol;
 
 	comp_dbg(mod->dev, "volume_process()");
 
@@ -537,7 +650,8 @@ static int volume_process(struct processing_module *mod,
 		if (cd->ramp_finished || cd->vol_ramp_frames > avail_frames) {
 			/* without ramping process all at once */
 			frames = avail_frames;
-		} else if (cd->ramp_type == SOF_VOLUME_LINEAR_ZC) {
+		} else if (cd->ramp_type == SOF_VOLUME_LINEAR_ZC ||
+			   cd->ramp_type == SOF_VOLUME_LOG_ZC) {
 			/* with ZC ramping look for next ZC offset */
 			frames = cd->zc_get(input_buffers[0].data, cd->vol_ramp_frames, &prev_sum);
 		} else {
@@ -545,13 +659,19 @@ static int volume_process(struct processing_module *mod,
 			frames = cd->vol_ramp_frames;
 		}
 
+		scale_vol = cd->scale_vol;
 		if (!cd->ramp_finished) {
+#if CONFIG_COMP_VOLUME_SMOOTH_RAMP
+			if (volume_ramp_interp(mod, frames))
+				scale_vol = cd->scale_ramp;
+#else
 			volume_ramp(mod);
 			cd->vol_ramp_elapsed_frames += frames;
+#endif
 		}
 
 		/* copy and scale volume */
-		cd->scale_vol(mod, &input_buffers[0], &output_buffers[0], frames, cd->attenuation);
+		scale_vol(mod, &input_buffers[0], &output_buffers[0], frames, cd->attenuation);
 
 		avail_frames -= frames;
 	}
@@ -588,6 +708,26 @@ static vol_zc_func vol_get_zc_function(struct comp_dev *dev,
 	return NULL;
 }
 
+#if CONFIG_COMP_VOLUME_SMOOTH_RAMP
+/*
+ * \brief Retrieves volume per-sample ramp function.
+ * \param[in,out] dev Volume base component device.
+ */
+static vol_scale_func vol_get_ramp_function(struct comp_dev *dev,
+					    struct comp_buffer __sparse_cache *sinkb)
+{
+	int i;
+
+	/* map the ramp function to frame format */
+	for (i = 0; i < volume_ramp_func_count; i++) {
+		if (audio_stream_get_valid_fmt(&sinkb->stream) == volume_ramp_func_map[i].frame_fmt)
+			return volume_ramp_func_map[i].func;
+	}
+
+	return NULL;
+}
+#endif
+
 /**
  * \brief Set volume frames alignment limit.
  * \param[in,out] source Structure pointer of source.
@@ -687,6 +827,15 @@ static int volume_prepare(struct processing_module *mod,
 		goto err;
 	}
 
+#if CONFIG_COMP_VOLUME_SMOOTH_RAMP
+	cd->scale_ramp = vol_get_ramp_function(dev, sink_c);
+	if (!cd->scale_ramp) {
+		comp_err(dev, "volume_prepare(): invalid cd->scale_ramp");
+		ret = -EINVAL;
+		goto err;
+	}
+#endif
+
 	/* Set current volume to min to ensure ramp starts from minimum
 	 * to previous volume request. Copy() checks for ramp finished
 	 * and executes it if it has not yet finished as result of
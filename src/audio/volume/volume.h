@@ -21,6 +21,7 @@
 #include <sof/audio/module_adapter/module/generic.h>
 #include <rtos/bit.h>
 #include <sof/common.h>
+#include <sof/math/numbers.h>
 #include <sof/trace/trace.h>
 #include <ipc/stream.h>
 #include <user/trace.h>
@@ -93,6 +94,18 @@ struct sof_ipc_ctrl_value_chan;
 #define VOL_RAMP_UPDATE_THRESHOLD_FAST_MS	64
 #define VOL_RAMP_UPDATE_THRESHOLD_FASTEST_MS	32
 
+/**
+ * \brief Per-sample interpolated ramp parameters.
+ * The gain is interpolated between ramp update points in blocks of
+ * VOL_RAMP_BLOCK_FRAMES frames. The interpolation accumulator keeps
+ * VOL_RAMP_STEP_SHIFT extra fractional bits to keep slow ramps exact.
+ */
+#define VOL_RAMP_BLOCK_FRAMES	16
+#define VOL_RAMP_STEP_SHIFT	24
+
+/** \brief Lowest gain in dB for logarithmic ramp, Q8.24 */
+#define VOL_RAMP_LOG_FLOOR_DB	Q_CONVERT_FLOAT(-90.0, 24)
+
 /**
  * \brief left shift 8 bits to put the valid 24 bits into
  * higher part of 32 bits container.
@@ -176,6 +189,17 @@ struct vol_data {
 	bool copy_gain;				/**< control copy gain or not */
 	uint32_t attenuation;			/**< peakmeter adjustment in range [0 - 31] */
 	bool is_passthrough;			/**< is passthrough or do gain multiplication */
+#if CONFIG_COMP_VOLUME_SMOOTH_RAMP
+	vol_scale_func scale_ramp;		/**< per-sample ramp processing function */
+	int64_t ramp_acc[SOF_IPC_MAX_CHANNELS];	/**< interpolated gain with extra fraction */
+	int64_t ramp_step[SOF_IPC_MAX_CHANNELS]; /**< interpolated gain increment per frame */
+	/**< per-sample gains for one block of interleaved frames */
+	int32_t ramp_gain[VOL_RAMP_BLOCK_FRAMES * SOF_IPC_MAX_CHANNELS] __aligned(8);
+#endif
+#if CONFIG_COMP_VOLUME_LOG_RAMP
+	int32_t ramp_db[SOF_IPC_MAX_CHANNELS];	/**< ramp start gain in dB Q8.24 */
+	int32_t ramp_tdb[SOF_IPC_MAX_CHANNELS];	/**< ramp target gain in dB Q8.24 */
+#endif
 };
 
 /** \brief Volume processing functions map. */
@@ -197,6 +221,108 @@ struct comp_zc_func_map {
 	vol_zc_func func;	/**< volume zc function */
 };
 
+/** \brief Volume per-sample ramp functions map. */
+struct comp_ramp_func_map {
+	uint16_t frame_fmt;	/**< frame format */
+	vol_scale_func func;	/**< volume ramp function */
+};
+
+#if CONFIG_COMP_VOLUME_SMOOTH_RAMP
+/** \brief Map of formats with per-sample ramp functions. */
+extern const struct comp_ramp_func_map volume_ramp_func_map[];
+
+/** \brief Number of per-sample ramp functions. */
+extern const size_t volume_ramp_func_count;
+
+/**
+ * \brief Computes per-sample gains for a block of frames.
+ * \param[in,out] cd Volume component private data.
+ * \param[in] frames Number of frames, max. VOL_RAMP_BLOCK_FRAMES.
+ * \param[in] channels_count Number of interleaved channels.
+ *
+ * The gains are stored interleaved to cd->ramp_gain so that the
+ * multiply loop can process the block as a plain vector product.
+ */
+static inline void vol_ramp_gain_block(struct vol_data *cd, int frames,
+				       const int channels_count)
+{
+	int32_t *gain = cd->ramp_gain;
+	int i, j;
+
+	for (i = 0; i < frames; i++) {
+		for (j = 0; j < channels_count; j++) {
+			cd->ramp_acc[j] += cd->ramp_step[j];
+			*gain++ = (int32_t)(cd->ramp_acc[j] >> VOL_RAMP_STEP_SHIFT);
+		}
+	}
+}
+
+#if CONFIG_COMP_PEAK_VOL
+/**
+ * \brief Scales a peak to Q1.31 with saturation, as AE_SLAA32S() does in
+ *	  the peak meters of the non-ramp HiFi functions.
+ * \param[in] peak Absolute peak value.
+ * \param[in] shift Left shift, including the attenuation adjustment.
+ * \return Scaled peak.
+ */
+static inline uint32_t vol_ramp_peak_scale(uint32_t peak, int shift)
+{
+	if (peak > ((uint32_t)INT32_MAX >> shift))
+		return INT32_MAX;
+
+	return peak << shift;
+}
+
+/**
+ * \brief Updates peak meter from a block of 32 bit samples.
+ * \param[in,out] cd Volume component private data.
+ * \param[in] x Input samples.
+ * \param[in] samples Number of samples, multiple of channels count.
+ * \param[in] channels_count Number of interleaved channels.
+ * \param[in] shift Left shift to scale the peak to Q1.31.
+ */
+static inline void vol_ramp_peak_s32(struct vol_data *cd, const int32_t *x, int samples,
+				     const int channels_count, int shift)
+{
+	uint32_t tmp;
+	int i, j;
+
+	for (j = 0; j < channels_count; j++) {
+		tmp = 0;
+		for (i = j; i < samples; i += channels_count)
+			tmp = MAX((uint32_t)ABS(x[i]), tmp);
+
+		tmp = vol_ramp_peak_scale(tmp, shift);
+		cd->peak_regs.peak_meter[j] = MAX(tmp, cd->peak_regs.peak_meter[j]);
+	}
+}
+
+/**
+ * \brief Updates peak meter from a block of 16 bit samples.
+ * \param[in,out] cd Volume component private data.
+ * \param[in] x Input samples.
+ * \param[in] samples Number of samples, multiple of channels count.
+ * \param[in] channels_count Number of interleaved channels.
+ * \param[in] shift Left shift to scale the peak to Q1.31.
+ */
+static inline void vol_ramp_peak_s16(struct vol_data *cd, const int16_t *x, int samples,
+				     const int channels_count, int shift)
+{
+	uint32_t tmp;
+	int i, j;
+
+	for (j = 0; j < channels_count; j++) {
+		tmp = 0;
+		for (i = j; i < samples; i += channels_count)
+			tmp = MAX((uint32_t)ABS(x[i]), tmp);
+
+		tmp = vol_ramp_peak_scale(tmp, shift);
+		cd->peak_regs.peak_meter[j] = MAX(tmp, cd->peak_regs.peak_meter[j]);
+	}
+}
+#endif /* CONFIG_COMP_PEAK_VOL */
+#endif /* CONFIG_COMP_VOLUME_SMOOTH_RAMP */
+
 #if CONFIG_IPC_MAJOR_3
 /**
  * \brief Retrievies volume processing function.
@@ -156,6 +156,10 @@ int volume_init(struct processing_module *mod)
 #endif
 #if CONFIG_COMP_VOLUME_WINDOWS_FADE
 	case SOF_VOLUME_WINDOWS_FADE:
+#endif
+#if CONFIG_COMP_VOLUME_LOG_RAMP
+	case SOF_VOLUME_LOG:
+	case SOF_VOLUME_LOG_ZC:
 #endif
 		cd->ramp_type = vol->ramp;
 		cd->initial_ramp = vol->initial_ramp;
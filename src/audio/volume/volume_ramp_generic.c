@@ -0,0 +1,197 @@
+// SPDX-License-Identifier: BSD-3-Clause
+//
+// Copyright(c) 2023 Intel Corporation. All rights reserved.
+
+/**
+ * \file
+ * \brief Volume generic per-sample ramp processing implementation
+ *
+ * The gain is interpolated per sample between the ramp update points.
+ * Gains are generated for a block of frames at a time so the multiply
+ * loop stays a simple vector product like the fixed gain version.
+ */
+
+#include <sof/audio/buffer.h>
+#include <sof/audio/component.h>
+#include <sof/audio/format.h>
+#include <sof/common.h>
+#include <ipc/stream.h>
+#include <stddef.h>
+#include <stdint.h>
+
+LOG_MODULE_DECLARE(volume_generic, CONFIG_SOF_LOG_LEVEL);
+
+#include "volume.h"
+
+#ifdef VOLUME_GENERIC
+
+#if CONFIG_COMP_VOLUME_SMOOTH_RAMP
+
+#if CONFIG_FORMAT_S24LE
+/**
+ * \brief Volume ramp from 24/32 bit to 24/32 bit.
+ * \param[in,out] mod Volume processing module handle
+ * \param[in,out] bsource Input buffer.
+ * \param[in,out] bsink Destination buffer.
+ * \param[in] frames Number of frames to process.
+ * \param[in] attenuation factor for peakmeter adjustment
+ */
+static void vol_ramp_s24_to_s24(struct processing_module *mod,
+				struct input_stream_buffer *bsource,
+				struct output_stream_buffer *bsink, uint32_t frames,
+				uint32_t attenuation)
+{
+	struct vol_data *cd = module_get_private_data(mod);
+	struct audio_stream __sparse_cache *source = bsource->data;
+	struct audio_stream __sparse_cache *sink = bsink->data;
+	const int32_t *gain = cd->ramp_gain;
+	int32_t *x;
+	int32_t *y;
+	int nmax, n, i;
+	const int nch = audio_stream_get_channels(source);
+	int remaining_samples = frames * nch;
+
+	x = audio_stream_wrap(source, (char *)audio_stream_get_rptr(source) + bsource->consumed);
+	y = audio_stream_wrap(sink, (char *)audio_stream_get_wptr(sink) + bsink->size);
+
+	bsource->consumed += VOL_S32_SAMPLES_TO_BYTES(remaining_samples);
+	bsink->size += VOL_S32_SAMPLES_TO_BYTES(remaining_samples);
+	while (remaining_samples) {
+		nmax = audio_stream_samples_without_wrap_s24(source, x);
+		n = MIN(remaining_samples, nmax);
+		nmax = audio_stream_samples_without_wrap_s24(sink, y);
+		n = MIN(n, nmax);
+		n = MIN(n, VOL_RAMP_BLOCK_FRAMES * nch);
+		vol_ramp_gain_block(cd, n / nch, nch);
+		for (i = 0; i < n; i++)
+			y[i] = q_multsr_sat_32x32_24(sign_extend_s24(x[i]), gain[i],
+						     Q_SHIFT_BITS_64(23, VOL_QXY_Y, 23));
+
+#if CONFIG_COMP_PEAK_VOL
+		vol_ramp_peak_s32(cd, x, n, nch, attenuation + PEAK_24S_32C_ADJUST);
+#endif
+		remaining_samples -= n;
+		x = audio_stream_wrap(source, x + n);
+		y = audio_stream_wrap(sink, y + n);
+	}
+}
+#endif /* CONFIG_FORMAT_S24LE */
+
+#if CONFIG_FORMAT_S32LE
+/**
+ * \brief Volume ramp from 32 bit to 32 bit.
+ * \param[in,out] mod Volume processing module handle
+ * \param[in,out] bsource Input buffer.
+ * \param[in,out] bsink Destination buffer.
+ * \param[in] frames Number of frames to process.
+ * \param[in] attenuation factor for peakmeter adjustment
+ */
+static void vol_ramp_s32_to_s32(struct processing_module *mod,
+				struct input_stream_buffer *bsource,
+				struct output_stream_buffer *bsink, uint32_t frames,
+				uint32_t attenuation)
+{
+	struct vol_data *cd = module_get_private_data(mod);
+	struct audio_stream __sparse_cache *source = bsource->data;
+	struct audio_stream __sparse_cache *sink = bsink->data;
+	const int32_t *gain = cd->ramp_gain;
+	int32_t *x;
+	int32_t *y;
+	int nmax, n, i;
+	const int nch = audio_stream_get_channels(source);
+	int remaining_samples = frames * nch;
+
+	x = audio_stream_wrap(source, (char *)audio_stream_get_rptr(source) + bsource->consumed);
+	y = audio_stream_wrap(sink, (char *)audio_stream_get_wptr(sink) + bsink->size);
+
+	bsource->consumed += VOL_S32_SAMPLES_TO_BYTES(remaining_samples);
+	bsink->size += VOL_S32_SAMPLES_TO_BYTES(remaining_samples);
+	while (remaining_samples) {
+		nmax = audio_stream_samples_without_wrap_s32(source, x);
+		n = MIN(remaining_samples, nmax);
+		nmax = audio_stream_samples_without_wrap_s32(sink, y);
+		n = MIN(n, nmax);
+		n = MIN(n, VOL_RAMP_BLOCK_FRAMES * nch);
+		vol_ramp_gain_block(cd, n / nch, nch);
+		for (i = 0; i < n; i++)
+			y[i] = q_multsr_sat_32x32(x[i], gain[i],
+						  Q_SHIFT_BITS_64(31, VOL_QXY_Y, 31));
+
+#if CONFIG_COMP_PEAK_VOL
+		vol_ramp_peak_s32(cd, x, n, nch, attenuation);
+#endif
+		remaining_samples -= n;
+		x = audio_stream_wrap(source, x + n);
+		y = audio_stream_wrap(sink, y + n);
+	}
+}
+#endif /* CONFIG_FORMAT_S32LE */
+
+#if CONFIG_FORMAT_S16LE
+/**
+ * \brief Volume ramp from 16 bit to 16 bit.
+ * \param[in,out] mod Volume processing module handle
+ * \param[in,out] bsource Input buffer.
+ * \param[in,out] bsink Destination buffer.
+ * \param[in] frames Number of frames to process.
+ * \param[in] attenuation factor for peakmeter adjustment (unused for 16bit)
+ */
+static void vol_ramp_s16_to_s16(struct processing_module *mod,
+				struct input_stream_buffer *bsource,
+				struct output_stream_buffer *bsink, uint32_t frames,
+				uint32_t attenuation)
+{
+	struct vol_data *cd = module_get_private_data(mod);
+	struct audio_stream __sparse_cache *source = bsource->data;
+	struct audio_stream __sparse_cache *sink = bsink->data;
+	const int32_t *gain = cd->ramp_gain;
+	int16_t *x;
+	int16_t *y;
+	int nmax, n, i;
+	const int nch = audio_stream_get_channels(source);
+	int remaining_samples = frames * nch;
+
+	x = audio_stream_wrap(source, (char *)audio_stream_get_rptr(source) + bsource->consumed);
+	y = audio_stream_wrap(sink, (char *)audio_stream_get_wptr(sink) + bsink->size);
+
+	bsource->consumed += VOL_S16_SAMPLES_TO_BYTES(remaining_samples);
+	bsink->size += VOL_S16_SAMPLES_TO_BYTES(remaining_samples);
+	while (remaining_samples) {
+		nmax = audio_stream_samples_without_wrap_s16(source, x);
+		n = MIN(remaining_samples, nmax);
+		nmax = audio_stream_samples_without_wrap_s16(sink, y);
+		n = MIN(n, nmax);
+		n = MIN(n, VOL_RAMP_BLOCK_FRAMES * nch);
+		vol_ramp_gain_block(cd, n / nch, nch);
+		for (i = 0; i < n; i++)
+			y[i] = q_multsr_sat_32x32_16(x[i], gain[i],
+						     Q_SHIFT_BITS_32(15, VOL_QXY_Y, 15));
+
+#if CONFIG_COMP_PEAK_VOL
+		/* attenuation is for 32 bit containers only, as in vol_s16_to_s16() */
+		vol_ramp_peak_s16(cd, x, n, nch, PEAK_16S_32C_ADJUST);
+#endif
+		remaining_samples -= n;
+		x = audio_stream_wrap(source, x + n);
+		y = audio_stream_wrap(sink, y + n);
+	}
+}
+#endif /* CONFIG_FORMAT_S16LE */
+
+const struct comp_ramp_func_map volume_ramp_func_map[] = {
+#if CONFIG_FORMAT_S16LE
+	{ SOF_IPC_FRAME_S16_LE, vol_ramp_s16_to_s16 },
+#endif
+#if CONFIG_FORMAT_S24LE
+	{ SOF_IPC_FRAME_S24_4LE, vol_ramp_s24_to_s24 },
+#endif
+#if CONFIG_FORMAT_S32LE
+	{ SOF_IPC_FRAME_S32_LE, vol_ramp_s32_to_s32 },
+#endif
+};
+
+const size_t volume_ramp_func_count = ARRAY_SIZE(volume_ramp_func_map);
+
+#endif /* CONFIG_COMP_VOLUME_SMOOTH_RAMP */
+
+#endif /* VOLUME_GENERIC */
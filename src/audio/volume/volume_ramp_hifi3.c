@@ -0,0 +1,302 @@
+// SPDX-License-Identifier: BSD-3-Clause
+//
+// Copyright(c) 2023 Intel Corporation. All rights reserved.
+
+/**
+ * \file
+ * \brief Volume HiFi3/HiFi4 per-sample ramp processing implementation
+ *
+ * The per-sample gains for a block are computed by vol_ramp_gain_block()
+ * interleaved in the same order as the samples, so the gains are loaded
+ * two at a time with the samples and no circular gain buffer is needed.
+ */
+
+#include <sof/audio/buffer.h>
+#include <sof/audio/component.h>
+#include <sof/common.h>
+#include <ipc/stream.h>
+#include <stddef.h>
+#include <stdint.h>
+
+LOG_MODULE_DECLARE(volume_hifi3, CONFIG_SOF_LOG_LEVEL);
+
+#include "volume.h"
+
+#if defined(VOLUME_HIFI3) || defined(VOLUME_HIFI4)
+
+#if CONFIG_COMP_VOLUME_SMOOTH_RAMP
+
+#include <xtensa/tie/xt_hifi3.h>
+
+#if CONFIG_FORMAT_S24LE
+/**
+ * \brief HiFi3 enabled volume ramp from 24/32 bit to 24/32 or 32 bit.
+ * \param[in,out] mod Volume processing module handle
+ * \param[in,out] bsource Input buffer.
+ * \param[in,out] bsink Destination buffer.
+ * \param[in] frames Number of frames to process.
+ * \param[in] attenuation factor for peakmeter adjustment
+ */
+static void vol_ramp_s24_to_s24_s32(struct processing_module *mod,
+				    struct input_stream_buffer *bsource,
+				    struct output_stream_buffer *bsink, uint32_t frames,
+				    uint32_t attenuation)
+{
+	struct vol_data *cd = module_get_private_data(mod);
+	struct audio_stream __sparse_cache *source = bsource->data;
+	struct audio_stream __sparse_cache *sink = bsink->data;
+	ae_f32x2 in_sample = AE_ZERO32();
+	ae_f32x2 out_sample = AE_ZERO32();
+	ae_f32x2 volume = AE_ZERO32();
+	ae_f32x2 *gain;
+	int i, n, m;
+	ae_valign inu = AE_ZALIGN64();
+	ae_valign outu = AE_ZALIGN64();
+	ae_valign gainu;
+	ae_f32x2 *in = (ae_f32x2 *)audio_stream_wrap(source, (char *)audio_stream_get_rptr(source)
+						     + bsource->consumed);
+	ae_f32x2 *out = (ae_f32x2 *)audio_stream_wrap(sink, (char *)audio_stream_get_wptr(sink)
+						      + bsink->size);
+	const int channels_count = audio_stream_get_channels(sink);
+	int samples = channels_count * frames;
+
+	bsource->consumed += VOL_S32_SAMPLES_TO_BYTES(samples);
+	bsink->size += VOL_S32_SAMPLES_TO_BYTES(samples);
+
+	while (samples) {
+		m = audio_stream_samples_without_wrap_s24(source, in);
+		n = MIN(m, samples);
+		m = audio_stream_samples_without_wrap_s24(sink, out);
+		n = MIN(m, n);
+		n = MIN(n, VOL_RAMP_BLOCK_FRAMES * channels_count);
+		vol_ramp_gain_block(cd, n / channels_count, channels_count);
+#if CONFIG_COMP_PEAK_VOL
+		vol_ramp_peak_s32(cd, (int32_t *)in, n, channels_count,
+				  attenuation + PEAK_24S_32C_ADJUST);
+#endif
+		gain = (ae_f32x2 *)cd->ramp_gain;
+		gainu = AE_LA64_PP(gain);
+		inu = AE_LA64_PP(in);
+		/* process two continuous sample data once */
+		for (i = 0; i < n; i += 2) {
+			/* Load the per-sample volume values */
+			AE_LA32X2_IP(volume, gainu, gain);
+
+			/* Load the input sample */
+			AE_LA32X2_IP(in_sample, inu, in);
+
+			/* Multiply the input sample */
+#if COMP_VOLUME_Q8_16
+			out_sample = AE_MULFP32X2RS(AE_SLAI32S(volume, 7), AE_SLAI32(in_sample, 8));
+#elif COMP_VOLUME_Q1_23
+			out_sample = AE_MULFP32X2RS(volume, AE_SLAI32(in_sample, 8));
+#else
+#error "Need CONFIG_COMP_VOLUME_Qx_y"
+#endif
+
+			/* Shift for S24_LE */
+			out_sample = AE_SLAI32S(out_sample, 8);
+			out_sample = AE_SRAI32(out_sample, 8);
+
+			/* Store the output sample */
+			AE_SA32X2_IP(out_sample, outu, out);
+		}
+		AE_SA64POS_FP(outu, out);
+		samples -= n;
+		in = audio_stream_wrap(source, in);
+		out = audio_stream_wrap(sink, out);
+	}
+}
+#endif /* CONFIG_FORMAT_S24LE */
+
+#if CONFIG_FORMAT_S32LE
+/**
+ * \brief HiFi3 enabled volume ramp from 32 bit to 24/32 or 32 bit.
+ * \param[in,out] mod Volume processing module handle
+ * \param[in,out] bsource Input buffer.
+ * \param[in,out] bsink Destination buffer.
+ * \param[in] frames Number of frames to process.
+ * \param[in] attenuation factor for peakmeter adjustment
+ */
+static void vol_ramp_s32_to_s24_s32(struct processing_module *mod,
+				    struct input_stream_buffer *bsource,
+				    struct output_stream_buffer *bsink, uint32_t frames,
+				    uint32_t attenuation)
+{
+	struct vol_data *cd = module_get_private_data(mod);
+	struct audio_stream __sparse_cache *source = bsource->data;
+	struct audio_stream __sparse_cache *sink = bsink->data;
+	ae_f32x2 in_sample = AE_ZERO32();
+	ae_f32x2 out_sample = AE_ZERO32();
+	ae_f32x2 volume = AE_ZERO32();
+	ae_f32x2 *gain;
+	int i, n, m;
+	ae_f64 mult0;
+	ae_f64 mult1;
+	ae_valign inu = AE_ZALIGN64();
+	ae_valign outu = AE_ZALIGN64();
+	ae_valign gainu;
+	ae_f32x2 *in = (ae_f32x2 *)audio_stream_wrap(source, (char *)audio_stream_get_rptr(source)
+						     + bsource->consumed);
+	ae_f32x2 *out = (ae_f32x2 *)audio_stream_wrap(sink, (char *)audio_stream_get_wptr(sink)
+						      + bsink->size);
+	const int channels_count = audio_stream_get_channels(sink);
+	int samples = channels_count * frames;
+
+	bsource->consumed += VOL_S32_SAMPLES_TO_BYTES(samples);
+	bsink->size += VOL_S32_SAMPLES_TO_BYTES(samples);
+
+	while (samples) {
+		m = audio_stream_samples_without_wrap_s32(source, in);
+		n = MIN(m, samples);
+		m = audio_stream_samples_without_wrap_s32(sink, out);
+		n = MIN(m, n);
+		n = MIN(n, VOL_RAMP_BLOCK_FRAMES * channels_count);
+		vol_ramp_gain_block(cd, n / channels_count, channels_count);
+#if CONFIG_COMP_PEAK_VOL
+		vol_ramp_peak_s32(cd, (int32_t *)in, n, channels_count, attenuation);
+#endif
+		gain = (ae_f32x2 *)cd->ramp_gain;
+		gainu = AE_LA64_PP(gain);
+		inu = AE_LA64_PP(in);
+		/* process two continuous sample data once */
+		for (i = 0; i < n; i += 2) {
+			/* Load the per-sample volume values */
+			AE_LA32X2_IP(volume, gainu, gain);
+
+			/* Load the input sample */
+			AE_LA32X2_IP(in_sample, inu, in);
+
+#if COMP_VOLUME_Q8_16
+			/* Q8.16 x Q1.31 << 1 -> Q9.48 */
+			mult0 = AE_MULF32S_HH(volume, in_sample);
+			mult0 = AE_SRAI64(mult0, 1);			/* Q9.47 */
+			mult1 = AE_MULF32S_LL(volume, in_sample);
+			mult1 = AE_SRAI64(mult1, 1);
+			out_sample = AE_ROUND32X2F48SSYM(mult0, mult1);	/* Q9.47 -> Q1.31 */
+#elif COMP_VOLUME_Q1_23
+			/* Q1.23 x Q1.31 << 1 -> Q2.55 */
+			mult0 = AE_MULF32S_HH(volume, in_sample);
+			mult0 = AE_SRAI64(mult0, 8);			/* Q2.47 */
+			mult1 = AE_MULF32S_LL(volume, in_sample);
+			mult1 = AE_SRAI64(mult1, 8);
+			out_sample = AE_ROUND32X2F48SSYM(mult0, mult1);	/* Q2.47 -> Q1.31 */
+#else
+#error "Need CONFIG_COMP_VOLUME_Qx_y"
+#endif
+			AE_SA32X2_IP(out_sample, outu, out);
+		}
+		AE_SA64POS_FP(outu, out);
+		samples -= n;
+		in = audio_stream_wrap(source, in);
+		out = audio_stream_wrap(sink, out);
+	}
+}
+#endif /* CONFIG_FORMAT_S32LE */
+
+#if CONFIG_FORMAT_S16LE
+/**
+ * \brief HiFi3 enabled volume ramp from 16 bit to 16 bit.
+ * \param[in,out] mod Volume processing module handle
+ * \param[in,out] bsource Input buffer.
+ * \param[in,out] bsink Destination buffer.
+ * \param[in] frames Number of frames to process.
+ * \param[in] attenuation factor for peakmeter adjustment (unused for 16bit)
+ */
+static void vol_ramp_s16_to_s16(struct processing_module *mod,
+				struct input_stream_buffer *bsource,
+				struct output_stream_buffer *bsink, uint32_t frames,
+				uint32_t attenuation)
+{
+	struct vol_data *cd = module_get_private_data(mod);
+	struct audio_stream __sparse_cache *source = bsource->data;
+	struct audio_stream __sparse_cache *sink = bsink->data;
+	ae_f32x2 volume0 = AE_ZERO32();
+	ae_f32x2 volume1 = AE_ZERO32();
+	ae_f32x2 out_sample0 = AE_ZERO32();
+	ae_f32x2 out_sample1 = AE_ZERO32();
+	ae_f16x4 in_sample = AE_ZERO16();
+	ae_f16x4 out_sample = AE_ZERO16();
+	ae_f32x2 *gain;
+	int i, n, m;
+	ae_valign inu = AE_ZALIGN64();
+	ae_valign outu = AE_ZALIGN64();
+	ae_valign gainu;
+	ae_f16x4 *in = (ae_f16x4 *)audio_stream_wrap(source, (char *)audio_stream_get_rptr(source)
+						     + bsource->consumed);
+	ae_f16x4 *out = (ae_f16x4 *)audio_stream_wrap(sink, (char *)audio_stream_get_wptr(sink)
+						      + bsink->size);
+	const int channels_count = audio_stream_get_channels(sink);
+	int samples = channels_count * frames;
+
+	bsource->consumed += VOL_S16_SAMPLES_TO_BYTES(samples);
+	bsink->size += VOL_S16_SAMPLES_TO_BYTES(samples);
+
+	while (samples) {
+		m = audio_stream_samples_without_wrap_s16(source, in);
+		n = MIN(m, samples);
+		m = audio_stream_samples_without_wrap_s16(sink, out);
+		n = MIN(m, n);
+		n = MIN(n, VOL_RAMP_BLOCK_FRAMES * channels_count);
+		vol_ramp_gain_block(cd, n / channels_count, channels_count);
+#if CONFIG_COMP_PEAK_VOL
+		/* attenuation is for 32 bit containers only, as in vol_s16_to_s16() */
+		vol_ramp_peak_s16(cd, (int16_t *)in, n, channels_count, PEAK_16S_32C_ADJUST);
+#endif
+		gain = (ae_f32x2 *)cd->ramp_gain;
+		gainu = AE_LA64_PP(gain);
+		inu = AE_LA64_PP(in);
+		for (i = 0; i < n; i += 4) {
+			/* load four per-sample volume gains */
+			AE_LA32X2_IP(volume0, gainu, gain);
+			AE_LA32X2_IP(volume1, gainu, gain);
+
+#if COMP_VOLUME_Q8_16
+			/* Q8.16 to Q9.23 */
+			volume0 = AE_SLAI32S(volume0, 7);
+			volume1 = AE_SLAI32S(volume1, 7);
+#elif COMP_VOLUME_Q1_23
+			/* No need to shift, Q1.23 is OK as such */
+#else
+#error "Need CONFIG_COMP_VOLUME_Qx_y"
+#endif
+			/* Load the input sample */
+			AE_LA16X4_IP(in_sample, inu, in);
+
+			/* Multiply the input sample */
+			out_sample0 = AE_MULFP32X16X2RS_H(volume0, in_sample);
+			out_sample1 = AE_MULFP32X16X2RS_L(volume1, in_sample);
+
+			/* Q9.23 to Q1.31 */
+			out_sample0 = AE_SLAI32S(out_sample0, 8);
+			out_sample1 = AE_SLAI32S(out_sample1, 8);
+
+			/* store the output */
+			out_sample = AE_ROUND16X4F32SSYM(out_sample0, out_sample1);
+			AE_SA16X4_IP(out_sample, outu, out);
+		}
+		AE_SA64POS_FP(outu, out);
+		samples -= n;
+		in = audio_stream_wrap(source, in);
+		out = audio_stream_wrap(sink, out);
+	}
+}
+#endif /* CONFIG_FORMAT_S16LE */
+
+const struct comp_ramp_func_map volume_ramp_func_map[] = {
+#if CONFIG_FORMAT_S16LE
+	{ SOF_IPC_FRAME_S16_LE, vol_ramp_s16_to_s16 },
+#endif
+#if CONFIG_FORMAT_S24LE
+	{ SOF_IPC_FRAME_S24_4LE, vol_ramp_s24_to_s24_s32 },
+#endif
+#if CONFIG_FORMAT_S32LE
+	{ SOF_IPC_FRAME_S32_LE, vol_ramp_s32_to_s24_s32 },
+#endif
+};
+
+const size_t volume_ramp_func_count = ARRAY_SIZE(volume_ramp_func_map);
+
+#endif /* CONFIG_COMP_VOLUME_SMOOTH_RAMP */
+
+#endif /* VOLUME_HIFI3 || VOLUME_HIFI4 */
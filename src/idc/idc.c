@@ -367,10 +367,10 @@ static void idc_prepare_d0ix(void)
 	platform_pm_runtime_prepare_d0ix_en(cpu_get_id());
 }
 
-static void idc_process_async_msg(uint32_t slot)
+static void idc_process_async_msg(void)
 {
 #if CONFIG_AMS
-	process_incoming_message(slot);
+	process_incoming_message();
 #else
 	tr_err(&idc_tr, "idc_cmd(): AMS not enabled");
 #endif
@@ -453,7 +453,7 @@ void idc_cmd(struct idc_msg *msg)
 		idc_secondary_core_crashed(msg->header);
 		break;
 	case iTS(IDC_MSG_AMS):
-		idc_process_async_msg(IDC_HEADER_TO_AMS_SLOT_MASK(msg->header));
+		idc_process_async_msg();
 		break;
 	default:
 		tr_err(&idc_tr, "idc_cmd(): invalid msg->header = %u",
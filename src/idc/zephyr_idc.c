@@ -17,6 +17,11 @@
  * - k_p4wq_submit()
  *	runs on primary CPU
  *	send tasks to other CPUs.
+ *
+ * Several commands for one core can also be sent as a batch with a single
+ * work item: the target core runs them in order and the sender only waits
+ * for the batch completion, so batches to different cores and the work of
+ * the sender itself run in parallel.
  */
 
 #include <zephyr/kernel.h>
@@ -44,6 +49,25 @@ void idc_init_thread(void)
 {
 }
 
+struct idc_batch *idc_batch_init(uint32_t core)
+{
+	return NULL;
+}
+
+int idc_batch_add(struct idc_batch *batch, const struct idc_msg *msg)
+{
+	return -EINVAL;
+}
+
+void idc_batch_submit(struct idc_batch *batch)
+{
+}
+
+int idc_batch_wait(struct idc_batch *batch)
+{
+	return -EINVAL;
+}
+
 #else
 
 K_P4WQ_ARRAY_DEFINE(q_zephyr_idc, CONFIG_CORE_COUNT, SOF_STACK_SIZE,
@@ -145,6 +169,129 @@ int idc_send_msg(struct idc_msg *msg, uint32_t mode)
 	return ret;
 }
 
+struct idc_batch {
+	struct k_p4wq_work work;
+	/* written by the sender and read by the target and vice versa */
+	struct {
+		struct idc_msg msg[IDC_BATCH_MAX];
+		struct idc_payload payload[IDC_BATCH_MAX];
+		uint32_t count;
+		int status;		/**< status of the first failed message */
+	} data __aligned(PLATFORM_DCACHE_ALIGN);
+};
+
+/* Batches are only built and waited for by the IPC thread, one per target */
+static struct idc_batch idc_batch[CONFIG_CORE_COUNT];
+
+static void idc_batch_handler(struct k_p4wq_work *work)
+{
+	struct idc_batch *batch = container_of(work, struct idc_batch, work);
+	struct idc *idc = *idc_get();
+	struct idc_payload *payload = idc_payload_get(idc, cpu_get_id());
+	struct idc_msg *msg;
+	int ret;
+	int i;
+
+	sys_cache_data_invd_range(&batch->data, sizeof(batch->data));
+
+	batch->data.status = 0;
+	for (i = 0; i < batch->data.count; i++) {
+		msg = batch->data.msg + i;
+
+		/* handlers read the payload from the slot of this core */
+		if (msg->size) {
+			const int idc_batch_memcpy_err __unused =
+				memcpy_s(payload->data, sizeof(payload->data),
+					 batch->data.payload[i].data, msg->size);
+			assert(!idc_batch_memcpy_err);
+		}
+
+		idc->received_msg.core = msg->core;
+		idc->received_msg.header = msg->header;
+		idc->received_msg.extension = msg->extension;
+		idc_cmd(&idc->received_msg);
+
+		ret = idc_msg_status_get(cpu_get_id());
+		if (ret) {
+			batch->data.status = ret;
+			break;
+		}
+	}
+
+	sys_cache_data_flush_range(&batch->data, sizeof(batch->data));
+}
+
+struct idc_batch *idc_batch_init(uint32_t core)
+{
+	struct idc_batch *batch = idc_batch + core;
+
+	batch->data.count = 0;
+
+	return batch;
+}
+
+int idc_batch_add(struct idc_batch *batch, const struct idc_msg *msg)
+{
+	uint32_t i = batch->data.count;
+	int ret;
+
+	if (i == IDC_BATCH_MAX) {
+		idc_batch_submit(batch);
+		ret = idc_batch_wait(batch);
+		if (ret)
+			return ret;
+
+		i = 0;
+	}
+
+	if (msg->size > IDC_MAX_PAYLOAD_SIZE)
+		return -EINVAL;
+
+	batch->data.msg[i] = *msg;
+	/* Temporarily store sender core ID */
+	batch->data.msg[i].core = cpu_get_id();
+	batch->data.msg[i].payload = NULL;
+
+	if (msg->size) {
+		const int idc_batch_memcpy_err __unused =
+			memcpy_s(batch->data.payload[i].data, sizeof(batch->data.payload[i].data),
+				 msg->payload, msg->size);
+		assert(!idc_batch_memcpy_err);
+	}
+
+	batch->data.count = i + 1;
+
+	return 0;
+}
+
+void idc_batch_submit(struct idc_batch *batch)
+{
+	struct k_p4wq_work *work = &batch->work;
+
+	/* Same priority as the IPC thread which is an EDF task and under Zephyr */
+	work->priority = EDF_ZEPHYR_PRIORITY;
+	work->deadline = 0;
+	work->handler = idc_batch_handler;
+	work->sync = true;
+
+	sys_cache_data_flush_range(&batch->data, sizeof(batch->data));
+	k_p4wq_submit(q_zephyr_idc + (batch - idc_batch), work);
+}
+
+int idc_batch_wait(struct idc_batch *batch)
+{
+	int ret;
+
+	ret = k_p4wq_wait(&batch->work, K_FOREVER);
+	if (ret < 0)
+		return ret;
+
+	sys_cache_data_invd_range(&batch->data, sizeof(batch->data));
+	batch->data.count = 0;
+
+	return batch->data.status;
+}
+
 void idc_init_thread(void)
 {
 	int cpu = cpu_get_id();
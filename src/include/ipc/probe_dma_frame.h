@@ -30,7 +30,7 @@ struct probe_data_packet {
  * Audio format from extraction probes is encoded as 32 bit value. Following
  * graphic explains encoding.
  *
- * A|BBBB|CCCC|DDDD|EEEEE|FF|GG|H|I|J|XXXXXXX
+ * A|BBBB|CCCC|DDDD|EEEEE|FF|GG|H|I|J|K|LLLLLL
  * A - 1 bit - Specifies Type Encoding - 1 for Standard encoding
  * B - 4 bits - Specify Standard Type - 0 for Audio
  * C - 4 bits - Specify Audio format - 0 for PCM
@@ -57,6 +57,15 @@ struct probe_data_packet {
  * H - 1 bit - Specifies Sample Format - 0 for Integer, 1 for Floating point
  * I - 1 bit - Specifies Sample Endianness - 0 for LE
  * J - 1 bit - Specifies Interleaving - 1 for Sample Interleaving
+ * K - 1 bit - Specifies Compression - 1 for compressed samples, see below
+ * L - 6 bits - Specify Decimation minus 1, one frame of this many was kept,
+ *		so the sample rate is D divided by the decimation
+ *
+ * Compressed data has for each sample, interleaved as the samples, the
+ * difference to the previous sample of the same channel in the packet, or
+ * to 0 for the first one, wrapped to the container size. It is zigzag encoded,
+ * (d << 1) ^ (d >> 31), and written as an unsigned LEB128 varint, 7 bits a
+ * byte from the lowest with the top bit set in all but the last byte.
  */
 #define PROBE_SHIFT_FMT_TYPE		31
 #define PROBE_SHIFT_STANDARD_TYPE	27
@@ -68,6 +77,8 @@ struct probe_data_packet {
 #define PROBE_SHIFT_SAMPLE_FMT		9
 #define PROBE_SHIFT_SAMPLE_END		8
 #define PROBE_SHIFT_INTERLEAVING_ST	7
+#define PROBE_SHIFT_COMPRESSION		6
+#define PROBE_SHIFT_DECIMATION		0
 
 #define PROBE_MASK_FMT_TYPE		MASK(31, 31)
 #define PROBE_MASK_STANDARD_TYPE	MASK(30, 27)
@@ -79,5 +90,7 @@ struct probe_data_packet {
 #define PROBE_MASK_SAMPLE_FMT		MASK(9, 9)
 #define PROBE_MASK_SAMPLE_END		MASK(8, 8)
 #define PROBE_MASK_INTERLEAVING_ST	MASK(7, 7)
+#define PROBE_MASK_COMPRESSION		MASK(6, 6)
+#define PROBE_MASK_DECIMATION		MASK(5, 0)
 
 #endif
@@ -46,6 +46,31 @@
 
 static const uint32_t INVALID_QUEUE_ID = 0xFFFFFFFF;
 
+/**
+ * \brief Fused PCM conversion and attenuation function for data in circular buffer
+ * \param source buffer with samples to process, read pointer is not modified
+ * \param sink output buffer, write pointer is not modified
+ * \param samples number of samples to convert
+ * \param attenuation right shift applied to each converted sample
+ * \return error code or number of processed samples.
+ */
+typedef int (*copier_fused_func)(const struct audio_stream __sparse_cache *source,
+				 struct audio_stream __sparse_cache *sink,
+				 uint32_t samples, uint32_t attenuation);
+
+/** \brief Fused conversion and attenuation functions map. */
+struct copier_fused_map {
+	enum sof_ipc_frame source;	/**< source frame format */
+	enum sof_ipc_frame sink;	/**< sink frame format */
+	copier_fused_func func;		/**< fused conversion function */
+};
+
+/** \brief Map of formats with fused conversion and attenuation functions. */
+extern const struct copier_fused_map copier_fused_map[];
+
+/** \brief Number of fused conversion functions. */
+extern const size_t copier_fused_count;
+
 /* copier Module Configuration & Interface
  * UUID: 9BA00C83-CA12-4A83-943C-1FA2E82F9DDA
  *
@@ -279,6 +304,13 @@ pcm_converter_func get_converter_func(const struct ipc4_audio_format *in_fmt,
 				      enum ipc4_gateway_type type,
 				      enum ipc4_direction_type dir);
 
+/* Returns a kernel that converts and attenuates in a single pass over the
+ * data, or NULL when the format pair has no fused kernel and the separate
+ * conversion plus apply_attenuation() passes have to be used instead.
+ */
+copier_fused_func get_fused_converter_func(const struct ipc4_audio_format *in_fmt,
+					   const struct ipc4_audio_format *out_fmt);
+
 struct comp_ipc_config;
 int create_endpoint_buffer(struct comp_dev *dev,
 			   struct copier_data *cd,
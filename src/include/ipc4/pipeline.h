@@ -394,7 +394,15 @@ struct ipc4_chain_dma {
 		uint32_t enable			: 1;
 		/* controls SCS bit in both Host and Link gateway */
 		uint32_t scs		: 1;
-		uint32_t rsvd2		: 5;
+		/* Link gateway uses the other container size than Host
+		 * gateway, samples are converted between them. Valid only
+		 * with FW built with CONFIG_COMP_CHAIN_DMA_CONVERT, must be
+		 * zero otherwise.
+		 */
+		uint32_t cnv		: 1;
+		/* 32 bit containers hold 24 bit samples, used with cnv */
+		uint32_t cnv_s24	: 1;
+		uint32_t rsvd2		: 3;
 		/* Global::CHAIN_DMA */
 		uint32_t type		: 5;
 		/* Msg::MSG_REQUEST */
@@ -46,6 +46,7 @@
 #define IPC4_PROBE_MODULE_INJECTION_DMA_DETACH	  2
 #define IPC4_PROBE_MODULE_PROBE_POINTS_ADD	  3
 #define IPC4_PROBE_MODULE_DISCONNECT_PROBE_POINTS 4
+#define IPC4_PROBE_MODULE_PROBE_POINTS_OPTIONS	  5
 
 /**
  * Description of probe dma
@@ -80,6 +81,23 @@ struct probe_point {
 				 */
 } __attribute__((packed, aligned(4)));
 
+#define PROBE_OPTION_S16		BIT(0)	/**< reduce wider integer samples to 16 bits */
+#define PROBE_OPTION_COMPRESS		BIT(1)	/**< compress the samples losslessly */
+
+#define PROBE_DECIMATION_MAX		64
+
+/**
+ * Extraction options of a probe point, to probe more points at once than
+ * the extraction DMA could carry in full. Frames are dropped without low
+ * pass filtering when decimating.
+ */
+struct probe_point_options {
+	probe_point_id_t buffer_id;	/**< ID of buffer the extraction probe is attached to */
+	uint32_t channel_mask;		/**< Channels to extract, 0 for all */
+	uint32_t decimation;		/**< Extract one frame of this many, 0 or 1 for all */
+	uint32_t flags;			/**< PROBE_OPTION_xxx */
+} __attribute__((packed, aligned(4)));
+
 struct sof_ipc_probe_info_params {
 	uint32_t num_elems;				/**< Count of elements in array */
 	union {
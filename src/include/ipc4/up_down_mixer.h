@@ -23,7 +23,9 @@ enum up_down_mix_coeff_select {
 	/**< module will use default coeffs */
 	DEFAULT_COEFFICIENTS_WITH_CHANNEL_MAP,
 	/**< custom coeffs are required */
-	CUSTOM_COEFFICIENTS_WITH_CHANNEL_MAP
+	CUSTOM_COEFFICIENTS_WITH_CHANNEL_MAP,
+	/**< custom mixing matrix follows the module config */
+	CUSTOM_MATRIX_WITH_CHANNEL_MAP
 };
 
 #define UP_DOWN_MIX_COEFFS_LENGTH       8
@@ -67,4 +69,14 @@ struct ipc4_up_down_mixer_module_cfg {
 	channel_map channel_map;
 } __packed __aligned(8);
 
+/*
+ * With #CUSTOM_MATRIX_WITH_CHANNEL_MAP the config is followed by the mixing
+ * matrix. It has a row of Q1.31 gains per output channel of channel_map and
+ * each row has a gain per input channel.
+ */
+struct ipc4_up_down_mixer_matrix_cfg {
+	struct ipc4_up_down_mixer_module_cfg cfg;
+	int32_t matrix[];
+} __packed __aligned(8);
+
 #endif /* __SOF_IPC4_UP_DOWN_MIXER_H__ */
@@ -28,6 +28,9 @@ struct comp_dev;
 /* Number of sinks for a 4 way crossover filter */
 #define CROSSOVER_4WAY_NUM_SINKS 4
 
+/* Frames converted to Q1.31 and split as one block */
+#define CROSSOVER_BLOCK_FRAMES 16
+
 /**
  * The Crossover filter will have from 2 to 4 outputs.
  * Diagram of a 4-way Crossover filter (6 LR4 Filters).
@@ -75,8 +78,12 @@ typedef void (*crossover_process)(struct comp_data *cd,
 				  int32_t num_sinks,
 				  uint32_t frames);
 
-typedef void (*crossover_split)(int32_t in, int32_t out[],
-				struct crossover_state *state);
+/* Split of interleaved frames of all channels into bands. The input is
+ * passed in the last band buffer and the filters overwrite the buffers in
+ * place with the band outputs. The split is shared with Multiband DRC.
+ */
+typedef void (*crossover_split_block)(struct crossover_state state[],
+				      int32_t *out[], int frames, int nch);
 
 /* Crossover component private data */
 struct comp_data {
@@ -90,7 +97,9 @@ struct comp_data {
 	struct sof_crossover_config *config;      /**< pointer to setup blob */
 	enum sof_ipc_frame source_format;         /**< source frame format */
 	crossover_process crossover_process;      /**< processing function */
-	crossover_split crossover_split;          /**< split function */
+	crossover_split_block crossover_split_block; /**< block split function */
+	/**< Q1.31 block of each band */
+	int32_t block[SOF_CROSSOVER_MAX_STREAMS][CROSSOVER_BLOCK_FRAMES * PLATFORM_MAX_CHANNELS];
 };
 
 struct crossover_proc_fnmap {
@@ -134,29 +143,19 @@ static inline crossover_process
 	return NULL;
 }
 
-extern const crossover_split crossover_split_fnmap[];
-extern const size_t crossover_split_fncount;
+extern const crossover_split_block crossover_split_block_fnmap[];
 
 /**
- * \brief Returns Crossover split function.
+ * \brief Returns Crossover block split function.
  */
-static inline crossover_split crossover_find_split_func(int32_t num_sinks)
+static inline crossover_split_block crossover_find_split_block_func(int32_t num_sinks)
 {
 	if (num_sinks < CROSSOVER_2WAY_NUM_SINKS ||
 	    num_sinks > CROSSOVER_4WAY_NUM_SINKS)
 		return NULL;
-	// The functions in the map are offset by 2 indices.
-	return crossover_split_fnmap[num_sinks - CROSSOVER_2WAY_NUM_SINKS];
-}
 
-/*
- * \brief Runs input in through the LR4 filter and returns it's output.
- */
-static inline int32_t crossover_generic_process_lr4(int32_t in,
-						    struct iir_state_df2t *lr4)
-{
-	/* Cascade two biquads with same coefficients in series. */
-	return iir_df2t(lr4, in);
+	/* The functions in the map are offset by 2 indices. */
+	return crossover_split_block_fnmap[num_sinks - CROSSOVER_2WAY_NUM_SINKS];
 }
 
 #endif //  __SOF_AUDIO_CROSSOVER_CROSSOVER_H__
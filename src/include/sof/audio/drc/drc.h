@@ -32,6 +32,16 @@ struct comp_dev;
 #define DRC_DIVISION_FRAMES 32
 #define DRC_DIVISION_FRAMES_MASK (DRC_DIVISION_FRAMES - 1)
 
+/* The compression curve is tabulated at setup time over DRC_GAIN_LUT_OCTAVES
+ * octaves below full scale with 2^DRC_GAIN_LUT_STEPS_SHIFT points per octave
+ * and linearly interpolated in between. Levels below the lowest octave
+ * (about -120 dB) use the first point.
+ */
+#define DRC_GAIN_LUT_OCTAVES 20
+#define DRC_GAIN_LUT_STEPS_SHIFT 3
+#define DRC_GAIN_LUT_SIZE ((DRC_GAIN_LUT_OCTAVES << DRC_GAIN_LUT_STEPS_SHIFT) + 1)
+#define DRC_GAIN_LUT_MIN_MSB (31 - DRC_GAIN_LUT_OCTAVES)
+
 /* Stores the state of DRC */
 struct drc_state {
 	/* The detector_average is the target gain obtained by looking at the
@@ -57,6 +67,9 @@ struct drc_state {
 	int32_t processed; /* switch */
 
 	int32_t max_attack_compression_diff_db; /* Q8.24 */
+
+	/* Compression curve drc_volume_gain() sampled by drc_init_gain_lut() */
+	int32_t gain_lut[DRC_GAIN_LUT_SIZE]; /* Q2.30 */
 };
 
 typedef void (*drc_func)(struct processing_module *mod,
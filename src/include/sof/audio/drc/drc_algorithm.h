@@ -9,6 +9,7 @@
 
 #include <stdint.h>
 #include <sof/audio/drc/drc.h>
+#include <sof/math/numbers.h>
 #include <sof/platform.h>
 #include <user/drc.h>
 
@@ -22,6 +23,65 @@ int drc_init_pre_delay_buffers(struct drc_state *state,
 int drc_set_pre_delay_time(struct drc_state *state,
 			   int32_t pre_delay_time,
 			   int32_t rate);
+void drc_init_gain_lut(struct drc_state *state, const struct sof_drc_params *p);
+
+/* Returns the compression curve gain in Q2.30 for the Q1.31 level x, used to
+ * build the gain table.
+ */
+int32_t drc_volume_gain(const struct sof_drc_params *p, int32_t x);
+
+/* Returns the magnitude of the Q1.31 sample x for drc_gain_lut_lookup(),
+ * saturated to INT32_MAX for a full scale negative sample.
+ */
+static inline int32_t drc_abs_sat(int32_t x)
+{
+	return x == INT32_MIN ? INT32_MAX : ABS(x);
+}
+
+/* Returns the compression curve gain in Q2.30 for the Q1.31 level x >= 0,
+ * interpolated from the table built by drc_init_gain_lut().
+ */
+static inline int32_t drc_gain_lut_lookup(const struct drc_state *state, int32_t x)
+{
+	const int32_t *lut;
+	int32_t frac;
+	int msb = 0;
+	int shift;
+	int v = x;
+
+	if (x < (1 << DRC_GAIN_LUT_MIN_MSB))
+		return state->gain_lut[0];
+
+	/* Position of the most significant bit, x is at least 2^11 here */
+	if (v >= 1 << 16) {
+		v >>= 16;
+		msb += 16;
+	}
+	if (v >= 1 << 8) {
+		v >>= 8;
+		msb += 8;
+	}
+	if (v >= 1 << 4) {
+		v >>= 4;
+		msb += 4;
+	}
+	if (v >= 1 << 2) {
+		v >>= 2;
+		msb += 2;
+	}
+	if (v >= 1 << 1)
+		msb += 1;
+
+	/* The octave and the next DRC_GAIN_LUT_STEPS_SHIFT bits select the
+	 * table segment, the remaining bits are the interpolation fraction.
+	 */
+	shift = msb - DRC_GAIN_LUT_STEPS_SHIFT;
+	lut = &state->gain_lut[((msb - DRC_GAIN_LUT_MIN_MSB) << DRC_GAIN_LUT_STEPS_SHIFT) +
+			       ((x >> shift) & ((1 << DRC_GAIN_LUT_STEPS_SHIFT) - 1))];
+	frac = x & ((1 << shift) - 1);
+
+	return lut[0] + (int32_t)(((int64_t)(lut[1] - lut[0]) * frac) >> shift);
+}
 
 /* drc process functions */
 void drc_update_detector_average(struct drc_state *state,
@@ -18,6 +18,9 @@
 #define EQ_IIR_BYTES_TO_S16_SAMPLES(b)	((b) >> 1)
 #define EQ_IIR_BYTES_TO_S32_SAMPLES(b)	((b) >> 2)
 
+/** \brief Frames converted to Q1.31 and filtered as one block */
+#define EQ_IIR_BLOCK_FRAMES		16
+
 struct audio_stream;
 struct comp_dev;
 
@@ -86,9 +86,14 @@ struct host_data {
 				   *  copied by dma connected to host
 				   */
 	uint32_t period_bytes;	/**< number of bytes per one period */
+#if CONFIG_HOST_DMA_BATCH
+	uint32_t batch_bytes;	/**< local buffer watermark for a copy, 0 if disabled */
+#endif
 
 	host_copy_func copy;	/**< host copy function */
 	pcm_converter_func process;	/**< processing function */
+	copier_fused_func fused_process; /**< conversion + attenuation, replaces process */
+	uint32_t attenuation;	/**< attenuation passed to fused_process */
 
 	/* IPC host init info */
 	struct ipc_config_host ipc_host;
@@ -117,6 +122,31 @@ static inline int host_common_copy(struct host_data *hd, struct comp_dev *dev, c
 {
 	return hd->copy(hd, dev, cb);
 }
+/* Same as dma_buffer_copy_from() but with the fused conversion and attenuation
+ * kernel, so the playback data is touched only once per copy.
+ */
+static inline int host_dma_buffer_copy_fused(struct host_data *hd,
+					     struct comp_buffer __sparse_cache *source,
+					     struct comp_buffer __sparse_cache *sink,
+					     uint32_t source_bytes)
+{
+	struct audio_stream __sparse_cache *istream = &source->stream;
+	uint32_t samples = source_bytes / audio_stream_sample_bytes(istream);
+	uint32_t sink_bytes = audio_stream_sample_bytes(&sink->stream) * samples;
+	int ret;
+
+	/* source buffer contains data copied by DMA */
+	audio_stream_invalidate(istream, source_bytes);
+
+	ret = hd->fused_process(istream, &sink->stream, samples, hd->attenuation);
+
+	buffer_stream_writeback(sink, sink_bytes);
+
+	audio_stream_consume(istream, source_bytes);
+	comp_update_buffer_produce(sink, sink_bytes);
+
+	return ret;
+}
 void host_common_update(struct host_data *hd, struct comp_dev *dev, uint32_t bytes);
 void host_common_one_shot(struct host_data *hd, uint32_t bytes);
 int copier_host_create(struct comp_dev *dev, struct copier_data *cd,
@@ -126,5 +156,6 @@ void copier_host_free(struct copier_data *cd);
 int copier_host_params(struct copier_data *cd, struct comp_dev *dev,
 		       struct sof_ipc_stream_params *params);
 void copier_host_dma_cb(struct comp_dev *dev, size_t bytes);
+void copier_host_update_attenuation(struct copier_data *cd, struct comp_dev *dev);
 
 #endif /* __SOF_HOST_COPIER_H__ */
@@ -24,6 +24,16 @@ struct comp_buffer;
 
 /* KPB internal defines */
 
+#if CONFIG_KPB_HISTORY_COMPRESSION
+/** 24 and 32 bit history is stored as block floating point with 16 bit
+ * mantissas, the memory of the raw history holds twice the time.
+ */
+#define KPB_HISTORY_TIME_SCALE 2
+#define KPB_BFP_BLOCK_SAMPLES 16 /**< samples per shared exponent */
+#else
+#define KPB_HISTORY_TIME_SCALE 1
+#endif
+
 #if CONFIG_TIGERLAKE
 #define KPB_MAX_BUFF_TIME 3000 /**< time of buffering in miliseconds */
 #define HOST_WAKEUP_TIME 1000 /* aprox. time of host DMA wakup from suspend [ms] */
@@ -33,18 +43,19 @@ struct comp_buffer;
 #define HOST_WAKEUP_TIME 0 /* aprox. time of host DMA wakup from suspend [ms] */
 #endif
 
-#define KPB_MAX_DRAINING_REQ (KPB_MAX_BUFF_TIME - HOST_WAKEUP_TIME)
+/** Time of history kept for sw bit samples, longer if they are compressed */
+#define KPB_MAX_HISTORY_TIME(sw) ((sw) == 16 ? KPB_MAX_BUFF_TIME : \
+	KPB_MAX_BUFF_TIME * KPB_HISTORY_TIME_SCALE)
+#define KPB_MAX_DRAINING_REQ(sw) (KPB_MAX_HISTORY_TIME(sw) - HOST_WAKEUP_TIME)
 #define KPB_MAX_SUPPORTED_CHANNELS 6 /**< number of supported channels */
 /**< number of samples taken each milisecond */
 #define	KPB_SAMPLES_PER_MS (KPB_SAMPLNG_FREQUENCY / 1000)
 #define	KPB_SAMPLNG_FREQUENCY 16000 /**< supported sampling frequency in Hz */
 #define KPB_SAMPLE_CONTAINER_SIZE(sw) ((sw == 16) ? 16 : 32)
 #define KPB_MAX_BUFFER_SIZE(sw, channels_number) ((KPB_SAMPLNG_FREQUENCY / 1000) * \
-	(KPB_SAMPLE_CONTAINER_SIZE(sw) / 8) * KPB_MAX_BUFF_TIME * \
+	(KPB_SAMPLE_CONTAINER_SIZE(sw) / 8) * KPB_MAX_HISTORY_TIME(sw) * \
 	 (channels_number))
 #define KPB_MAX_NO_OF_CLIENTS 2
-#define KPB_NO_OF_HISTORY_BUFFERS 2 /**< no of internal buffers */
-#define KPB_ALLOCATION_STEP 0x100
 #define KPB_NO_OF_MEM_POOLS 3
 #define KPB_BYTES_TO_FRAMES(bytes, sample_width, channels_number) \
 	((bytes) / ((KPB_SAMPLE_CONTAINER_SIZE(sample_width) / 8) * \
@@ -116,25 +127,22 @@ struct kpb_client {
 	struct comp_buffer *sink; /**< client's sink */
 };
 
-enum buffer_state {
-	KPB_BUFFER_FREE = 0,
-	KPB_BUFFER_FULL,
-	KPB_BUFFER_OFF,
-};
-
 enum kpb_id {
 	KPB_LP = 0,
 	KPB_HP,
 };
 
+/* History ring, samples are stored in their 16 or 32 bit containers or
+ * as 16 bit block floating point mantissas if exponents are present.
+ */
 struct history_buffer {
-	enum buffer_state state; /**< state of the buffer */
 	void *start_addr; /**< buffer start address */
 	void *end_addr; /**< buffer end address */
 	void *w_ptr; /**< buffer write pointer */
 	void *r_ptr; /**< buffer read pointer */
-	struct history_buffer *next; /**< next history buffer */
-	struct history_buffer *prev; /**< next history buffer */
+#if CONFIG_KPB_HISTORY_COMPRESSION
+	uint8_t *exponents; /**< block exponents, NULL for raw samples */
+#endif
 };
 
 /* Draining task data */
@@ -156,7 +164,7 @@ struct history_data {
 	size_t buffer_size; /**< size of internal history buffer */
 	size_t buffered; /**< amount of buffered data */
 	size_t free; /** spce we can use to write new data */
-	struct history_buffer *c_hb; /**< current buffer used for writing */
+	struct history_buffer hb; /**< contiguous history ring */
 };
 
 enum ipc4_kpb_module_config_params {
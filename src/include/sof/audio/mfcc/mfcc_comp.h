@@ -12,6 +12,9 @@
 #include <sof/math/auditory.h>
 #include <sof/math/dct.h>
 #include <sof/math/fft.h>
+#include <sof/math/stft.h>
+#include <rtos/atomic.h>
+#include <stdbool.h>
 #include <stddef.h>
 #include <stdint.h>
 
@@ -30,25 +33,27 @@
 #endif
 
 #define MFCC_MAGIC 0x6d666363 /* ASCII for "mfcc" */
+#define MFCC_MAGIC_SAMPLES 2 /* Magic as int16_t samples in sink */
 
-/* Set to 16 for lower RAM and MCPS with slightly lower quality. Set to 32 for best
- * quality but higher MCPS and RAM. The MFCC input is currently 16 bits. With this option
- * set to 32 the FFT and Mel filterbank are computed with better 32 bit precision. There
- * is also need to enable 32 bit FFT from Kconfig if set.
+/* The FFT and Mel filterbank are computed by default with 16 bits for lower RAM
+ * and MCPS with slightly lower quality. The 32 bit version is selected from Kconfig
+ * for best quality but higher MCPS and RAM.
  */
+#if CONFIG_COMP_MFCC_32BIT_FFT
+#define MFCC_FFT_BITS	32
+#else
 #define MFCC_FFT_BITS	16
+#endif
 
 /* MFCC with 16 bit FFT benefits from data normalize, for 32 bits there's no
  * significant impact. The amount of left shifts for FFT input is limited to
- * 10 that equals about 60 dB boost. The boost is compensated in Mel energy
- * calculation.
+ * STFT_NORMALIZE_MAX_SHIFT. The boost is compensated in Mel energy calculation.
  */
 #if MFCC_FFT_BITS == 16
 #define MFCC_NORMALIZE_FFT
 #else
 #undef MFCC_NORMALIZE_FFT
 #endif
-#define MFCC_NORMALIZE_MAX_SHIFT	10
 
 struct audio_stream;
 struct comp_dev;
@@ -65,42 +70,66 @@ struct mfcc_func_map {
 	mfcc_func func;		/**< processing function */
 };
 
-struct mfcc_buffer {
-	int16_t *addr;
-	int16_t *end_addr;
-	int16_t *r_ptr;
-	int16_t *w_ptr;
-	int s_avail; /**< samples count */
-	int s_free; /**< samples count */
-	int s_length; /**< length in samples for wrap */
-};
-
 struct mfcc_pre_emph {
 	int16_t coef;
 	int16_t delay;
+	int32_t delay32; /**< Q1.31, for 24 and 32 bit input */
 	int enable;
 };
 
-struct mfcc_fft {
-#if MFCC_FFT_BITS == 16
-	struct icomplex16 *fft_buf; /**< fft_padded_size */
-	struct icomplex16 *fft_out; /**< fft_padded_size */
-#elif MFCC_FFT_BITS == 32
-	struct icomplex32 *fft_buf; /**< fft_padded_size */
-	struct icomplex32 *fft_out; /**< fft_padded_size */
-#else
-#error "MFCC_FFT_BITS needs to be 16 or 32"
-#endif
-	struct fft_plan *fft_plan;
-	int fft_fill_start_idx; /**< Set to 0 for pad left, etc. */
-	int fft_size;
-	int fft_padded_size;
-	int fft_hop_size;
-	int fft_buf_size;
-	int half_fft_size;
-	size_t fft_buffer_size; /**< bytes */
+/**
+ * \brief Single producer, single consumer ring of cepstral coefficients
+ * sets. A slot holds num_ceps Q8.7 values of one analysis frame. Only the
+ * MFCC processing writes w_idx and only the consumer writes r_idx, the
+ * indices run from 0 to 2 x slots - 1 to tell a full ring from an empty
+ * one. If the consumer falls behind the new frames are dropped.
+ */
+struct mfcc_feature_ring {
+	int16_t *data; /**< slots x num_ceps */
+	int num_ceps;
+	int slots;
+	atomic_t w_idx; /**< producer index */
+	atomic_t r_idx; /**< consumer index */
+	uint32_t overruns; /**< count of dropped frames, producer only */
+	bool sink_consumer; /**< the audio sink, not mfcc_feature_read(), consumes */
 };
 
+static inline int mfcc_feature_ring_next(const struct mfcc_feature_ring *ring, int idx)
+{
+	return idx + 1 == 2 * ring->slots ? 0 : idx + 1;
+}
+
+static inline int16_t *mfcc_feature_ring_slot(const struct mfcc_feature_ring *ring, int idx)
+{
+	if (idx >= ring->slots)
+		idx -= ring->slots;
+
+	return ring->data + idx * ring->num_ceps;
+}
+
+/* Returns the number of frames the consumer can read */
+static inline int mfcc_feature_ring_avail(struct mfcc_feature_ring *ring)
+{
+	int n = atomic_read(&ring->w_idx) - atomic_read(&ring->r_idx);
+
+	return n < 0 ? n + 2 * ring->slots : n;
+}
+
+/* Consumer side, returns the oldest frame or NULL if the ring is empty */
+static inline int16_t *mfcc_feature_ring_peek(struct mfcc_feature_ring *ring)
+{
+	if (!mfcc_feature_ring_avail(ring))
+		return NULL;
+
+	return mfcc_feature_ring_slot(ring, atomic_read(&ring->r_idx));
+}
+
+/* Consumer side, frees the frame returned by mfcc_feature_ring_peek() */
+static inline void mfcc_feature_ring_release(struct mfcc_feature_ring *ring)
+{
+	atomic_set(&ring->r_idx, mfcc_feature_ring_next(ring, atomic_read(&ring->r_idx)));
+}
+
 struct mfcc_cepstral_lifter {
 	struct mat_matrix_16b *matrix;
 	int16_t cepstral_lifter;
@@ -108,29 +137,22 @@ struct mfcc_cepstral_lifter {
 };
 
 struct mfcc_state {
-	struct mfcc_buffer buf; /**< Circular buffer for input data */
+	struct stft_plan stft; /**< Framing, window and FFT */
 	struct mfcc_pre_emph emph; /**< Pre-emphasis filter */
-	struct mfcc_fft fft; /**< FFT related */
 	struct dct_plan_16 dct; /**< DCT related */
 	struct psy_mel_filterbank melfb; /**< Mel filter bank */
 	struct mfcc_cepstral_lifter lifter; /**< Cepstral lifter coefficients */
-	struct mat_matrix_16b *mel_spectra; /**< Pointer to scratch */
-	struct mat_matrix_16b *cepstral_coef; /**< Pointer to scratch */
+	struct mfcc_feature_ring features; /**< Output cepstral coefficients */
+	struct mat_matrix_16b *dct_lifter; /**< DCT matrix multiplied by lifter */
+	int16_t *mel_batch; /**< max_batch x num_mel_bins, Q8.7 */
 	int32_t *power_spectra; /**< Pointer to scratch */
-	int16_t buf_avail;
-	int16_t *buffers;
-	int16_t *prev_data; /**< prev_data_size */
-	int16_t *window; /**< fft_size */
+	int max_batch; /**< Max frames per process call */
+	int16_t *window; /**< frame_length */
 	int16_t *triangles;
 	int source_channel;
-	int buffer_size;
-	int prev_data_size;
 	int low_freq;
 	int high_freq;
 	int sample_rate;
-	int waiting_fill:1; /**< booleans */
-	int prev_samples_valid:1;
-	size_t sample_buffers_size; /**< bytes */
 };
 
 /* MFCC component private data */
@@ -142,19 +164,6 @@ struct mfcc_comp_data {
 	mfcc_func mfcc_func;		/**< processing function */
 };
 
-static inline int mfcc_buffer_samples_without_wrap(struct mfcc_buffer *buffer, int16_t *ptr)
-{
-	return buffer->end_addr - ptr;
-}
-
-static inline int16_t *mfcc_buffer_wrap(struct mfcc_buffer *buffer, int16_t *ptr)
-{
-	if (ptr >= buffer->end_addr)
-		ptr -= buffer->s_length;
-
-	return ptr;
-}
-
 int mfcc_setup(struct processing_module *mod, int max_frames, int rate, int channels);
 
 void mfcc_free_buffers(struct mfcc_comp_data *cd);
@@ -162,19 +171,31 @@ void mfcc_free_buffers(struct mfcc_comp_data *cd);
 void mfcc_s16_default(struct processing_module *mod, struct input_stream_buffer *bsource,
 		      struct output_stream_buffer *bsink, int frames);
 
-void mfcc_source_copy_s16(struct input_stream_buffer *bsource, struct mfcc_buffer *buf,
-			  struct mfcc_pre_emph *emph, int frames, int source_channel);
+void mfcc_s24_default(struct processing_module *mod, struct input_stream_buffer *bsource,
+		      struct output_stream_buffer *bsink, int frames);
 
-void mfcc_fill_prev_samples(struct mfcc_buffer *buf, int16_t *prev_data,
-			    int prev_data_length);
+void mfcc_s32_default(struct processing_module *mod, struct input_stream_buffer *bsource,
+		      struct output_stream_buffer *bsink, int frames);
 
-void mfcc_fill_fft_buffer(struct mfcc_state *state);
+/**
+ * \brief Copy features from the ring for a consumer that does not use the
+ * audio sink, e.g. an inference module. It is the single consumer of the
+ * ring and may run in another thread than the MFCC processing.
+ * \param[in,out] state       MFCC state
+ * \param[out]    dst         Output, frames x num_ceps Q8.7 values
+ * \param[in]     max_frames  Max number of feature frames to copy
+ * \return Number of feature frames copied, -EBUSY if the audio sink is
+ *	   the consumer of the ring.
+ */
+int mfcc_feature_read(struct mfcc_state *state, int16_t *dst, int max_frames);
 
-#ifdef MFCC_NORMALIZE_FFT
-int mfcc_normalize_fft_buffer(struct mfcc_state *state);
-#endif
+void mfcc_source_copy_s16(struct input_stream_buffer *bsource, struct stft_buffer *buf,
+			  struct mfcc_pre_emph *emph, int frames, int source_channel);
 
-void mfcc_apply_window(struct mfcc_state *state, int input_shift);
+/* The shift is 8 for S24_4LE and 0 for S32_LE */
+void mfcc_source_copy_s32(struct input_stream_buffer *bsource, struct stft_buffer *buf,
+			  struct mfcc_pre_emph *emph, int frames, int source_channel,
+			  int shift);
 
 #if CONFIG_FORMAT_S16LE
 
@@ -184,8 +205,18 @@ int16_t *mfcc_sink_copy_zero_s16(const struct audio_stream *sink,
 int16_t *mfcc_sink_copy_data_s16(const struct audio_stream *sink, int16_t *w_ptr,
 				 int samples, int16_t *r_ptr);
 
-void mfcc_s16_default(struct processing_module *mod, struct input_stream_buffer *bsource,
-		      struct output_stream_buffer *bsink, int frames);
+#endif
+
+#if CONFIG_FORMAT_S24LE || CONFIG_FORMAT_S32LE
+
+/* The 16 bit data is written left aligned with shift of 16 for S32_LE and 8 for
+ * S24_4LE, so that the upper 16 bits of sink samples are the same as with S16_LE.
+ */
+int32_t *mfcc_sink_copy_zero_s32(const struct audio_stream *sink,
+				 int32_t *w_ptr, int samples);
+
+int32_t *mfcc_sink_copy_data_s32(const struct audio_stream *sink, int32_t *w_ptr,
+				 int samples, int16_t *r_ptr, int shift);
 #endif
 
 #ifdef UNIT_TEST
@@ -17,6 +17,9 @@
 #include <user/multiband_drc.h>
 #include <stdint.h>
 
+/* Frames run through the filters and the band split as one block */
+#define MULTIBAND_DRC_BLOCK_FRAMES 16
+
 /**
  * Stores the state of the sub-components in Multiband DRC
  */
@@ -41,7 +44,12 @@ struct multiband_drc_comp_data {
 	enum sof_ipc_frame source_format;        /**< source frame format */
 	bool process_enabled;                    /**< true if component is enabled */
 	multiband_drc_func multiband_drc_func;   /**< processing function */
-	crossover_split crossover_split;         /**< crossover n-way split func */
+	crossover_split_block crossover_split_block; /**< crossover n-way block split func */
+	/**< Q1.31 block of crossover input and band outputs */
+	int32_t band_block[SOF_MULTIBAND_DRC_MAX_BANDS][MULTIBAND_DRC_BLOCK_FRAMES *
+							PLATFORM_MAX_CHANNELS];
+	/**< Q1.31 block of band mix and deemphasis filter */
+	int32_t block[MULTIBAND_DRC_BLOCK_FRAMES * PLATFORM_MAX_CHANNELS];
 };
 
 struct multiband_drc_proc_fnmap {
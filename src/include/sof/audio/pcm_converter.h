@@ -71,6 +71,49 @@ extern const struct pcm_func_map pcm_func_map[];
 /** \brief Number of conversion functions. */
 extern const size_t pcm_func_count;
 
+/** \brief PCM conversion functions mapfor different size of valid bit and container. */
+struct pcm_func_vc_map {
+	enum sof_ipc_frame source;	/**< source frame container format */
+	enum sof_ipc_frame valid_src_bits;	/**< source frame format */
+	enum sof_ipc_frame sink;	/**< sink frame container format */
+	enum sof_ipc_frame valid_sink_bits;	/**< sink frame format */
+
+	pcm_converter_func func; /**< PCM conversion function */
+};
+
+#if CONFIG_PCM_CONVERTER_GENERATED
+/** \brief Map of generated conversion functions for all format pairs. */
+extern const struct pcm_func_vc_map pcm_func_gen_map[];
+
+/** \brief Number of generated conversion functions. */
+extern const size_t pcm_func_gen_count;
+
+/**
+ * \brief Retrieves generated PCM conversion function, used as fallback when
+ *	  no dedicated function is available.
+ * \param in_bits is source container format.
+ * \param valid_in_bits is source valid sample format.
+ * \param out_bits is sink container format.
+ * \param valid_out_bits is sink valid sample format.
+ */
+pcm_converter_func pcm_get_generated_function(enum sof_ipc_frame in_bits,
+					      enum sof_ipc_frame valid_in_bits,
+					      enum sof_ipc_frame out_bits,
+					      enum sof_ipc_frame valid_out_bits);
+
+/* container format of a frame format with valid bits equal to the sample */
+static inline enum sof_ipc_frame pcm_frame_container(enum sof_ipc_frame fmt)
+{
+	switch (fmt) {
+	case SOF_IPC_FRAME_S24_4LE:
+	case SOF_IPC_FRAME_S24_4LE_MSB:
+		return SOF_IPC_FRAME_S32_LE;
+	default:
+		return fmt;
+	}
+}
+#endif
+
 /**
  * \brief Retrieves PCM conversion function.
  * \param[in] in Source frame format.
@@ -91,19 +134,14 @@ pcm_get_conversion_function(enum sof_ipc_frame in,
 		return pcm_func_map[i].func;
 	}
 
+#if CONFIG_PCM_CONVERTER_GENERATED
+	return pcm_get_generated_function(pcm_frame_container(in), in,
+					  pcm_frame_container(out), out);
+#else
 	return NULL;
+#endif
 }
 
-/** \brief PCM conversion functions mapfor different size of valid bit and container. */
-struct pcm_func_vc_map {
-	enum sof_ipc_frame source;	/**< source frame container format */
-	enum sof_ipc_frame valid_src_bits;	/**< source frame format */
-	enum sof_ipc_frame sink;	/**< sink frame container format */
-	enum sof_ipc_frame valid_sink_bits;	/**< sink frame format */
-
-	pcm_converter_func func; /**< PCM conversion function */
-};
-
 /** \brief Map of formats with dedicated conversion functions. */
 extern const struct pcm_func_vc_map pcm_func_vc_map[];
 
@@ -142,7 +180,11 @@ pcm_get_conversion_vc_function(enum sof_ipc_frame in_bits,
 		return pcm_func_vc_map[i].func;
 	}
 
+#if CONFIG_PCM_CONVERTER_GENERATED
+	return pcm_get_generated_function(in_bits, valid_in_bits, out_bits, valid_out_bits);
+#else
 	return NULL;
+#endif
 }
 
 /**
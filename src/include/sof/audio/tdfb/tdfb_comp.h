@@ -13,6 +13,7 @@
 #include <sof/math/fir_generic.h>
 #include <sof/math/fir_hifi2ep.h>
 #include <sof/math/fir_hifi3.h>
+#include <sof/math/fft.h>
 #include <sof/math/iir_df1.h>
 #include <sof/platform.h>
 #include <user/tdfb.h>
@@ -67,22 +68,56 @@ struct tdfb_direction_data {
 	int32_t unit_delay; /* Q1.31 seconds */
 	int32_t frame_count_since_control;
 	int32_t *df1_delay;
-	int32_t *r;
+	int32_t *r;		/* Smoothed xcorr, (mics - 1) x (2 * max_lag + 1) */
+	int32_t *tdoa;		/* Time differences table, num_angles x (mics - 1) */
+	int16_t *x_ref;		/* Linear copy of reference mic, max_frames */
+	int16_t *x_mic;		/* Linear copy of other mic, max_frames + 2 * max_lag */
 	int16_t *d;
 	int16_t *d_end;
 	int16_t *wp;
 	int16_t *rp;
-	int16_t step_sign;
 	int16_t az_slow;
 	int16_t az;
 	int16_t max_lag;
+	int16_t num_mics;	/* Mics used for direction, max. PLATFORM_MAX_CHANNELS */
+	int16_t angle_first;	/* First table index to search */
+	int16_t angle_last;	/* Last table index to search */
 	size_t d_size;
 	size_t r_size;
 	bool line_array; /* Limit scan to -90 to 90 degrees */
 };
 
+/* Frequency domain overlap-save filter bank. The microphone spectra are
+ * computed once per hop and shared by all beams. The per-bin weights are the
+ * transforms of the configured FIR filters.
+ */
+struct tdfb_fd_data {
+	struct fft_plan *fft_plan;
+	struct fft_plan *ifft_plan;
+	struct icomplex32 *fft_buf;	/* fft_size */
+	struct icomplex32 *fft_out;	/* fft_size */
+	struct icomplex32 *weights;	/* num_filters x num_bins, Q1.31 */
+	struct icomplex32 *spectra;	/* num_in x num_bins, Q1.31 */
+	struct icomplex32 *mix;		/* 2 x num_bins, output channels pair */
+	int32_t *in_buf;		/* num_in x fft_size, Q1.31 */
+	int32_t *out_buf;		/* num_out x hop, Q5.27 */
+	int32_t *data;			/* pointer to allocated RAM */
+	size_t data_size;		/* allocated size */
+	int fft_size;
+	int fft_len;			/* log2 of fft_size */
+	int num_bins;			/* fft_size / 2 + 1 */
+	int hop;			/* fft_size / 2 */
+	int pos;			/* input write index, hop to fft_size - 1 */
+	int num_in;
+	int num_out;
+	int out_shift;			/* left shifts from IFFT output to Q5.27 */
+};
+
 struct tdfb_comp_data {
 	struct fir_state_32x16 fir[SOF_TDFB_FIR_MAX_COUNT]; /**< FIR state */
+#if CONFIG_COMP_TDFB_FREQ_DOMAIN
+	struct tdfb_fd_data fd;		    /**< frequency domain filter bank */
+#endif
 	struct comp_data_blob_handler *model_handler;
 	struct sof_tdfb_config *config;	    /**< pointer to setup blob */
 	struct sof_tdfb_angle *filter_angles;
@@ -93,6 +128,7 @@ struct tdfb_comp_data {
 	int32_t in[TDFB_IN_BUF_LENGTH];	    /**< input samples buffer */
 	int32_t out[TDFB_IN_BUF_LENGTH];    /**< output samples mix buffer */
 	int32_t *fir_delay;		    /**< pointer to allocated RAM */
+	int16_t *fir_coef;		    /**< selected filters in setup blob */
 	int16_t *input_channel_select;	    /**< For each FIR define in ch */
 	int16_t *output_channel_mix;	    /**< For each FIR define out ch */
 	int16_t *output_stream_mix;         /**< for each FIR define stream */
@@ -104,6 +140,7 @@ struct tdfb_comp_data {
 	bool direction_change:1;	    /**< set if direction value has significant change */
 	bool beam_on:1;			    /**< set true if beam is off */
 	bool update:1;			    /**< set true if control enum has been received */
+	bool fd_active:1;		    /**< set if frequency domain filtering is used */
 	void (*tdfb_func)(struct tdfb_comp_data *cd,
 			  struct input_stream_buffer *bsource,
 			  struct output_stream_buffer *bsink,
@@ -128,6 +165,30 @@ void tdfb_fir_s32(struct tdfb_comp_data *cd,
 		  struct output_stream_buffer *bsink, int frames);
 #endif
 
+#if CONFIG_COMP_TDFB_FREQ_DOMAIN
+int tdfb_fd_setup(struct tdfb_comp_data *cd, int source_nch, int sink_nch);
+void tdfb_fd_free(struct tdfb_comp_data *cd);
+void tdfb_fd_reset(struct tdfb_comp_data *cd);
+
+#if CONFIG_FORMAT_S16LE
+void tdfb_fd_s16(struct tdfb_comp_data *cd,
+		 struct input_stream_buffer *bsource,
+		 struct output_stream_buffer *bsink, int frames);
+#endif
+
+#if CONFIG_FORMAT_S24LE
+void tdfb_fd_s24(struct tdfb_comp_data *cd,
+		 struct input_stream_buffer *bsource,
+		 struct output_stream_buffer *bsink, int frames);
+#endif
+
+#if CONFIG_FORMAT_S32LE
+void tdfb_fd_s32(struct tdfb_comp_data *cd,
+		 struct input_stream_buffer *bsource,
+		 struct output_stream_buffer *bsink, int frames);
+#endif
+#endif /* CONFIG_COMP_TDFB_FREQ_DOMAIN */
+
 int tdfb_direction_init(struct tdfb_comp_data *cd, int32_t fs, int channels);
 void tdfb_direction_copy_emphasis(struct tdfb_comp_data *cd, int channels, int *channel, int32_t x);
 void tdfb_direction_estimate(struct tdfb_comp_data *cd, int frames, int channels);
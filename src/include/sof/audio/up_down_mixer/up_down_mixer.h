@@ -21,6 +21,20 @@
 #include <stddef.h>
 #include <stdint.h>
 
+#define UP_DOWN_MIXER_GENERIC
+
+#if defined(__XCC__)
+#include <xtensa/config/core-isa.h>
+
+#if XCHAL_HAVE_HIFI3
+#undef UP_DOWN_MIXER_GENERIC
+#endif
+
+#endif
+
+/** Max number of channels, an IPC4 channel map holds 8 positions. */
+#define UP_DOWN_MIXER_MAX_CHANNELS	8
+
 /** This type is introduced for better readability. */
 typedef const int32_t *downmix_coefficients;
 
@@ -110,6 +124,14 @@ static inline enum ipc4_channel_index get_channel_index(const channel_map map,
 	return (enum ipc4_channel_index)((map >> (location * 4)) & 0xF);
 }
 
+/**
+ * \brief Non-zero coefficient of the mixing matrix.
+ */
+struct up_down_mixer_tap {
+	int32_t coef;	/**< Q1.31 gain */
+	uint8_t in;	/**< Input channel slot */
+};
+
 /**
  * \brief up_down_mixer component private data.
  */
@@ -141,6 +163,16 @@ struct up_down_mixer_data {
 	const int32_t k_half_scaled_lo_ro_downmix16bit[UP_DOWN_MIX_COEFFS_LENGTH];
 	const int32_t k_quatro_mono_scaled_lo_ro_downmix16bit[UP_DOWN_MIX_COEFFS_LENGTH];
 
+	/** Number of channels in the output buffer, set for the matrix mixer. */
+	size_t out_channel_no;
+
+	/**
+	 * Mixing matrix as lists of non-zero taps per output channel, the
+	 * zero coefficients are skipped in processing.
+	 */
+	struct up_down_mixer_tap taps[UP_DOWN_MIXER_MAX_CHANNELS][UP_DOWN_MIXER_MAX_CHANNELS];
+	uint8_t num_taps[UP_DOWN_MIXER_MAX_CHANNELS];
+
 	/** In/out internal buffers */
 	int32_t *buf_in;
 	int32_t *buf_out;
@@ -496,4 +528,56 @@ void upmix32bit_4_0_to_5_1(struct up_down_mixer_data *cd, const uint8_t * const
 void upmix32bit_quatro_to_5_1(struct up_down_mixer_data *cd, const uint8_t * const in_data,
 			      const uint32_t in_size, uint8_t * const out_data);
 
+/**
+ * \brief Set the mixing matrix.
+ *
+ * \param[in,out] cd                     Component private data.
+ * \param[in]     matrix                 Q1.31 gains, out_channels rows of in_channels.
+ * \param[in]     in_channels            Number of input channels.
+ * \param[in]     out_channels           Number of output channels.
+ * \return Error code.
+ */
+int up_down_mixer_set_matrix(struct up_down_mixer_data *cd, const int32_t *matrix,
+			     size_t in_channels, size_t out_channels);
+
+/**
+ * \brief Derive the mixing matrix from the input and output channel maps.
+ *
+ * An input channel goes to the output channel in the same position. When
+ * the position is missing in output the channel is folded to the nearest
+ * existing position, e.g. surround to side or front, center and LFE to the
+ * front pair and the front pair to center. When up-mixing the empty surround
+ * or side pair repeats the front pair.
+ *
+ * \param[in,out] cd                     Component private data.
+ * \param[in]     coefficients           Q1.31 downmix gains indexed by channel position.
+ * \param[in]     in_channels            Number of input channels.
+ * \param[in]     out_channels           Number of output channels.
+ * \return Error code.
+ */
+int up_down_mixer_map_matrix(struct up_down_mixer_data *cd, const int32_t *coefficients,
+			     size_t in_channels, size_t out_channels);
+
+/**
+ * \brief 32 bit matrix mixer, any number of input and output channels.
+ *
+ * \param[in]   cd                      Component private data.
+ * \param[in]   in_data                 Input buffer.
+ * \param[in]   in_size                 Input buffer size.
+ * \param[out]  out_data                Output buffer.
+ */
+void mix_matrix32bit(struct up_down_mixer_data *cd, const uint8_t * const in_data,
+		     const uint32_t in_size, uint8_t * const out_data);
+
+/**
+ * \brief 16 bit matrix mixer, any number of input and output channels.
+ *
+ * \param[in]   cd                      Component private data.
+ * \param[in]   in_data                 Input buffer.
+ * \param[in]   in_size                 Input buffer size.
+ * \param[out]  out_data                Output buffer.
+ */
+void mix_matrix16bit(struct up_down_mixer_data *cd, const uint8_t * const in_data,
+		     const uint32_t in_size, uint8_t * const out_data);
+
 #endif /* __SOF_AUDIO_UP_DOWN_MIXER_H__ */
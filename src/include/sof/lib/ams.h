@@ -9,6 +9,7 @@
 #define __SOF_LIB_AMS_H__
 
 #include <errno.h>
+#include <rtos/atomic.h>
 #include <rtos/task.h>
 #include <ipc/topology.h>
 #include <rtos/alloc.h>
@@ -28,6 +29,9 @@
 #define AMS_ROUTING_TABLE_SIZE 16
 /* Space allocated for async message content*/
 #define AMS_MAX_MSG_SIZE 0x1000
+/* Slots in the pool of each core, the message data follows the payload struct */
+#define AMS_SLOTS_PER_CORE CONFIG_AMS_SLOTS_PER_CORE
+#define AMS_SLOT_COUNT (CONFIG_CORE_COUNT * AMS_SLOTS_PER_CORE)
 
 /* Size of slots message, module id and instance id */
 #define AMS_SLOT_SIZE(msg) (AMS_MESSAGE_SIZE(msg) + sizeof(uint16_t) * 2)
@@ -115,12 +119,31 @@ struct ams_shared_context {
 	struct ams_consumer_entry rt_table[AMS_ROUTING_TABLE_SIZE];
 	struct ams_producer producer_table[AMS_ROUTING_TABLE_SIZE];
 	struct uuid_idx uuid_table[AMS_SERVICE_UUID_TABLE_SIZE];
+};
 
-	uint32_t slot_uses[CONFIG_CORE_COUNT];
-	/* marks which core already processed slot */
-	uint32_t slot_done[CONFIG_CORE_COUNT];
-
-	struct ams_slot slots[CONFIG_CORE_COUNT];
+/*
+ * Slots of messages sent to other cores, in uncached memory and accessed
+ * with atomics only, without the shared context lock. A core allocates
+ * slots only from its own range, any core frees a slot when it drops the
+ * last use of it.
+ *
+ * A slot sent to a core is marked in the inbox of the core, and an IDC is
+ * sent only when no doorbell is pending for the core yet, so all slots
+ * queued until the core handles the IDC are processed in one go.
+ */
+struct ams_slot_pool {
+	/* free slots of each core, bit per slot of the core */
+	atomic_t free[CONFIG_CORE_COUNT];
+	/* slots waiting to be processed by each core, bit per slot */
+	atomic_t inbox[CONFIG_CORE_COUNT];
+	/* set when an IDC was sent to the core and it has not emptied the inbox */
+	atomic_t doorbell[CONFIG_CORE_COUNT];
+	/* references to the slot, by the sender and the cores it was sent to */
+	atomic_t uses[AMS_SLOT_COUNT];
+	/* cores already served, by the sender or by forwarding the slot */
+	atomic_t done[AMS_SLOT_COUNT];
+
+	struct ams_slot slots[AMS_SLOT_COUNT];
 };
 
 struct ams_context {
@@ -131,7 +154,6 @@ struct ams_context {
 struct ams_task {
 	struct task ams_task;
 	struct async_message_service *ams;
-	uint32_t pending_slots;
 };
 
 struct async_message_service {
@@ -252,6 +274,11 @@ static inline struct ams_shared_context *ams_ctx_get(void)
 {
 	return sof_get()->ams_shared_ctx;
 }
+
+static inline struct ams_slot_pool *ams_slot_pool_get(void)
+{
+	return sof_get()->ams_slot_pool;
+}
 #else
 static inline int ams_init(void) { return 0; }
 static inline int ams_get_message_type_id(const uint8_t *message_uuid,
@@ -289,9 +316,10 @@ static inline struct ams_shared_context *ams_ctx_get(void)
 #endif /* CONFIG_AMS */
 
 #if CONFIG_SMP && CONFIG_AMS
-int process_incoming_message(uint32_t slot);
+/* Handles the IDC sent when slots were queued to the inbox of this core */
+int process_incoming_message(void);
 #else
-static inline int process_incoming_message(uint32_t slot) { return 0; }
+static inline int process_incoming_message(void) { return 0; }
 #endif /* CONFIG_SMP && CONFIG_AMS */
 
 struct async_message_service **arch_ams_get(void);
@@ -34,6 +34,8 @@
 #include <stdint.h>
 #include <zephyr/device.h>
 
+union ipc4_connector_node_id;
+
 /** \addtogroup sof_dai_drivers DAI Drivers
  *  DAI Drivers API specification.
  *  @{
@@ -301,6 +303,12 @@ int dai_position(struct comp_dev *dev, struct sof_ipc_stream_posn *posn);
  */
 void dai_dma_position_update(struct dai_data *dd, struct comp_dev *dev);
 
+/**
+ * \brief get unused llp slot for a gateway node
+ * \return offset of the slot in the fw registers window or negative error
+ */
+int dai_get_unused_llp_slot(struct comp_dev *dev, union ipc4_connector_node_id *node);
+
 /**
  * \brief release llp slot
  */
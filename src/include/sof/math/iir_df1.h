@@ -50,6 +50,32 @@ void iir_reset_df1(struct iir_state_df1 *iir);
 
 int32_t iir_df1(struct iir_state_df1 *iir, int32_t x);
 
+/**
+ * \brief Filter a block of samples of one channel with a biquad cascade.
+ * \param[in,out] iir Filter state, updated for the next block.
+ * \param[in] x Input samples in Q1.31.
+ * \param[out] y Output samples in Q1.31, may be the same as x.
+ * \param[in] frames Number of samples to process.
+ * \param[in] stride Distance in samples between consecutive inputs and outputs.
+ */
+void iir_df1_block(struct iir_state_df1 *iir, const int32_t *x, int32_t *y,
+		   int frames, int stride);
+
+/**
+ * \brief Filter a block of two adjacent interleaved channels together.
+ *
+ * The channels are processed as two lanes of the same loop. If the filter
+ * topologies differ the channels are processed one by one.
+ * \param[in,out] iir0 Filter state of the first channel.
+ * \param[in,out] iir1 Filter state of the second channel.
+ * \param[in] x Input samples of the first channel in Q1.31.
+ * \param[out] y Output samples of the first channel in Q1.31, may be the same as x.
+ * \param[in] frames Number of frames to process.
+ * \param[in] stride Distance in samples between consecutive frames.
+ */
+void iir_df1_block_x2(struct iir_state_df1 *iir0, struct iir_state_df1 *iir1,
+		      const int32_t *x, int32_t *y, int frames, int stride);
+
 /* Inline functions */
 #if IIR_DF1_HIFI3
 #include "iir_df1_hifi3.h"
@@ -0,0 +1,145 @@
+/* SPDX-License-Identifier: BSD-3-Clause
+ *
+ * Copyright(c) 2023 Intel Corporation. All rights reserved.
+ *
+ */
+
+/* Short-time Fourier transform analysis and synthesis */
+
+#ifndef __SOF_MATH_STFT_H__
+#define __SOF_MATH_STFT_H__
+
+#include <sof/audio/audio_stream.h>
+#include <sof/math/fft.h>
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+/* The amount of left shifts for block floating point FFT input is by default
+ * limited to 10 that equals about 60 dB boost. The shift used for a frame is
+ * reported in input_shift so that the user can compensate it.
+ */
+#define STFT_NORMALIZE_MAX_SHIFT	10
+
+/**
+ * \brief Circular buffer of Q1.31 samples for STFT input and output.
+ */
+struct stft_buffer {
+	int32_t *addr;
+	int32_t *end_addr;
+	int32_t *r_ptr;
+	int32_t *w_ptr;
+	int s_avail;	/**< samples count */
+	int s_free;	/**< samples count */
+	int s_length;	/**< length in samples for wrap */
+};
+
+/**
+ * \brief STFT state. The input buffer holds the frame history so the
+ * analysis frames are read in place from it. The spectrum of the last
+ * analyzed frame is in fft_out. The synthesis, if enabled, reads the
+ * spectrum from fft_out and overlap-adds the frames to the output buffer.
+ */
+struct stft_plan {
+	struct stft_buffer ibuf;	/**< Analysis input, Q1.31 */
+	struct stft_buffer obuf;	/**< Synthesis output, Q1.31 */
+	struct fft_plan *fft_plan;	/**< fft_buf to fft_out */
+	struct fft_plan *ifft_plan;	/**< fft_out to fft_buf, synthesis only */
+	void *fft_buf;			/**< icomplex16 or icomplex32, fft_padded_size */
+	void *fft_out;			/**< icomplex16 or icomplex32, fft_padded_size */
+	const int16_t *window;		/**< Q1.15, frame_size, owned by the user */
+	int32_t *overlap;		/**< Synthesis overlap-add, frame_size */
+	int32_t *buffers;
+	int32_t synth_gain;		/**< Overlap-add normalize, Q2.30 */
+	int frame_size;
+	int hop_size;
+	int fft_padded_size;
+	int fft_bits;			/**< 16 or 32 */
+	int max_shift;			/**< Block floating point max shift, 0 to disable */
+	int input_shift;		/**< Shift applied to the last analyzed frame */
+	size_t fft_buffer_size;		/**< bytes */
+};
+
+/**
+ * \brief Allocate and initialize STFT.
+ * \param[in,out]  st          STFT state
+ * \param[in]      frame_size  Analysis frame and window length
+ * \param[in]      hop_size    Frame advance, 1 to frame_size
+ * \param[in]      fft_bits    FFT word length, 16 or 32
+ * \param[in]      max_frames  Max samples per stft_input_*() or stft_output_*() call
+ * \param[in]      window      Window function, frame_size Q1.15 values
+ * \param[in]      synthesis   Allocate also inverse transform and overlap-add
+ * \return Zero if success, otherwise error code.
+ */
+int stft_plan_init(struct stft_plan *st, int frame_size, int hop_size, int fft_bits,
+		   int max_frames, const int16_t *window, bool synthesis);
+
+/**
+ * \brief Free STFT buffers.
+ * \param[in,out]  st  STFT state
+ */
+void stft_plan_free(struct stft_plan *st);
+
+/**
+ * \brief Clear STFT input, output and overlap-add state.
+ * \param[in,out]  st  STFT state
+ */
+void stft_reset(struct stft_plan *st);
+
+/**
+ * \brief Analyze the next frame if there is a hop of new input. The
+ * first frame is analyzed when the first full frame of input is available.
+ * \param[in,out]  st  STFT state
+ * \return True if a spectrum was computed to fft_out. The spectrum is scaled
+ *	   by 2^input_shift / fft_padded_size.
+ */
+bool stft_analysis(struct stft_plan *st);
+
+/**
+ * \brief Inverse transform the spectrum in fft_out and overlap-add it. A
+ * hop of output samples becomes available in obuf.
+ * \param[in,out]  st  STFT state
+ */
+void stft_synthesis(struct stft_plan *st);
+
+/**
+ * \brief Copy one channel from audio stream to STFT input.
+ * \param[in,out]  st       STFT state
+ * \param[in]      source   Source stream
+ * \param[in]      x        Read position in source stream
+ * \param[in]      frames   Number of frames to copy, max_frames at most
+ * \param[in]      channel  Channel to copy
+ */
+void stft_input_s16(struct stft_plan *st, const struct audio_stream __sparse_cache *source,
+		    const int16_t *x, int frames, int channel);
+void stft_input_s32(struct stft_plan *st, const struct audio_stream __sparse_cache *source,
+		    const int32_t *x, int frames, int channel);
+
+/**
+ * \brief Copy STFT output to one channel of audio stream.
+ * \param[in,out]  st       STFT state
+ * \param[in]      sink     Sink stream
+ * \param[in]      y        Write position in sink stream
+ * \param[in]      frames   Number of frames to copy, the samples missing from
+ *			    output buffer are written as zeros.
+ * \param[in]      channel  Channel to write
+ */
+void stft_output_s16(struct stft_plan *st, const struct audio_stream __sparse_cache *sink,
+		     int16_t *y, int frames, int channel);
+void stft_output_s32(struct stft_plan *st, const struct audio_stream __sparse_cache *sink,
+		     int32_t *y, int frames, int channel);
+
+static inline int stft_buffer_samples_without_wrap(struct stft_buffer *buffer, int32_t *ptr)
+{
+	return buffer->end_addr - ptr;
+}
+
+static inline int32_t *stft_buffer_wrap(struct stft_buffer *buffer, int32_t *ptr)
+{
+	if (ptr >= buffer->end_addr)
+		ptr -= buffer->s_length;
+
+	return ptr;
+}
+
+#endif /* __SOF_MATH_STFT_H__ */
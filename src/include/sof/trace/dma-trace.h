@@ -9,6 +9,7 @@
 #define __SOF_TRACE_DMA_TRACE_H__
 
 #include <sof/lib/dma.h>
+#include <rtos/atomic.h>
 #include <rtos/task.h>
 #include <rtos/sof.h>
 #include <rtos/spinlock.h>
@@ -27,6 +28,22 @@ struct dma_trace_buf {
 	uint32_t avail;		/* bytes available to read */
 };
 
+#if CONFIG_TRACE_CORE_RINGS
+/* Trace events of one core waiting for trace_work(). Single producer, the
+ * owning core, so adding an event never takes a lock shared with other
+ * cores. The consumers, trace_work() and dma_trace_flush(), hold the lock
+ * of the DMA trace data. The offsets are in bytes, run freely and wrap at
+ * CONFIG_TRACE_CORE_RING_SIZE.
+ */
+struct dma_trace_ring {
+	atomic_t w_off;		/* written by the owning core only */
+	atomic_t r_off;		/* written by a consumer only */
+	uint32_t dropped;	/* events dropped on a full ring, by the owner */
+	uint32_t reported;	/* dropped events passed on, by a consumer */
+	uint8_t data[CONFIG_TRACE_CORE_RING_SIZE];
+};
+#endif
+
 struct dma_trace_data {
 	struct dma_sg_config config;
 	struct dma_trace_buf dmatb;
@@ -46,8 +63,12 @@ struct dma_trace_data {
 					 *  copied by dma connected to host
 					 */
 	uint32_t dropped_entries;	/* amount of dropped entries */
+	uint32_t drops;			/* changes whenever entries are dropped */
 	struct k_spinlock lock;		/* dma trace lock */
 	uint64_t time_delta;		/* difference between the host time */
+#if CONFIG_TRACE_CORE_RINGS
+	struct dma_trace_ring *rings;	/* CONFIG_CORE_COUNT rings, uncached */
+#endif
 };
 
 int dma_trace_init_early(struct sof *sof);
@@ -42,4 +42,38 @@ struct log_entry_header {
 	uint32_t log_entry_address;	 /* Address of log entry in ELF */
 } __attribute__((packed));
 
+/*
+ *  Compact log entry protocol, used by the DMA trace with CONFIG_TRACE_COMPACT.
+ *
+ *  uint32_t log_entry_address | TRACE_COMPACT_MARK
+ *  uint8_t  flags
+ *  varint   timestamp, absolute in a sync record, otherwise the difference
+ *           to the previous record of the same core
+ *  varint   uid, id_0 and id_1 with TRACE_COMPACT_CTX, set when they changed
+ *           and in all sync records
+ *  varint   arguments, params_num of the log entry
+ *  zero padding to a uint32_t boundary
+ *
+ * Varints are unsigned LEB128, 7 bits per byte starting from the lowest,
+ * with the top bit set in all but the last byte. A record follows the
+ * previous one of the same core only when their sequence numbers are
+ * consecutive, otherwise the decoder waits for the next sync record.
+ */
+#define TRACE_COMPACT_MARK		0x1	/* log entries are uint32_t aligned */
+#define TRACE_COMPACT_MARK_MASK		0x3
+#define TRACE_COMPACT_CORE_MASK		0x7	/* flags: reporting core's id */
+#define TRACE_COMPACT_SEQ_SHIFT		3	/* flags: sequence number per core */
+#define TRACE_COMPACT_SEQ_MASK		0x7
+#define TRACE_COMPACT_CTX		0x40	/* flags: uid and ids follow */
+#define TRACE_COMPACT_SYNC		0x80	/* flags: decodable on its own */
+
+/* bytes of a varint holding up to bits wide values */
+#define TRACE_COMPACT_VARINT_SIZE(bits)	(((bits) + 6) / 7)
+
+/* largest compact record of a log entry with params_num arguments */
+#define TRACE_COMPACT_SIZE_MAX(params_num)					\
+	((sizeof(uint32_t) + 1 + TRACE_COMPACT_VARINT_SIZE(64) +		\
+	  TRACE_COMPACT_VARINT_SIZE(32) + 2 * TRACE_COMPACT_VARINT_SIZE(TRACE_ID_LENGTH) + \
+	  (params_num) * TRACE_COMPACT_VARINT_SIZE(32) + 3) & ~3)
+
 #endif /* __USER_TRACE_H__ */
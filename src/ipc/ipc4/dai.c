@@ -238,8 +238,7 @@ void dai_release_llp_slot(struct dai_data *dd)
 	dd->slot_info.node_id = 0;
 }
 
-static int dai_get_unused_llp_slot(struct comp_dev *dev,
-				   union ipc4_connector_node_id *node)
+int dai_get_unused_llp_slot(struct comp_dev *dev, union ipc4_connector_node_id *node)
 {
 	struct ipc4_llp_reading_slot slot;
 	k_spinlock_key_t key;
@@ -469,6 +469,91 @@ static int ipc_wait_for_compound_msg(void)
 	return IPC4_SUCCESS;
 }
 
+/*
+ * Queues one phase of the pipelines on other cores as an IDC batch per core and
+ * starts the batches, so the cores run them while this core handles its own
+ * pipelines. The started batches are set in batch[], indexed by core.
+ */
+static int ipc4_ppl_state_remote_start(struct ipc *ipc, const uint32_t *ppl_id,
+				       uint32_t ppl_count, uint32_t *cmd, uint32_t phase,
+				       struct idc_batch **batch)
+{
+	struct idc_msg msg = { IDC_MSG_PPL_STATE, 0, 0, sizeof(*cmd), cmd, };
+	struct ipc_comp_dev *ppl_icd;
+	uint32_t core;
+	int ret;
+	int i;
+
+	for (core = 0; core < CONFIG_CORE_COUNT; core++)
+		batch[core] = NULL;
+
+	for (i = 0; i < ppl_count; i++) {
+		ppl_icd = ipc_get_comp_by_ppl_id(ipc, COMP_TYPE_PIPELINE, ppl_id[i]);
+		if (!ppl_icd) {
+			ipc_cmd_err(&ipc_tr, "ipc: comp %d not found", ppl_id[i]);
+			return IPC4_INVALID_RESOURCE_ID;
+		}
+
+		core = ppl_icd->core;
+		if (cpu_is_me(core))
+			continue;
+
+		msg.extension = IDC_MSG_PPL_STATE_EXT(ppl_id[i], phase);
+		msg.core = core;
+
+		if (!batch[core])
+			batch[core] = idc_batch_init(core);
+
+		/* a full batch is run first, the batches are not started yet */
+		ret = idc_batch_add(batch[core], &msg);
+		if (ret != 0)
+			return ret;
+	}
+
+	for (core = 0; core < CONFIG_CORE_COUNT; core++)
+		if (batch[core])
+			idc_batch_submit(batch[core]);
+
+	return 0;
+}
+
+/*
+ * Runs the pending trigger batch of one core and waits for it, so the pipelines
+ * after it in the host list are only triggered once it is done. Returns ret or
+ * else the remote failure.
+ */
+static int ipc4_ppl_state_remote_flush(struct idc_batch **pending, int ret)
+{
+	int status;
+
+	if (!*pending)
+		return ret;
+
+	idc_batch_submit(*pending);
+	status = idc_batch_wait(*pending);
+	*pending = NULL;
+
+	return ret ? ret : status;
+}
+
+/* Waits for the started batches, returns ret or else the first remote failure */
+static int ipc4_ppl_state_remote_wait(struct idc_batch **batch, int ret)
+{
+	uint32_t core;
+	int status;
+
+	for (core = 0; core < CONFIG_CORE_COUNT; core++) {
+		if (!batch[core])
+			continue;
+
+		status = idc_batch_wait(batch[core]);
+		if (!ret)
+			ret = status;
+	}
+
+	return ret;
+}
+
 static int ipc4_set_pipeline_state(struct ipc4_message_request *ipc4)
 {
 	const struct ipc4_pipeline_set_state_data *ppl_data;
@@ -477,8 +562,11 @@ static int ipc4_set_pipeline_state(struct ipc4_message_request *ipc4)
 	struct ipc *ipc = ipc_get();
 	uint32_t cmd, ppl_count, id;
 	const uint32_t *ppl_id;
+	struct idc_batch *batch[CONFIG_CORE_COUNT];
+	struct idc_batch *pending = NULL;
+	struct idc_msg msg = { IDC_MSG_PPL_STATE, 0, 0, sizeof(cmd), &cmd, };
 	bool use_idc = false;
-	uint32_t idx;
+	uint32_t idx = cpu_get_id();
 	int ret = 0;
 	int i;
 
@@ -515,73 +603,81 @@ static int ipc4_set_pipeline_state(struct ipc4_message_request *ipc4)
 		}
 	}
 
+	/* All the pipelines are on one other core, pass IPC to it */
+	if (!use_idc && !cpu_is_me(idx))
+		return ipc4_process_on_core(idx, false);
+
 	/* Run the prepare phase on the pipelines */
+	ret = ipc4_ppl_state_remote_start(ipc, ppl_id, ppl_count, &cmd,
+					  IDC_PPL_STATE_PHASE_PREPARE, batch);
+	if (ret != 0)
+		return ret;
+
 	for (i = 0; i < ppl_count; i++) {
 		ppl_icd = ipc_get_comp_by_ppl_id(ipc, COMP_TYPE_PIPELINE, ppl_id[i]);
 		if (!ppl_icd) {
 			ipc_cmd_err(&ipc_tr, "ipc: comp %d not found", ppl_id[i]);
-			return IPC4_INVALID_RESOURCE_ID;
+			ret = IPC4_INVALID_RESOURCE_ID;
+			break;
 		}
 
-		/* Pass IPC to target core
-		 * or use idc if more than one core used
-		 */
-		if (!cpu_is_me(ppl_icd->core)) {
-			if (use_idc) {
-				struct idc_msg msg = { IDC_MSG_PPL_STATE,
-					IDC_MSG_PPL_STATE_EXT(ppl_id[i],
-							      IDC_PPL_STATE_PHASE_PREPARE),
-					ppl_icd->core,
-					sizeof(cmd), &cmd, };
-
-				ret = idc_send_msg(&msg, IDC_BLOCKING);
-			} else {
-				return ipc4_process_on_core(ppl_icd->core, false);
-			}
-		} else {
-			ret = ipc4_pipeline_prepare(ppl_icd, cmd);
-		}
+		if (!cpu_is_me(ppl_icd->core))
+			continue;
 
+		ret = ipc4_pipeline_prepare(ppl_icd, cmd);
 		if (ret != 0)
-			return ret;
+			break;
 	}
 
-	/* Run the trigger phase on the pipelines */
+	ret = ipc4_ppl_state_remote_wait(batch, ret);
+	if (ret != 0)
+		return ret;
+
+	/*
+	 * Run the trigger phase on the pipelines in the order of the host list,
+	 * the host relies on it, e.g. the DAI is stopped before the host copier.
+	 * Only a run of pipelines on the same other core is sent as one batch.
+	 */
 	for (i = 0; i < ppl_count; i++) {
 		bool delayed = false;
 
 		ppl_icd = ipc_get_comp_by_ppl_id(ipc, COMP_TYPE_PIPELINE, ppl_id[i]);
 		if (!ppl_icd) {
 			ipc_cmd_err(&ipc_tr, "ipc: comp %d not found", ppl_id[i]);
-			return IPC4_INVALID_RESOURCE_ID;
+			ret = IPC4_INVALID_RESOURCE_ID;
+			break;
+		}
+
+		if (pending && ppl_icd->core != msg.core) {
+			ret = ipc4_ppl_state_remote_flush(&pending, 0);
+			if (ret != 0)
+				break;
 		}
 
-		/* Pass IPC to target core
-		 * or use idc if more than one core used
-		 */
 		if (!cpu_is_me(ppl_icd->core)) {
-			if (use_idc) {
-				struct idc_msg msg = { IDC_MSG_PPL_STATE,
-					IDC_MSG_PPL_STATE_EXT(ppl_id[i],
-							      IDC_PPL_STATE_PHASE_TRIGGER),
-					ppl_icd->core,
-					sizeof(cmd), &cmd, };
-
-				ret = idc_send_msg(&msg, IDC_BLOCKING);
-			} else {
-				return ipc4_process_on_core(ppl_icd->core, false);
-			}
-		} else {
-			ipc_compound_pre_start(state.primary.r.type);
-			ret = ipc4_pipeline_trigger(ppl_icd, cmd, &delayed);
-			ipc_compound_post_start(state.primary.r.type, ret, delayed);
+			msg.extension = IDC_MSG_PPL_STATE_EXT(ppl_id[i],
+							      IDC_PPL_STATE_PHASE_TRIGGER);
+			msg.core = ppl_icd->core;
+
+			if (!pending)
+				pending = idc_batch_init(msg.core);
+
+			ret = idc_batch_add(pending, &msg);
+			if (ret != 0)
+				break;
+
+			continue;
 		}
 
+		ipc_compound_pre_start(state.primary.r.type);
+		ret = ipc4_pipeline_trigger(ppl_icd, cmd, &delayed);
+		ipc_compound_post_start(state.primary.r.type, ret, delayed);
 		if (ret != 0)
-			return ret;
+			break;
 	}
 
-	return ret;
+	/* the pipelines queued before a failure are still triggered, as before */
+	return ipc4_ppl_state_remote_flush(&pending, ret);
 }
 
 #if CONFIG_LIBRARY_MANAGER
@@ -333,6 +333,50 @@ static struct comp_buffer *ipc4_create_buffer(struct comp_dev *src, struct comp_
 	return buffer_new(&ipc_buf);
 }
 
+static int ipc4_comp_bind_op(struct comp_dev *dev, struct ipc4_module_bind_unbind *bu,
+			     bool bind)
+{
+	return bind ? comp_bind(dev, bu) : comp_unbind(dev, bu);
+}
+
+/*
+ * Binds or unbinds both the source and the sink. When they are on different
+ * cores, the one on another core is sent as an IDC batch first and runs in
+ * parallel with the other one instead of waiting for one IDC after the other.
+ */
+static void ipc4_comp_bind_pair(struct comp_dev *source, struct comp_dev *sink,
+				struct ipc4_module_bind_unbind *bu, bool bind,
+				int *src_ret, int *sink_ret)
+{
+	struct idc_msg msg = { bind ? IDC_MSG_BIND : IDC_MSG_UNBIND, 0, 0, sizeof(*bu), bu, };
+	struct comp_dev *remote = cpu_is_me(source->ipc_config.core) ? sink : source;
+	struct comp_dev *local = remote == source ? sink : source;
+	int *remote_ret = remote == source ? src_ret : sink_ret;
+	int *local_ret = remote == source ? sink_ret : src_ret;
+	struct idc_batch *batch;
+	bool has_op;
+
+	has_op = bind ? !!remote->drv->ops.bind : !!remote->drv->ops.unbind;
+	if (source->ipc_config.core == sink->ipc_config.core || !has_op) {
+		*src_ret = ipc4_comp_bind_op(source, bu, bind);
+		*sink_ret = ipc4_comp_bind_op(sink, bu, bind);
+		return;
+	}
+
+	msg.extension = IDC_EXTENSION(remote->ipc_config.id);
+	msg.core = remote->ipc_config.core;
+	batch = idc_batch_init(msg.core);
+	*remote_ret = idc_batch_add(batch, &msg);
+	if (*remote_ret < 0) {
+		*local_ret = ipc4_comp_bind_op(local, bu, bind);
+		return;
+	}
+
+	idc_batch_submit(batch);
+	*local_ret = ipc4_comp_bind_op(local, bu, bind);
+	*remote_ret = idc_batch_wait(batch);
+}
+
 int ipc_comp_connect(struct ipc *ipc, ipc_pipe_comp_connect *_connect)
 {
 	struct ipc4_module_bind_unbind *bu;
@@ -344,7 +388,7 @@ int ipc_comp_connect(struct ipc *ipc, ipc_pipe_comp_connect *_connect)
 	struct ipc4_base_module_cfg sink_src_cfg;
 	uint32_t flags;
 	int src_id, sink_id;
-	int ret;
+	int ret, ret1;
 
 	bu = (struct ipc4_module_bind_unbind *)_connect;
 	src_id = IPC4_COMP_ID(bu->primary.r.module_id, bu->primary.r.instance_id);
@@ -415,13 +459,15 @@ int ipc_comp_connect(struct ipc *ipc, ipc_pipe_comp_connect *_connect)
 	}
 
 
-	ret = comp_bind(source, bu);
-	if (ret < 0)
+	ipc4_comp_bind_pair(source, sink, bu, true, &ret, &ret1);
+	if (ret < 0 || ret1 < 0) {
+		/* undo the one that succeeded */
+		if (ret >= 0)
+			comp_unbind(source, bu);
+		if (ret1 >= 0)
+			comp_unbind(sink, bu);
 		goto e_src_bind;
-
-	ret = comp_bind(sink, bu);
-	if (ret < 0)
-		goto e_sink_bind;
+	}
 
 	/* update direction for sink component if it is not set already */
 	if (!sink->direction_set && source->direction_set) {
@@ -439,8 +485,6 @@ int ipc_comp_connect(struct ipc *ipc, ipc_pipe_comp_connect *_connect)
 
 	return IPC4_SUCCESS;
 
-e_sink_bind:
-	comp_unbind(source, bu);
 e_src_bind:
 	pipeline_disconnect(sink, buffer, PPL_CONN_DIR_BUFFER_TO_COMP);
 e_sink_connect:
@@ -512,8 +556,7 @@ int ipc_comp_disconnect(struct ipc *ipc, ipc_pipe_comp_connect *_connect)
 	irq_local_disable(flags);
 	pipeline_disconnect(src, buffer, PPL_CONN_DIR_COMP_TO_BUFFER);
 	pipeline_disconnect(sink, buffer, PPL_CONN_DIR_BUFFER_TO_COMP);
-	ret = comp_unbind(src, bu);
-	ret1 = comp_unbind(sink, bu);
+	ipc4_comp_bind_pair(src, sink, bu, false, &ret, &ret1);
 	irq_local_enable(flags);
 
 	buffer_free(buffer);
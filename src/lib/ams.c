@@ -278,30 +278,69 @@ int ams_unregister_consumer(uint32_t message_type_id,
 	return err;
 }
 
-static uint32_t ams_push_slot(struct ams_shared_context __sparse_cache *ctx_shared,
+/* slot bits of all cores fit in the inbox of a core */
+STATIC_ASSERT(AMS_SLOT_COUNT <= 32, ams_slot_count_exceeds_inbox);
+
+static uint32_t ams_alloc_slot(struct ams_slot_pool *pool, int core)
+{
+	atomic_val_t free_slots;
+	int bit;
+
+	/* only this core takes from its range, a free may race with us */
+	do {
+		free_slots = atomic_get(&pool->free[core]);
+		if (!free_slots)
+			return AMS_INVALID_SLOT;
+		bit = find_lsb_set(free_slots) - 1;
+	} while (!atomic_cas(&pool->free[core], free_slots, free_slots & ~BIT(bit)));
+
+	return core * AMS_SLOTS_PER_CORE + bit;
+}
+
+static void ams_put_slot(struct ams_slot_pool *pool, uint32_t slot)
+{
+	/* last user frees the slot to the core which allocated it */
+	if (atomic_dec(&pool->uses[slot]) == 1)
+		atomic_or(&pool->free[slot / AMS_SLOTS_PER_CORE],
+			  BIT(slot % AMS_SLOTS_PER_CORE));
+}
+
+static uint32_t ams_push_slot(struct ams_slot_pool *pool,
 			      const struct ams_message_payload *msg,
 			      uint16_t module_id, uint16_t instance_id)
 {
+	struct ams_slot *ams_slot;
+	uint32_t slot;
 	int err;
 
-	for (uint32_t i = 0; i < ARRAY_SIZE(ctx_shared->slots); ++i) {
-		if (ctx_shared->slot_uses[i] == 0) {
-			err = memcpy_s((__sparse_force void *)ctx_shared->slots[i].u.msg_raw,
-				       sizeof(ctx_shared->slots[i].u.msg_raw),
-				       msg, AMS_MESSAGE_SIZE(msg));
-
-			if (err != 0)
-				return AMS_INVALID_SLOT;
-
-			ctx_shared->slots[i].module_id = module_id;
-			ctx_shared->slots[i].instance_id = instance_id;
-			ctx_shared->slot_done[i] = 0;
-
-			return i;
+	if (msg->message_length > AMS_MAX_MSG_SIZE - sizeof(*msg))
+		return AMS_INVALID_SLOT;
+
+	slot = ams_alloc_slot(pool, cpu_get_id());
+	if (slot == AMS_INVALID_SLOT)
+		return AMS_INVALID_SLOT;
+
+	/* message data is copied after the payload, receivers point to it */
+	ams_slot = &pool->slots[slot];
+	ams_slot->u.msg = *msg;
+	if (msg->message_length) {
+		err = memcpy_s(ams_slot->u.msg_raw + sizeof(*msg),
+			       sizeof(ams_slot->u.msg_raw) - sizeof(*msg),
+			       msg->message, msg->message_length);
+		if (err != 0) {
+			atomic_set(&pool->uses[slot], 1);
+			ams_put_slot(pool, slot);
+			return AMS_INVALID_SLOT;
 		}
 	}
 
-	return AMS_INVALID_SLOT;
+	ams_slot->module_id = module_id;
+	ams_slot->instance_id = instance_id;
+	atomic_set(&pool->done[slot], BIT(cpu_get_id()));
+	/* held by the sender until the message is sent to all cores */
+	atomic_set(&pool->uses[slot], 1);
+
+	return slot;
 }
 
 static int ams_get_ixc_route_to_target(int source_core, int target_core)
@@ -316,67 +355,63 @@ static int ams_get_ixc_route_to_target(int source_core, int target_core)
 }
 
 static int send_message_over_ixc(struct async_message_service *ams, uint32_t slot,
-				 struct ams_consumer_entry *target)
+				 int ixc_route)
 {
-	if (!target)
-		return -EINVAL;
+	struct ams_slot_pool *pool = ams_slot_pool_get();
+
+	atomic_inc(&pool->uses[slot]);
+	atomic_or(&pool->inbox[ixc_route], BIT(slot));
 
-	int ixc_route = ams_get_ixc_route_to_target(cpu_get_id(),
-							 target->consumer_core_id);
+	/* the doorbell already sent to the core will pick the slot up */
+	if (!atomic_cas(&pool->doorbell[ixc_route], 0, 1))
+		return 0;
 
 	struct idc_msg ams_request = {
-		.header = IDC_MSG_AMS | slot,
+		.header = IDC_MSG_AMS,
 		.extension = IDC_MSG_AMS_EXT,
 		.core = ixc_route,
 		.size = 0,
 		.payload = NULL};
 
 	/* send IDC message */
-	return idc_send_msg(&ams_request, IDC_NON_BLOCKING);
+	int err = idc_send_msg(&ams_request, IDC_NON_BLOCKING);
+
+	if (err != 0) {
+		/* slot stays in the inbox, next message to the core rings again */
+		atomic_set(&pool->doorbell[ixc_route], 0);
+		tr_err(&ams_tr, "AMS doorbell to core %d failed: %d", ixc_route, err);
+	}
+
+	return err;
 }
 
 static int ams_send_over_ixc(struct async_message_service *ams, uint32_t slot,
-			     struct ams_consumer_entry *target)
+			     int ixc_route)
 {
 #if CONFIG_SMP
-	return send_message_over_ixc(ams, slot, target);
+	return send_message_over_ixc(ams, slot, ixc_route);
 #else
 	return -EINVAL;
 #endif
 }
 
-static int ams_message_send_internal(struct async_message_service *ams,
-				     const struct ams_message_payload *const ams_message_payload,
-				     uint16_t module_id, uint16_t instance_id,
-				     uint32_t incoming_slot)
+/* Copies the matching routing table entries, so the shared context lock is
+ * not held while messages are delivered.
+ */
+static int ams_find_consumers(struct async_message_service *ams, uint32_t message_type_id,
+			      uint16_t module_id, uint16_t instance_id,
+			      struct ams_consumer_entry *targets)
 {
-	bool found_any = false;
-	bool incoming = (incoming_slot != AMS_INVALID_SLOT);
 	struct ams_consumer_entry __sparse_cache *routing_table;
 	struct ams_shared_context __sparse_cache *shared_c;
-	uint32_t forwarded = 0;
-	uint32_t slot;
-	struct ams_consumer_entry ams_target;
-	int ixc_route;
-	int cpu_id;
-	int err = 0;
-
-	if (!ams->ams_context || !ams_message_payload)
-		return -EINVAL;
+	int count = 0;
 
 	shared_c = ams_acquire(ams->ams_context->shared);
-	cpu_id = cpu_get_id();
-
-	if (incoming)
-		shared_c->slot_done[incoming_slot] |= BIT(cpu_id);
 
 	routing_table = shared_c->rt_table;
-
 	for (int iter = 0; iter < AMS_ROUTING_TABLE_SIZE; iter++) {
-		slot = AMS_INVALID_SLOT;
-
 		/* Search for required entry */
-		if (routing_table[iter].message_type_id != ams_message_payload->message_type_id)
+		if (routing_table[iter].message_type_id != message_type_id)
 			continue;
 
 		/* check if we want to limit to specific module* */
@@ -387,73 +422,78 @@ static int ams_message_send_internal(struct async_message_service *ams,
 			}
 		}
 
-		found_any = true;
-		ams_target = routing_table[iter];
-		ixc_route = ams_get_ixc_route_to_target(cpu_id,
-							ams_target.consumer_core_id);
+		targets[count++] = routing_table[iter];
+	}
+
+	ams_release(shared_c);
+
+	return count;
+}
+
+static int ams_message_send_internal(struct async_message_service *ams,
+				     const struct ams_message_payload *const ams_message_payload,
+				     uint16_t module_id, uint16_t instance_id,
+				     uint32_t incoming_slot)
+{
+	struct ams_consumer_entry targets[AMS_ROUTING_TABLE_SIZE];
+	struct ams_slot_pool *pool = ams_slot_pool_get();
+	bool incoming = (incoming_slot != AMS_INVALID_SLOT);
+	uint32_t slot = incoming_slot;
+	int ixc_route;
+	int cpu_id;
+	int count;
+	int err = 0;
+	int ret;
+
+	if (!ams->ams_context || !ams_message_payload)
+		return -EINVAL;
+
+	count = ams_find_consumers(ams, ams_message_payload->message_type_id,
+				   module_id, instance_id, targets);
+	if (!count) {
+		tr_err(&ams_tr, "No entries found!");
+		return 0;
+	}
+
+	cpu_id = cpu_get_id();
+
+	for (int i = 0; i < count; i++) {
+		ixc_route = ams_get_ixc_route_to_target(cpu_id, targets[i].consumer_core_id);
 
 		if (ixc_route == cpu_id) {
 			/* we are on target core already */
-			/* release lock here, callback are NOT supposed to change routing_table */
-			ams_release(shared_c);
+			targets[i].consumer_callback(ams_message_payload, targets[i].ctx);
+			continue;
+		}
 
-			ams_target.consumer_callback(ams_message_payload, ams_target.ctx);
-			err = 0;
-		} else {
-			/* we have to go through idc */
-			if (incoming) {
-				/* if bit is set we are forwarding it again */
-				if (shared_c->slot_done[incoming_slot] & BIT(ams_target.consumer_core_id)) {
-					/* slot was already processed for that core, skip it */
-					continue;
-				}
-			} else {
-				slot = ams_push_slot(shared_c,
-						     ams_message_payload, module_id,
-						     instance_id);
-				if (slot == AMS_INVALID_SLOT) {
-					ams_release(shared_c);
-					return -EINVAL;
-				}
-			}
-			if ((forwarded & BIT(ams_target.consumer_core_id)) == 0) {
-				/* bump uses count, mark current as processed already */
-				if (slot != AMS_INVALID_SLOT) {
-					shared_c->slot_uses[slot]++;
-					shared_c->slot_done[slot] |= BIT(cpu_id);
-				}
-
-				/* release lock here, so other core can acquire it again */
-				ams_release(shared_c);
-
-				if (slot != AMS_INVALID_SLOT) {
-					forwarded |= BIT(ams_target.consumer_core_id);
-					err = ams_send_over_ixc(ams, slot, &ams_target);
-					if (err != 0) {
-						/* idc not sent, update slot refs locally */
-						shared_c = ams_acquire(ams->ams_context->shared);
-						shared_c->slot_uses[slot]--;
-						shared_c->slot_done[slot] |= BIT(ams_target.consumer_core_id);
-						ams_release(shared_c);
-					}
-				}
-			} else {
-				/* message already forwarded, nothing to do here */
-				ams_release(shared_c);
+		/* primary core forwards to all other cores, secondary cores only
+		 * process what was forwarded to them
+		 */
+		if (incoming && cpu_id != PLATFORM_PRIMARY_CORE_ID)
+			continue;
+
+		if (slot == AMS_INVALID_SLOT) {
+			slot = ams_push_slot(pool, ams_message_payload, module_id, instance_id);
+			if (slot == AMS_INVALID_SLOT) {
+				tr_err(&ams_tr, "No free AMS slot on core %d", cpu_id);
+				return -EINVAL;
 			}
 		}
 
-		/* acquire shared context lock again */
-		shared_c = ams_acquire(ams->ams_context->shared);
-	}
-
-	if (incoming)
-		shared_c->slot_uses[incoming_slot]--;
+		/* claim the core, it may be already served by the sender or an
+		 * earlier consumer on it
+		 */
+		if (atomic_or(&pool->done[slot], BIT(ixc_route)) & BIT(ixc_route))
+			continue;
 
-	ams_release(shared_c);
+		ret = ams_send_over_ixc(ams, slot, ixc_route);
+		if (ret != 0)
+			err = ret;
+	}
 
-	if (!found_any)
-		tr_err(&ams_tr, "No entries found!");
+	/* drop the hold of the sender, receivers drop theirs once processed */
+	if (!incoming && slot != AMS_INVALID_SLOT)
+		ams_put_slot(pool, slot);
 
 	return err;
 }
@@ -484,43 +524,33 @@ int ams_send_mi(const struct ams_message_payload *const ams_message_payload,
 
 static int ams_process_slot(struct async_message_service *ams, uint32_t slot)
 {
-	struct ams_shared_context __sparse_cache *shared_c;
+	struct ams_slot_pool *pool = ams_slot_pool_get();
+	struct ams_slot *ams_slot = &pool->slots[slot];
 	struct ams_message_payload msg;
-	uint16_t module_id;
-	uint16_t instance_id;
-
-	shared_c = ams_acquire(ams->ams_context->shared);
+	int ret;
 
-	msg = shared_c->slots[slot].u.msg;
-	module_id = shared_c->slots[slot].module_id;
-	instance_id = shared_c->slots[slot].instance_id;
+	/* consumers read the message data in place, the slot is held meanwhile */
+	msg = ams_slot->u.msg;
+	msg.message = ams_slot->u.msg_raw + sizeof(msg);
 
-	ams_release(shared_c);
 	tr_info(&ams_tr, "ams_process_slot slot %d msg %d from 0x%08x",
 		slot, msg.message_type_id,
 		msg.producer_module_id << 16 | msg.producer_instance_id);
 
-	return ams_message_send_internal(ams, &msg, module_id, instance_id, slot);
+	ret = ams_message_send_internal(ams, &msg, ams_slot->module_id,
+					ams_slot->instance_id, slot);
+	ams_put_slot(pool, slot);
+
+	return ret;
 }
 
 #if CONFIG_SMP
 
-static void ams_task_add_slot_to_process(struct ams_task *ams_task, uint32_t slot)
-{
-	int flags;
-
-	irq_local_disable(flags);
-	ams_task->pending_slots |= BIT(slot);
-	irq_local_enable(flags);
-}
-
-int process_incoming_message(uint32_t slot)
+int process_incoming_message(void)
 {
 	struct async_message_service *ams = *arch_ams_get();
 	struct ams_task *task = &ams->ams_task;
 
-	ams_task_add_slot_to_process(task, slot);
-
 	return schedule_task(&task->ams_task, 0, 10000);
 }
 
@@ -531,22 +561,23 @@ int process_incoming_message(uint32_t slot)
 static enum task_state process_message(void *arg)
 {
 	struct ams_task *ams_task = arg;
+	struct ams_slot_pool *pool = ams_slot_pool_get();
+	int cpu_id = cpu_get_id();
+	atomic_val_t pending;
 	uint32_t slot;
-	int flags;
 
-	if (ams_task->pending_slots == 0) {
-		tr_err(&ams_tr, "Could not process message! Skipping.");
-		return SOF_TASK_STATE_COMPLETED;
-	}
-
-	slot = 31 - clz(ams_task->pending_slots);
+	/* clear the doorbell first, a slot queued after emptying the inbox
+	 * rings again
+	 */
+	atomic_set(&pool->doorbell[cpu_id], 0);
+	pending = atomic_set(&pool->inbox[cpu_id], 0);
 
-	ams_process_slot(ams_task->ams, slot);
+	while (pending) {
+		slot = find_lsb_set(pending) - 1;
+		pending &= ~BIT(slot);
+		ams_process_slot(ams_task->ams, slot);
+	}
 
-	/* only done on main core, irq disabling is enough */
-	irq_local_disable(flags);
-	ams_task->pending_slots &= ~BIT(slot);
-	irq_local_enable(flags);
 	schedule_task_cancel(&ams_task->ams_task);
 
 	return SOF_TASK_STATE_COMPLETED;
@@ -585,6 +616,7 @@ int ams_init(void)
 	struct async_message_service **ams = arch_ams_get();
 	struct sof *sof;
 	int ret = 0;
+	int i;
 
 	*ams = rzalloc(SOF_MEM_ZONE_SYS, SOF_MEM_FLAG_COHERENT, SOF_MEM_CAPS_RAM,
 		       sizeof(**ams));
@@ -600,6 +632,14 @@ int ams_init(void)
 		if (!sof->ams_shared_ctx)
 			goto err;
 		coherent_shared(sof->ams_shared_ctx, c);
+
+		/* shared zone is uncached, as needed for the atomics */
+		sof->ams_slot_pool = rzalloc(SOF_MEM_ZONE_RUNTIME_SHARED, 0, SOF_MEM_CAPS_RAM,
+					     sizeof(*sof->ams_slot_pool));
+		if (!sof->ams_slot_pool)
+			goto err;
+		for (i = 0; i < CONFIG_CORE_COUNT; i++)
+			atomic_set(&sof->ams_slot_pool->free[i], MASK(AMS_SLOTS_PER_CORE - 1, 0));
 	}
 
 	ams_shared_ctx = ams_ctx_get();
@@ -39,7 +39,7 @@ void fft_execute_32(struct fft_plan *plan, bool ifft)
 	if (!plan->inb32 || !plan->outb32)
 		return;
 
-	inx = (ae_int32x2 *)plan->inb32 + 1;
+	inx = (ae_int32x2 *)plan->inb32;
 	outx = (ae_int32x2 *)plan->outb32;
 
 	/* convert to complex conjugate for ifft */
@@ -54,7 +54,7 @@ void fft_execute_32(struct fft_plan *plan, bool ifft)
 
 	/* step 1: re-arrange input in bit reverse order, and shrink the level to avoid overflow */
 	inu = AE_LA64_PP(inx);
-	for (i = 1; i < size; ++i) {
+	for (i = 0; i < size; ++i) {
 		AE_LA32X2_IP(sample, inu, inx);
 		sample = AE_SRAA32S(sample, len);
 		out = &outx[plan->bit_reverse_idx[i]];
@@ -106,4 +106,156 @@ int32_t iir_df1(struct iir_state_df1 *iir, int32_t x)
 	return sat_int32(out);
 }
 
+/* Block processing of a series cascade. The biquads are run one at a time
+ * over the whole block so each section state stays in local variables
+ * across the block. The output of a section overwrites y[] and is the
+ * input of the next one. A topology with parallel sections uses the
+ * sample by sample version.
+ */
+void iir_df1_block(struct iir_state_df1 *iir, const int32_t *x, int32_t *y,
+		   int frames, int stride)
+{
+	const int32_t *in = x;
+	int32_t *coefp = iir->coef;
+	int32_t *delay = iir->delay;
+	int64_t acc;
+	int32_t y1, y2, x1, x2;
+	int32_t tmp;
+	int32_t s;
+	int shift;
+	int i;
+	int j;
+
+	/* Bypass is set with number of biquads set to zero. */
+	if (!iir->biquads) {
+		if (x != y)
+			for (i = 0; i < frames; i++)
+				y[i * stride] = x[i * stride];
+
+		return;
+	}
+
+	if (iir->biquads != iir->biquads_in_series) {
+		for (i = 0; i < frames; i++)
+			y[i * stride] = iir_df1(iir, x[i * stride]);
+
+		return;
+	}
+
+	for (j = 0; j < iir->biquads; j++) {
+		y2 = delay[0];
+		y1 = delay[1];
+		x2 = delay[2];
+		x1 = delay[3];
+		shift = 45 + coefp[5];
+		for (i = 0; i < frames * stride; i += stride) {
+			s = in[i];
+			acc = ((int64_t)coefp[0]) * y2; /* a2 * y(n - 2) */
+			acc += ((int64_t)coefp[1]) * y1; /* a1 * y(n - 1) */
+			acc += ((int64_t)coefp[2]) * x2; /* b2 * x(n - 2) */
+			acc += ((int64_t)coefp[3]) * x1; /* b1 * x(n - 1) */
+			acc += ((int64_t)coefp[4]) * s; /* b0 * x */
+			tmp = (int32_t)sat_int32(Q_SHIFT_RND(acc, 61, 31));
+			y2 = y1;
+			y1 = tmp;
+			x2 = x1;
+			x1 = s;
+			acc = ((int64_t)coefp[6]) * tmp; /* Gain */
+			y[i] = sat_int32(Q_SHIFT_RND(acc, shift, 31));
+		}
+
+		delay[0] = y2;
+		delay[1] = y1;
+		delay[2] = x2;
+		delay[3] = x1;
+		coefp += SOF_EQ_IIR_NBIQUAD;
+		delay += IIR_DF1_NUM_STATE;
+		in = y;
+	}
+}
+
+/* Two channels with the same topology as lanes of one loop, the channels
+ * are adjacent in the interleaved x[] and y[].
+ */
+void iir_df1_block_x2(struct iir_state_df1 *iir0, struct iir_state_df1 *iir1,
+		      const int32_t *x, int32_t *y, int frames, int stride)
+{
+	const int32_t *in = x;
+	int32_t *c0 = iir0->coef;
+	int32_t *c1 = iir1->coef;
+	int32_t *d0 = iir0->delay;
+	int32_t *d1 = iir1->delay;
+	int64_t acc0, acc1;
+	int32_t y1_0, y2_0, x1_0, x2_0;
+	int32_t y1_1, y2_1, x1_1, x2_1;
+	int32_t s0, s1;
+	int32_t tmp0, tmp1;
+	int shift0, shift1;
+	int i;
+	int j;
+
+	if (iir0->biquads != iir1->biquads || !iir0->biquads ||
+	    iir0->biquads != iir0->biquads_in_series ||
+	    iir1->biquads != iir1->biquads_in_series) {
+		iir_df1_block(iir0, x, y, frames, stride);
+		iir_df1_block(iir1, x + 1, y + 1, frames, stride);
+		return;
+	}
+
+	for (j = 0; j < iir0->biquads; j++) {
+		y2_0 = d0[0];
+		y1_0 = d0[1];
+		x2_0 = d0[2];
+		x1_0 = d0[3];
+		y2_1 = d1[0];
+		y1_1 = d1[1];
+		x2_1 = d1[2];
+		x1_1 = d1[3];
+		shift0 = 45 + c0[5];
+		shift1 = 45 + c1[5];
+		for (i = 0; i < frames * stride; i += stride) {
+			s0 = in[i];
+			s1 = in[i + 1];
+			acc0 = ((int64_t)c0[0]) * y2_0;
+			acc1 = ((int64_t)c1[0]) * y2_1;
+			acc0 += ((int64_t)c0[1]) * y1_0;
+			acc1 += ((int64_t)c1[1]) * y1_1;
+			acc0 += ((int64_t)c0[2]) * x2_0;
+			acc1 += ((int64_t)c1[2]) * x2_1;
+			acc0 += ((int64_t)c0[3]) * x1_0;
+			acc1 += ((int64_t)c1[3]) * x1_1;
+			acc0 += ((int64_t)c0[4]) * s0;
+			acc1 += ((int64_t)c1[4]) * s1;
+			tmp0 = (int32_t)sat_int32(Q_SHIFT_RND(acc0, 61, 31));
+			tmp1 = (int32_t)sat_int32(Q_SHIFT_RND(acc1, 61, 31));
+			y2_0 = y1_0;
+			y2_1 = y1_1;
+			y1_0 = tmp0;
+			y1_1 = tmp1;
+			x2_0 = x1_0;
+			x2_1 = x1_1;
+			x1_0 = s0;
+			x1_1 = s1;
+			acc0 = ((int64_t)c0[6]) * tmp0;
+			acc1 = ((int64_t)c1[6]) * tmp1;
+			y[i] = sat_int32(Q_SHIFT_RND(acc0, shift0, 31));
+			y[i + 1] = sat_int32(Q_SHIFT_RND(acc1, shift1, 31));
+		}
+
+		d0[0] = y2_0;
+		d0[1] = y1_0;
+		d0[2] = x2_0;
+		d0[3] = x1_0;
+		d1[0] = y2_1;
+		d1[1] = y1_1;
+		d1[2] = x2_1;
+		d1[3] = x1_1;
+		c0 += SOF_EQ_IIR_NBIQUAD;
+		c1 += SOF_EQ_IIR_NBIQUAD;
+		d0 += IIR_DF1_NUM_STATE;
+		d1 += IIR_DF1_NUM_STATE;
+		in = y;
+	}
+}
+
 #endif
@@ -122,4 +122,187 @@ int32_t iir_df1(struct iir_state_df1 *iir, int32_t x)
 	return out;
 }
 
+/* Block processing of a series cascade. The biquads are run one at a time
+ * over the whole block so each section state stays in AE registers
+ * across the block. The output of a section overwrites y[] and is the
+ * input of the next one. A topology with parallel sections uses the
+ * sample by sample version.
+ */
+void iir_df1_block(struct iir_state_df1 *iir, const int32_t *x, int32_t *y,
+		   int frames, int stride)
+{
+	ae_int64 acc;
+	ae_int32x2 coef_a2a1;
+	ae_int32x2 coef_b2b1;
+	ae_int32x2 coef_b0;
+	ae_int32x2 gain;
+	ae_int32x2 delay_y2y1;
+	ae_int32x2 delay_x2x1;
+	ae_int32x2 in;
+	ae_int32x2 tmp;
+	ae_int32 *src;
+	ae_int32 *dst;
+	int32_t *coefp = iir->coef;
+	int32_t *delay = iir->delay;
+	const int inc = stride * sizeof(int32_t);
+	int shift;
+	int i;
+	int j;
+
+	/* Bypass is set with number of biquads set to zero. */
+	if (!iir->biquads) {
+		if (x != y)
+			for (i = 0; i < frames; i++)
+				y[i * stride] = x[i * stride];
+
+		return;
+	}
+
+	if (iir->biquads != iir->biquads_in_series) {
+		for (i = 0; i < frames; i++)
+			y[i * stride] = iir_df1(iir, x[i * stride]);
+
+		return;
+	}
+
+	src = (ae_int32 *)x;
+	for (j = 0; j < iir->biquads; j++) {
+		/* Coefficients order in coef[] is {a2, a1, b2, b1, b0, shift, gain} */
+		coef_a2a1 = AE_MOVDA32X2(coefp[0], coefp[1]);
+		coef_b2b1 = AE_MOVDA32X2(coefp[2], coefp[3]);
+		coef_b0 = AE_MOVDA32(coefp[4]);
+		shift = coefp[5];
+		gain = AE_MOVDA32(coefp[6]);
+		delay_y2y1 = AE_MOVDA32X2(delay[0], delay[1]);
+		delay_x2x1 = AE_MOVDA32X2(delay[2], delay[3]);
+		dst = (ae_int32 *)y;
+		for (i = 0; i < frames; i++) {
+			AE_L32_XP(in, src, inc);
+			acc = AE_MULF32R_HH(coef_a2a1, delay_y2y1); /* a2 * y(n - 2) */
+			AE_MULAF32R_LL(acc, coef_a2a1, delay_y2y1); /* a1 * y(n - 1) */
+			AE_MULAF32R_HH(acc, coef_b2b1, delay_x2x1); /* b2 * x(n - 2) */
+			AE_MULAF32R_LL(acc, coef_b2b1, delay_x2x1); /* b1 * x(n - 1) */
+			AE_MULAF32R_HH(acc, coef_b0, in); /*  b0 * x  */
+			acc = AE_SLAI64S(acc, 1); /* Convert to Q17.47 */
+			tmp = AE_ROUND32F48SSYM(acc); /* Round to Q1.31 */
+
+			/* Shift the state, new values go to the low lane */
+			delay_y2y1 = AE_SEL32_LL(delay_y2y1, tmp);
+			delay_x2x1 = AE_SEL32_LL(delay_x2x1, in);
+
+			/* Apply gain Q18.14 x Q1.31 -> Q34.30 */
+			acc = AE_MULF32R_HH(gain, tmp); /* Gain */
+			acc = AE_SLAI64S(acc, 17); /* Convert to Q17.47 */
+			acc = AE_SRAA64(acc, shift);
+			AE_S32_L_XP(AE_ROUND32F48SSYM(acc), dst, inc);
+		}
+
+		delay[0] = AE_MOVAD32_H(delay_y2y1);
+		delay[1] = AE_MOVAD32_L(delay_y2y1);
+		delay[2] = AE_MOVAD32_H(delay_x2x1);
+		delay[3] = AE_MOVAD32_L(delay_x2x1);
+		coefp += SOF_EQ_IIR_NBIQUAD;
+		delay += IIR_DF1_NUM_STATE;
+		src = (ae_int32 *)y;
+	}
+}
+
+/* Two channels with the same topology as the high and low lanes of the
+ * AE registers, the channels are adjacent in the interleaved x[] and y[].
+ */
+void iir_df1_block_x2(struct iir_state_df1 *iir0, struct iir_state_df1 *iir1,
+		      const int32_t *x, int32_t *y, int frames, int stride)
+{
+	ae_int64 acc0, acc1;
+	ae_int32x2 a2, a1, b2, b1, b0, gain;
+	ae_int32x2 y2, y1, x2, x1;
+	ae_int32x2 in0, in1;
+	ae_int32x2 in;
+	ae_int32x2 tmp;
+	ae_int32x2 out;
+	ae_int32 *src;
+	ae_int32 *dst;
+	int32_t *c0 = iir0->coef;
+	int32_t *c1 = iir1->coef;
+	int32_t *d0 = iir0->delay;
+	int32_t *d1 = iir1->delay;
+	const int inc = stride * sizeof(int32_t);
+	int shift0, shift1;
+	int i;
+	int j;
+
+	if (iir0->biquads != iir1->biquads || !iir0->biquads ||
+	    iir0->biquads != iir0->biquads_in_series ||
+	    iir1->biquads != iir1->biquads_in_series) {
+		iir_df1_block(iir0, x, y, frames, stride);
+		iir_df1_block(iir1, x + 1, y + 1, frames, stride);
+		return;
+	}
+
+	src = (ae_int32 *)x;
+	for (j = 0; j < iir0->biquads; j++) {
+		/* Channel 0 is in the high lane and channel 1 in the low lane */
+		a2 = AE_MOVDA32X2(c0[0], c1[0]);
+		a1 = AE_MOVDA32X2(c0[1], c1[1]);
+		b2 = AE_MOVDA32X2(c0[2], c1[2]);
+		b1 = AE_MOVDA32X2(c0[3], c1[3]);
+		b0 = AE_MOVDA32X2(c0[4], c1[4]);
+		shift0 = c0[5];
+		shift1 = c1[5];
+		gain = AE_MOVDA32X2(c0[6], c1[6]);
+		y2 = AE_MOVDA32X2(d0[0], d1[0]);
+		y1 = AE_MOVDA32X2(d0[1], d1[1]);
+		x2 = AE_MOVDA32X2(d0[2], d1[2]);
+		x1 = AE_MOVDA32X2(d0[3], d1[3]);
+		dst = (ae_int32 *)y;
+		for (i = 0; i < frames; i++) {
+			in0 = AE_L32_X(src, 0);
+			in1 = AE_L32_X(src, sizeof(int32_t));
+			src = (ae_int32 *)((int32_t *)src + stride);
+			in = AE_SEL32_HH(in0, in1);
+
+			acc0 = AE_MULF32R_HH(a2, y2);
+			acc1 = AE_MULF32R_LL(a2, y2);
+			AE_MULAF32R_HH(acc0, a1, y1);
+			AE_MULAF32R_LL(acc1, a1, y1);
+			AE_MULAF32R_HH(acc0, b2, x2);
+			AE_MULAF32R_LL(acc1, b2, x2);
+			AE_MULAF32R_HH(acc0, b1, x1);
+			AE_MULAF32R_LL(acc1, b1, x1);
+			AE_MULAF32R_HH(acc0, b0, in);
+			AE_MULAF32R_LL(acc1, b0, in);
+			acc0 = AE_SLAI64S(acc0, 1);
+			acc1 = AE_SLAI64S(acc1, 1);
+			tmp = AE_ROUND32X2F48SSYM(acc0, acc1);
+			y2 = y1;
+			y1 = tmp;
+			x2 = x1;
+			x1 = in;
+
+			acc0 = AE_MULF32R_HH(gain, tmp);
+			acc1 = AE_MULF32R_LL(gain, tmp);
+			acc0 = AE_SRAA64(AE_SLAI64S(acc0, 17), shift0);
+			acc1 = AE_SRAA64(AE_SLAI64S(acc1, 17), shift1);
+			out = AE_ROUND32X2F48SSYM(acc0, acc1);
+			AE_S32_L_X(AE_SEL32_HH(out, out), dst, 0);
+			AE_S32_L_X(out, dst, sizeof(int32_t));
+			dst = (ae_int32 *)((int32_t *)dst + stride);
+		}
+
+		d0[0] = AE_MOVAD32_H(y2);
+		d1[0] = AE_MOVAD32_L(y2);
+		d0[1] = AE_MOVAD32_H(y1);
+		d1[1] = AE_MOVAD32_L(y1);
+		d0[2] = AE_MOVAD32_H(x2);
+		d1[2] = AE_MOVAD32_L(x2);
+		d0[3] = AE_MOVAD32_H(x1);
+		d1[3] = AE_MOVAD32_L(x1);
+		c0 += SOF_EQ_IIR_NBIQUAD;
+		c1 += SOF_EQ_IIR_NBIQUAD;
+		d0 += IIR_DF1_NUM_STATE;
+		d1 += IIR_DF1_NUM_STATE;
+		src = (ae_int32 *)y;
+	}
+}
+
 #endif
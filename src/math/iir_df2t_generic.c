@@ -105,4 +105,125 @@ int32_t iir_df2t(struct iir_state_df2t *iir, int32_t x)
 	return out;
 }
 
+/* Block processing of a series cascade. The biquads are run one at a time
+ * over the whole block so each section state stays in local variables
+ * across the block. The output of a section overwrites y[] and is the
+ * input of the next one. A topology with parallel sections uses the
+ * sample by sample version.
+ */
+void iir_df2t_block(struct iir_state_df2t *iir, const int32_t *x, int32_t *y,
+		    int frames, int stride)
+{
+	const int32_t *in = x;
+	int32_t *coefp = iir->coef;
+	int64_t *delay = iir->delay;
+	int64_t acc;
+	int64_t d0, d1;
+	int32_t tmp;
+	int32_t s;
+	int shift;
+	int i;
+	int j;
+
+	/* Bypass is set with number of biquads set to zero. */
+	if (!iir->biquads) {
+		if (x != y)
+			for (i = 0; i < frames; i++)
+				y[i * stride] = x[i * stride];
+
+		return;
+	}
+
+	if (iir->biquads != iir->biquads_in_series) {
+		for (i = 0; i < frames; i++)
+			y[i * stride] = iir_df2t(iir, x[i * stride]);
+
+		return;
+	}
+
+	for (j = 0; j < iir->biquads; j++) {
+		d0 = delay[0];
+		d1 = delay[1];
+		shift = 45 + coefp[5];
+		for (i = 0; i < frames * stride; i += stride) {
+			s = in[i];
+			acc = ((int64_t)coefp[4]) * s + d0; /* Coef b0 */
+			tmp = (int32_t)sat_int32(Q_SHIFT_RND(acc, 61, 31));
+			d0 = d1 + ((int64_t)coefp[3]) * s + ((int64_t)coefp[1]) * tmp;
+			d1 = ((int64_t)coefp[2]) * s + ((int64_t)coefp[0]) * tmp;
+			acc = ((int64_t)coefp[6]) * tmp; /* Gain */
+			y[i] = sat_int32(Q_SHIFT_RND(acc, shift, 31));
+		}
+
+		delay[0] = d0;
+		delay[1] = d1;
+		coefp += SOF_EQ_IIR_NBIQUAD;
+		delay += IIR_DF2T_NUM_DELAYS;
+		in = y;
+	}
+}
+
+/* Two channels with the same topology as lanes of one loop, the channels
+ * are adjacent in the interleaved x[] and y[].
+ */
+void iir_df2t_block_x2(struct iir_state_df2t *iir0, struct iir_state_df2t *iir1,
+		       const int32_t *x, int32_t *y, int frames, int stride)
+{
+	const int32_t *in = x;
+	int32_t *c0 = iir0->coef;
+	int32_t *c1 = iir1->coef;
+	int64_t *dp0 = iir0->delay;
+	int64_t *dp1 = iir1->delay;
+	int64_t acc0, acc1;
+	int64_t d0_0, d1_0, d0_1, d1_1;
+	int32_t s0, s1;
+	int32_t tmp0, tmp1;
+	int shift0, shift1;
+	int i;
+	int j;
+
+	if (iir0->biquads != iir1->biquads || !iir0->biquads ||
+	    iir0->biquads != iir0->biquads_in_series ||
+	    iir1->biquads != iir1->biquads_in_series) {
+		iir_df2t_block(iir0, x, y, frames, stride);
+		iir_df2t_block(iir1, x + 1, y + 1, frames, stride);
+		return;
+	}
+
+	for (j = 0; j < iir0->biquads; j++) {
+		d0_0 = dp0[0];
+		d1_0 = dp0[1];
+		d0_1 = dp1[0];
+		d1_1 = dp1[1];
+		shift0 = 45 + c0[5];
+		shift1 = 45 + c1[5];
+		for (i = 0; i < frames * stride; i += stride) {
+			s0 = in[i];
+			s1 = in[i + 1];
+			acc0 = ((int64_t)c0[4]) * s0 + d0_0;
+			acc1 = ((int64_t)c1[4]) * s1 + d0_1;
+			tmp0 = (int32_t)sat_int32(Q_SHIFT_RND(acc0, 61, 31));
+			tmp1 = (int32_t)sat_int32(Q_SHIFT_RND(acc1, 61, 31));
+			d0_0 = d1_0 + ((int64_t)c0[3]) * s0 + ((int64_t)c0[1]) * tmp0;
+			d0_1 = d1_1 + ((int64_t)c1[3]) * s1 + ((int64_t)c1[1]) * tmp1;
+			d1_0 = ((int64_t)c0[2]) * s0 + ((int64_t)c0[0]) * tmp0;
+			d1_1 = ((int64_t)c1[2]) * s1 + ((int64_t)c1[0]) * tmp1;
+			acc0 = ((int64_t)c0[6]) * tmp0;
+			acc1 = ((int64_t)c1[6]) * tmp1;
+			y[i] = sat_int32(Q_SHIFT_RND(acc0, shift0, 31));
+			y[i + 1] = sat_int32(Q_SHIFT_RND(acc1, shift1, 31));
+		}
+
+		dp0[0] = d0_0;
+		dp0[1] = d1_0;
+		dp1[0] = d0_1;
+		dp1[1] = d1_1;
+		c0 += SOF_EQ_IIR_NBIQUAD;
+		c1 += SOF_EQ_IIR_NBIQUAD;
+		dp0 += IIR_DF2T_NUM_DELAYS;
+		dp1 += IIR_DF2T_NUM_DELAYS;
+		in = y;
+	}
+}
+
 #endif
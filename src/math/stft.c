@@ -0,0 +1,502 @@
+// SPDX-License-Identifier: BSD-3-Clause
+//
+// Copyright(c) 2023 Intel Corporation. All rights reserved.
+
+/* Short-time Fourier transform analysis and synthesis. The analysis frames
+ * are read in place from a circular buffer that keeps the frame history, so
+ * the overlapping part of the frame is not copied around between hops. The
+ * frames are normalized with a block exponent before the FFT to make best
+ * use of the FFT word length.
+ */
+
+#include <sof/audio/audio_stream.h>
+#include <sof/audio/format.h>
+#include <sof/math/fft.h>
+#include <sof/math/numbers.h>
+#include <sof/math/stft.h>
+#include <rtos/alloc.h>
+#include <rtos/string.h>
+#include <ipc/topology.h>
+#include <errno.h>
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+static void stft_init_buffer(struct stft_buffer *buf, int32_t *base, int size)
+{
+	buf->addr = base;
+	buf->end_addr = base + size;
+	buf->r_ptr = base;
+	buf->w_ptr = base;
+	buf->s_free = size;
+	buf->s_avail = 0;
+	buf->s_length = size;
+}
+
+int stft_plan_init(struct stft_plan *st, int frame_size, int hop_size, int fft_bits,
+		   int max_frames, const int16_t *window, bool synthesis)
+{
+	int64_t sum = 0;
+	int64_t power;
+	size_t bytes;
+	int ibuf_size;
+	int obuf_size = 0;
+	int overlap_size = 0;
+	int ret;
+	int i;
+
+	if (frame_size < 1 || frame_size > FFT_SIZE_MAX || hop_size < 1 ||
+	    hop_size > frame_size || max_frames < 1 || !window)
+		return -EINVAL;
+
+	switch (fft_bits) {
+#if CONFIG_MATH_16BIT_FFT
+	case 16:
+		bytes = sizeof(struct icomplex16);
+		break;
+#endif
+#if CONFIG_MATH_32BIT_FFT
+	case 32:
+		bytes = sizeof(struct icomplex32);
+		break;
+#endif
+	default:
+		return -EINVAL;
+	}
+
+	st->frame_size = frame_size;
+	st->hop_size = hop_size;
+	st->fft_bits = fft_bits;
+	st->fft_padded_size = 1 << (31 - norm_int32(frame_size - 1)); /* Round up to 2^N */
+
+	st->fft_buffer_size = st->fft_padded_size * bytes;
+	st->window = window;
+	st->max_shift = STFT_NORMALIZE_MAX_SHIFT;
+	st->ifft_plan = NULL;
+
+	/* The input keeps a frame of history plus the new samples of one call, and
+	 * the output a hop plus the samples consumed by one call.
+	 */
+	ibuf_size = frame_size + max_frames;
+	if (synthesis) {
+		obuf_size = hop_size + max_frames;
+		overlap_size = frame_size;
+	}
+
+	st->buffers = rzalloc(SOF_MEM_ZONE_RUNTIME, 0, SOF_MEM_CAPS_RAM,
+			      sizeof(int32_t) * (ibuf_size + obuf_size + overlap_size));
+	if (!st->buffers)
+		return -ENOMEM;
+
+	stft_init_buffer(&st->ibuf, st->buffers, ibuf_size);
+	stft_init_buffer(&st->obuf, st->buffers + ibuf_size, obuf_size);
+	st->overlap = synthesis ? st->buffers + ibuf_size + obuf_size : NULL;
+
+	st->fft_buf = rzalloc(SOF_MEM_ZONE_RUNTIME, 0, SOF_MEM_CAPS_RAM, st->fft_buffer_size);
+	if (!st->fft_buf) {
+		ret = -ENOMEM;
+		goto free_buffers;
+	}
+
+	st->fft_out = rzalloc(SOF_MEM_ZONE_RUNTIME, 0, SOF_MEM_CAPS_RAM, st->fft_buffer_size);
+	if (!st->fft_out) {
+		ret = -ENOMEM;
+		goto free_fft_buf;
+	}
+
+	st->fft_plan = fft_plan_new(st->fft_buf, st->fft_out, st->fft_padded_size, fft_bits);
+	if (!st->fft_plan) {
+		ret = -ENOMEM;
+		goto free_fft_out;
+	}
+
+	if (synthesis) {
+		st->ifft_plan = fft_plan_new(st->fft_out, st->fft_buf, st->fft_padded_size,
+					     fft_bits);
+		if (!st->ifft_plan) {
+			ret = -ENOMEM;
+			goto free_fft_plan;
+		}
+
+		/* The overlapping windowed frames sum to the mean of window squared
+		 * times frame_size / hop_size. Normalize the overlap-add with the
+		 * inverse of it.
+		 */
+		for (i = 0; i < frame_size; i++)
+			sum += (int32_t)window[i] * window[i]; /* Q2.30 */
+
+		power = sum / hop_size;
+		if (!power) {
+			ret = -EINVAL;
+			goto free_ifft_plan;
+		}
+
+		st->synth_gain = sat_int32(((int64_t)1 << 60) / power); /* Q2.30 */
+	}
+
+	stft_reset(st);
+	return 0;
+
+free_ifft_plan:
+	fft_plan_free(st->ifft_plan);
+
+free_fft_plan:
+	fft_plan_free(st->fft_plan);
+
+free_fft_out:
+	rfree(st->fft_out);
+
+free_fft_buf:
+	rfree(st->fft_buf);
+
+free_buffers:
+	rfree(st->buffers);
+	return ret;
+}
+
+void stft_plan_free(struct stft_plan *st)
+{
+	fft_plan_free(st->fft_plan);
+	fft_plan_free(st->ifft_plan);
+	rfree(st->fft_buf);
+	rfree(st->fft_out);
+	rfree(st->buffers);
+	st->fft_plan = NULL;
+	st->ifft_plan = NULL;
+	st->fft_buf = NULL;
+	st->fft_out = NULL;
+	st->buffers = NULL;
+}
+
+void stft_reset(struct stft_plan *st)
+{
+	int i;
+
+	stft_init_buffer(&st->ibuf, st->ibuf.addr, st->ibuf.s_length);
+	stft_init_buffer(&st->obuf, st->obuf.addr, st->obuf.s_length);
+	if (st->overlap) {
+		for (i = 0; i < st->frame_size; i++)
+			st->overlap[i] = 0;
+	}
+
+	st->input_shift = 0;
+}
+
+/* Returns the left shift that normalizes the frame peak without overflow */
+static int stft_frame_shift(struct stft_plan *st)
+{
+	struct stft_buffer *buf = &st->ibuf;
+	int32_t *r = buf->r_ptr;
+	int32_t smax = 0;
+	int32_t x;
+	int copied;
+	int shift;
+	int n;
+	int j;
+
+	for (copied = 0; copied < st->frame_size; copied += n) {
+		n = stft_buffer_samples_without_wrap(buf, r);
+		n = MIN(n, st->frame_size - copied);
+		for (j = 0; j < n; j++) {
+			/* One's complement is enough for the norm of negative values */
+			x = r[j] ^ (r[j] >> 31);
+			smax = MAX(smax, x);
+		}
+
+		r = stft_buffer_wrap(buf, r + n);
+	}
+
+	shift = norm_int32(smax);
+	return MIN(shift, st->max_shift);
+}
+
+bool stft_analysis(struct stft_plan *st)
+{
+	struct stft_buffer *buf = &st->ibuf;
+	const int16_t *w = st->window;
+	int32_t *r = buf->r_ptr;
+	int copied;
+	int shift;
+	int idx = 0;
+	int n;
+	int j;
+
+	/* The first frame is analyzed once the whole frame is filled with valid
+	 * data, after that once per hop of new data.
+	 */
+	if (buf->s_avail < st->frame_size)
+		return false;
+
+	shift = st->max_shift > 0 ? stft_frame_shift(st) : 0;
+	st->input_shift = shift;
+
+	/* Clear FFT input buffer because it may have been used as scratch, the
+	 * imaginary part and the padding remain zero.
+	 */
+	bzero(st->fft_buf, st->fft_buffer_size);
+
+	/* Window the frame into FFT input */
+	for (copied = 0; copied < st->frame_size; copied += n) {
+		n = stft_buffer_samples_without_wrap(buf, r);
+		n = MIN(n, st->frame_size - copied);
+#if CONFIG_MATH_16BIT_FFT
+		if (st->fft_bits == 16) {
+			struct icomplex16 *fft16 = st->fft_buf;
+
+			for (j = 0; j < n; j++)
+				fft16[idx + j].real =
+					sat_int16(Q_MULTSR_32X32((int64_t)(r[j] << shift),
+								 w[idx + j], 31, 15, 15));
+		}
+#endif
+#if CONFIG_MATH_32BIT_FFT
+		if (st->fft_bits == 32) {
+			struct icomplex32 *fft32 = st->fft_buf;
+
+			for (j = 0; j < n; j++)
+				fft32[idx + j].real =
+					sat_int32(Q_MULTSR_32X32((int64_t)(r[j] << shift),
+								 w[idx + j], 31, 15, 31));
+		}
+#endif
+		idx += n;
+		r = stft_buffer_wrap(buf, r + n);
+	}
+
+	/* Advance a hop, the rest of the frame is the overlap of next frame */
+	buf->r_ptr = stft_buffer_wrap(buf, buf->r_ptr + st->hop_size);
+	buf->s_avail -= st->hop_size;
+	buf->s_free += st->hop_size;
+
+	/* The FFT out buffer needs to be cleared to avoid to corrupt the output */
+	bzero(st->fft_out, st->fft_buffer_size);
+
+#if CONFIG_MATH_16BIT_FFT
+	if (st->fft_bits == 16)
+		fft_execute_16(st->fft_plan, false);
+#endif
+#if CONFIG_MATH_32BIT_FFT
+	if (st->fft_bits == 32)
+		fft_execute_32(st->fft_plan, false);
+#endif
+
+	return true;
+}
+
+void stft_synthesis(struct stft_plan *st)
+{
+	struct stft_buffer *buf = &st->obuf;
+	const int qy = 31 - st->input_shift;
+	int32_t *w = buf->w_ptr;
+	int32_t s;
+	int copied;
+	int nmax;
+	int n;
+	int j;
+
+	/* The inverse transform output is the windowed frame scaled by the block
+	 * exponent of analysis.
+	 */
+	bzero(st->fft_buf, st->fft_buffer_size);
+
+#if CONFIG_MATH_16BIT_FFT
+	if (st->fft_bits == 16) {
+		struct icomplex16 *fft16 = st->fft_buf;
+
+		fft_execute_16(st->ifft_plan, true);
+		for (j = 0; j < st->frame_size; j++) {
+			s = Q_MULTSR_32X32((int64_t)fft16[j].real << 16, st->window[j],
+					   31, 15, 31);
+			s = Q_MULTSR_32X32((int64_t)s, st->synth_gain, 31, 30, qy);
+			st->overlap[j] = sat_int32((int64_t)st->overlap[j] + s);
+		}
+	}
+#endif
+#if CONFIG_MATH_32BIT_FFT
+	if (st->fft_bits == 32) {
+		struct icomplex32 *fft32 = st->fft_buf;
+
+		fft_execute_32(st->ifft_plan, true);
+		for (j = 0; j < st->frame_size; j++) {
+			s = Q_MULTSR_32X32((int64_t)fft32[j].real, st->window[j], 31, 15, 31);
+			s = Q_MULTSR_32X32((int64_t)s, st->synth_gain, 31, 30, qy);
+			st->overlap[j] = sat_int32((int64_t)st->overlap[j] + s);
+		}
+	}
+#endif
+
+	/* The first hop of overlap-add is complete, move it to output. If the
+	 * user has not consumed the output the samples that don't fit are lost.
+	 */
+	nmax = MIN(st->hop_size, buf->s_free);
+	for (copied = 0; copied < nmax; copied += n) {
+		n = stft_buffer_samples_without_wrap(buf, w);
+		n = MIN(n, nmax - copied);
+		for (j = 0; j < n; j++)
+			w[j] = st->overlap[copied + j];
+
+		w = stft_buffer_wrap(buf, w + n);
+	}
+
+	buf->w_ptr = w;
+	buf->s_avail += copied;
+	buf->s_free -= copied;
+
+	for (j = 0; j < st->frame_size - st->hop_size; j++)
+		st->overlap[j] = st->overlap[j + st->hop_size];
+
+	for (; j < st->frame_size; j++)
+		st->overlap[j] = 0;
+}
+
+void stft_input_s16(struct stft_plan *st, const struct audio_stream __sparse_cache *source,
+		    const int16_t *x, int frames, int channel)
+{
+	struct stft_buffer *buf = &st->ibuf;
+	const int16_t *x0;
+	int32_t *w = buf->w_ptr;
+	const int nch = audio_stream_get_channels(source);
+	int copied;
+	int nmax;
+	int n;
+	int i;
+
+	for (copied = 0; copied < frames; copied += n) {
+		nmax = frames - copied;
+		n = audio_stream_frames_without_wrap(source, x);
+		n = MIN(n, nmax);
+		nmax = stft_buffer_samples_without_wrap(buf, w);
+		n = MIN(n, nmax);
+		x0 = x + channel;
+		for (i = 0; i < n; i++) {
+			w[i] = (int32_t)*x0 << 16;
+			x0 += nch;
+		}
+
+		x = audio_stream_wrap(source, (int16_t *)x + n * nch);
+		w = stft_buffer_wrap(buf, w + n);
+	}
+
+	buf->s_avail += copied;
+	buf->s_free -= copied;
+	buf->w_ptr = w;
+}
+
+void stft_input_s32(struct stft_plan *st, const struct audio_stream __sparse_cache *source,
+		    const int32_t *x, int frames, int channel)
+{
+	struct stft_buffer *buf = &st->ibuf;
+	const int32_t *x0;
+	int32_t *w = buf->w_ptr;
+	const int nch = audio_stream_get_channels(source);
+	int copied;
+	int nmax;
+	int n;
+	int i;
+
+	for (copied = 0; copied < frames; copied += n) {
+		nmax = frames - copied;
+		n = audio_stream_frames_without_wrap(source, x);
+		n = MIN(n, nmax);
+		nmax = stft_buffer_samples_without_wrap(buf, w);
+		n = MIN(n, nmax);
+		x0 = x + channel;
+		for (i = 0; i < n; i++) {
+			w[i] = *x0;
+			x0 += nch;
+		}
+
+		x = audio_stream_wrap(source, (int32_t *)x + n * nch);
+		w = stft_buffer_wrap(buf, w + n);
+	}
+
+	buf->s_avail += copied;
+	buf->s_free -= copied;
+	buf->w_ptr = w;
+}
+
+void stft_output_s16(struct stft_plan *st, const struct audio_stream __sparse_cache *sink,
+		     int16_t *y, int frames, int channel)
+{
+	struct stft_buffer *buf = &st->obuf;
+	int32_t *r = buf->r_ptr;
+	int16_t *y0;
+	const int nch = audio_stream_get_channels(sink);
+	const int avail = MIN(frames, buf->s_avail);
+	int copied;
+	int nmax;
+	int n;
+	int i;
+
+	for (copied = 0; copied < frames; copied += n) {
+		nmax = frames - copied;
+		n = audio_stream_frames_without_wrap(sink, y);
+		n = MIN(n, nmax);
+		y0 = y + channel;
+		if (copied < avail) {
+			nmax = stft_buffer_samples_without_wrap(buf, r);
+			n = MIN(n, nmax);
+			n = MIN(n, avail - copied);
+			for (i = 0; i < n; i++) {
+				*y0 = sat_int16(Q_SHIFT_RND(r[i], 31, 15));
+				y0 += nch;
+			}
+
+			r = stft_buffer_wrap(buf, r + n);
+		} else {
+			for (i = 0; i < n; i++) {
+				*y0 = 0;
+				y0 += nch;
+			}
+		}
+
+		y = audio_stream_wrap(sink, y + n * nch);
+	}
+
+	buf->s_avail -= avail;
+	buf->s_free += avail;
+	buf->r_ptr = r;
+}
+
+void stft_output_s32(struct stft_plan *st, const struct audio_stream __sparse_cache *sink,
+		     int32_t *y, int frames, int channel)
+{
+	struct stft_buffer *buf = &st->obuf;
+	int32_t *r = buf->r_ptr;
+	int32_t *y0;
+	const int nch = audio_stream_get_channels(sink);
+	const int avail = MIN(frames, buf->s_avail);
+	int copied;
+	int nmax;
+	int n;
+	int i;
+
+	for (copied = 0; copied < frames; copied += n) {
+		nmax = frames - copied;
+		n = audio_stream_frames_without_wrap(sink, y);
+		n = MIN(n, nmax);
+		y0 = y + channel;
+		if (copied < avail) {
+			nmax = stft_buffer_samples_without_wrap(buf, r);
+			n = MIN(n, nmax);
+			n = MIN(n, avail - copied);
+			for (i = 0; i < n; i++) {
+				*y0 = r[i];
+				y0 += nch;
+			}
+
+			r = stft_buffer_wrap(buf, r + n);
+		} else {
+			for (i = 0; i < n; i++) {
+				*y0 = 0;
+				y0 += nch;
+			}
+		}
+
+		y = audio_stream_wrap(sink, y + n * nch);
+	}
+
+	buf->s_avail -= avail;
+	buf->s_free += avail;
+	buf->r_ptr = r;
+}
@@ -78,6 +78,23 @@ struct probe_dma_ext {
 	struct dma_copy dc;		/**< DMA copy */
 };
 
+#if CONFIG_IPC_MAJOR_4
+/* bytes staged on stack between copies to the probe buffer */
+#define PROBE_EXTRACT_CHUNK	256
+/* largest encoded sample, a 32 bit varint */
+#define PROBE_EXTRACT_SAMPLE_MAX	5
+
+/**
+ * Extraction options of a probe point and their state
+ */
+struct probe_extract_cfg {
+	uint32_t channel_mask;	/**< channels to extract, 0 for all */
+	uint32_t decimation;	/**< extract one frame of this many */
+	uint32_t flags;		/**< PROBE_OPTION_xxx */
+	uint32_t skip;		/**< frames to drop before the next extracted one */
+};
+#endif
+
 /**
  * Probe main struct
  */
@@ -85,6 +102,9 @@ struct probe_pdata {
 	struct probe_dma_ext ext_dma;				  /**< extraction DMA */
 	struct probe_dma_ext inject_dma[CONFIG_PROBE_DMA_MAX];	  /**< injection DMA */
 	struct probe_point probe_points[CONFIG_PROBE_POINTS_MAX]; /**< probe points */
+#if CONFIG_IPC_MAJOR_4
+	struct probe_extract_cfg ext_cfg[CONFIG_PROBE_POINTS_MAX]; /**< extraction options */
+#endif
 	struct probe_data_packet header;			  /**< data packet header */
 	struct task dmap_work;					  /**< probe task */
 };
@@ -688,16 +708,14 @@ static int copy_from_pbuffer(struct probe_dma_buf *pbuf, void *data,
 }
 
 /**
- * \brief Generate probe data packet header, update timestamp, calc crc
- *	  and copy data to probe buffer.
+ * \brief Fill probe data packet header, update timestamp and calc crc.
  * \param[in] buffer_id component buffer id
  * \param[in] size data size.
  * \param[in] format audio format.
  * \param[out] checksum.
- * \return 0 on success, error code otherwise.
  */
-static int probe_gen_header(uint32_t buffer_id, uint32_t size,
-			    uint32_t format, uint64_t *checksum)
+static void probe_fill_header(uint32_t buffer_id, uint32_t size,
+			      uint32_t format, uint64_t *checksum)
 {
 	struct probe_pdata *_probe = probe_get();
 	struct probe_data_packet *header;
@@ -722,8 +740,25 @@ static int probe_gen_header(uint32_t buffer_id, uint32_t size,
 		    header->data_size_bytes;
 
 	dcache_writeback_region((__sparse_force void __sparse_cache *)header, sizeof(*header));
+}
 
-	return copy_to_pbuffer(&_probe->ext_dma.dmapb, header,
+/**
+ * \brief Generate probe data packet header, update timestamp, calc crc
+ *	  and copy data to probe buffer.
+ * \param[in] buffer_id component buffer id
+ * \param[in] size data size.
+ * \param[in] format audio format.
+ * \param[out] checksum.
+ * \return 0 on success, error code otherwise.
+ */
+static int probe_gen_header(uint32_t buffer_id, uint32_t size,
+			    uint32_t format, uint64_t *checksum)
+{
+	struct probe_pdata *_probe = probe_get();
+
+	probe_fill_header(buffer_id, size, format, checksum);
+
+	return copy_to_pbuffer(&_probe->ext_dma.dmapb, &_probe->header,
 			       sizeof(struct probe_data_packet));
 }
 
@@ -865,6 +900,222 @@ static void probe_logging_hook(uint8_t *buffer, size_t length)
 }
 #endif
 
+#if CONFIG_IPC_MAJOR_4
+/**
+ * \brief Overwrite data already copied to probe buffer.
+ * \param[in,out] pbuf DMA buffer.
+ * \param[in] at position where the data was copied, may be past the end.
+ * \param[in] data pointer.
+ * \param[in] bytes size.
+ * \return 0 on success, error code otherwise.
+ */
+static int pbuffer_rewrite(struct probe_dma_buf *pbuf, uintptr_t at, void *data,
+			   uint32_t bytes)
+{
+	uint32_t head;
+	uint32_t tail;
+
+	if (at >= pbuf->end_addr)
+		at -= pbuf->size;
+
+	head = MIN(bytes, (uint32_t)(pbuf->end_addr - at));
+	tail = bytes - head;
+
+	if (memcpy_s((void *)at, pbuf->end_addr - at, data, head)) {
+		tr_err(&pr_tr, "pbuffer_rewrite(): memcpy_s() failed");
+		return -EINVAL;
+	}
+	dcache_writeback_region((__sparse_force void __sparse_cache *)at, head);
+
+	if (tail) {
+		if (memcpy_s((void *)pbuf->addr, pbuf->size, (char *)data + head, tail)) {
+			tr_err(&pr_tr, "pbuffer_rewrite(): memcpy_s() failed");
+			return -EINVAL;
+		}
+		dcache_writeback_region((__sparse_force void __sparse_cache *)pbuf->addr, tail);
+	}
+
+	return 0;
+}
+
+/**
+ * \brief Read one sample of probed buffer, reduced to 16 bits if requested.
+ * \param[in] ptr sample pointer.
+ * \param[in] frame_fmt format of the probed buffer.
+ * \param[in] s16 true to reduce the sample to 16 bits.
+ * \return sample value.
+ */
+static int32_t probe_read_sample(const void *ptr, uint32_t frame_fmt, bool s16)
+{
+	switch (frame_fmt) {
+	case SOF_IPC_FRAME_S16_LE:
+		return *(const int16_t *)ptr;
+	case SOF_IPC_FRAME_S24_4LE:
+		if (s16)
+			return sign_extend_s24(*(const int32_t *)ptr) >> 8;
+		return *(const int32_t *)ptr;
+	case SOF_IPC_FRAME_S32_LE:
+		if (s16)
+			return *(const int32_t *)ptr >> 16;
+		return *(const int32_t *)ptr;
+	default:
+		return *(const int32_t *)ptr;
+	}
+}
+
+/**
+ * \brief Copy probed data to probe buffer as a data packet, with channels
+ *	  selected, frames decimated, samples reduced and compressed as set by
+ *	  the probe point options.
+ * \param[in] _probe probe main struct.
+ * \param[in,out] cfg extraction options of the probe point.
+ * \param[in] buffer probed buffer.
+ * \param[in] cb_data produce notification.
+ * \param[in] buffer_id probe point buffer id.
+ * \return 0 on success, error code otherwise.
+ */
+static int probe_extract_reduced(struct probe_pdata *_probe,
+				 struct probe_extract_cfg *cfg,
+				 struct comp_buffer __sparse_cache *buffer,
+				 struct buffer_cb_transact *cb_data,
+				 uint32_t buffer_id)
+{
+	struct audio_stream __sparse_cache *stream = &buffer->stream;
+	struct probe_dma_buf *pbuf = &_probe->ext_dma.dmapb;
+	uint32_t frame_fmt = audio_stream_get_frm_fmt(stream);
+	uint32_t channels = audio_stream_get_channels(stream);
+	uint32_t sample_bytes = audio_stream_sample_bytes(stream);
+	uint32_t frames = cb_data->transaction_amount / (channels * sample_bytes);
+	bool compress = cfg->flags & PROBE_OPTION_COMPRESS;
+	bool s16 = (cfg->flags & PROBE_OPTION_S16) && frame_fmt != SOF_IPC_FRAME_S16_LE &&
+		   frame_fmt != SOF_IPC_FRAME_FLOAT;
+	uint32_t out_bytes = s16 ? sizeof(int16_t) : sample_bytes;
+	int32_t prev[PLATFORM_MAX_CHANNELS] = { 0 };
+	uint8_t chunk[PROBE_EXTRACT_CHUNK];
+	uint32_t chunk_fill = 0;
+	uint32_t mask;
+	uint32_t out_channels;
+	uint32_t first = cfg->skip;
+	uint32_t kept;
+	uint32_t size;
+	uint32_t format;
+	uint32_t ch;
+	uint32_t i;
+	uintptr_t header_at;
+	uint64_t checksum;
+	uint32_t z;
+	int32_t d;
+	int32_t v;
+	char *ptr;
+	int ret;
+
+	if (!channels || channels > PLATFORM_MAX_CHANNELS)
+		return -EINVAL;
+
+	mask = MASK(channels - 1, 0);
+	if (cfg->channel_mask)
+		mask &= cfg->channel_mask;
+	out_channels = popcount(mask);
+
+	/* frames kept after the ones still to skip from the previous packet */
+	if (frames > cfg->skip) {
+		kept = (frames - cfg->skip - 1) / cfg->decimation + 1;
+		cfg->skip = cfg->skip + kept * cfg->decimation - frames;
+	} else {
+		kept = 0;
+		cfg->skip -= frames;
+	}
+
+	if (!kept || !out_channels)
+		return 0;
+
+	/* worst case size, varint takes up to 7 bits of the value a byte */
+	size = kept * out_channels * out_bytes;
+	if (compress)
+		size = kept * out_channels * ((out_bytes * 8 + 6) / 7);
+
+	if (pbuf->size - pbuf->avail <
+	    sizeof(struct probe_data_packet) + size + sizeof(checksum))
+		return -EINVAL;
+
+	format = probe_gen_format(s16 ? SOF_IPC_FRAME_S16_LE : frame_fmt,
+				  audio_stream_get_rate(stream), out_channels);
+	format |= ((uint32_t)compress << PROBE_SHIFT_COMPRESSION) & PROBE_MASK_COMPRESSION;
+	format |= ((cfg->decimation - 1) << PROBE_SHIFT_DECIMATION) & PROBE_MASK_DECIMATION;
+
+	/* size of compressed data is patched to the header once known */
+	header_at = pbuf->w_ptr;
+	ret = probe_gen_header(buffer_id, compress ? 0 : size, format, &checksum);
+	if (ret < 0)
+		return ret;
+
+	size = 0;
+	ptr = audio_stream_wrap(stream, (char *)cb_data->transaction_begin_address +
+				first * channels * sample_bytes);
+	for (i = 0; i < kept; i++) {
+		for (ch = 0; ch < channels; ch++) {
+			if (!(mask & BIT(ch))) {
+				ptr = audio_stream_wrap(stream, ptr + sample_bytes);
+				continue;
+			}
+
+			v = probe_read_sample(ptr, frame_fmt, s16);
+			ptr = audio_stream_wrap(stream, ptr + sample_bytes);
+
+			if (compress) {
+				/* zigzag of the delta wrapped to the output size */
+				d = out_bytes == sizeof(int16_t) ? (int16_t)(v - prev[ch]) :
+				    (int32_t)((uint32_t)v - prev[ch]);
+				prev[ch] = v;
+				z = ((uint32_t)d << 1) ^ (uint32_t)(d >> 31);
+				while (z >= 0x80) {
+					chunk[chunk_fill++] = (z & 0x7f) | 0x80;
+					z >>= 7;
+				}
+				chunk[chunk_fill++] = z;
+			} else {
+				chunk[chunk_fill++] = v;
+				chunk[chunk_fill++] = v >> 8;
+				if (out_bytes == sizeof(int32_t)) {
+					chunk[chunk_fill++] = v >> 16;
+					chunk[chunk_fill++] = v >> 24;
+				}
+			}
+
+			/* flush when next sample might not fit */
+			if (chunk_fill > sizeof(chunk) - PROBE_EXTRACT_SAMPLE_MAX) {
+				ret = copy_to_pbuffer(pbuf, chunk, chunk_fill);
+				if (ret < 0)
+					return ret;
+				size += chunk_fill;
+				chunk_fill = 0;
+			}
+		}
+
+		/* skip the decimated frames, none after the last kept one */
+		if (i + 1 < kept)
+			ptr = audio_stream_wrap(stream, ptr + (cfg->decimation - 1) *
+						channels * sample_bytes);
+	}
+
+	ret = copy_to_pbuffer(pbuf, chunk, chunk_fill);
+	if (ret < 0)
+		return ret;
+	size += chunk_fill;
+
+	if (compress) {
+		checksum += size;
+		ret = pbuffer_rewrite(pbuf, header_at +
+				      offsetof(struct probe_data_packet, data_size_bytes),
+				      &size, sizeof(size));
+		if (ret < 0)
+			return ret;
+	}
+
+	return copy_to_pbuffer(pbuf, &checksum, sizeof(checksum));
+}
+#endif
+
 /**
  * \brief General extraction probe callback, called from buffer produce.
  *	  It will search for probe point connected to this buffer.
@@ -903,6 +1154,20 @@ static void probe_cb_produce(void *arg, enum notify_id type, void *data)
 		return;
 	}
 
+#if CONFIG_IPC_MAJOR_4
+	if (_probe->probe_points[i].purpose == PROBE_PURPOSE_EXTRACTION &&
+	    (_probe->ext_cfg[i].channel_mask || _probe->ext_cfg[i].decimation > 1 ||
+	     _probe->ext_cfg[i].flags)) {
+		ret = probe_extract_reduced(_probe, &_probe->ext_cfg[i], buffer,
+					    cb_data, buffer_id);
+		if (ret < 0)
+			goto err;
+
+		kick_probe_task(_probe);
+		return;
+	}
+#endif
+
 	if (_probe->probe_points[i].purpose == PROBE_PURPOSE_EXTRACTION) {
 		format = probe_gen_format(audio_stream_get_frm_fmt(&buffer->stream),
 					  audio_stream_get_rate(&buffer->stream),
@@ -1281,6 +1546,9 @@ int probe_point_add(uint32_t count, const struct probe_point *probe)
 		_probe->probe_points[first_free].buffer_id = *buf_id;
 		_probe->probe_points[first_free].purpose = probe[i].purpose;
 		_probe->probe_points[first_free].stream_tag = stream_tag;
+#if CONFIG_IPC_MAJOR_4
+		_probe->ext_cfg[first_free] = (struct probe_extract_cfg){ .decimation = 1 };
+#endif
 
 		if (fw_logs) {
 #if CONFIG_LOG_BACKEND_SOF_PROBE
@@ -1450,6 +1718,59 @@ int probe_point_remove(uint32_t count, const uint32_t *buffer_id)
 }
 
 #if CONFIG_IPC_MAJOR_4
+/**
+ * \brief Set extraction options of probe points.
+ * \param[in] count number of options.
+ * \param[in] opts options, each for an extraction probe point already added.
+ * \return 0 on success, error code otherwise.
+ */
+static int probe_point_options(uint32_t count, const struct probe_point_options *opts)
+{
+	struct probe_pdata *_probe = probe_get();
+	struct probe_extract_cfg *cfg;
+	uint32_t i;
+	uint32_t j;
+
+	tr_dbg(&pr_tr, "probe_point_options() count = %u", count);
+
+	if (!_probe) {
+		tr_err(&pr_tr, "probe_point_options(): Not initialized.");
+		return -EINVAL;
+	}
+
+	for (i = 0; i < count; i++) {
+		tr_dbg(&pr_tr, "\tbuffer_id[%u] = %u, channel_mask = 0x%x, decimation = %u",
+		       i, opts[i].buffer_id.full_id, opts[i].channel_mask, opts[i].decimation);
+
+		if (opts[i].decimation > PROBE_DECIMATION_MAX) {
+			tr_err(&pr_tr, "probe_point_options(): Invalid decimation %u",
+			       opts[i].decimation);
+			return -EINVAL;
+		}
+
+		for (j = 0; j < CONFIG_PROBE_POINTS_MAX; j++)
+			if (_probe->probe_points[j].stream_tag != PROBE_POINT_INVALID &&
+			    _probe->probe_points[j].purpose == PROBE_PURPOSE_EXTRACTION &&
+			    _probe->probe_points[j].buffer_id.full_id ==
+			    opts[i].buffer_id.full_id)
+				break;
+
+		if (j == CONFIG_PROBE_POINTS_MAX) {
+			tr_err(&pr_tr, "probe_point_options(): No extraction probe point for buffer_id %u",
+			       opts[i].buffer_id.full_id);
+			return -EINVAL;
+		}
+
+		cfg = &_probe->ext_cfg[j];
+		cfg->channel_mask = opts[i].channel_mask;
+		cfg->decimation = MAX(opts[i].decimation, 1);
+		cfg->flags = opts[i].flags;
+		cfg->skip = 0;
+	}
+
+	return 0;
+}
+
 static struct comp_dev *probe_new(const struct comp_driver *drv,
 				  const struct comp_ipc_config *config, const void *spec)
 {
@@ -1500,6 +1821,9 @@ static int probe_set_large_config(struct comp_dev *dev, uint32_t param_id,
 				     (const struct probe_dma *)data);
 	case IPC4_PROBE_MODULE_INJECTION_DMA_DETACH:
 		return probe_dma_remove(data_offset / sizeof(uint32_t), (const uint32_t *)data);
+	case IPC4_PROBE_MODULE_PROBE_POINTS_OPTIONS:
+		return probe_point_options(data_offset / sizeof(struct probe_point_options),
+					   (const struct probe_point_options *)data);
 	default:
 		return -EINVAL;
 	}
@@ -10,6 +10,7 @@
 #include <sof/ipc/msg.h>
 #include <rtos/alloc.h>
 #include <rtos/cache.h>
+#include <rtos/interrupt.h>
 #include <sof/lib/cpu.h>
 #include <sof/lib/dma.h>
 #include <sof/lib/memory.h>
@@ -22,10 +23,12 @@
 #include <rtos/spinlock.h>
 #include <rtos/string.h>
 #include <sof/trace/dma-trace.h>
+#include <sof/trace/trace.h>
 #include <ipc/topology.h>
 #include <ipc/trace.h>
 #include <kernel/abi.h>
 #include <user/abi_dbg.h>
+#include <user/trace.h>
 #include <sof_versions.h>
 
 #ifdef __ZEPHYR__
@@ -52,6 +55,10 @@ static int dma_trace_get_avail_data(struct dma_trace_data *d,
 				    struct dma_trace_buf *buffer,
 				    int avail);
 
+#if CONFIG_TRACE_CORE_RINGS
+static void dtrace_rings_drain(struct dma_trace_data *d);
+#endif
+
 /** Periodically runs and starts the DMA even when the buffer is not
  * full.
  */
@@ -61,10 +68,16 @@ static enum task_state trace_work(void *data)
 	struct dma_trace_buf *buffer = &d->dmatb;
 	struct dma_sg_config *config = &d->config;
 	k_spinlock_key_t key;
-	uint32_t avail = buffer->avail;
+	uint32_t avail;
 	int32_t size;
 	uint32_t overflow;
 
+#if CONFIG_TRACE_CORE_RINGS
+	/* merge the events of all cores to the DMA trace buffer */
+	dtrace_rings_drain(d);
+#endif
+	avail = buffer->avail;
+
 	/* The host DMA channel is not available */
 	if (!d->dc.chan)
 		return SOF_TASK_STATE_RESCHEDULE;
@@ -157,6 +170,17 @@ int dma_trace_init_early(struct sof *sof)
 	dma_sg_init(&sof->dmat->config.elem_array);
 	k_spinlock_init(&sof->dmat->lock);
 
+#if CONFIG_TRACE_CORE_RINGS
+	/* written and read by different cores, so coherent */
+	sof->dmat->rings = rzalloc(SOF_MEM_ZONE_SYS_SHARED, SOF_MEM_FLAG_COHERENT,
+				   SOF_MEM_CAPS_RAM,
+				   sizeof(*sof->dmat->rings) * CONFIG_CORE_COUNT);
+	if (!sof->dmat->rings) {
+		ret = -ENOMEM;
+		goto err;
+	}
+#endif
+
 	ipc_build_trace_posn(&sof->dmat->posn);
 	sof->dmat->msg = ipc_msg_init(sof->dmat->posn.rhdr.hdr.cmd,
 				      sof->dmat->posn.rhdr.hdr.size);
@@ -538,6 +562,11 @@ void dma_trace_flush(void *t)
 	if (!dma_trace_initialized(trace_data))
 		return;
 
+#if CONFIG_TRACE_CORE_RINGS
+	/* the consumers are serialized, so any core can drain the rings */
+	dtrace_rings_drain(trace_data);
+#endif
+
 	buffer = &trace_data->dmatb;
 	avail = buffer->avail;
 
@@ -704,10 +733,243 @@ static void dtrace_add_event(const char *e, uint32_t length)
 	} else {
 		/* if there is not enough memory for new log, we drop it */
 		trace_data->dropped_entries++;
+		trace_data->drops++;
+	}
+
+}
+
+#if CONFIG_TRACE_CORE_RINGS
+
+/* Largest event, log entry header and the maximum number of arguments */
+#if CONFIG_TRACE_COMPACT
+#define DTRACE_RING_EVENT_MAX	TRACE_COMPACT_SIZE_MAX(_TRACE_EVENT_MAX_ARGUMENT_COUNT)
+#else
+#define DTRACE_RING_EVENT_MAX	(sizeof(struct log_entry_header) + \
+				 _TRACE_EVENT_MAX_ARGUMENT_COUNT * sizeof(uint32_t))
+#endif
+#define DTRACE_RING_MASK	(CONFIG_TRACE_CORE_RING_SIZE - 1)
+
+STATIC_ASSERT(!(CONFIG_TRACE_CORE_RING_SIZE & DTRACE_RING_MASK),
+	      trace_core_ring_size_not_power_of_two);
+
+/* Ring events start with their length and the time they were added, so
+ * they can be merged without knowing the payload encoding.
+ */
+#define DTRACE_RING_EVENT_HDR	(sizeof(uint32_t) + sizeof(uint64_t))
+
+static inline uint32_t dtrace_ring_event_size(uint32_t length)
+{
+	return DTRACE_RING_EVENT_HDR + ALIGN_UP(length, sizeof(uint32_t));
+}
+
+static inline uint32_t dtrace_ring_used(const struct dma_trace_ring *ring)
+{
+	return (uint32_t)atomic_read(&ring->w_off) - (uint32_t)atomic_read(&ring->r_off);
+}
+
+static void dtrace_ring_write(struct dma_trace_ring *ring, uint32_t off,
+			      const void *src, uint32_t bytes)
+{
+	uint32_t pos = off & DTRACE_RING_MASK;
+	uint32_t first = MIN(bytes, CONFIG_TRACE_CORE_RING_SIZE - pos);
+	int ret;
+
+	ret = memcpy_s(ring->data + pos, first, src, first);
+	assert(!ret);
+	if (bytes > first) {
+		ret = memcpy_s(ring->data, bytes - first, (const char *)src + first,
+			       bytes - first);
+		assert(!ret);
+	}
+}
+
+static void dtrace_ring_read(const struct dma_trace_ring *ring, uint32_t off,
+			     void *dst, uint32_t bytes)
+{
+	uint32_t pos = off & DTRACE_RING_MASK;
+	uint32_t first = MIN(bytes, CONFIG_TRACE_CORE_RING_SIZE - pos);
+	int ret;
+
+	ret = memcpy_s(dst, first, ring->data + pos, first);
+	assert(!ret);
+	if (bytes > first) {
+		ret = memcpy_s((char *)dst + first, bytes - first, ring->data,
+			       bytes - first);
+		assert(!ret);
+	}
+}
+
+/** Adds an event to the ring of the calling core. Only the interrupts of
+ * this core can preempt the writer, so they are masked instead of taking
+ * a lock.
+ */
+static void dtrace_ring_add(struct dma_trace_ring *ring, const char *e, uint32_t length)
+{
+	uint32_t size = dtrace_ring_event_size(length);
+	unsigned long flags;
+	uint64_t timestamp;
+	uint32_t w_off;
+
+	irq_local_disable(flags);
+
+	if (length > DTRACE_RING_EVENT_MAX ||
+	    size > CONFIG_TRACE_CORE_RING_SIZE - dtrace_ring_used(ring)) {
+		ring->dropped++;
+		dma_trace_data_get()->drops++;
+		irq_local_enable(flags);
+		return;
+	}
+
+	timestamp = sof_cycle_get_64_safe();
+	w_off = atomic_read(&ring->w_off);
+	dtrace_ring_write(ring, w_off, &length, sizeof(length));
+	dtrace_ring_write(ring, w_off + sizeof(length), &timestamp, sizeof(timestamp));
+	dtrace_ring_write(ring, w_off + DTRACE_RING_EVENT_HDR, e, length);
+
+	/* publish the event after its data, the atomic store orders it */
+	atomic_set(&ring->w_off, w_off + size);
+
+	irq_local_enable(flags);
+}
+
+static uint64_t dtrace_ring_timestamp(const struct dma_trace_ring *ring, uint32_t r_off)
+{
+	uint64_t timestamp;
+
+	dtrace_ring_read(ring, r_off + sizeof(uint32_t), &timestamp, sizeof(timestamp));
+
+	return timestamp;
+}
+
+/** Moves the events of all core rings to the DMA trace buffer, the oldest
+ * event of all cores first. The events that do not fit in the DMA trace
+ * buffer wait for the next run, so an event is only ever dropped by the
+ * core adding it. Each event is moved under the lock of the DMA trace data,
+ * which serializes the consumers, so any core can call this.
+ */
+static void dtrace_rings_drain(struct dma_trace_data *d)
+{
+	uint32_t event[DTRACE_RING_EVENT_MAX / sizeof(uint32_t)];
+	struct dma_trace_ring *oldest;
+	struct dma_trace_ring *ring;
+	uint64_t oldest_ts = 0;
+	uint64_t timestamp;
+	k_spinlock_key_t key;
+	uint32_t oldest_off = 0;
+	uint32_t dropped;
+	uint32_t length;
+	uint32_t r_off;
+	int i;
+
+	for (;;) {
+		key = k_spin_lock(&d->lock);
+
+		oldest = NULL;
+		for (i = 0; i < CONFIG_CORE_COUNT; i++) {
+			ring = &d->rings[i];
+			/* the atomic loads order the event reads after them */
+			r_off = atomic_read(&ring->r_off);
+			if (r_off == (uint32_t)atomic_read(&ring->w_off))
+				continue;
+
+			timestamp = dtrace_ring_timestamp(ring, r_off);
+			if (!oldest || timestamp < oldest_ts) {
+				oldest = ring;
+				oldest_ts = timestamp;
+				oldest_off = r_off;
+			}
+		}
+
+		if (!oldest) {
+			k_spin_unlock(&d->lock, key);
+			break;
+		}
+
+		dtrace_ring_read(oldest, oldest_off, &length, sizeof(length));
+
+		/* leave the rest in the rings until the buffer was copied */
+		if (dtrace_calc_buf_overflow(&d->dmatb, length)) {
+			k_spin_unlock(&d->lock, key);
+			break;
+		}
+
+		dtrace_ring_read(oldest, oldest_off + DTRACE_RING_EVENT_HDR, event, length);
+
+		/* free the slot only after it was read */
+		atomic_set(&oldest->r_off, oldest_off + dtrace_ring_event_size(length));
+
+		dtrace_add_event((const char *)event, length);
+		k_spin_unlock(&d->lock, key);
+	}
+
+	/* the drops are reported with the next event that fits */
+	key = k_spin_lock(&d->lock);
+	for (i = 0; i < CONFIG_CORE_COUNT; i++) {
+		ring = &d->rings[i];
+		dropped = ring->dropped - ring->reported;
+		ring->reported += dropped;
+		d->dropped_entries += dropped;
+	}
+	k_spin_unlock(&d->lock, key);
+}
+
+static bool dtrace_rings_half_full(const struct dma_trace_data *d)
+{
+	int i;
+
+	for (i = 0; i < CONFIG_CORE_COUNT; i++)
+		if (dtrace_ring_used(&d->rings[i]) >= CONFIG_TRACE_CORE_RING_SIZE / 2)
+			return true;
+
+	return false;
+}
+
+/** Main dma-trace entry point */
+void dtrace_event(const char *e, uint32_t length)
+{
+	struct dma_trace_data *trace_data = dma_trace_data_get();
+
+	if (!dma_trace_initialized(trace_data) ||
+	    length > DMA_TRACE_LOCAL_SIZE / 8 || length == 0) {
+		return;
 	}
 
+	dtrace_ring_add(&trace_data->rings[cpu_get_id()], e, length);
+
+	/* only the primary core schedules the copy, if DMA trace copying is
+	 * not working already
+	 */
+	if (trace_data->copy_in_progress ||
+	    cpu_get_id() != PLATFORM_PRIMARY_CORE_ID)
+		return;
+
+	/* schedule copy now if any ring or the buffer is > 50% full */
+	if (trace_data->enabled &&
+	    (dtrace_rings_half_full(trace_data) ||
+	     trace_data->dmatb.avail >= (DMA_TRACE_LOCAL_SIZE / 2))) {
+		reschedule_task(&trace_data->dmat_work,
+				DMA_TRACE_RESCHEDULE_TIME);
+		/* reschedule should not be interrupted
+		 * just like we are in copy progress
+		 */
+		trace_data->copy_in_progress = 1;
+	}
+}
+
+void dtrace_event_atomic(const char *e, uint32_t length)
+{
+	struct dma_trace_data *trace_data = dma_trace_data_get();
+
+	if (!dma_trace_initialized(trace_data) ||
+	    length > DMA_TRACE_LOCAL_SIZE / 8 || length == 0) {
+		return;
+	}
+
+	dtrace_ring_add(&trace_data->rings[cpu_get_id()], e, length);
 }
 
+#else /* CONFIG_TRACE_CORE_RINGS */
+
 /** Main dma-trace entry point */
 void dtrace_event(const char *e, uint32_t length)
 {
@@ -760,3 +1022,5 @@ void dtrace_event_atomic(const char *e, uint32_t length)
 
 	dtrace_add_event(e, length);
 }
+
+#endif /* CONFIG_TRACE_CORE_RINGS */
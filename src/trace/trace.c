@@ -12,6 +12,7 @@
 #include <rtos/timer.h>
 #include <rtos/alloc.h>
 #include <rtos/cache.h>
+#include <rtos/interrupt.h>
 #include <sof/lib/cpu.h>
 #include <sof/lib/mailbox.h>
 #include <sof/lib/memory.h>
@@ -33,18 +34,49 @@ LOG_MODULE_DECLARE(ipc, CONFIG_SOF_LOG_LEVEL);
 extern struct tr_ctx dt_tr;
 
 #if CONFIG_TRACE_FILTERING_ADAPTIVE
+/* hash index slots, at most half of them is used to keep probe sequences short */
+#define RECENT_INDEX_SLOTS	(2 * CONFIG_TRACE_RECENT_ENTRIES_COUNT)
+
 struct recent_log_entry {
 	uint32_t entry_id;
 	uint64_t message_ts;
 	uint64_t first_suppression_ts;
 	uint32_t trigger_count;
+	uint16_t prev;	/* last seen order links */
+	uint16_t next;
 };
 
+/* Recent entries are found through an open addressing hash index of entry IDs
+ * and linked in the order they were last seen, so neither lookup nor expiry
+ * cost depends on CONFIG_TRACE_RECENT_ENTRIES_COUNT. Index values and links
+ * are the entry position + 1, 0 means none.
+ */
 struct recent_trace_context {
 	struct recent_log_entry recent_entries[CONFIG_TRACE_RECENT_ENTRIES_COUNT];
+	uint16_t index[RECENT_INDEX_SLOTS];
+	uint16_t lru_head;	/* least recently seen entry */
+	uint16_t lru_tail;	/* most recently seen entry */
+	uint16_t free_head;	/* released entries, linked by next */
+	uint16_t allocated;	/* entries used at least once */
 };
 #endif /* CONFIG_TRACE_FILTERING_ADAPTIVE */
 
+#if CONFIG_TRACE_COMPACT
+/* What the decoder knows after the last compact DMA trace event of a core */
+struct compact_trace_context {
+	uint64_t timestamp;
+	uint32_t uid;
+	uint32_t ids;		/* id_0 and id_1 as in struct log_entry_header */
+	uint32_t drops;		/* dma_trace_data drops at the last sync event */
+	uint32_t seq;
+	uint32_t sync_countdown;	/* events until the next sync event */
+	bool busy;		/* an event is being added */
+};
+
+STATIC_ASSERT(CONFIG_CORE_COUNT - 1 <= TRACE_COMPACT_CORE_MASK,
+	      too_many_cores_for_compact_trace);
+#endif /* CONFIG_TRACE_COMPACT */
+
 /** MAILBOX_TRACE_BASE ring buffer */
 struct trace {
 	uintptr_t pos ; /**< offset of the next byte to write */
@@ -57,6 +89,9 @@ struct trace {
 #if CONFIG_TRACE_FILTERING_ADAPTIVE
 	struct recent_trace_context trace_core_context[CONFIG_CORE_COUNT];
 #endif
+#if CONFIG_TRACE_COMPACT
+	struct compact_trace_context compact_context[CONFIG_CORE_COUNT];
+#endif
 };
 
 /* calculates total message size, both header and payload in bytes */
@@ -132,15 +167,110 @@ static inline bool trace_filter_verbosity(uint32_t lvl, const struct tr_ctx *ctx
 #endif /* CONFIG_TRACE_FILTERING_VERBOSITY */
 
 #if CONFIG_TRACE_FILTERING_ADAPTIVE
-/** Report how many times an entry was suppressed and clear it. */
+static inline struct recent_trace_context *recent_context_get(void)
+{
+	return &trace_get()->trace_core_context[cpu_get_id()];
+}
+
+static inline struct recent_log_entry *recent_entry(struct recent_trace_context *rc,
+						     uint16_t link)
+{
+	return &rc->recent_entries[link - 1];
+}
+
+/* Fibonacci hashing, the well mixed high bits of the product pick the slot */
+static inline uint32_t recent_index_home(uint32_t entry_id)
+{
+	return ((uint64_t)(entry_id * 0x9E3779B1u) * RECENT_INDEX_SLOTS) >> 32;
+}
+
+/** Returns the index slot of entry_id or the free slot ending its probe sequence. */
+static uint32_t recent_index_find(struct recent_trace_context *rc, uint32_t entry_id)
+{
+	uint32_t slot = recent_index_home(entry_id);
+
+	while (rc->index[slot] && recent_entry(rc, rc->index[slot])->entry_id != entry_id)
+		slot = (slot + 1) % RECENT_INDEX_SLOTS;
+
+	return slot;
+}
+
+static void recent_lru_unlink(struct recent_trace_context *rc, struct recent_log_entry *entry)
+{
+	if (entry->prev)
+		recent_entry(rc, entry->prev)->next = entry->next;
+	else
+		rc->lru_head = entry->next;
+
+	if (entry->next)
+		recent_entry(rc, entry->next)->prev = entry->prev;
+	else
+		rc->lru_tail = entry->prev;
+}
+
+static void recent_lru_append(struct recent_trace_context *rc, uint16_t link)
+{
+	struct recent_log_entry *entry = recent_entry(rc, link);
+
+	entry->prev = rc->lru_tail;
+	entry->next = 0;
+
+	if (rc->lru_tail)
+		recent_entry(rc, rc->lru_tail)->next = link;
+	else
+		rc->lru_head = link;
+
+	rc->lru_tail = link;
+}
+
+/** Stop tracking an entry. Following index slots are shifted back into the
+ * freed one, so probe sequences stay unbroken without tombstones.
+ */
+static void recent_entry_release(struct recent_trace_context *rc, uint16_t link)
+{
+	struct recent_log_entry *entry = recent_entry(rc, link);
+	uint32_t hole = recent_index_find(rc, entry->entry_id);
+	uint32_t slot = hole;
+	uint32_t home;
+
+	for (;;) {
+		slot = (slot + 1) % RECENT_INDEX_SLOTS;
+		if (!rc->index[slot])
+			break;
+
+		/* an entry may move back unless its home is cyclically in (hole, slot] */
+		home = recent_index_home(recent_entry(rc, rc->index[slot])->entry_id);
+		if (slot > hole ? home <= hole || home > slot : home <= hole && home > slot) {
+			rc->index[hole] = rc->index[slot];
+			hole = slot;
+		}
+	}
+	rc->index[hole] = 0;
+
+	recent_lru_unlink(rc, entry);
+	memset(entry, 0, sizeof(*entry));
+	entry->next = rc->free_head;
+	rc->free_head = link;
+}
+
+/** Report how many times an entry was suppressed. */
 static void emit_suppressed_entry(struct recent_log_entry *entry)
 {
 	_log_message(trace_log_unfiltered, false, LOG_LEVEL_INFO, _TRACE_INV_CLASS, &dt_tr,
 		     _TRACE_INV_ID, _TRACE_INV_ID, "Suppressed %u similar messages: %pQ",
 		     entry->trigger_count - CONFIG_TRACE_BURST_COUNT,
 		     (void *)entry->entry_id);
+}
 
-	memset(entry, 0, sizeof(*entry));
+/** Emit the entry if it suppressed any message and stop tracking it. */
+static void recent_entry_flush(struct recent_trace_context *rc, uint16_t link)
+{
+	struct recent_log_entry *entry = recent_entry(rc, link);
+
+	if (entry->trigger_count > CONFIG_TRACE_BURST_COUNT)
+		emit_suppressed_entry(entry);
+
+	recent_entry_release(rc, link);
 }
 
 /** Flush entries that have not been seen again in the last
@@ -148,24 +278,13 @@ static void emit_suppressed_entry(struct recent_log_entry *entry)
  */
 static void emit_recent_entries(uint64_t current_ts)
 {
-	struct trace *trace = trace_get();
-	struct recent_log_entry *recent_entries =
-		trace->trace_core_context[cpu_get_id()].recent_entries;
-	int i;
-
-	/* Check if any tracked entries were dormant long enough to unsuppress them */
-	for (i = 0; i < CONFIG_TRACE_RECENT_ENTRIES_COUNT; i++) {
-		if (recent_entries[i].entry_id) {
-			if (current_ts - recent_entries[i].message_ts >
-			    CONFIG_TRACE_RECENT_TIME_THRESHOLD) {
-				if (recent_entries[i].trigger_count > CONFIG_TRACE_BURST_COUNT)
-					emit_suppressed_entry(&recent_entries[i]);
-				else
-					memset(&recent_entries[i], 0, sizeof(recent_entries[i]));
-			}
-		}
-	}
+	struct recent_trace_context *rc = recent_context_get();
 
+	/* Entries are in last seen order, so stop at the first one still recent */
+	while (rc->lru_head &&
+	       current_ts - recent_entry(rc, rc->lru_head)->message_ts >
+	       CONFIG_TRACE_RECENT_TIME_THRESHOLD)
+		recent_entry_flush(rc, rc->lru_head);
 }
 
 /**
@@ -177,64 +296,140 @@ static void emit_recent_entries(uint64_t current_ts)
  */
 static bool trace_filter_flood(uint32_t log_level, uint32_t entry, uint64_t message_ts)
 {
-	struct trace *trace = trace_get();
-	struct recent_log_entry *recent_entries =
-		trace->trace_core_context[cpu_get_id()].recent_entries;
-	struct recent_log_entry *oldest_entry = recent_entries;
-	int i;
+	struct recent_trace_context *rc = recent_context_get();
+	struct recent_log_entry *recent;
+	uint32_t slot;
+	uint16_t link;
 
 	/* don't attempt to suppress debug messages using this method, it would be uneffective */
 	if (log_level >= LOG_LEVEL_DEBUG)
 		return true;
 
 	/* check if same log entry was sent recently */
-	for (i = 0; i < CONFIG_TRACE_RECENT_ENTRIES_COUNT; i++) {
-		/* Identify the oldest (or empty) entry to evict if we have no match  */
-		if (oldest_entry->first_suppression_ts > recent_entries[i].first_suppression_ts)
-			oldest_entry = &recent_entries[i];
-
-		if (recent_entries[i].entry_id == entry) {
-			/* We have a match but include this message in this burst only if the
-			 * burst:
-			   - 1. hasn't lasted for too long;
-			   - 2. hasn't been quiet for too long.
-			 */
-			if (message_ts - recent_entries[i].first_suppression_ts <
-			    CONFIG_TRACE_RECENT_MAX_TIME &&
-			    message_ts - recent_entries[i].message_ts <
-			    CONFIG_TRACE_RECENT_TIME_THRESHOLD) {
-				recent_entries[i].trigger_count++;
-				/* Refresh last seen time */
-				recent_entries[i].message_ts = message_ts;
-
-				/* Allow the start of a burst to be printed normally */
-				return recent_entries[i].trigger_count <= CONFIG_TRACE_BURST_COUNT;
-			}
+	slot = recent_index_find(rc, entry);
+	link = rc->index[slot];
+	if (link) {
+		recent = recent_entry(rc, link);
+
+		/* We have a match but include this message in this burst only if the
+		 * burst:
+		   - 1. hasn't lasted for too long;
+		   - 2. hasn't been quiet for too long.
+		 */
+		if (message_ts - recent->first_suppression_ts < CONFIG_TRACE_RECENT_MAX_TIME &&
+		    message_ts - recent->message_ts < CONFIG_TRACE_RECENT_TIME_THRESHOLD) {
+			recent->trigger_count++;
+			/* Refresh last seen time */
+			recent->message_ts = message_ts;
+			recent_lru_unlink(rc, recent);
+			recent_lru_append(rc, link);
+
+			/* Allow the start of a burst to be printed normally */
+			return recent->trigger_count <= CONFIG_TRACE_BURST_COUNT;
+		}
 
-			/* Emit and clear this burst */
-			if (recent_entries[i].trigger_count > CONFIG_TRACE_BURST_COUNT)
-				emit_suppressed_entry(&recent_entries[i]);
-			else
-				memset(&recent_entries[i], 0, sizeof(recent_entries[i]));
+		/* Emit and clear this burst */
+		recent_entry_flush(rc, link);
 
-			return true;
-		}
+		return true;
+	}
+
+	/* Make room for tracking new entry, by emitting the least recently seen one */
+	if (!rc->free_head && rc->allocated == CONFIG_TRACE_RECENT_ENTRIES_COUNT) {
+		recent_entry_flush(rc, rc->lru_head);
+		/* index slots may have shifted */
+		slot = recent_index_find(rc, entry);
 	}
 
-	/* Make room for tracking new entry, by emitting the oldest one in the filter */
-	if (oldest_entry->entry_id && oldest_entry->trigger_count > CONFIG_TRACE_BURST_COUNT)
-		emit_suppressed_entry(oldest_entry);
+	if (rc->free_head) {
+		link = rc->free_head;
+		rc->free_head = recent_entry(rc, link)->next;
+	} else {
+		link = ++rc->allocated;
+	}
 
 	/* Start a new burst */
-	oldest_entry->entry_id = entry;
-	oldest_entry->message_ts = message_ts;
-	oldest_entry->first_suppression_ts = message_ts;
-	oldest_entry->trigger_count = 1;
+	recent = recent_entry(rc, link);
+	recent->entry_id = entry;
+	recent->message_ts = message_ts;
+	recent->first_suppression_ts = message_ts;
+	recent->trigger_count = 1;
+	rc->index[slot] = link;
+	recent_lru_append(rc, link);
 
 	return true;
 }
 #endif /* CONFIG_TRACE_FILTERING_ADAPTIVE */
 
+#if CONFIG_TRACE_COMPACT
+static inline uint8_t *put_varint(uint8_t *dst, uint64_t value)
+{
+	while (value >= 0x80) {
+		*dst++ = (uint8_t)value | 0x80;
+		value >>= 7;
+	}
+	*dst++ = value;
+
+	return dst;
+}
+
+/** Encodes an event into a compact trace message, see user/trace.h, and
+ * passes it to dtrace_event(). Called with the local interrupts masked, so
+ * the events of a core reach the buffer in the order they were encoded.
+ */
+static void dma_trace_log_compact(struct compact_trace_context *cc, bool send_atomic,
+				  uint32_t log_entry, const struct tr_ctx *ctx,
+				  uint32_t id_1, uint32_t id_2, int arg_count, va_list vargs)
+{
+	struct dma_trace_data *trace_data = dma_trace_data_get();
+	uint32_t data[TRACE_COMPACT_SIZE_MAX(_TRACE_EVENT_MAX_ARGUMENT_COUNT) /
+		      sizeof(uint32_t)];
+	uint8_t *flags = (uint8_t *)&data[1];
+	uint8_t *p = flags + 1;
+	uint32_t uid = (uintptr_t)ctx->uuid_p;
+	uint32_t ids = (id_1 & TRACE_ID_MASK) | (id_2 & TRACE_ID_MASK) << TRACE_ID_LENGTH;
+	uint64_t timestamp = sof_cycle_get_64_safe() + trace_data->time_delta;
+	int i;
+
+	data[0] = log_entry | TRACE_COMPACT_MARK;
+	*flags = cpu_get_id() | (cc->seq++ & TRACE_COMPACT_SEQ_MASK) << TRACE_COMPACT_SEQ_SHIFT;
+
+	/* start over after drops, they may have broken the chain of this core */
+	if (!cc->sync_countdown || cc->drops != trace_data->drops ||
+	    timestamp < cc->timestamp) {
+		*flags |= TRACE_COMPACT_SYNC | TRACE_COMPACT_CTX;
+		cc->sync_countdown = CONFIG_TRACE_COMPACT_SYNC_INTERVAL;
+		cc->drops = trace_data->drops;
+		p = put_varint(p, timestamp);
+	} else {
+		p = put_varint(p, timestamp - cc->timestamp);
+		if (uid != cc->uid || ids != cc->ids)
+			*flags |= TRACE_COMPACT_CTX;
+	}
+	cc->sync_countdown--;
+	cc->timestamp = timestamp;
+
+	if (*flags & TRACE_COMPACT_CTX) {
+		p = put_varint(p, uid);
+		p = put_varint(p, id_1 & TRACE_ID_MASK);
+		p = put_varint(p, id_2 & TRACE_ID_MASK);
+		cc->uid = uid;
+		cc->ids = ids;
+	}
+
+	for (i = 0; i < arg_count; ++i)
+		p = put_varint(p, va_arg(vargs, uint32_t));
+
+	while ((uintptr_t)p % sizeof(uint32_t))
+		*p++ = 0;
+
+	if (send_atomic)
+		dtrace_event_atomic((const char *)data, p - (uint8_t *)data);
+	else
+		dtrace_event((const char *)data, p - (uint8_t *)data);
+}
+#endif /* CONFIG_TRACE_COMPACT */
+
 /** Implementation shared and invoked by both adaptive filtering and
  * not. Serializes events into trace messages and passes them to
  * dtrace_event()
@@ -246,6 +441,28 @@ static void dma_trace_log(bool send_atomic, uint32_t log_entry, const struct tr_
 	const int message_size = MESSAGE_SIZE(arg_count);
 	int i;
 
+#if CONFIG_TRACE_COMPACT
+	struct compact_trace_context *cc;
+	uint32_t flags;
+
+	irq_local_disable(flags);
+	cc = &trace_get()->compact_context[cpu_get_id()];
+
+	/* events logged while adding one, like dropped logs reports, would
+	 * break the chain, they are sent in the fixed format
+	 */
+	if (!cc->busy && dma_trace_initialized(dma_trace_data_get())) {
+		cc->busy = true;
+		dma_trace_log_compact(cc, send_atomic, log_entry, ctx, id_1, id_2,
+				      arg_count, vargs);
+		cc->busy = false;
+		irq_local_enable(flags);
+		return;
+	}
+
+	irq_local_enable(flags);
+#endif /* CONFIG_TRACE_COMPACT */
+
 	/* fill log content. arg_count is in the dictionary. */
 	put_header(data, ctx->uuid_p, id_1, id_2, log_entry, sof_cycle_get_64_safe());
 
@@ -289,10 +506,16 @@ void trace_log_filtered(bool send_atomic, const void *log_entry, const struct tr
 #if CONFIG_TRACE_FILTERING_ADAPTIVE
 	if (!trace->user_filter_override) {
 		const uint64_t current_ts = sof_cycle_get_64_safe();
+		uint32_t flags;
+		bool pass;
 
+		/* recent entries are linked, don't let an interrupt on this core see them torn */
+		irq_local_disable(flags);
 		emit_recent_entries(current_ts);
+		pass = trace_filter_flood(lvl, (uint32_t)log_entry, current_ts);
+		irq_local_enable(flags);
 
-		if (!trace_filter_flood(lvl, (uint32_t)log_entry, current_ts))
+		if (!pass)
 			return;
 	}
 #endif /* CONFIG_TRACE_FILTERING_ADAPTIVE */
@@ -0,0 +1,98 @@
+// SPDX-License-Identifier: BSD-3-Clause
+//
+// Copyright(c) 2023 Intel Corporation. All rights reserved.
+
+#include <stdio.h>
+#include <stdint.h>
+#include <stdarg.h>
+#include <stddef.h>
+#include <setjmp.h>
+#include <cmocka.h>
+
+#include <sof/audio/drc/drc_algorithm.h>
+#include <sof/audio/format.h>
+
+#define LUT_STEP	1000
+
+/* A table that rises by LUT_STEP per point, so the lookup result tells the
+ * point and the interpolation fraction it came from.
+ */
+static void lut_init(struct drc_state *state)
+{
+	int i;
+
+	for (i = 0; i < DRC_GAIN_LUT_SIZE; i++)
+		state->gain_lut[i] = i * LUT_STEP;
+}
+
+static void test_drc_abs_sat(void **state)
+{
+	(void)state;
+
+	assert_int_equal(drc_abs_sat(0), 0);
+	assert_int_equal(drc_abs_sat(-5), 5);
+	assert_int_equal(drc_abs_sat(INT32_MAX), INT32_MAX);
+	assert_int_equal(drc_abs_sat(-INT32_MAX), INT32_MAX);
+	assert_int_equal(drc_abs_sat(INT32_MIN), INT32_MAX);
+}
+
+static void test_drc_gain_lut_lookup_points(void **state)
+{
+	struct drc_state st;
+	int32_t x;
+	int i;
+
+	(void)state;
+
+	lut_init(&st);
+
+	/* Below the table range the gain of silence is used */
+	assert_int_equal(drc_gain_lut_lookup(&st, 0), 0);
+	assert_int_equal(drc_gain_lut_lookup(&st, (1 << DRC_GAIN_LUT_MIN_MSB) - 1), 0);
+
+	/* Sample points of the table are returned as is */
+	for (i = 0; i < DRC_GAIN_LUT_SIZE - 1; i++) {
+		x = ((1 << DRC_GAIN_LUT_STEPS_SHIFT) +
+		     (i & ((1 << DRC_GAIN_LUT_STEPS_SHIFT) - 1))) <<
+			((i >> DRC_GAIN_LUT_STEPS_SHIFT) + DRC_GAIN_LUT_MIN_MSB -
+			 DRC_GAIN_LUT_STEPS_SHIFT);
+		assert_int_equal(drc_gain_lut_lookup(&st, x), i * LUT_STEP);
+	}
+}
+
+static void test_drc_gain_lut_lookup_full_scale(void **state)
+{
+	const int32_t full_scale = (DRC_GAIN_LUT_SIZE - 1) * LUT_STEP;
+	struct drc_state st;
+	int32_t gain;
+
+	(void)state;
+
+	lut_init(&st);
+
+	/* Positive full scale interpolates to the last point */
+	gain = drc_gain_lut_lookup(&st, drc_abs_sat(INT32_MAX));
+	assert_true(gain > full_scale - LUT_STEP);
+	assert_true(gain <= full_scale);
+
+	/* Negative full scale in 32 bit and in 16 bit samples gets the same
+	 * gain, not the gain of silence.
+	 */
+	assert_int_equal(drc_gain_lut_lookup(&st, drc_abs_sat(INT32_MIN)), gain);
+	assert_int_equal(drc_gain_lut_lookup(&st,
+					     drc_abs_sat(Q_SHIFT_LEFT((int32_t)INT16_MIN, 15, 31))),
+			 gain);
+}
+
+int main(void)
+{
+	const struct CMUnitTest tests[] = {
+		cmocka_unit_test(test_drc_abs_sat),
+		cmocka_unit_test(test_drc_gain_lut_lookup_points),
+		cmocka_unit_test(test_drc_gain_lut_lookup_full_scale),
+	};
+
+	cmocka_set_message_output(CM_OUTPUT_TAP);
+
+	return cmocka_run_group_tests(tests, NULL, NULL);
+}
@@ -0,0 +1,142 @@
+// SPDX-License-Identifier: BSD-3-Clause
+//
+// Copyright(c) 2023 Intel Corporation. All rights reserved.
+
+#include <stdio.h>
+#include <stdint.h>
+#include <stdarg.h>
+#include <stddef.h>
+#include <setjmp.h>
+#include <cmocka.h>
+#include <errno.h>
+
+#include <sof/audio/mfcc/mfcc_comp.h>
+
+#define NUM_CEPS	13
+#define SLOTS		4
+
+static int16_t ring_data[SLOTS * NUM_CEPS];
+static int16_t out[3 * SLOTS * NUM_CEPS];
+
+static void ring_init(struct mfcc_state *state, bool sink_consumer)
+{
+	struct mfcc_feature_ring *ring = &state->features;
+
+	ring->data = ring_data;
+	ring->num_ceps = NUM_CEPS;
+	ring->slots = SLOTS;
+	atomic_init(&ring->w_idx, 0);
+	atomic_init(&ring->r_idx, 0);
+	ring->overruns = 0;
+	ring->sink_consumer = sink_consumer;
+}
+
+/* Same as the MFCC processing: drop the frame when full, else fill the
+ * slot with the frame number and publish it.
+ */
+static void ring_write(struct mfcc_feature_ring *ring, int frame)
+{
+	int w_idx = atomic_read(&ring->w_idx);
+	int16_t *ceps;
+	int j;
+
+	if (mfcc_feature_ring_avail(ring) == ring->slots) {
+		ring->overruns++;
+		return;
+	}
+
+	ceps = mfcc_feature_ring_slot(ring, w_idx);
+	for (j = 0; j < ring->num_ceps; j++)
+		ceps[j] = frame * 100 + j;
+
+	atomic_set(&ring->w_idx, mfcc_feature_ring_next(ring, w_idx));
+}
+
+static void check_frames(const int16_t *x, int first, int frames)
+{
+	int f;
+	int j;
+
+	for (f = 0; f < frames; f++)
+		for (j = 0; j < NUM_CEPS; j++)
+			assert_int_equal(*x++, (first + f) * 100 + j);
+}
+
+static void test_mfcc_feature_read_batch(void **state)
+{
+	struct mfcc_state st;
+	int frame = 0;
+	int read = 0;
+	int n;
+	int i;
+
+	(void)state;
+
+	ring_init(&st, false);
+	assert_int_equal(mfcc_feature_read(&st, out, SLOTS), 0);
+
+	/* Indices go around the 2 x slots range several times */
+	for (i = 0; i < 5 * SLOTS; i++) {
+		ring_write(&st.features, frame++);
+		ring_write(&st.features, frame++);
+		n = mfcc_feature_read(&st, out, 3);
+		assert_int_equal(n, 2);
+		check_frames(out, read, n);
+		read += n;
+	}
+
+	assert_int_equal(mfcc_feature_ring_avail(&st.features), 0);
+	assert_int_equal(st.features.overruns, 0);
+}
+
+static void test_mfcc_feature_read_overrun(void **state)
+{
+	struct mfcc_state st;
+	int n;
+	int i;
+
+	(void)state;
+
+	ring_init(&st, false);
+
+	/* The frames that do not fit are dropped, the oldest ones are kept */
+	for (i = 0; i < SLOTS + 3; i++)
+		ring_write(&st.features, i);
+
+	assert_int_equal(st.features.overruns, 3);
+	n = mfcc_feature_read(&st, out, 3 * SLOTS);
+	assert_int_equal(n, SLOTS);
+	check_frames(out, 0, SLOTS);
+
+	/* There is room again after the read */
+	ring_write(&st.features, 10);
+	n = mfcc_feature_read(&st, out, 3 * SLOTS);
+	assert_int_equal(n, 1);
+	check_frames(out, 10, 1);
+}
+
+static void test_mfcc_feature_read_sink_consumer(void **state)
+{
+	struct mfcc_state st;
+
+	(void)state;
+
+	/* The audio sink is the only consumer, the frame stays in the ring */
+	ring_init(&st, true);
+	ring_write(&st.features, 0);
+	assert_int_equal(mfcc_feature_read(&st, out, SLOTS), -EBUSY);
+	assert_int_equal(mfcc_feature_ring_avail(&st.features), 1);
+}
+
+int main(void)
+{
+	const struct CMUnitTest tests[] = {
+		cmocka_unit_test(test_mfcc_feature_read_batch),
+		cmocka_unit_test(test_mfcc_feature_read_overrun),
+		cmocka_unit_test(test_mfcc_feature_read_sink_consumer),
+	};
+
+	cmocka_set_message_output(CM_OUTPUT_TAP);
+
+	return cmocka_run_group_tests(tests, NULL, NULL);
+}
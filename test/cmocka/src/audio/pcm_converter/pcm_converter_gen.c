@@ -0,0 +1,226 @@
+// SPDX-License-Identifier: BSD-3-Clause
+//
+// Copyright(c) 2023 Intel Corporation. All rights reserved.
+
+#include <sof/audio/pcm_converter.h>
+#include <sof/audio/audio_stream.h>
+#include <sof/audio/format.h>
+#include <sof/common.h>
+#include <ipc/stream.h>
+
+#include <stdio.h>
+#include <stdarg.h>
+#include <stddef.h>
+#include <setjmp.h>
+#include <stdint.h>
+#include <string.h>
+#include <time.h>
+#include <cmocka.h>
+
+/* samples per test run, not a multiple of the HiFi load width on purpose */
+#define PCM_GEN_TEST_SAMPLES	1023
+
+/* samples converted per benchmark run, 1 s of stereo 48 kHz */
+#define PCM_GEN_BENCH_SAMPLES	(2 * 48000)
+#define PCM_GEN_BENCH_BLOCK	(2 * 48)
+
+static int32_t in_buf[PCM_GEN_TEST_SAMPLES];
+static int32_t out_buf[PCM_GEN_TEST_SAMPLES];
+
+/* minimal circular buffer setup, the converters only use the inline helpers */
+static void pcm_gen_stream_init(struct audio_stream *stream, void *data, uint32_t bytes)
+{
+	memset(stream, 0, sizeof(*stream));
+	stream->addr = data;
+	stream->end_addr = (uint8_t *)data + bytes;
+	stream->size = bytes;
+	stream->r_ptr = data;
+	stream->w_ptr = data;
+}
+
+static int pcm_gen_valid_bits(enum sof_ipc_frame valid)
+{
+	switch (valid) {
+	case SOF_IPC_FRAME_U8:
+		return 8;
+	case SOF_IPC_FRAME_S16_LE:
+		return 16;
+	case SOF_IPC_FRAME_S32_LE:
+		return 32;
+	default:
+		return 24;
+	}
+}
+
+static int pcm_gen_container_bytes(enum sof_ipc_frame container)
+{
+	switch (container) {
+	case SOF_IPC_FRAME_U8:
+		return 1;
+	case SOF_IPC_FRAME_S16_LE:
+		return 2;
+	case SOF_IPC_FRAME_S24_3LE:
+		return 3;
+	default:
+		return 4;
+	}
+}
+
+/* reference encoder, value is an integer in the valid bits range */
+static void pcm_gen_ref_write(uint8_t *p, enum sof_ipc_frame container,
+			      enum sof_ipc_frame valid, int32_t value)
+{
+	switch (container) {
+	case SOF_IPC_FRAME_U8:
+		*p = value + 128;
+		break;
+	case SOF_IPC_FRAME_S16_LE:
+		*(int16_t *)p = value;
+		break;
+	case SOF_IPC_FRAME_S24_3LE:
+		p[0] = value;
+		p[1] = value >> 8;
+		p[2] = value >> 16;
+		break;
+	default:
+		if (valid == SOF_IPC_FRAME_S24_4LE_MSB)
+			value <<= 8;
+		*(int32_t *)p = value;
+		break;
+	}
+}
+
+static int32_t pcm_gen_ref_read(const uint8_t *p, enum sof_ipc_frame container,
+				enum sof_ipc_frame valid)
+{
+	switch (container) {
+	case SOF_IPC_FRAME_U8:
+		return *p - 128;
+	case SOF_IPC_FRAME_S16_LE:
+		return *(const int16_t *)p;
+	case SOF_IPC_FRAME_S24_3LE:
+		return sign_extend_s24(p[0] | (p[1] << 8) | (p[2] << 16));
+	default:
+		if (valid == SOF_IPC_FRAME_S24_4LE_MSB)
+			return *(const int32_t *)p >> 8;
+		return *(const int32_t *)p;
+	}
+}
+
+/* reference re-quantization with rounding and saturation */
+static int32_t pcm_gen_ref_convert(int32_t value, int in_bits, int out_bits)
+{
+	int64_t x = value;
+	int64_t max = (1LL << (out_bits - 1)) - 1;
+
+	if (out_bits >= in_bits)
+		return x << (out_bits - in_bits);
+
+	x = ((x >> (in_bits - out_bits - 1)) + 1) >> 1;
+
+	return x > max ? max : x;
+}
+
+static void test_pcm_converter_gen_all_pairs(void **state)
+{
+	struct audio_stream source, sink;
+	const struct pcm_func_vc_map *map;
+	int tested = 0;
+	size_t i;
+	int in_bits, out_bits, in_bytes, out_bytes;
+	int32_t value, expected;
+	int j;
+
+	(void)state;
+
+	for (i = 0; i < pcm_func_gen_count; i++) {
+		map = &pcm_func_gen_map[i];
+		if (!map->func)
+			continue;
+
+		in_bits = pcm_gen_valid_bits(map->valid_src_bits);
+		out_bits = pcm_gen_valid_bits(map->valid_sink_bits);
+		in_bytes = pcm_gen_container_bytes(map->source);
+		out_bytes = pcm_gen_container_bytes(map->sink);
+
+		pcm_gen_stream_init(&source, in_buf, PCM_GEN_TEST_SAMPLES * in_bytes);
+		pcm_gen_stream_init(&sink, out_buf, PCM_GEN_TEST_SAMPLES * out_bytes);
+
+		/* sweep the full range including both extremes */
+		for (j = 0; j < PCM_GEN_TEST_SAMPLES; j++) {
+			value = (int32_t)(((int64_t)j * 0xffffffffLL /
+					   (PCM_GEN_TEST_SAMPLES - 1)) - 0x80000000LL);
+			value >>= 32 - in_bits;
+			pcm_gen_ref_write((uint8_t *)in_buf + j * in_bytes, map->source,
+					  map->valid_src_bits, value);
+		}
+
+		map->func(&source, 0, &sink, 0, PCM_GEN_TEST_SAMPLES);
+
+		for (j = 0; j < PCM_GEN_TEST_SAMPLES; j++) {
+			value = pcm_gen_ref_read((uint8_t *)in_buf + j * in_bytes, map->source,
+						 map->valid_src_bits);
+			expected = pcm_gen_ref_convert(value, in_bits, out_bits);
+#if CONFIG_PCM_CONVERTER_DITHER
+			if (out_bits < in_bits) {
+				int32_t diff = pcm_gen_ref_read((uint8_t *)out_buf + j * out_bytes,
+								map->sink, map->valid_sink_bits) -
+					       expected;
+
+				assert_in_range(diff + 2, 0, 4);
+				continue;
+			}
+#endif
+			assert_int_equal(pcm_gen_ref_read((uint8_t *)out_buf + j * out_bytes,
+							  map->sink, map->valid_sink_bits),
+					 expected);
+		}
+
+		tested++;
+	}
+
+	assert_true(tested > 0);
+}
+
+/* Not a pass/fail test, reports host cost of each generated converter */
+static void test_pcm_converter_gen_benchmark(void **state)
+{
+	struct audio_stream source, sink;
+	const struct pcm_func_vc_map *map;
+	clock_t start, end;
+	size_t i;
+	int done;
+
+	(void)state;
+
+	for (i = 0; i < pcm_func_gen_count; i++) {
+		map = &pcm_func_gen_map[i];
+		if (!map->func)
+			continue;
+
+		pcm_gen_stream_init(&source, in_buf, sizeof(in_buf));
+		pcm_gen_stream_init(&sink, out_buf, sizeof(out_buf));
+
+		start = clock();
+		for (done = 0; done < PCM_GEN_BENCH_SAMPLES; done += PCM_GEN_BENCH_BLOCK)
+			map->func(&source, 0, &sink, 0, PCM_GEN_BENCH_BLOCK);
+		end = clock();
+
+		print_message("pcm gen %d/%d -> %d/%d: %.3f ms per second of stereo 48 kHz\n",
+			      map->source, map->valid_src_bits, map->sink,
+			      map->valid_sink_bits,
+			      1000.0 * (end - start) / CLOCKS_PER_SEC);
+	}
+}
+
+int main(void)
+{
+	const struct CMUnitTest tests[] = {
+		cmocka_unit_test(test_pcm_converter_gen_all_pairs),
+		cmocka_unit_test(test_pcm_converter_gen_benchmark),
+	};
+
+	cmocka_set_message_output(CM_OUTPUT_TAP);
+
+	return cmocka_run_group_tests(tests, NULL, NULL);
+}
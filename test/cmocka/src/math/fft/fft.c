@@ -427,6 +427,65 @@ static void test_math_fft_1024_ifft(void **state)
 	assert_int_equal(db < FFT_DB_TH, 0);
 }
 
+/* Impulse at the first input and a constant input. The first input element
+ * must reach the transform, and the output must not depend on the previous
+ * output buffer contents.
+ */
+#define FIRST_SIZE	256
+#define FIRST_LEN	8
+#define STALE		0x5a5a
+
+static void test_math_fft_256_first_element(void **state)
+{
+	struct icomplex32 *inb;
+	struct icomplex32 *outb;
+	struct fft_plan *plan;
+	const int32_t a = 1 << 30;
+	int i;
+
+	(void)state;
+
+	inb = rzalloc(SOF_MEM_ZONE_RUNTIME, 0, SOF_MEM_CAPS_RAM,
+		      FIRST_SIZE * sizeof(struct icomplex32));
+	outb = rzalloc(SOF_MEM_ZONE_RUNTIME, 0, SOF_MEM_CAPS_RAM,
+		       FIRST_SIZE * sizeof(struct icomplex32));
+	assert_non_null(inb);
+	assert_non_null(outb);
+	plan = fft_plan_new(inb, outb, FIRST_SIZE, 32);
+	assert_non_null(plan);
+
+	/* Impulse gives a flat spectrum */
+	for (i = 0; i < FIRST_SIZE; i++) {
+		outb[i].real = STALE;
+		outb[i].imag = STALE;
+	}
+	inb[0].real = a;
+	fft_execute_32(plan, false);
+	for (i = 0; i < FIRST_SIZE; i++) {
+		assert_in_range(outb[i].real, (a >> FIRST_LEN) - 1, (a >> FIRST_LEN) + 1);
+		assert_in_range(outb[i].imag, -1, 1);
+	}
+
+	/* Constant gives only the DC bin */
+	for (i = 0; i < FIRST_SIZE; i++) {
+		inb[i].real = a;
+		inb[i].imag = 0;
+		outb[i].real = STALE;
+		outb[i].imag = STALE;
+	}
+	fft_execute_32(plan, false);
+	assert_in_range(outb[0].real, a - FIRST_SIZE, a + FIRST_SIZE);
+	assert_in_range(outb[0].imag, -FIRST_SIZE, FIRST_SIZE);
+	for (i = 1; i < FIRST_SIZE; i++) {
+		assert_in_range(outb[i].real, -FIRST_SIZE, FIRST_SIZE);
+		assert_in_range(outb[i].imag, -FIRST_SIZE, FIRST_SIZE);
+	}
+
+	fft_plan_free(plan);
+	rfree(outb);
+	rfree(inb);
+}
+
 static void test_math_fft_512_2ch(void **state)
 {
 	struct sof_ipc_buffer test_buf_desc = {
@@ -786,6 +845,57 @@ static void test_math_fft_1024_ifft_16(void **state)
 	assert_int_equal(db < FFT_DB_TH_16, 0);
 }
 
+static void test_math_fft_256_first_element_16(void **state)
+{
+	struct icomplex16 *inb;
+	struct icomplex16 *outb;
+	struct fft_plan *plan;
+	const int16_t a = 1 << 14;
+	int i;
+
+	(void)state;
+
+	inb = rzalloc(SOF_MEM_ZONE_RUNTIME, 0, SOF_MEM_CAPS_RAM,
+		      FIRST_SIZE * sizeof(struct icomplex16));
+	outb = rzalloc(SOF_MEM_ZONE_RUNTIME, 0, SOF_MEM_CAPS_RAM,
+		       FIRST_SIZE * sizeof(struct icomplex16));
+	assert_non_null(inb);
+	assert_non_null(outb);
+	plan = fft_plan_new(inb, outb, FIRST_SIZE, 16);
+	assert_non_null(plan);
+
+	/* Impulse gives a flat spectrum */
+	for (i = 0; i < FIRST_SIZE; i++) {
+		outb[i].real = STALE;
+		outb[i].imag = STALE;
+	}
+	inb[0].real = a;
+	fft_execute_16(plan, false);
+	for (i = 0; i < FIRST_SIZE; i++) {
+		assert_in_range(outb[i].real, (a >> FIRST_LEN) - 1, (a >> FIRST_LEN) + 1);
+		assert_in_range(outb[i].imag, -1, 1);
+	}
+
+	/* Constant gives only the DC bin */
+	for (i = 0; i < FIRST_SIZE; i++) {
+		inb[i].real = a;
+		inb[i].imag = 0;
+		outb[i].real = STALE;
+		outb[i].imag = STALE;
+	}
+	fft_execute_16(plan, false);
+	assert_in_range(outb[0].real, a - FIRST_LEN, a + FIRST_LEN);
+	assert_in_range(outb[0].imag, -FIRST_LEN, FIRST_LEN);
+	for (i = 1; i < FIRST_SIZE; i++) {
+		assert_in_range(outb[i].real, -FIRST_LEN, FIRST_LEN);
+		assert_in_range(outb[i].imag, -FIRST_LEN, FIRST_LEN);
+	}
+
+	fft_plan_free(plan);
+	rfree(outb);
+	rfree(inb);
+}
+
 int main(void)
 {
 	const struct CMUnitTest tests[] = {
@@ -798,6 +908,8 @@ int main(void)
 		cmocka_unit_test(test_math_fft_1024),
 		cmocka_unit_test(test_math_fft_1024_ifft),
 		cmocka_unit_test(test_math_fft_512_2ch),
+		cmocka_unit_test(test_math_fft_256_first_element),
+		cmocka_unit_test(test_math_fft_256_first_element_16),
 	};
 
 	cmocka_set_message_output(CM_OUTPUT_TAP);
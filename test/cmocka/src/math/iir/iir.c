@@ -0,0 +1,318 @@
+// SPDX-License-Identifier: BSD-3-Clause
+//
+// Copyright(c) 2023 Intel Corporation. All rights reserved.
+
+#include <sof/audio/format.h>
+#include <sof/math/iir_df1.h>
+#include <sof/math/iir_df2t.h>
+#include <sof/math/numbers.h>
+#include <user/eq.h>
+
+#include <stdio.h>
+#include <stdarg.h>
+#include <stddef.h>
+#include <setjmp.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <cmocka.h>
+
+#define IIR_TEST_CHANNELS	5
+#define IIR_TEST_SECTIONS	10
+#define IIR_TEST_FRAMES		257
+#define IIR_TEST_BLOCK		16
+
+/* frames per benchmark run, 1 s of 48 kHz */
+#define IIR_BENCH_FRAMES	48000
+
+static int32_t coef[IIR_TEST_CHANNELS][IIR_TEST_SECTIONS * SOF_EQ_IIR_NBIQUAD];
+static int32_t df1_delay[2][IIR_TEST_CHANNELS][IIR_TEST_SECTIONS * IIR_DF1_NUM_STATE];
+static int64_t df2t_delay[2][IIR_TEST_CHANNELS][IIR_TEST_SECTIONS * IIR_DF2T_NUM_DELAYS];
+static int32_t in[IIR_TEST_FRAMES * IIR_TEST_CHANNELS];
+static int32_t ref[IIR_TEST_FRAMES * IIR_TEST_CHANNELS];
+static int32_t out[IIR_TEST_FRAMES * IIR_TEST_CHANNELS];
+
+/* Stable resonators with a different pole for each section and channel,
+ * coefficients order is {a2, a1, b2, b1, b0, shift, gain}.
+ */
+static void iir_test_coef(void)
+{
+	int32_t *c;
+	double r, w;
+	int ch, i;
+
+	for (ch = 0; ch < IIR_TEST_CHANNELS; ch++) {
+		for (i = 0; i < IIR_TEST_SECTIONS; i++) {
+			c = &coef[ch][i * SOF_EQ_IIR_NBIQUAD];
+			r = 0.80 + 0.015 * i;
+			w = 0.1 + 0.25 * i + 0.05 * ch;
+			c[0] = Q_CONVERT_FLOAT(-r * r, 30);
+			c[1] = Q_CONVERT_FLOAT(2.0 * r * (1.0 - w * w / 2.0), 30);
+			c[2] = Q_CONVERT_FLOAT(0.10, 30);
+			c[3] = Q_CONVERT_FLOAT(-0.20, 30);
+			c[4] = Q_CONVERT_FLOAT(0.25, 30);
+			c[5] = i & 1;
+			c[6] = Q_CONVERT_FLOAT(0.9, 14);
+		}
+	}
+}
+
+static void iir_test_input(int frames)
+{
+	int i;
+
+	srand(1);
+	for (i = 0; i < frames * IIR_TEST_CHANNELS; i++)
+		in[i] = (rand() << 16) ^ rand();
+}
+
+static void iir_test_df1_init(struct iir_state_df1 *iir, int set, int sections, int series)
+{
+	int ch;
+
+	for (ch = 0; ch < IIR_TEST_CHANNELS; ch++) {
+		iir[ch].biquads = sections;
+		iir[ch].biquads_in_series = series;
+		iir[ch].coef = coef[ch];
+		iir[ch].delay = df1_delay[set][ch];
+	}
+
+	memset(df1_delay[set], 0, sizeof(df1_delay[set]));
+}
+
+static void iir_test_df2t_init(struct iir_state_df2t *iir, int set, int sections, int series)
+{
+	int ch;
+
+	for (ch = 0; ch < IIR_TEST_CHANNELS; ch++) {
+		iir[ch].biquads = sections;
+		iir[ch].biquads_in_series = series;
+		iir[ch].coef = coef[ch];
+		iir[ch].delay = df2t_delay[set][ch];
+	}
+
+	memset(df2t_delay[set], 0, sizeof(df2t_delay[set]));
+}
+
+/* Same order as in the components, channel pairs and then the odd channel */
+static void iir_test_df1_blocks(struct iir_state_df1 *iir, const int32_t *x, int32_t *y,
+				int frames)
+{
+	const int nch = IIR_TEST_CHANNELS;
+	int n, ch;
+
+	for (; frames > 0; frames -= n) {
+		n = MIN(frames, IIR_TEST_BLOCK);
+		for (ch = 0; ch + 1 < nch; ch += 2)
+			iir_df1_block_x2(&iir[ch], &iir[ch + 1], x + ch, y + ch, n, nch);
+
+		if (ch < nch)
+			iir_df1_block(&iir[ch], x + ch, y + ch, n, nch);
+
+		x += n * nch;
+		y += n * nch;
+	}
+}
+
+static void iir_test_df2t_blocks(struct iir_state_df2t *iir, const int32_t *x, int32_t *y,
+				 int frames)
+{
+	const int nch = IIR_TEST_CHANNELS;
+	int n, ch;
+
+	for (; frames > 0; frames -= n) {
+		n = MIN(frames, IIR_TEST_BLOCK);
+		for (ch = 0; ch + 1 < nch; ch += 2)
+			iir_df2t_block_x2(&iir[ch], &iir[ch + 1], x + ch, y + ch, n, nch);
+
+		if (ch < nch)
+			iir_df2t_block(&iir[ch], x + ch, y + ch, n, nch);
+
+		x += n * nch;
+		y += n * nch;
+	}
+}
+
+static void iir_test_df1(int sections, int series, bool in_place)
+{
+	struct iir_state_df1 iir_ref[IIR_TEST_CHANNELS];
+	struct iir_state_df1 iir[IIR_TEST_CHANNELS];
+	int i;
+
+	iir_test_df1_init(iir_ref, 0, sections, series);
+	iir_test_df1_init(iir, 1, sections, series);
+
+	/* The last channel has a different topology when pairs can be used */
+	if (series == sections && sections > 1) {
+		iir_ref[IIR_TEST_CHANNELS - 2].biquads = sections - 1;
+		iir_ref[IIR_TEST_CHANNELS - 2].biquads_in_series = sections - 1;
+		iir[IIR_TEST_CHANNELS - 2].biquads = sections - 1;
+		iir[IIR_TEST_CHANNELS - 2].biquads_in_series = sections - 1;
+	}
+
+	iir_test_input(IIR_TEST_FRAMES);
+	for (i = 0; i < IIR_TEST_FRAMES * IIR_TEST_CHANNELS; i++)
+		ref[i] = iir_df1(&iir_ref[i % IIR_TEST_CHANNELS], in[i]);
+
+	if (in_place) {
+		for (i = 0; i < IIR_TEST_FRAMES * IIR_TEST_CHANNELS; i++)
+			out[i] = in[i];
+
+		iir_test_df1_blocks(iir, out, out, IIR_TEST_FRAMES);
+	} else {
+		iir_test_df1_blocks(iir, in, out, IIR_TEST_FRAMES);
+	}
+
+	assert_memory_equal(ref, out, sizeof(out));
+	assert_memory_equal(df1_delay[0], df1_delay[1], sizeof(df1_delay[0]));
+}
+
+static void iir_test_df2t(int sections, int series, bool in_place)
+{
+	struct iir_state_df2t iir_ref[IIR_TEST_CHANNELS];
+	struct iir_state_df2t iir[IIR_TEST_CHANNELS];
+	int i;
+
+	iir_test_df2t_init(iir_ref, 0, sections, series);
+	iir_test_df2t_init(iir, 1, sections, series);
+
+	if (series == sections && sections > 1) {
+		iir_ref[IIR_TEST_CHANNELS - 2].biquads = sections - 1;
+		iir_ref[IIR_TEST_CHANNELS - 2].biquads_in_series = sections - 1;
+		iir[IIR_TEST_CHANNELS - 2].biquads = sections - 1;
+		iir[IIR_TEST_CHANNELS - 2].biquads_in_series = sections - 1;
+	}
+
+	iir_test_input(IIR_TEST_FRAMES);
+	for (i = 0; i < IIR_TEST_FRAMES * IIR_TEST_CHANNELS; i++)
+		ref[i] = iir_df2t(&iir_ref[i % IIR_TEST_CHANNELS], in[i]);
+
+	if (in_place) {
+		for (i = 0; i < IIR_TEST_FRAMES * IIR_TEST_CHANNELS; i++)
+			out[i] = in[i];
+
+		iir_test_df2t_blocks(iir, out, out, IIR_TEST_FRAMES);
+	} else {
+		iir_test_df2t_blocks(iir, in, out, IIR_TEST_FRAMES);
+	}
+
+	assert_memory_equal(ref, out, sizeof(out));
+	assert_memory_equal(df2t_delay[0], df2t_delay[1], sizeof(df2t_delay[0]));
+}
+
+static void test_iir_df1_block_series(void **state)
+{
+	(void)state;
+
+	iir_test_df1(IIR_TEST_SECTIONS, IIR_TEST_SECTIONS, false);
+	iir_test_df1(IIR_TEST_SECTIONS, IIR_TEST_SECTIONS, true);
+	iir_test_df1(1, 1, false);
+}
+
+static void test_iir_df1_block_parallel(void **state)
+{
+	(void)state;
+
+	iir_test_df1(IIR_TEST_SECTIONS, IIR_TEST_SECTIONS / 2, false);
+}
+
+static void test_iir_df1_block_bypass(void **state)
+{
+	(void)state;
+
+	iir_test_df1(0, 0, false);
+}
+
+static void test_iir_df2t_block_series(void **state)
+{
+	(void)state;
+
+	iir_test_df2t(IIR_TEST_SECTIONS, IIR_TEST_SECTIONS, false);
+	iir_test_df2t(IIR_TEST_SECTIONS, IIR_TEST_SECTIONS, true);
+	iir_test_df2t(1, 1, false);
+}
+
+static void test_iir_df2t_block_parallel(void **state)
+{
+	(void)state;
+
+	iir_test_df2t(IIR_TEST_SECTIONS, IIR_TEST_SECTIONS / 2, false);
+}
+
+static void test_iir_df2t_block_bypass(void **state)
+{
+	(void)state;
+
+	iir_test_df2t(0, 0, false);
+}
+
+static double iir_bench_ns(clock_t start, clock_t end)
+{
+	return 1e9 * (end - start) / CLOCKS_PER_SEC /
+	       ((double)IIR_BENCH_FRAMES * IIR_TEST_CHANNELS * IIR_TEST_SECTIONS);
+}
+
+/* Not a pass/fail test, reports host cost per section per channel sample */
+static void test_iir_block_benchmark(void **state)
+{
+	struct iir_state_df1 df1[IIR_TEST_CHANNELS];
+	struct iir_state_df2t df2t[IIR_TEST_CHANNELS];
+	clock_t start, end;
+	int done, i;
+
+	(void)state;
+
+	iir_test_input(IIR_TEST_BLOCK);
+	iir_test_df1_init(df1, 0, IIR_TEST_SECTIONS, IIR_TEST_SECTIONS);
+	iir_test_df2t_init(df2t, 0, IIR_TEST_SECTIONS, IIR_TEST_SECTIONS);
+
+	start = clock();
+	for (done = 0; done < IIR_BENCH_FRAMES; done += IIR_TEST_BLOCK)
+		for (i = 0; i < IIR_TEST_BLOCK * IIR_TEST_CHANNELS; i++)
+			out[i] = iir_df1(&df1[i % IIR_TEST_CHANNELS], in[i]);
+	end = clock();
+	print_message("iir df1 sample: %.2f ns per section per channel sample\n",
+		      iir_bench_ns(start, end));
+
+	start = clock();
+	for (done = 0; done < IIR_BENCH_FRAMES; done += IIR_TEST_BLOCK)
+		iir_test_df1_blocks(df1, in, out, IIR_TEST_BLOCK);
+	end = clock();
+	print_message("iir df1 block: %.2f ns per section per channel sample\n",
+		      iir_bench_ns(start, end));
+
+	start = clock();
+	for (done = 0; done < IIR_BENCH_FRAMES; done += IIR_TEST_BLOCK)
+		for (i = 0; i < IIR_TEST_BLOCK * IIR_TEST_CHANNELS; i++)
+			out[i] = iir_df2t(&df2t[i % IIR_TEST_CHANNELS], in[i]);
+	end = clock();
+	print_message("iir df2t sample: %.2f ns per section per channel sample\n",
+		      iir_bench_ns(start, end));
+
+	start = clock();
+	for (done = 0; done < IIR_BENCH_FRAMES; done += IIR_TEST_BLOCK)
+		iir_test_df2t_blocks(df2t, in, out, IIR_TEST_BLOCK);
+	end = clock();
+	print_message("iir df2t block: %.2f ns per section per channel sample\n",
+		      iir_bench_ns(start, end));
+}
+
+int main(void)
+{
+	const struct CMUnitTest tests[] = {
+		cmocka_unit_test(test_iir_df1_block_series),
+		cmocka_unit_test(test_iir_df1_block_parallel),
+		cmocka_unit_test(test_iir_df1_block_bypass),
+		cmocka_unit_test(test_iir_df2t_block_series),
+		cmocka_unit_test(test_iir_df2t_block_parallel),
+		cmocka_unit_test(test_iir_df2t_block_bypass),
+		cmocka_unit_test(test_iir_block_benchmark),
+	};
+
+	iir_test_coef();
+	cmocka_set_message_output(CM_OUTPUT_TAP);
+
+	return cmocka_run_group_tests(tests, NULL, NULL);
+}
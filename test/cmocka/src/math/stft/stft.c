@@ -0,0 +1,207 @@
+// SPDX-License-Identifier: BSD-3-Clause
+//
+// Copyright(c) 2023 Intel Corporation. All rights reserved.
+
+#include <stdio.h>
+#include <stdint.h>
+#include <stdarg.h>
+#include <stddef.h>
+#include <setjmp.h>
+#include <math.h>
+#include <cmocka.h>
+#include <stdbool.h>
+
+#include <sof/audio/audio_stream.h>
+#include <sof/audio/format.h>
+#include <sof/math/fft.h>
+#include <sof/math/stft.h>
+
+#define TWO_PI		6.28318530717959
+#define SINE_SCALE_S32	2147483647.0
+#define SINE_FS		48000.0
+#define FRAME_SIZE	256
+#define PERIOD_FRAMES	64
+#define NUM_PERIODS	32
+#define TEST_SAMPLES	(PERIOD_FRAMES * NUM_PERIODS)
+#define MIN_SNR_16	30.0
+#define MIN_SNR_32	95.0
+
+static int16_t window[FRAME_SIZE];
+static int32_t in[TEST_SAMPLES];
+static int32_t out[TEST_SAMPLES];
+
+/* Periodic Hann window, its square overlap-adds to a constant with hop
+ * sizes of frame size / 4 and smaller powers of two.
+ */
+static void get_hann_window(int16_t *w, int length)
+{
+	int i;
+
+	for (i = 0; i < length; i++)
+		w[i] = (int16_t)round(32767.0 * 0.5 * (1.0 - cos(TWO_PI * i / length)));
+}
+
+static void get_sine_32(int32_t *x, double sine_freq, double scale, int length)
+{
+	double c = TWO_PI * sine_freq / SINE_FS;
+	int i;
+
+	for (i = 0; i < length; i++)
+		x[i] = (int32_t)round(scale * SINE_SCALE_S32 * sin(c * i));
+}
+
+/* Mono S32 stream over a linear buffer, the period is re-pointed per call */
+static void set_stream(struct audio_stream *stream, int32_t *data, int frames)
+{
+	stream->addr = data;
+	stream->end_addr = data + frames;
+	stream->size = frames * sizeof(int32_t);
+	stream->r_ptr = data;
+	stream->w_ptr = data;
+	audio_stream_set_frm_fmt(stream, SOF_IPC_FRAME_S32_LE);
+	audio_stream_set_channels(stream, 1);
+}
+
+static int power_peak_index(struct stft_plan *st)
+{
+	struct icomplex16 *y16 = st->fft_out;
+	struct icomplex32 *y32 = st->fft_out;
+	double pmax = 0.0;
+	double p;
+	int imax = 0;
+	int i;
+
+	for (i = 0; i <= st->fft_padded_size / 2; i++) {
+		if (st->fft_bits == 16)
+			p = (double)y16[i].real * y16[i].real + (double)y16[i].imag * y16[i].imag;
+		else
+			p = (double)y32[i].real * y32[i].real + (double)y32[i].imag * y32[i].imag;
+
+		if (p > pmax) {
+			pmax = p;
+			imax = i;
+		}
+	}
+
+	return imax;
+}
+
+static void test_stft_analysis(int fft_bits)
+{
+	struct stft_plan st = { 0 };
+	struct audio_stream source = { 0 };
+	const int hop_size = 128;
+	const int bin = 8;
+	int frames = 0;
+	int ret;
+	int i;
+
+	get_hann_window(window, FRAME_SIZE);
+	get_sine_32(in, SINE_FS * bin / FRAME_SIZE, 0.5, TEST_SAMPLES);
+	ret = stft_plan_init(&st, FRAME_SIZE, hop_size, fft_bits, PERIOD_FRAMES, window, false);
+	assert_int_equal(ret, 0);
+	assert_int_equal(st.fft_padded_size, FRAME_SIZE);
+
+	for (i = 0; i < NUM_PERIODS; i++) {
+		set_stream(&source, &in[i * PERIOD_FRAMES], PERIOD_FRAMES);
+		stft_input_s32(&st, &source, source.r_ptr, PERIOD_FRAMES, 0);
+		while (stft_analysis(&st)) {
+			assert_int_equal(power_peak_index(&st), bin);
+			frames++;
+		}
+	}
+
+	/* First frame when frame is full, then one per hop */
+	assert_int_equal(frames, (TEST_SAMPLES - FRAME_SIZE) / hop_size + 1);
+	stft_plan_free(&st);
+}
+
+static void test_stft_reconstruct(int fft_bits, double min_snr)
+{
+	struct stft_plan st = { 0 };
+	struct audio_stream source = { 0 };
+	struct audio_stream sink = { 0 };
+	const int hop_size = FRAME_SIZE / 4;
+	const int delay = FRAME_SIZE - hop_size;
+	double signal = 0.0;
+	double noise = 0.0;
+	double snr;
+	double d;
+	int ret;
+	int i;
+
+	get_hann_window(window, FRAME_SIZE);
+	get_sine_32(in, 997.0, 0.5, TEST_SAMPLES);
+	ret = stft_plan_init(&st, FRAME_SIZE, hop_size, fft_bits, PERIOD_FRAMES, window, true);
+	assert_int_equal(ret, 0);
+
+	for (i = 0; i < NUM_PERIODS; i++) {
+		set_stream(&source, &in[i * PERIOD_FRAMES], PERIOD_FRAMES);
+		set_stream(&sink, &out[i * PERIOD_FRAMES], PERIOD_FRAMES);
+		stft_input_s32(&st, &source, source.r_ptr, PERIOD_FRAMES, 0);
+		while (stft_analysis(&st))
+			stft_synthesis(&st);
+
+		stft_output_s32(&st, &sink, sink.w_ptr, PERIOD_FRAMES, 0);
+	}
+
+	/* Output is delayed by the frame overlap, skip also the samples that
+	 * are not yet summed from all overlapping frames.
+	 */
+	for (i = 2 * delay; i < TEST_SAMPLES; i++) {
+		d = (double)out[i] - in[i - delay];
+		signal += (double)in[i - delay] * in[i - delay];
+		noise += d * d;
+	}
+
+	snr = 10 * log10(signal / noise);
+	printf("%s: %d bits, SNR %5.2f dB\n", __func__, fft_bits, snr);
+	assert_true(snr > min_snr);
+	stft_plan_free(&st);
+}
+
+static void test_math_stft_analysis_16(void **state)
+{
+	(void)state;
+
+	test_stft_analysis(16);
+}
+
+static void test_math_stft_reconstruct_16(void **state)
+{
+	(void)state;
+
+	test_stft_reconstruct(16, MIN_SNR_16);
+}
+
+#if CONFIG_MATH_32BIT_FFT
+static void test_math_stft_analysis_32(void **state)
+{
+	(void)state;
+
+	test_stft_analysis(32);
+}
+
+static void test_math_stft_reconstruct_32(void **state)
+{
+	(void)state;
+
+	test_stft_reconstruct(32, MIN_SNR_32);
+}
+#endif
+
+int main(void)
+{
+	const struct CMUnitTest tests[] = {
+		cmocka_unit_test(test_math_stft_analysis_16),
+		cmocka_unit_test(test_math_stft_reconstruct_16),
+#if CONFIG_MATH_32BIT_FFT
+		cmocka_unit_test(test_math_stft_analysis_32),
+		cmocka_unit_test(test_math_stft_reconstruct_32),
+#endif
+	};
+
+	cmocka_set_message_output(CM_OUTPUT_TAP);
+
+	return cmocka_run_group_tests(tests, NULL, NULL);
+}
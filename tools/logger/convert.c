@@ -12,13 +12,18 @@
 #include <stdint.h>
 #include <string.h>
 #include <errno.h>
+#include <inttypes.h>
+#include <pthread.h>
 #include <unistd.h>
 #include <math.h>
 #include <sof/lib/uuid.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
 #include <time.h>
 #include <user/abi_dbg.h>
 #include <user/trace.h>
 #include "convert.h"
+#include "export.h"
 #include "filter.h"
 #include "misc.h"
 
@@ -43,23 +48,63 @@ struct ldc_entry_header {
 	uint32_t text_len;
 };
 
-/** Dictionary entry + unformatted parameters */
+/** Conversion of a log parameter, found when indexing the dictionary */
+enum ldc_param_type {
+	LDC_PARAM_RAW = 0,	/**< passed to printf as is */
+	LDC_PARAM_STRING,	/**< %s, not supported */
+	LDC_PARAM_UUID,		/**< %pUx, uuid entry address */
+	LDC_PARAM_ENTRY,	/**< %pQ, log entry address */
+};
+
+#define LDC_UUID_BE		(1 << 0)
+#define LDC_UUID_UPPER		(1 << 1)
+
+/* Format string errors, reported each time the entry is printed */
+#define LDC_FORMAT_INVALID	(1 << 0)
+#define LDC_FORMAT_TOO_MANY	(1 << 1)
+#define LDC_FORMAT_TOO_FEW	(1 << 2)
+
+/** Dictionary entry, parsed once from the mapped ldc file. The header and
+ * the strings point to the mapping, only the strings that need rewriting
+ * for output are copied to heap.
+ */
 struct ldc_entry {
-	struct ldc_entry_header header;
-	char *file_name;
-	char *text;
-	uint32_t *params;
+	const struct ldc_entry_header *header;
+	const char *file_name;	/**< shortened for output */
+	const char *text;	/**< printf format, %pU and %pQ replaced by %s */
+	const char *raw_text;	/**< text as in the dictionary */
+	char *file_name_buf;
+	char *text_buf;
+	uint32_t address;
+	uint8_t params_count;	/**< conversion specifiers found */
+	uint8_t format_errors;
+	uint8_t param_type[TRACE_MAX_PARAMS_COUNT];
+	uint8_t param_flags[TRACE_MAX_PARAMS_COUNT];
 };
 
-/** Dictionary entry + formatted parameters */
+/** Formatted parameters of one log statement */
 struct proc_ldc_entry {
 	int subst_mask;
-	struct ldc_entry_header header;
-	char *file_name;
-	char *text;
 	uintptr_t params[TRACE_MAX_PARAMS_COUNT];
 };
 
+/** Address to dictionary entry hash table with linear probing */
+struct ldc_index {
+	struct ldc_entry **slots;
+	uint32_t mask;
+	uint32_t count;
+};
+
+static struct ldc_index ldc_index;
+static pthread_mutex_t ldc_index_lock = PTHREAD_MUTEX_INITIALIZER;
+
+/** The whole ldc file, mapped or read to heap */
+static struct {
+	void *data;
+	size_t size;
+	bool mapped;
+} ldc_map;
+
 static const char *BAD_PTR_STR = "<bad uid ptr 0x%.8x>";
 
 #define UUID_LOWER "%s%s%s<%08x-%04x-%04x-%02x%02x-%02x%02x%02x%02x%02x%02x>%s%s%s"
@@ -67,7 +112,7 @@ static const char *BAD_PTR_STR = "<bad uid ptr 0x%.8x>";
 
 static const char *missing = "<missing>";
 
-static int read_entry_from_ldc_file(struct ldc_entry *entry, uint32_t log_entry_address);
+static const struct ldc_entry *ldc_find(uint32_t address);
 
 char *format_uid_raw(const struct sof_uuid_entry *uid_entry, int use_colors, int name_first,
 		     bool be, bool upper)
@@ -143,81 +188,55 @@ static const char *format_uid(uint32_t uid_ptr, int use_colors, bool be, bool up
 	return str;
 }
 
-/* fmt should point '%pUx`, return pointer to UUID string or zero */
-static const char *asprintf_uuid(const char *fmt, uint32_t uuid_key, bool use_colors, int *fmt_len)
+/* fmt should point '%pUx`, return length of the specifier and UUID flags */
+static int parse_uuid_format(const char *fmt, const char *fmt_end, uint8_t *flags)
 {
-	const char *fmt_end = fmt + strlen(fmt);
-	int be, upper;
 	int len = 4; /* assure full formating, with x */
 
-	if (fmt + 2 >= fmt_end || fmt[1] != 'p' || fmt[2] != 'U') {
-		*fmt_len = 0;
-		return NULL;
-	}
 	/* check 'x' value */
 	switch (fmt + 3 < fmt_end ? fmt[3] : 0) {
 	case 'b':
-		be = 1;
-		upper = 0;
+		*flags = LDC_UUID_BE;
 		break;
 	case 'B':
-		be = 1;
-		upper = 1;
+		*flags = LDC_UUID_BE | LDC_UUID_UPPER;
 		break;
 	case 'l':
-		be = 0;
-		upper = 0;
+		*flags = 0;
 		break;
 	case 'L':
-		be = 0;
-		upper = 1;
+		*flags = LDC_UUID_UPPER;
 		break;
 	default:
-		be = 0;
-		upper = 0;
+		*flags = 0;
 		--len;
 		break;
 	}
-	*fmt_len = len;
-	return format_uid(uuid_key, use_colors, be, upper);
-}
-
-static const char *asprintf_entry_text(uint32_t entry_address)
-{
-	struct ldc_entry entry;
-	int ret;
-
-	ret = read_entry_from_ldc_file(&entry, entry_address);
-	if (ret)
-		return NULL;
 
-	free(entry.file_name);
-
-	return entry.text;
+	return len;
 }
 
-/** printf-like formatting from the binary ldc_entry input to the
- *  formatted proc_lpc_entry output. Also copies the unmodified
- *  ldc_entry_header from input to output.
+/** Scans the dictionary entry text for conversion specifiers and finds
+ * the parameter types. The text is rewritten to a plain printf format
+ * when it has %pU or %pQ, otherwise the entry keeps pointing to the
+ * mapped dictionary.
  *
- * @param[out] pe copy of the header + formatted output
- * @param[in] e copy of the dictionary entry where unformatted,
-    uint32_t params have been inserted.
-   @param[in] use_colors whether to use ANSI terminal codes
-*/
-static void process_params(struct proc_ldc_entry *pe,
-			   const struct ldc_entry *e,
-			   int use_colors)
+ * @param[in,out] e dictionary entry with raw_text and header set
+ * @return 0 on success, -ENOMEM if the text copy failed
+ */
+static int parse_entry_format(struct ldc_entry *e)
 {
-	char *p = e->text;
-	const char *t_end = p + strlen(e->text);
+	char *text = strdup(e->raw_text);
+	const char *t_end;
+	bool rewritten = false;
+	char *p = text;
 	int uuid_fmt_len;
 	int i = 0;
 
-	pe->subst_mask = 0;
-	pe->header =  e->header;
-	pe->file_name = e->file_name;
-	pe->text = e->text;
+	if (!text)
+		return -ENOMEM;
+
+	t_end = p + strlen(text);
 
 	/*
 	 * Scan the text for possible replacements. We follow the Linux kernel
@@ -226,19 +245,15 @@ static void process_params(struct proc_ldc_entry *pe,
 	 * For decoding log entry text from pointer %pQ is used.
 	 */
 	while ((p = strchr(p, '%'))) {
-		uint32_t raw_param;
-
-		if (i >= e->header.params_num) {
-			/* Don't read e->params[] out of bounds. */
-			log_err("Too many %% conversion specifiers in '%s'\n",
-				e->text);
+		if (i >= e->header->params_num) {
+			/* Don't read params out of bounds. */
+			e->format_errors |= LDC_FORMAT_TOO_MANY;
 			break;
 		}
-		raw_param = e->params[i];
 
 		/* % can't be the last char */
 		if (p + 1 >= t_end) {
-			log_err("Invalid format string\n");
+			e->format_errors |= LDC_FORMAT_INVALID;
 			break;
 		}
 
@@ -247,56 +262,108 @@ static void process_params(struct proc_ldc_entry *pe,
 			/* Skip "%%" */
 			p += 2;
 		} else if (p[1] == 's') {
-			/* %s format specifier */
-			/* check for string printing, because it leads to logger crash */
-			log_err("String printing is not supported\n");
-			pe->params[i] = (uintptr_t)log_asprintf("<String @ 0x%08x>", raw_param);
-			if (!pe->params[i])
-				abort();
-			pe->subst_mask |= 1 << i;
-			++i;
+			/* %s format specifier, string printing leads to logger crash */
+			e->param_type[i++] = LDC_PARAM_STRING;
 			p += 2;
 		} else if (p + 2 < t_end && p[1] == 'p' && p[2] == 'U') {
-			/* %pUx format specifier */
-			/* substitute UUID entry address with formatted string pointer from heap */
-			pe->params[i] = (uintptr_t)asprintf_uuid(p, raw_param, use_colors,
-								 &uuid_fmt_len);
-			if (!pe->params[i])
-				abort();
-			pe->subst_mask |= 1 << i;
-			++i;
+			/* %pUx format specifier, UUID entry address */
+			uuid_fmt_len = parse_uuid_format(p, t_end, &e->param_flags[i]);
+			e->param_type[i++] = LDC_PARAM_UUID;
 			/* replace uuid formatter with %s */
 			p[1] = 's';
 			memmove(&p[2], &p[uuid_fmt_len], (int)(t_end - &p[uuid_fmt_len]) + 1);
 			p += uuid_fmt_len - 2;
 			t_end -= uuid_fmt_len - 2;
+			rewritten = true;
 		} else if (p + 2 < t_end && p[1] == 'p' && p[2] == 'Q') {
-			/* %pQ format specifier */
-			/* substitute log entry address with formatted entry text */
-			pe->params[i] = (uintptr_t)asprintf_entry_text(raw_param);
-
-			if (pe->params[i])
-				pe->subst_mask |= 1 << i;
-			else
-				pe->params[i] = (uintptr_t)missing;
-
-			++i;
-
+			/* %pQ format specifier, log entry address */
+			e->param_type[i++] = LDC_PARAM_ENTRY;
 			/* replace entry formatter with %s */
 			p[1] = 's';
 			memmove(&p[2], &p[3], t_end - &p[2]);
 			p++;
 			t_end--;
+			rewritten = true;
 		} else {
 			/* arguments different from %pU and %pQ should be passed without
 			 * modification
 			 */
-			pe->params[i] = raw_param;
-			++i;
+			e->param_type[i++] = LDC_PARAM_RAW;
 			p += 2;
 		}
 	}
-	if (i < e->header.params_num)
+	if (i < e->header->params_num)
+		e->format_errors |= LDC_FORMAT_TOO_FEW;
+
+	e->params_count = i;
+
+	if (rewritten) {
+		e->text_buf = text;
+		e->text = text;
+	} else {
+		free(text);
+		e->text = e->raw_text;
+	}
+
+	return 0;
+}
+
+/** printf-like formatting of the log statement parameters with the
+ *  conversions found when indexing the dictionary entry.
+ *
+ * @param[out] pe formatted parameters
+ * @param[in] e dictionary entry
+ * @param[in] params unformatted parameters from the log
+ * @param[in] use_colors whether to use ANSI terminal codes
+ */
+static void process_params(struct proc_ldc_entry *pe,
+			   const struct ldc_entry *e,
+			   const uint32_t *params,
+			   int use_colors)
+{
+	const struct ldc_entry *ref;
+	int i;
+
+	pe->subst_mask = 0;
+
+	for (i = 0; i < e->params_count; i++) {
+		switch (e->param_type[i]) {
+		case LDC_PARAM_STRING:
+			/* check for string printing, because it leads to logger crash */
+			log_err("String printing is not supported\n");
+			pe->params[i] = (uintptr_t)log_asprintf("<String @ 0x%08x>", params[i]);
+			if (!pe->params[i])
+				abort();
+			pe->subst_mask |= 1 << i;
+			break;
+		case LDC_PARAM_UUID:
+			/* substitute UUID entry address with formatted string pointer from heap */
+			pe->params[i] = (uintptr_t)format_uid(params[i], use_colors,
+							      e->param_flags[i] & LDC_UUID_BE,
+							      e->param_flags[i] & LDC_UUID_UPPER);
+			if (!pe->params[i])
+				abort();
+			pe->subst_mask |= 1 << i;
+			break;
+		case LDC_PARAM_ENTRY:
+			/* substitute log entry address with entry text from dictionary */
+			ref = ldc_find(params[i]);
+			pe->params[i] = ref ? (uintptr_t)ref->raw_text : (uintptr_t)missing;
+			break;
+		default:
+			pe->params[i] = params[i];
+			break;
+		}
+	}
+
+	for (; i < TRACE_MAX_PARAMS_COUNT; i++)
+		pe->params[i] = i < e->header->params_num ? params[i] : 0;
+
+	if (e->format_errors & LDC_FORMAT_TOO_MANY)
+		log_err("Too many %% conversion specifiers in '%s'\n", e->text);
+	if (e->format_errors & LDC_FORMAT_INVALID)
+		log_err("Invalid format string\n");
+	if (e->format_errors & LDC_FORMAT_TOO_FEW)
 		log_err("Too few %% conversion specifiers in '%s'\n", e->text);
 }
 
@@ -394,7 +461,7 @@ static const char *get_level_color(uint32_t level)
 	}
 }
 
-static const char *get_level_name(uint32_t level)
+const char *get_level_name(uint32_t level)
 {
 	switch (level) {
 	case LOG_LEVEL_CRITICAL:
@@ -430,9 +497,10 @@ static const char *get_component_name(uint32_t trace_class, uint32_t uid_ptr)
 }
 
 /* remove superfluous leading file path and shrink to last 20 chars */
-static char *format_file_name(char *file_name_raw, int full_name)
+static int format_file_name(struct ldc_entry *e, const char *file_name_raw, int full_name)
 {
-	char *name;
+	const char *name;
+	char *sep_pos;
 	int len;
 
 	/* most/all string should have "src" */
@@ -440,43 +508,95 @@ static char *format_file_name(char *file_name_raw, int full_name)
 	if (!name)
 		name = file_name_raw;
 
+	e->file_name = name;
 	if (full_name)
-		return name;
+		return 0;
 	/* keep the last 24 chars */
 	len = strlen(name);
 	if (len > 24) {
-		char *sep_pos = NULL;
-
 		name += (len - 24);
-		sep_pos = strchr(name, '/');
-		if (!sep_pos)
-			return name;
-		while (--sep_pos >= name)
+		e->file_name = name;
+		if (!strchr(name, '/'))
+			return 0;
+
+		/* the mapped dictionary is read-only, shorten a copy */
+		e->file_name_buf = strdup(name);
+		if (!e->file_name_buf)
+			return -ENOMEM;
+
+		sep_pos = strchr(e->file_name_buf, '/');
+		while (--sep_pos >= e->file_name_buf)
 			*sep_pos = '.';
+		e->file_name = e->file_name_buf;
 	}
-	return name;
+	return 0;
 }
 
+/** Timestamp origin and delta of one log line, see entry_timing_update() */
+struct entry_timing {
+	uint64_t origin;
+	uint64_t last_timestamp;
+	bool first;	/**< first line since start or wrap, zero DELTA */
+	bool wrap;	/**< timestamp went backwards */
+};
+
 static int entry_number = 1;
-/** Formats and outputs one entry from the trace + the corresponding
- * ldc_entry from the dictionary passed as arguments. Expects the log
- * variables to have already been copied into the ldc_entry.
+static uint64_t timestamp_origin;
+
+/** Tracks the timestamp state of the log lines in input order. This is
+ * the only part of printing that depends on the previous lines.
+ *
+ * @param[in] dma_log protocol header of the line
+ * @param[in] last_timestamp timestamp of the previous line
+ * @param[out] t timing of the line for print_entry()
  */
-static void print_entry_params(const struct log_entry_header *dma_log,
-			       const struct ldc_entry *entry, uint64_t last_timestamp)
+static void entry_timing_update(const struct log_entry_header *dma_log,
+				uint64_t last_timestamp, struct entry_timing *t)
 {
-	static uint64_t timestamp_origin;
+	t->last_timestamp = last_timestamp;
+	t->wrap = dma_log->timestamp < last_timestamp;
+	t->first = false;
 
-	FILE *out_fd = global_config->out_fd;
+	if (t->wrap)
+		entry_number = 1;
+
+	/* The first entry:
+	 *  - is never shown with a relative TIMESTAMP (to itself!?)
+	 *  - shows a zero DELTA
+	 */
+	if (entry_number == 1) {
+		entry_number++;
+		/* Display absolute (and random) timestamps */
+		timestamp_origin = 0;
+		t->first = true;
+	} else if (entry_number == 2) {
+		entry_number++;
+		if (global_config->relative_timestamps == 1)
+			/* Switch to relative timestamps from now on. */
+			timestamp_origin = last_timestamp;
+	} /* We don't need the exact entry_number after 3 */
+
+	t->origin = timestamp_origin;
+}
+
+/** Formats and outputs one entry from the trace + the corresponding
+ * ldc_entry from the dictionary passed as arguments. Does not depend on
+ * any other state than the arguments, so lines can be formatted in any
+ * order once their timing is known.
+ */
+static void print_entry_params(FILE *out_fd, const struct log_entry_header *dma_log,
+			       const struct ldc_entry *entry, const uint32_t *params,
+			       const struct entry_timing *t)
+{
 	int use_colors = global_config->use_colors;
 	int raw_output = global_config->raw_output;
 	int hide_location = global_config->hide_location;
 	int time_precision = global_config->time_precision;
 
 	char ids[TRACE_MAX_IDS_STR];
-	float dt = to_usecs(dma_log->timestamp - last_timestamp);
+	float dt = to_usecs(dma_log->timestamp - t->last_timestamp);
 	struct proc_ldc_entry proc_entry;
-	static char time_fmt[64];
+	char time_fmt[64];
 	int ret;
 
 	if (raw_output)
@@ -486,28 +606,13 @@ static void print_entry_params(const struct log_entry_header *dma_log,
 	if (dt > 1000.0 * 1000.0 * 1000.0)
 		dt = NAN;
 
-	if (dma_log->timestamp < last_timestamp) {
+	if (t->wrap)
 		fprintf(out_fd,
 			"\n\t\t --- negative DELTA = %.3f us: wrap, IPC_TRACE, other? ---\n\n",
-			-to_usecs(last_timestamp - dma_log->timestamp));
-		entry_number = 1;
-	}
+			-to_usecs(t->last_timestamp - dma_log->timestamp));
 
-	/* The first entry:
-	 *  - is never shown with a relative TIMESTAMP (to itself!?)
-	 *  - shows a zero DELTA
-	 */
-	if (entry_number == 1) {
-		entry_number++;
-		/* Display absolute (and random) timestamps */
-		timestamp_origin = 0;
+	if (t->first)
 		dt = 0;
-	} else if (entry_number == 2) {
-		entry_number++;
-		if (global_config->relative_timestamps == 1)
-			/* Switch to relative timestamps from now on. */
-			timestamp_origin = last_timestamp;
-	} /* We don't need the exact entry_number after 3 */
 
 	if (dma_log->id_0 != INVALID_TRACE_ID &&
 	    dma_log->id_1 != INVALID_TRACE_ID)
@@ -524,20 +629,18 @@ static void print_entry_params(const struct log_entry_header *dma_log,
 				 time_precision, time_precision);
 
 		fprintf(out_fd, entry_fmt,
-			entry->header.level == use_colors ?
+			entry->header->level == use_colors ?
 				(LOG_LEVEL_CRITICAL ? KRED : KNRM) : "",
 			dma_log->core_id,
-			entry->header.level,
-			get_component_name(entry->header.component_class, dma_log->uid),
+			entry->header->level,
+			get_component_name(entry->header->component_class, dma_log->uid),
 			raw_output && strlen(ids) ? "-" : "",
 			ids);
 		if (time_precision >= 0)
 			fprintf(out_fd, time_fmt,
-				to_usecs(dma_log->timestamp - timestamp_origin), dt);
+				to_usecs(dma_log->timestamp - t->origin), dt);
 		if (!hide_location)
-			fprintf(out_fd, "(%s:%u) ",
-				format_file_name(entry->file_name, raw_output),
-				entry->header.line_idx);
+			fprintf(out_fd, "(%s:%u) ", entry->file_name, entry->header->line_idx);
 	} else {
 		if (time_precision >= 0) {
 			const unsigned int ts_width = timestamp_width(time_precision);
@@ -548,7 +651,7 @@ static void print_entry_params(const struct log_entry_header *dma_log,
 
 			fprintf(out_fd, time_fmt,
 				use_colors ? KGRN : "",
-				to_usecs(dma_log->timestamp - timestamp_origin), dt,
+				to_usecs(dma_log->timestamp - t->origin), dt,
 				use_colors ? KNRM : "");
 		}
 
@@ -558,45 +661,43 @@ static void print_entry_params(const struct log_entry_header *dma_log,
 		/* component name and id */
 		fprintf(out_fd, "%s%-12s %-5s%s ",
 			use_colors ? KYEL : "",
-			get_component_name(entry->header.component_class, dma_log->uid),
+			get_component_name(entry->header->component_class, dma_log->uid),
 			ids,
 			use_colors ? KNRM : "");
 
 		/* location */
 		if (!hide_location)
-			fprintf(out_fd, "%24s:%-4u ",
-				format_file_name(entry->file_name, raw_output),
-				entry->header.line_idx);
+			fprintf(out_fd, "%24s:%-4u ", entry->file_name, entry->header->line_idx);
 
 		/* level name */
 		fprintf(out_fd, "%s%s",
-			use_colors ? get_level_color(entry->header.level) : "",
-			get_level_name(entry->header.level));
+			use_colors ? get_level_color(entry->header->level) : "",
+			get_level_name(entry->header->level));
 	}
 
 	/* Minimal, printf-like formatting */
-	process_params(&proc_entry, entry, use_colors);
+	process_params(&proc_entry, entry, params, use_colors);
 
-	switch (proc_entry.header.params_num) {
+	switch (entry->header->params_num) {
 	case 0:
-		ret = fprintf(out_fd, "%s", proc_entry.text);
+		ret = fprintf(out_fd, "%s", entry->text);
 		break;
 	case 1:
-		ret = fprintf(out_fd, proc_entry.text, proc_entry.params[0]);
+		ret = fprintf(out_fd, entry->text, proc_entry.params[0]);
 		break;
 	case 2:
-		ret = fprintf(out_fd, proc_entry.text, proc_entry.params[0], proc_entry.params[1]);
+		ret = fprintf(out_fd, entry->text, proc_entry.params[0], proc_entry.params[1]);
 		break;
 	case 3:
-		ret = fprintf(out_fd, proc_entry.text, proc_entry.params[0], proc_entry.params[1],
+		ret = fprintf(out_fd, entry->text, proc_entry.params[0], proc_entry.params[1],
 			      proc_entry.params[2]);
 		break;
 	case 4:
-		ret = fprintf(out_fd, proc_entry.text, proc_entry.params[0], proc_entry.params[1],
+		ret = fprintf(out_fd, entry->text, proc_entry.params[0], proc_entry.params[1],
 			      proc_entry.params[2], proc_entry.params[3]);
 		break;
 	default:
-		log_err("Unsupported number of arguments for '%s'", proc_entry.text);
+		log_err("Unsupported number of arguments for '%s'", entry->text);
 		ret = 0; /* don't log ferror */
 		break;
 	}
@@ -604,187 +705,647 @@ static void print_entry_params(const struct log_entry_header *dma_log,
 	/* log format text comes from ldc file (may be invalid), so error check is needed here */
 	if (ret < 0)
 		log_err("trace fprintf failed for '%s', %d '%s'",
-			proc_entry.text, ferror(out_fd), strerror(ferror(out_fd)));
+			entry->text, ferror(out_fd), strerror(ferror(out_fd)));
 	fprintf(out_fd, "%s\n", use_colors ? KNRM : "");
-	fflush(out_fd);
 }
 
-static int read_entry_from_ldc_file(struct ldc_entry *entry, uint32_t log_entry_address)
+/** Outputs a CSV field, quoted when it has separators, quotes or new lines */
+static void print_csv_string(FILE *out_fd, const char *s)
 {
-	uint32_t base_address = global_config->logs_header->base_address;
-	uint32_t data_offset = global_config->logs_header->data_offset;
+	const char *q;
 
-	int ret;
+	if (!strpbrk(s, ",\"\r\n")) {
+		fputs(s, out_fd);
+		return;
+	}
+
+	fputc('"', out_fd);
+	while ((q = strchr(s, '"'))) {
+		fwrite(s, 1, q - s + 1, out_fd);
+		fputc('"', out_fd);
+		s = q + 1;
+	}
+	fputs(s, out_fd);
+	fputc('"', out_fd);
+}
 
-	/* evaluate entry offset in input file */
-	uint32_t entry_offset = (log_entry_address - base_address) + data_offset;
+static void print_csv_header(void)
+{
+	fprintf(global_config->out_fd,
+		"timestamp,core,level,component,id_0,id_1,file,line,entry,p0,p1,p2,p3,format\n");
+	fflush(global_config->out_fd);
+}
 
-	entry->file_name = NULL;
-	entry->text = NULL;
-	entry->params = NULL;
+/** Outputs one entry as a CSV record for data processing tools. Nothing
+ * is printf-formatted from the dictionary: the timestamp is in ticks, the
+ * parameters are raw and the format text is as in the dictionary.
+ */
+static void print_entry_csv(FILE *out_fd, const struct log_entry_header *dma_log,
+			    const struct ldc_entry *entry, const uint32_t *params)
+{
+	int i;
 
-	/* set file position to beginning of processed entry */
-	fseek(global_config->ldc_fd, entry_offset, SEEK_SET);
+	fprintf(out_fd, "%" PRIu64 ",%u,%u,%s,", (uint64_t)dma_log->timestamp,
+		dma_log->core_id, entry->header->level,
+		get_component_name(entry->header->component_class, dma_log->uid));
 
-	/* fetching elf header params */
-	ret = fread(&entry->header, sizeof(entry->header), 1, global_config->ldc_fd);
-	if (ret != 1) {
-		log_err("Failed to read entry header for offset 0x%x in dictionary.\n",
-			entry_offset);
-		ret = -1;
-		goto out;
-	}
-	if (entry->header.file_name_len > TRACE_MAX_FILENAME_LEN) {
-		log_err("Invalid filename length %d or ldc file does not match firmware\n",
-			entry->header.file_name_len);
-		ret = -EINVAL;
-		goto out;
-	}
-	entry->file_name = (char *)malloc(entry->header.file_name_len);
+	if (dma_log->id_0 != INVALID_TRACE_ID &&
+	    dma_log->id_1 != INVALID_TRACE_ID)
+		fprintf(out_fd, "%d,%d,", dma_log->id_0 & TRACE_IDS_MASK,
+			dma_log->id_1 & TRACE_IDS_MASK);
+	else
+		fputs(",,", out_fd);
 
-	if (!entry->file_name) {
-		log_err("can't allocate %d byte for entry.file_name\n",
-			entry->header.file_name_len);
-		ret = -ENOMEM;
-		goto out;
-	}
+	print_csv_string(out_fd, entry->file_name);
+	fprintf(out_fd, ",%u,0x%08x,", entry->header->line_idx, entry->address);
 
-	ret = fread(entry->file_name, sizeof(char), entry->header.file_name_len,
-		    global_config->ldc_fd);
-	if (ret != entry->header.file_name_len) {
-		log_err("Failed to read source filename for offset 0x%x in dictionary.\n",
-			entry_offset);
-		ret = -1;
-		goto out;
+	for (i = 0; i < TRACE_MAX_PARAMS_COUNT; i++) {
+		if (i < entry->header->params_num)
+			fprintf(out_fd, "0x%x", params[i]);
+		fputc(',', out_fd);
 	}
 
-	/* fetching text */
-	if (entry->header.text_len > TRACE_MAX_TEXT_LEN) {
-		log_err("Invalid text length.\n");
-		ret = -EINVAL;
-		goto out;
-	}
-	entry->text = (char *)malloc(entry->header.text_len);
-	if (!entry->text) {
-		log_err("can't allocate %d byte for entry.text\n", entry->header.text_len);
-		ret = -ENOMEM;
-		goto out;
+	print_csv_string(out_fd, entry->raw_text);
+	fputc('\n', out_fd);
+}
+
+static void get_export_line(struct export_line *l, const struct log_entry_header *dma_log,
+			    const struct ldc_entry *entry, const uint32_t *params)
+{
+	const struct snd_sof_uids_header *uids_dict = global_config->uids_dict;
+	int i;
+
+	l->timestamp = dma_log->timestamp;
+	l->entry_address = entry->address;
+	l->uid = dma_log->uid;
+	l->uuid = NULL;
+	if (dma_log->uid >= uids_dict->base_address &&
+	    dma_log->uid < uids_dict->base_address + uids_dict->data_length)
+		l->uuid = get_uuid_entry(dma_log->uid);
+	l->component = get_component_name(entry->header->component_class, dma_log->uid);
+	l->file = entry->file_name;
+	l->format = entry->raw_text;
+	l->line = entry->header->line_idx;
+	l->level = entry->header->level;
+	l->params_num = entry->header->params_num;
+	for (i = 0; i < entry->header->params_num; i++)
+		l->params[i] = params[i];
+	l->core = dma_log->core_id;
+
+	if (dma_log->id_0 != INVALID_TRACE_ID &&
+	    dma_log->id_1 != INVALID_TRACE_ID) {
+		l->id_0 = dma_log->id_0 & TRACE_IDS_MASK;
+		l->id_1 = dma_log->id_1 & TRACE_IDS_MASK;
+	} else {
+		l->id_0 = EXPORT_NO_ID;
+		l->id_1 = EXPORT_NO_ID;
 	}
-	ret = fread(entry->text, sizeof(char), entry->header.text_len, global_config->ldc_fd);
-	if (ret != entry->header.text_len) {
-		log_err("Failed to read log message at offset 0x%x from dictionary.\n",
-			entry_offset);
-		ret = -1;
-		goto out;
+}
+
+static void print_entry(FILE *out_fd, const struct log_entry_header *dma_log,
+			const struct ldc_entry *entry, const uint32_t *params,
+			const struct entry_timing *t)
+{
+	struct export_line line;
+
+	switch (global_config->output_format) {
+	case LOGGER_FORMAT_CSV:
+		print_entry_csv(out_fd, dma_log, entry, params);
+		break;
+	case LOGGER_FORMAT_JSON:
+		get_export_line(&line, dma_log, entry, params);
+		export_json_line(out_fd, &line);
+		break;
+	case LOGGER_FORMAT_COLUMNS:
+	case LOGGER_FORMAT_SUMMARY:
+		/* written out at the end of input */
+		get_export_line(&line, dma_log, entry, params);
+		export_add_line(&line);
+		break;
+	default:
+		print_entry_params(out_fd, dma_log, entry, params, t);
+		break;
 	}
+}
 
-	return 0;
+/** Whole input formats are written out by export_finish() */
+static bool is_export_format(void)
+{
+	return global_config->output_format == LOGGER_FORMAT_COLUMNS ||
+	       global_config->output_format == LOGGER_FORMAT_SUMMARY;
+}
 
-out:
-	free(entry->text);
-	entry->text = NULL;
-	free(entry->file_name);
-	entry->file_name = NULL;
+/** Notes about the input itself are kept out of the machine readable formats */
+static FILE *get_notes_fd(FILE *out_fd)
+{
+	return global_config->output_format != LOGGER_FORMAT_TEXT ? stderr : out_fd;
+}
 
-	return ret;
+static void print_missing_params(FILE *out_fd, const struct ldc_entry *entry, bool eof)
+{
+	fprintf(out_fd,
+		"warn: failed to fread() %d params from the log for %s:%d\n",
+		entry->header->params_num,
+		(const char *)(entry->header + 1), entry->header->line_idx);
+
+	if (eof)
+		fprintf(out_fd, "warn: log's End Of File. Device suspend?\n");
 }
 
-/** Gets the dictionary entry matching the log entry argument, reads
- * from the log the variable number of arguments needed by this entry
- * and passes everything to print_entry_params() to finish processing
- * this log entry. So not just "fetch" but everything else after it too.
+static void print_resync(FILE *out_fd, unsigned int skipped_dwords)
+{
+	fprintf(out_fd,
+		"\nFound valid LDC address after skipping %zu bytes (one line uses %zu + 0 to 16 bytes)\n",
+		sizeof(uint32_t) * skipped_dwords, sizeof(struct log_entry_header));
+}
+
+static void free_ldc_entry(struct ldc_entry *e)
+{
+	free(e->file_name_buf);
+	free(e->text_buf);
+	free(e);
+}
+
+/** Parses the dictionary entry at the firmware address of the entry.
  *
- * @param[in] dma_log protocol header from any trace (not just from the
- * "DMA" trace)
- * @param[in,out] last_timestamp timestamp found for this entry
+ * @param[in] address log entry address in firmware
+ * @param[out] entry parsed entry, to be freed with free_ldc_entry()
+ * @return 0 on success, -EINVAL if there is no valid entry at address
  */
-static int fetch_entry(const struct log_entry_header *dma_log, uint64_t *last_timestamp)
+static int parse_ldc_entry(uint32_t address, struct ldc_entry **entry)
 {
-	struct ldc_entry entry;
+	const struct snd_sof_logs_header *logs_hdr = global_config->logs_header;
+	const uint8_t *data = (const uint8_t *)logs_hdr + logs_hdr->data_offset;
+	const struct ldc_entry_header *hdr;
+	const char *file_name;
+	struct ldc_entry *e;
+	uint32_t offset;
+	uint32_t size;
 	int ret;
 
-	ret = read_entry_from_ldc_file(&entry, dma_log->log_entry_address);
-	if (ret < 0) {
-		log_err("read_entry_from_ldc_file(0x%x) returned %d\n",
-			dma_log->log_entry_address, ret);
-		goto out;
-	}
+	/* evaluate entry offset in dictionary section */
+	offset = address - logs_hdr->base_address;
+	if (address < logs_hdr->base_address || logs_hdr->data_length < sizeof(*hdr) ||
+	    offset > logs_hdr->data_length - sizeof(*hdr))
+		return -EINVAL;
 
-	/* fetching entry params from dma dump */
-	if (entry.header.params_num > TRACE_MAX_PARAMS_COUNT) {
-		log_err("Invalid number of parameters.\n");
-		ret = -EINVAL;
-		goto out;
+	hdr = (const struct ldc_entry_header *)(data + offset);
+	if (hdr->params_num > TRACE_MAX_PARAMS_COUNT ||
+	    !hdr->file_name_len || hdr->file_name_len > TRACE_MAX_FILENAME_LEN ||
+	    !hdr->text_len || hdr->text_len > TRACE_MAX_TEXT_LEN)
+		return -EINVAL;
+
+	size = sizeof(*hdr) + hdr->file_name_len + hdr->text_len;
+	if (size > logs_hdr->data_length - offset)
+		return -EINVAL;
+
+	/* both strings must be terminated inside the entry */
+	file_name = (const char *)(hdr + 1);
+	if (file_name[hdr->file_name_len - 1] || file_name[size - sizeof(*hdr) - 1])
+		return -EINVAL;
+
+	e = calloc(1, sizeof(*e));
+	if (!e)
+		return -ENOMEM;
+
+	e->header = hdr;
+	e->address = address;
+	e->raw_text = file_name + hdr->file_name_len;
+
+	ret = format_file_name(e, file_name, global_config->raw_output);
+	if (!ret)
+		ret = parse_entry_format(e);
+	if (ret) {
+		free_ldc_entry(e);
+		return ret;
 	}
-	entry.params = (uint32_t *)malloc(sizeof(uint32_t) * entry.header.params_num);
-	if (!entry.params) {
-		log_err("can't allocate %d byte for entry.params\n",
-			(int)(sizeof(uint32_t) * entry.header.params_num));
-		ret = -ENOMEM;
-		goto out;
+
+	*entry = e;
+	return 0;
+}
+
+static uint32_t ldc_hash(uint32_t address)
+{
+	/* entries are 4 byte aligned, Knuth's multiplicative hash */
+	return (address >> 2) * 2654435761u;
+}
+
+static int ldc_index_insert(struct ldc_entry *e)
+{
+	struct ldc_entry **slots;
+	uint32_t mask;
+	uint32_t i, j;
+
+	/* keep the load factor at most 1/2 */
+	if ((ldc_index.count + 1) * 2 > ldc_index.mask + 1) {
+		mask = ldc_index.slots ? ldc_index.mask * 2 + 1 : 1023;
+		slots = calloc(mask + 1, sizeof(*slots));
+		if (!slots)
+			return -ENOMEM;
+
+		for (i = 0; ldc_index.slots && i <= ldc_index.mask; i++) {
+			if (!ldc_index.slots[i])
+				continue;
+			j = ldc_hash(ldc_index.slots[i]->address) & mask;
+			while (slots[j])
+				j = (j + 1) & mask;
+			slots[j] = ldc_index.slots[i];
+		}
+
+		free(ldc_index.slots);
+		ldc_index.slots = slots;
+		ldc_index.mask = mask;
 	}
 
-	if (global_config->serial_fd < 0) {
-		ret = fread(entry.params, sizeof(uint32_t), entry.header.params_num,
-			    global_config->in_fd);
-		if (ret != entry.header.params_num) {
-			fprintf(global_config->out_fd,
-				"warn: failed to fread() %d params from the log for %s:%d\n",
-				entry.header.params_num,
-				entry.file_name, entry.header.line_idx);
+	i = ldc_hash(e->address) & ldc_index.mask;
+	while (ldc_index.slots[i])
+		i = (i + 1) & ldc_index.mask;
+
+	ldc_index.slots[i] = e;
+	ldc_index.count++;
 
-			ret = ferror(global_config->in_fd) ? -1 : 0;
+	return 0;
+}
 
-			if (feof(global_config->in_fd))
-				fprintf(global_config->out_fd,
-					"warn: log's End Of File. Device suspend?\n");
+/** Looks up the dictionary entry of a log entry address. Addresses that
+ * were not found when building the index are parsed and added on demand.
+ *
+ * @return dictionary entry or NULL if the address has no valid entry
+ */
+static const struct ldc_entry *ldc_find(uint32_t address)
+{
+	struct ldc_entry *e = NULL;
+	uint32_t i;
 
-			goto out;
-		}
-	} else { /* serial */
-		size_t size = sizeof(uint32_t) * entry.header.params_num;
-		uint8_t *n;
+	/* %pQ parameters are looked up also by the decode workers */
+	pthread_mutex_lock(&ldc_index_lock);
 
-		/* Repeatedly read() how much we still miss until we got
-		 * enough for the number of params needed by this
-		 * particular statement.
-		 */
-		for (n = (uint8_t *)entry.params; size; n += ret, size -= ret) {
-			ret = read(global_config->serial_fd, n, size);
-			if (ret < 0) {
-				ret = -errno;
-				log_err("Failed to fread %d params from serial: %s\n",
-					entry.header.params_num, strerror(errno));
+	if (ldc_index.slots) {
+		i = ldc_hash(address) & ldc_index.mask;
+		while (ldc_index.slots[i]) {
+			if (ldc_index.slots[i]->address == address) {
+				e = ldc_index.slots[i];
 				goto out;
 			}
-			if (ret != size)
-				log_err("Partial read of %u bytes of %zu, reading more\n",
-					ret, size);
+			i = (i + 1) & ldc_index.mask;
 		}
-	} /* serial */
+	}
 
-	/* printing entry content */
-	print_entry_params(dma_log, &entry, *last_timestamp);
-	*last_timestamp = dma_log->timestamp;
+	if (parse_ldc_entry(address, &e))
+		goto out;
 
-	/* set f_ldc file position to the beginning */
-	rewind(global_config->ldc_fd);
+	if (ldc_index_insert(e)) {
+		free_ldc_entry(e);
+		e = NULL;
+	}
 
-	ret = 0;
 out:
-	/* free alocated memory */
-	free(entry.params);
-	free(entry.text);
-	free(entry.file_name);
-
-	return ret;
+	pthread_mutex_unlock(&ldc_index_lock);
+	return e;
 }
 
-static int serial_read(uint64_t *last_timestamp)
+/** Walks through the log entries section and indexes all the entries.
+ * The entries are 4 byte aligned, the linker may pad between them.
+ */
+static int build_ldc_index(void)
 {
-	struct log_entry_header dma_log;
-	size_t len;
-	uint8_t *n;
+	const struct snd_sof_logs_header *logs_hdr = global_config->logs_header;
+	struct ldc_entry *e;
+	uint32_t offset = 0;
+	uint32_t size;
+	int ret;
+
+	while (offset + sizeof(struct ldc_entry_header) <= logs_hdr->data_length) {
+		ret = parse_ldc_entry(logs_hdr->base_address + offset, &e);
+		if (ret == -ENOMEM)
+			return ret;
+		if (ret) {
+			offset += sizeof(uint32_t);
+			continue;
+		}
+
+		ret = ldc_index_insert(e);
+		if (ret) {
+			free_ldc_entry(e);
+			return ret;
+		}
+
+		size = sizeof(*e->header) + e->header->file_name_len + e->header->text_len;
+		offset += (size + sizeof(uint32_t) - 1) & ~(sizeof(uint32_t) - 1);
+	}
+
+	return 0;
+}
+
+static void free_ldc_index(void)
+{
+	uint32_t i;
+
+	for (i = 0; ldc_index.slots && i <= ldc_index.mask; i++)
+		if (ldc_index.slots[i])
+			free_ldc_entry(ldc_index.slots[i]);
+
+	free(ldc_index.slots);
+	memset(&ldc_index, 0, sizeof(ldc_index));
+}
+
+static bool is_ldc_address(uint32_t address)
+{
+	return address >= global_config->logs_header->base_address &&
+	       address <= global_config->logs_header->base_address +
+	       global_config->logs_header->data_length;
+}
+
+/** Prints a log line read in input order and fflush()es it */
+static void print_fetched_entry(const struct log_entry_header *dma_log,
+				const struct ldc_entry *entry, const uint32_t *params,
+				uint64_t *last_timestamp)
+{
+	struct entry_timing timing;
+
+	entry_timing_update(dma_log, *last_timestamp, &timing);
+	print_entry(global_config->out_fd, dma_log, entry, params, &timing);
+	fflush(global_config->out_fd);
+	*last_timestamp = dma_log->timestamp;
+}
+
+/** One compact log record, see TRACE_COMPACT_MARK in user/trace.h */
+struct compact_record {
+	uint32_t word;		/**< log entry address and TRACE_COMPACT_MARK */
+	uint8_t flags;
+	uint64_t timestamp;	/**< absolute or delta, see TRACE_COMPACT_SYNC */
+	uint64_t uid;
+	uint64_t id_0;
+	uint64_t id_1;
+	uint64_t params[TRACE_MAX_PARAMS_COUNT];
+};
+
+/** What the decoder knows after the last compact record of a core */
+struct compact_core_state {
+	uint64_t timestamp;
+	uint32_t uid;
+	uint32_t id_0;
+	uint32_t id_1;
+	unsigned int seq;	/**< of the next record */
+	bool valid;		/**< false until the next sync record */
+};
+
+static struct compact_core_state compact_state[TRACE_COMPACT_CORE_MASK + 1];
+static unsigned int compact_lost;	/**< records not decoded, not reported yet */
+
+static void compact_reset(void)
+{
+	memset(compact_state, 0, sizeof(compact_state));
+}
+
+static bool is_compact_word(uint32_t word)
+{
+	return (word & TRACE_COMPACT_MARK_MASK) == TRACE_COMPACT_MARK &&
+	       is_ldc_address(word & ~TRACE_COMPACT_MARK_MASK);
+}
+
+/** @return 1 on success, 0 when the data ends first, -EBADMSG when too long */
+static int get_varint(const uint8_t **p, const uint8_t *end, uint64_t *value)
+{
+	unsigned int shift;
+
+	*value = 0;
+	for (shift = 0; *p < end; shift += 7) {
+		if (shift >= 64)
+			return -EBADMSG;
+
+		*value |= (uint64_t)(**p & 0x7f) << shift;
+		if (!(*(*p)++ & 0x80))
+			return 1;
+	}
+
+	return 0;
+}
+
+/** Splits a compact record without using any decoder state.
+ *
+ * @param[in] data record, starting with the log entry address word
+ * @param[in] size bytes available at data
+ * @param[in] params_num arguments of the log entry
+ * @param[out] r the record
+ * @return record size in bytes, 0 when more than size bytes are needed or
+ * -EBADMSG when this is not a record
+ */
+static int compact_parse(const uint8_t *data, size_t size, uint32_t params_num,
+			 struct compact_record *r)
+{
+	const uint8_t *end = data + size;
+	const uint8_t *p = data + sizeof(uint32_t);
+	size_t record_size;
+	uint32_t i;
+	int ret;
+
+	if (params_num > TRACE_MAX_PARAMS_COUNT)
+		return -EBADMSG;
+	if (p >= end)
+		return 0;
+
+	r->word = *(const uint32_t *)data;
+	r->flags = *p++;
+	ret = get_varint(&p, end, &r->timestamp);
+
+	if (ret > 0 && (r->flags & TRACE_COMPACT_CTX)) {
+		ret = get_varint(&p, end, &r->uid);
+		if (ret > 0)
+			ret = get_varint(&p, end, &r->id_0);
+		if (ret > 0)
+			ret = get_varint(&p, end, &r->id_1);
+	}
+
+	for (i = 0; ret > 0 && i < params_num; i++)
+		ret = get_varint(&p, end, &r->params[i]);
+
+	if (ret <= 0)
+		return ret;
+
+	record_size = CEIL(p - data, sizeof(uint32_t)) * sizeof(uint32_t);
+	if (record_size > size)
+		return 0;
+
+	return record_size;
+}
+
+/** Restores the fixed header of a compact record from the previous record
+ * of the same core. Records after a gap in the sequence are counted in
+ * compact_lost until a sync record.
+ *
+ * @return false when the record cannot be decoded
+ */
+static bool compact_resolve(const struct compact_record *r, struct log_entry_header *dma_log,
+			    uint32_t *params, uint32_t params_num)
+{
+	unsigned int core = r->flags & TRACE_COMPACT_CORE_MASK;
+	unsigned int seq = (r->flags >> TRACE_COMPACT_SEQ_SHIFT) & TRACE_COMPACT_SEQ_MASK;
+	struct compact_core_state *st = &compact_state[core];
+	uint32_t i;
+
+	if (r->flags & TRACE_COMPACT_SYNC) {
+		st->timestamp = r->timestamp;
+		st->valid = true;
+	} else if (st->valid && seq == st->seq) {
+		st->timestamp += r->timestamp;
+	} else {
+		st->valid = false;
+		compact_lost++;
+		return false;
+	}
+
+	if (r->flags & TRACE_COMPACT_CTX) {
+		st->uid = r->uid;
+		st->id_0 = r->id_0 & TRACE_IDS_MASK;
+		st->id_1 = r->id_1 & TRACE_IDS_MASK;
+	}
+	st->seq = (seq + 1) & TRACE_COMPACT_SEQ_MASK;
+
+	dma_log->uid = st->uid;
+	dma_log->id_0 = st->id_0;
+	dma_log->id_1 = st->id_1;
+	dma_log->core_id = core;
+	dma_log->timestamp = st->timestamp;
+	dma_log->log_entry_address = r->word & ~TRACE_COMPACT_MARK_MASK;
+
+	for (i = 0; i < params_num; i++)
+		params[i] = r->params[i];
+
+	return true;
+}
+
+static void print_compact_lost(FILE *out_fd, unsigned int lost)
+{
+	fprintf(out_fd,
+		"warn: skipped %u compact log records following lost ones, until a sync record\n",
+		lost);
+}
+
+/** The compact record counterpart of fetch_entry(), reads the rest of the
+ * record from the input file after its first word.
+ *
+ * @param[in] word first word of the record, is_compact_word()
+ * @param[in,out] last_timestamp timestamp found for this entry
+ * @return 0 on success or end of input, -EBADMSG when this is not a
+ * record, the input is then back after word
+ */
+static int fetch_compact_entry(uint32_t word, uint64_t *last_timestamp)
+{
+	uint32_t buf[TRACE_COMPACT_SIZE_MAX(TRACE_MAX_PARAMS_COUNT) / sizeof(uint32_t)];
+	uint32_t params[TRACE_MAX_PARAMS_COUNT];
+	struct log_entry_header dma_log;
+	const struct ldc_entry *entry;
+	struct compact_record r;
+	size_t count = 1;
+	int ret;
+
+	entry = ldc_find(word & ~TRACE_COMPACT_MARK_MASK);
+	if (!entry) {
+		log_err("Invalid dictionary entry 0x%x or ldc file does not match firmware\n",
+			word & ~TRACE_COMPACT_MARK_MASK);
+		return -EINVAL;
+	}
+
+	/* read a word at a time, not to wait for input past the record */
+	buf[0] = word;
+	while (!(ret = compact_parse((const uint8_t *)buf, count * sizeof(uint32_t),
+				     entry->header->params_num, &r))) {
+		if (count == ARRAY_SIZE(buf)) {
+			ret = -EBADMSG;
+			break;
+		}
+
+		if (fread(&buf[count], sizeof(uint32_t), 1, global_config->in_fd) != 1) {
+			print_missing_params(get_notes_fd(global_config->out_fd), entry,
+					     feof(global_config->in_fd));
+			return ferror(global_config->in_fd) ? -1 : 0;
+		}
+		count++;
+	}
+
+	if (ret < 0) {
+		fseek(global_config->in_fd, -(long)((count - 1) * sizeof(uint32_t)), SEEK_CUR);
+		return ret;
+	}
+
+	if (!compact_resolve(&r, &dma_log, params, entry->header->params_num))
+		return 0;
+
+	if (compact_lost) {
+		print_compact_lost(get_notes_fd(global_config->out_fd), compact_lost);
+		compact_lost = 0;
+	}
+
+	print_fetched_entry(&dma_log, entry, params, last_timestamp);
+
+	return 0;
+}
+
+/** Gets the dictionary entry matching the log entry argument, reads
+ * from the log the variable number of arguments needed by this entry
+ * and passes everything to print_entry_params() to finish processing
+ * this log entry. So not just "fetch" but everything else after it too.
+ *
+ * @param[in] dma_log protocol header from any trace (not just from the
+ * "DMA" trace)
+ * @param[in,out] last_timestamp timestamp found for this entry
+ */
+static int fetch_entry(const struct log_entry_header *dma_log, uint64_t *last_timestamp)
+{
+	uint32_t params[TRACE_MAX_PARAMS_COUNT];
+	const struct ldc_entry *entry;
+	int ret;
+
+	entry = ldc_find(dma_log->log_entry_address);
+	if (!entry) {
+		log_err("Invalid dictionary entry 0x%x or ldc file does not match firmware\n",
+			dma_log->log_entry_address);
+		return -EINVAL;
+	}
+
+	/* fetching entry params from dma dump */
+	if (global_config->serial_fd < 0) {
+		ret = fread(params, sizeof(uint32_t), entry->header->params_num,
+			    global_config->in_fd);
+		if (ret != entry->header->params_num) {
+			print_missing_params(get_notes_fd(global_config->out_fd), entry,
+					     feof(global_config->in_fd));
+
+			return ferror(global_config->in_fd) ? -1 : 0;
+		}
+	} else { /* serial */
+		size_t size = sizeof(uint32_t) * entry->header->params_num;
+		uint8_t *n;
+
+		/* Repeatedly read() how much we still miss until we got
+		 * enough for the number of params needed by this
+		 * particular statement.
+		 */
+		for (n = (uint8_t *)params; size; n += ret, size -= ret) {
+			ret = read(global_config->serial_fd, n, size);
+			if (ret < 0) {
+				ret = -errno;
+				log_err("Failed to fread %d params from serial: %s\n",
+					entry->header->params_num, strerror(errno));
+				return ret;
+			}
+			if (ret != size)
+				log_err("Partial read of %u bytes of %zu, reading more\n",
+					ret, size);
+		}
+	} /* serial */
+
+	print_fetched_entry(dma_log, entry, params, last_timestamp);
+
+	return 0;
+}
+
+static int serial_read(uint64_t *last_timestamp)
+{
+	struct log_entry_header dma_log;
+	size_t len;
+	uint8_t *n;
 	int ret;
 
 	for (len = 0, n = (uint8_t *)&dma_log; len < sizeof(dma_log); n += sizeof(uint32_t)) {
@@ -833,19 +1394,424 @@ static int serial_read(uint64_t *last_timestamp)
 	return fetch_entry(&dma_log, last_timestamp);
 }
 
+/** Log lines formatted by one decode job */
+#define DECODE_CHUNK_RECORDS	2048
+
+/** One log line of an offline input, split from the input in order */
+struct log_record {
+	struct log_entry_header dma_log;
+	uint32_t params[TRACE_MAX_PARAMS_COUNT];
+	const struct ldc_entry *entry;	/**< NULL for a note only */
+	struct entry_timing timing;
+	uint32_t skipped_dwords;	/**< skipped before the line */
+	uint32_t lost;			/**< compact records lost before the line */
+	bool truncated;			/**< params cut by the end of input */
+};
+
+struct decode_chunk {
+	struct log_record records[DECODE_CHUNK_RECORDS];
+	unsigned int count;
+	char *out;		/**< formatted output, from open_memstream() */
+	size_t out_size;
+	bool done;
+	int ret;
+};
+
+/** Threads formatting chunks of log lines, the chunks are in a ring and
+ * written out in the order they were queued.
+ */
+struct decode_pool {
+	pthread_mutex_t lock;
+	pthread_cond_t queued;	/**< a chunk was queued or the pool stops */
+	pthread_cond_t done;	/**< a chunk was formatted */
+	struct decode_chunk *chunks;
+	unsigned int slots;
+	unsigned int head;	/**< next chunk to write out */
+	unsigned int next;	/**< next chunk to format */
+	unsigned int tail;	/**< next chunk to fill */
+	bool stop;
+	pthread_t *threads;
+	unsigned int thread_count;
+};
+
+static void format_chunk(struct decode_chunk *c)
+{
+	const struct log_record *r;
+	FILE *out_fd;
+	FILE *notes_fd;
+	unsigned int i;
+
+	out_fd = open_memstream(&c->out, &c->out_size);
+	if (!out_fd) {
+		c->ret = -errno;
+		return;
+	}
+	notes_fd = get_notes_fd(out_fd);
+
+	/* keep the error copies in line with the output */
+	log_err_redirect(out_fd);
+
+	for (i = 0; i < c->count; i++) {
+		r = &c->records[i];
+		if (r->skipped_dwords)
+			print_resync(notes_fd, r->skipped_dwords);
+		if (r->lost)
+			print_compact_lost(notes_fd, r->lost);
+		if (!r->entry)
+			continue;
+		if (r->truncated)
+			print_missing_params(notes_fd, r->entry, true);
+		else
+			print_entry(out_fd, &r->dma_log, r->entry, r->params, &r->timing);
+	}
+
+	log_err_redirect(NULL);
+
+	if (fclose(out_fd))
+		c->ret = -errno;
+}
+
+static void *decode_worker(void *data)
+{
+	struct decode_pool *pool = data;
+	struct decode_chunk *c;
+
+	pthread_mutex_lock(&pool->lock);
+	for (;;) {
+		while (pool->next == pool->tail && !pool->stop)
+			pthread_cond_wait(&pool->queued, &pool->lock);
+		if (pool->next == pool->tail)
+			break;
+
+		c = &pool->chunks[pool->next++ % pool->slots];
+		pthread_mutex_unlock(&pool->lock);
+
+		format_chunk(c);
+
+		pthread_mutex_lock(&pool->lock);
+		c->done = true;
+		pthread_cond_signal(&pool->done);
+	}
+	pthread_mutex_unlock(&pool->lock);
+
+	return NULL;
+}
+
+static void decode_pool_free(struct decode_pool *pool)
+{
+	unsigned int i;
+
+	pthread_mutex_lock(&pool->lock);
+	pool->stop = true;
+	pthread_cond_broadcast(&pool->queued);
+	pthread_mutex_unlock(&pool->lock);
+
+	for (i = 0; i < pool->thread_count; i++)
+		pthread_join(pool->threads[i], NULL);
+
+	for (i = 0; i < pool->slots; i++)
+		free(pool->chunks[i].out);
+
+	pthread_cond_destroy(&pool->done);
+	pthread_cond_destroy(&pool->queued);
+	pthread_mutex_destroy(&pool->lock);
+	free(pool->threads);
+	free(pool->chunks);
+}
+
+static int decode_pool_init(struct decode_pool *pool, unsigned int threads)
+{
+	int ret;
+
+	memset(pool, 0, sizeof(*pool));
+	pthread_mutex_init(&pool->lock, NULL);
+	pthread_cond_init(&pool->queued, NULL);
+	pthread_cond_init(&pool->done, NULL);
+
+	/* two chunks per thread keep the threads busy while one is written */
+	pool->slots = 2 * threads;
+	pool->chunks = calloc(pool->slots, sizeof(*pool->chunks));
+	pool->threads = calloc(threads, sizeof(*pool->threads));
+	if (!pool->chunks || !pool->threads) {
+		decode_pool_free(pool);
+		return -ENOMEM;
+	}
+
+	for (; pool->thread_count < threads; pool->thread_count++) {
+		ret = pthread_create(&pool->threads[pool->thread_count], NULL,
+				     decode_worker, pool);
+		if (ret) {
+			log_err("can't create decode thread: %s\n", strerror(ret));
+			decode_pool_free(pool);
+			return -ret;
+		}
+	}
+
+	return 0;
+}
+
+/** Waits for the oldest chunk to be formatted and writes it out */
+static int decode_pool_write(struct decode_pool *pool)
+{
+	struct decode_chunk *c = &pool->chunks[pool->head % pool->slots];
+	FILE *out_fd = global_config->out_fd;
+	int ret;
+
+	pthread_mutex_lock(&pool->lock);
+	while (!c->done)
+		pthread_cond_wait(&pool->done, &pool->lock);
+	pthread_mutex_unlock(&pool->lock);
+
+	ret = c->ret;
+	if (!ret && c->out_size && fwrite(c->out, c->out_size, 1, out_fd) != 1)
+		ret = -ferror(out_fd);
+
+	free(c->out);
+	c->out = NULL;
+	c->out_size = 0;
+	c->count = 0;
+	c->done = false;
+	c->ret = 0;
+	pool->head++;
+
+	return ret;
+}
+
+/** Gets the chunk to fill, writes out the oldest one first if needed */
+static struct decode_chunk *decode_pool_get(struct decode_pool *pool, int *ret)
+{
+	if (pool->tail - pool->head == pool->slots) {
+		*ret = decode_pool_write(pool);
+		if (*ret)
+			return NULL;
+	}
+
+	return &pool->chunks[pool->tail % pool->slots];
+}
+
+static void decode_pool_queue(struct decode_pool *pool)
+{
+	pthread_mutex_lock(&pool->lock);
+	pool->tail++;
+	pthread_cond_signal(&pool->queued);
+	pthread_mutex_unlock(&pool->lock);
+}
+
+/** Decodes a whole offline input on global_config->threads threads. The
+ * log lines are split from the input on the calling thread, which also
+ * tracks the timestamps across lines, so the output is the same as from
+ * the sequential logger_read() loop.
+ *
+ * @param[in] data input file contents
+ * @param[in] size input file size
+ * @param[out] skipped_dwords dwords skipped after the last line
+ */
+static int logger_read_parallel(const uint8_t *data, size_t size,
+				unsigned int *skipped_dwords)
+{
+	struct log_entry_header dma_log;
+	struct compact_record compact_r;
+	struct decode_pool pool;
+	struct decode_chunk *c = NULL;
+	struct log_record *r;
+	uint64_t last_timestamp = 0;
+	size_t params_size;
+	size_t pos = 0;
+	int record_size;
+	bool compact;
+	uint32_t word;
+	int err;
+	int ret;
+	int i;
+
+	ret = decode_pool_init(&pool, global_config->threads);
+	if (ret)
+		return ret;
+
+	*skipped_dwords = 0;
+
+	while (pos + sizeof(uint32_t) <= size) {
+		word = *(const uint32_t *)(data + pos);
+		compact = is_compact_word(word);
+
+		if (!compact && pos + sizeof(dma_log) > size)
+			break;
+
+		/* packed, can be read from any offset */
+		if (!compact)
+			dma_log = *(const struct log_entry_header *)(data + pos);
+
+		/* move forward by one DWORD until the address is in the dictionary */
+		if (!compact && !is_ldc_address(dma_log.log_entry_address)) {
+			pos += sizeof(uint32_t);
+			(*skipped_dwords)++;
+			continue;
+		}
+
+		if (!c) {
+			c = decode_pool_get(&pool, &ret);
+			if (!c)
+				break;
+		}
+
+		r = &c->records[c->count++];
+		r->skipped_dwords = *skipped_dwords;
+		r->lost = 0;
+		*skipped_dwords = 0;
+
+		if (compact) {
+			dma_log.log_entry_address = word & ~TRACE_COMPACT_MARK_MASK;
+			r->entry = ldc_find(dma_log.log_entry_address);
+			if (!r->entry) {
+				ret = -EINVAL;
+				break;
+			}
+
+			record_size = compact_parse(data + pos, size - pos,
+						    r->entry->header->params_num, &compact_r);
+			r->truncated = !record_size;
+			if (r->truncated)
+				break;
+
+			if (record_size < 0 ||
+			    !compact_resolve(&compact_r, &dma_log, r->params,
+					     r->entry->header->params_num)) {
+				/* not a line, keep the notes for the next one */
+				c->count--;
+				*skipped_dwords = r->skipped_dwords;
+				if (record_size < 0) {
+					pos += sizeof(uint32_t);
+					(*skipped_dwords)++;
+				} else {
+					pos += record_size;
+				}
+				continue;
+			}
+
+			pos += record_size;
+			r->lost = compact_lost;
+			compact_lost = 0;
+		} else {
+			r->entry = ldc_find(dma_log.log_entry_address);
+			if (!r->entry) {
+				ret = -EINVAL;
+				break;
+			}
+
+			pos += sizeof(dma_log);
+			params_size = sizeof(uint32_t) * r->entry->header->params_num;
+			r->truncated = pos + params_size > size;
+			if (r->truncated)
+				break;
+
+			for (i = 0; i < r->entry->header->params_num; i++)
+				r->params[i] = ((const uint32_t *)(data + pos))[i];
+			pos += params_size;
+		}
+
+		r->dma_log = dma_log;
+		entry_timing_update(&dma_log, last_timestamp, &r->timing);
+		last_timestamp = dma_log.timestamp;
+
+		if (c->count == DECODE_CHUNK_RECORDS) {
+			decode_pool_queue(&pool);
+			c = NULL;
+		}
+	}
+
+	if (c)
+		decode_pool_queue(&pool);
+
+	while (pool.head != pool.tail) {
+		err = decode_pool_write(&pool);
+		if (err && !ret)
+			ret = err;
+	}
+
+	decode_pool_free(&pool);
+	fflush(global_config->out_fd);
+
+	if (ret == -EINVAL) {
+		log_err("Invalid dictionary entry 0x%x or ldc file does not match firmware\n",
+			dma_log.log_entry_address);
+		log_err("fetch_entry() failed with: %d, aborting\n", ret);
+	}
+
+	return ret;
+}
+
+/** Maps a regular input file for logger_read_parallel() */
+static const uint8_t *map_input_file(size_t *size)
+{
+	struct stat st;
+	void *data;
+
+	if (fstat(fileno(global_config->in_fd), &st) || !S_ISREG(st.st_mode) ||
+	    st.st_size <= 0)
+		return NULL;
+
+	data = mmap(NULL, st.st_size, PROT_READ, MAP_PRIVATE,
+		    fileno(global_config->in_fd), 0);
+	if (data == MAP_FAILED)
+		return NULL;
+
+	*size = st.st_size;
+	return data;
+}
+
+static void print_skipped_tail(unsigned int skipped_dwords)
+{
+	FILE *out_fd = get_notes_fd(global_config->out_fd);
+
+	if (compact_lost)
+		print_compact_lost(out_fd, compact_lost);
+
+	/* End of (etrace) file */
+	fprintf(out_fd,
+		"Skipped %zu bytes after the last statement",
+		sizeof(uint32_t) * skipped_dwords);
+
+	if (!global_config->trace &&
+	    /* maximum 4 arguments supported */
+	    skipped_dwords < sizeof(struct log_entry_header) + 4 * sizeof(uint32_t))
+		fprintf(out_fd,
+			". Potential mailbox wrap, check the start of the output for later logs");
+
+	fprintf(out_fd, ".\n");
+}
+
 /** Main logger loop */
 static int logger_read(void)
 {
 	struct log_entry_header dma_log;
 	int ret = 0;
 	uint64_t last_timestamp = 0;
+	const uint8_t *data;
+	size_t size;
 
 	bool ldc_address_OK = false;
 	unsigned int skipped_dwords = 0;
+	bool compact;
+	int err;
 
-	if (!global_config->raw_output)
+	if (global_config->output_format == LOGGER_FORMAT_CSV)
+		print_csv_header();
+	else if (global_config->output_format == LOGGER_FORMAT_TEXT &&
+		 !global_config->raw_output)
 		print_table_header();
 
+	/* offline input files can be decoded in parallel */
+	if (global_config->threads > 1 && !global_config->trace &&
+	    global_config->serial_fd < 0 && !is_export_format()) {
+		data = map_input_file(&size);
+		if (data) {
+			ret = logger_read_parallel(data, size, &skipped_dwords);
+			munmap((void *)data, size);
+			print_skipped_tail(skipped_dwords);
+			return ret;
+		}
+	}
+
 	if (global_config->serial_fd >= 0)
 		/* Wait for CTRL-C */
 		for (;;) {
@@ -856,8 +1822,14 @@ static int logger_read(void)
 
 	/* One iteration per log statement */
 	while (!ferror(global_config->in_fd)) {
-		/* getting entry parameters from dma dump */
-		ret = fread(&dma_log, sizeof(dma_log), 1, global_config->in_fd);
+		/* getting entry parameters from dma dump, a compact record is
+		 * known from its first word
+		 */
+		ret = fread(&dma_log, sizeof(uint32_t), 1, global_config->in_fd);
+		compact = ret == 1 && is_compact_word(dma_log.uid);
+		if (ret == 1 && !compact)
+			ret = fread((uint32_t *)&dma_log + 1, sizeof(dma_log) - sizeof(uint32_t), 1,
+				    global_config->in_fd);
 		if (ret != 1) {
 			/*
 			 * use ferror (not errno) to check fread fail -
@@ -872,12 +1844,13 @@ static int logger_read(void)
 			}
 			/* for trace mode, try to reopen */
 			if (global_config->trace) {
-				fprintf(global_config->out_fd,
+				fprintf(get_notes_fd(global_config->out_fd),
 					"\n       ---- %s; %s -----\n\n",
 					"Re-opening trace input file",
 					"device suspend?");
 				if (freopen(NULL, "rb", global_config->in_fd)) {
 					entry_number = 1;
+					compact_reset();
 					continue;
 				} else {
 					log_err("in %s(), freopen(..., %s) failed: %s(%d)\n",
@@ -898,9 +1871,7 @@ static int logger_read(void)
 		/* checking if received trace address is located in
 		 * entry section in elf file.
 		 */
-		if (dma_log.log_entry_address < global_config->logs_header->base_address ||
-		    dma_log.log_entry_address > global_config->logs_header->base_address +
-		    global_config->logs_header->data_length) {
+		if (!compact && !is_ldc_address(dma_log.log_entry_address)) {
 			/* Finding uninitialized and incomplete log statements in the
 			 * mailbox ring buffer is routine. Take note in both cases but
 			 * report errors only for the DMA trace.
@@ -908,7 +1879,7 @@ static int logger_read(void)
 			if (global_config->trace && ldc_address_OK) {
 				log_err("log_entry_address %#10x is not in dictionary range!\n",
 					dma_log.log_entry_address);
-				fprintf(global_config->out_fd,
+				fprintf(get_notes_fd(global_config->out_fd),
 					"warn: Seeking forward 4 bytes at a time until re-synchronize.\n");
 			}
 			ldc_address_OK = false;
@@ -926,11 +1897,8 @@ static int logger_read(void)
 			/* At this point, skipped_dwords can be == 0
 			 * only when we just started to run.
 			 */
-			if (skipped_dwords != 0) {
-				fprintf(global_config->out_fd,
-					"\nFound valid LDC address after skipping %zu bytes (one line uses %zu + 0 to 16 bytes)\n",
-				       sizeof(uint32_t) * skipped_dwords, sizeof(dma_log));
-			}
+			if (skipped_dwords != 0)
+				print_resync(get_notes_fd(global_config->out_fd), skipped_dwords);
 
 			ldc_address_OK = true;
 			skipped_dwords = 0;
@@ -940,25 +1908,29 @@ static int logger_read(void)
 		 * arguments needed and finish the entire processing of
 		 * this log line.
 		 */
-		ret = fetch_entry(&dma_log, &last_timestamp);
+		if (compact) {
+			ret = fetch_compact_entry(dma_log.uid, &last_timestamp);
+			if (ret == -EBADMSG) {
+				ldc_address_OK = false;
+				skipped_dwords++;
+				continue;
+			}
+		} else {
+			ret = fetch_entry(&dma_log, &last_timestamp);
+		}
 		if (ret) {
 			log_err("fetch_entry() failed with: %d, aborting\n", ret);
 			break;
 		}
 	} /* next log entry */
 
-	/* End of (etrace) file */
-	fprintf(global_config->out_fd,
-		"Skipped %zu bytes after the last statement",
-		sizeof(uint32_t) * skipped_dwords);
-
-	if (!global_config->trace &&
-	    /* maximum 4 arguments supported */
-	    skipped_dwords < sizeof(dma_log) + 4 * sizeof(uint32_t))
-		fprintf(global_config->out_fd,
-			". Potential mailbox wrap, check the start of the output for later logs");
+	print_skipped_tail(skipped_dwords);
 
-	fprintf(global_config->out_fd, ".\n");
+	if (is_export_format()) {
+		err = export_finish(global_config->out_fd);
+		if (err && !ret)
+			ret = err;
+	}
 
 	return ret;
 }
@@ -1009,6 +1981,7 @@ static int dump_ldc_info(void)
 		SOF_ABI_VERSION_PATCH(global_config->logs_header->version.abi_version));
 	fprintf(out_fd, "ldc_file src checksum\t\t0x%08x\n",
 		global_config->logs_header->version.src_hash);
+	fprintf(out_fd, "ldc_file log entries\t\t%u\n", ldc_index.count);
 
 	if (global_config->version_fd) {
 		struct sof_ipc_fw_version ver;
@@ -1048,40 +2021,89 @@ static int dump_ldc_info(void)
 	return 0;
 }
 
+/** Maps the whole ldc file, or reads it to heap if it can't be mapped */
+static int map_ldc_file(void)
+{
+	FILE *ldc_fd = global_config->ldc_fd;
+	struct stat st;
+	void *data;
+
+	if (fstat(fileno(ldc_fd), &st) || st.st_size <= 0) {
+		log_err("Error while reading %s.\n", global_config->ldc_file);
+		return -EINVAL;
+	}
+
+	data = mmap(NULL, st.st_size, PROT_READ, MAP_PRIVATE, fileno(ldc_fd), 0);
+	if (data != MAP_FAILED) {
+		ldc_map.mapped = true;
+	} else {
+		data = malloc(st.st_size);
+		if (!data) {
+			log_err("can't allocate %zu bytes for %s\n", (size_t)st.st_size,
+				global_config->ldc_file);
+			return -ENOMEM;
+		}
+		if (fread(data, st.st_size, 1, ldc_fd) != 1) {
+			log_err("Error while reading %s.\n", global_config->ldc_file);
+			free(data);
+			return -ferror(ldc_fd);
+		}
+	}
+
+	ldc_map.data = data;
+	ldc_map.size = st.st_size;
+
+	return 0;
+}
+
+static void unmap_ldc_file(void)
+{
+	if (ldc_map.mapped)
+		munmap(ldc_map.data, ldc_map.size);
+	else
+		free(ldc_map.data);
+
+	memset(&ldc_map, 0, sizeof(ldc_map));
+}
+
 int convert(void)
 {
-	struct snd_sof_logs_header * const logs_hdr = malloc(sizeof(*logs_hdr));
-	struct snd_sof_uids_header uids_hdr;
-	int count, ret = 0;
+	struct snd_sof_logs_header *logs_hdr;
+	struct snd_sof_uids_header *uids_hdr;
+	size_t uids_offset;
+	int ret = 0;
 
 	/* const pointer initialized at build time */
 	if (!global_config)
 		abort();
 
-	if (!logs_hdr)
-		abort();
-
 	/* just a shorter alias */
 	struct convert_config * const config = global_config;
 
+	ret = map_ldc_file();
+	if (ret)
+		return ret;
+
+	logs_hdr = ldc_map.data;
 	config->logs_header = logs_hdr;
 
-	count = fread(logs_hdr, sizeof(*logs_hdr), 1, config->ldc_fd);
-	if (!count) {
+	if (ldc_map.size < sizeof(*logs_hdr)) {
 		log_err("Error while reading %s.\n", config->ldc_file);
-		return -ferror(config->ldc_fd);
+		ret = -EINVAL;
+		goto out;
 	}
 
 	if (strncmp((char *)logs_hdr->sig, SND_SOF_LOGS_SIG, SND_SOF_LOGS_SIG_SIZE)) {
 		log_err("Invalid ldc file signature.\n");
-		return -EINVAL;
+		ret = -EINVAL;
+		goto out;
 	}
 
 	if (global_config->version_fw && /* -n option */
 	    !global_config->dump_ldc) {
 		ret = verify_ldc_checksum(logs_hdr->version.src_hash);
 		if (ret)
-			return ret;
+			goto out;
 	}
 
 	/* default logger and ldc_file abi verification */
@@ -1097,32 +2119,34 @@ int convert(void)
 			SOF_ABI_VERSION_MAJOR(logs_hdr->version.abi_version),
 			SOF_ABI_VERSION_MINOR(logs_hdr->version.abi_version),
 			SOF_ABI_VERSION_PATCH(logs_hdr->version.abi_version));
-		return -EINVAL;
+		ret = -EINVAL;
+		goto out;
 	}
 
-	/* read uuid section header */
-	fseek(config->ldc_fd, logs_hdr->data_offset + logs_hdr->data_length, SEEK_SET);
-	count = fread(&uids_hdr, sizeof(uids_hdr), 1, config->ldc_fd);
-	if (!count) {
+	/* uuid section follows the log entries */
+	uids_offset = (size_t)logs_hdr->data_offset + logs_hdr->data_length;
+	if (uids_offset + sizeof(*uids_hdr) > ldc_map.size) {
 		log_err("Error while reading uuids header from %s.\n", config->ldc_file);
-		return -ferror(config->ldc_fd);
+		ret = -EINVAL;
+		goto out;
 	}
-	if (strncmp((char *)uids_hdr.sig, SND_SOF_UIDS_SIG,
+	uids_hdr = (struct snd_sof_uids_header *)((uint8_t *)ldc_map.data + uids_offset);
+	if (strncmp((char *)uids_hdr->sig, SND_SOF_UIDS_SIG,
 		    SND_SOF_UIDS_SIG_SIZE)) {
 		log_err("invalid uuid section signature.\n");
-		return -EINVAL;
-	}
-	config->uids_dict = calloc(1, sizeof(uids_hdr) + uids_hdr.data_length);
-	if (!config->uids_dict) {
-		log_err("failed to alloc memory for uuids.\n");
-		return -ENOMEM;
+		ret = -EINVAL;
+		goto out;
 	}
-	memcpy(config->uids_dict, &uids_hdr, sizeof(uids_hdr));
-	count = fread(config->uids_dict + 1, uids_hdr.data_length, 1,
-		      config->ldc_fd);
-	if (!count) {
+	if (uids_offset + uids_hdr->data_offset + uids_hdr->data_length > ldc_map.size) {
 		log_err("failed to read uuid section data.\n");
-		ret = -ferror(config->ldc_fd);
+		ret = -EINVAL;
+		goto out;
+	}
+	config->uids_dict = uids_hdr;
+
+	ret = build_ldc_index();
+	if (ret) {
+		log_err("failed to index %s, %d.\n", config->ldc_file, ret);
 		goto out;
 	}
 
@@ -1141,6 +2165,9 @@ int convert(void)
 
 	ret = logger_read();
 out:
-	free(config->uids_dict);
+	free_ldc_index();
+	config->uids_dict = NULL;
+	config->logs_header = NULL;
+	unmap_ldc_file();
 	return ret;
 }
@@ -21,6 +21,14 @@
 #define KYEL	"\x1B[33m"
 #define KBLU	"\x1B[34m"
 
+enum logger_format {
+	LOGGER_FORMAT_TEXT = 0,
+	LOGGER_FORMAT_CSV,
+	LOGGER_FORMAT_JSON,
+	LOGGER_FORMAT_COLUMNS,
+	LOGGER_FORMAT_SUMMARY,
+};
+
 struct convert_config {
 	const char *out_file;
 	const char *in_file;
@@ -42,11 +50,14 @@ struct convert_config {
 	int hide_location;
 	int relative_timestamps;
 	int time_precision;
+	int output_format;	/**< enum logger_format */
+	int threads;		/**< offline input decode threads */
 	struct snd_sof_uids_header *uids_dict;
 	struct snd_sof_logs_header *logs_header;
 };
 
 uint32_t get_uuid_key(const struct sof_uuid_entry *entry);
+const char *get_level_name(uint32_t level);
 
 /* pointer to config for global context */
 extern struct convert_config * const global_config;
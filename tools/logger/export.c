@@ -0,0 +1,609 @@
+// SPDX-License-Identifier: BSD-3-Clause
+//
+// Copyright(c) 2023 Intel Corporation. All rights reserved.
+
+#include <errno.h>
+#include <inttypes.h>
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <user/trace.h>
+#include "convert.h"
+#include "export.h"
+#include "misc.h"
+
+#define EXPORT_NO_ROW		UINT32_MAX
+#define EXPORT_COLUMN_ALIGN	8
+
+/* columns written by write_columns() */
+#define EXPORT_LOG_COLUMNS	12
+#define EXPORT_SITE_COLUMNS	5
+#define EXPORT_COMP_COLUMNS	3
+
+/** Log line of the columnar export, transposed to columns when written */
+struct export_row {
+	uint64_t timestamp;
+	uint32_t params[EXPORT_MAX_PARAMS];
+	uint32_t site;
+	uint32_t comp;
+	uint16_t id_0;
+	uint16_t id_1;
+	uint8_t core;
+	uint8_t level;
+	uint8_t params_num;
+};
+
+struct export_site {
+	uint32_t entry_address;
+	uint32_t line;
+	uint32_t level;
+	const char *file;
+	const char *format;
+	uint64_t count;
+	uint64_t last_timestamp;
+	uint64_t gaps;		/**< inter-arrival intervals seen */
+	uint64_t gap_sum;
+	uint64_t gap_min;
+	uint64_t gap_max;
+};
+
+struct export_comp {
+	uint32_t uid;
+	const char *name;
+	const struct sof_uuid_entry *uuid;
+	uint64_t count;
+	uint64_t errors;
+	uint64_t warnings;
+};
+
+/** Key to table row hash map with linear probing */
+struct export_map {
+	uint32_t *keys;
+	uint32_t *rows;		/**< EXPORT_NO_ROW for a free slot */
+	uint32_t mask;
+	uint32_t count;
+};
+
+static struct {
+	struct export_row *rows;
+	size_t row_count;
+	size_t row_size;
+	struct export_site *sites;
+	uint32_t site_count;
+	uint32_t site_size;
+	struct export_comp *comps;
+	uint32_t comp_count;
+	uint32_t comp_size;
+	struct export_map site_map;
+	struct export_map comp_map;
+} export;
+
+static void *export_grow(void *array, size_t *size, size_t elem_size)
+{
+	size_t new_size = *size ? *size * 2 : 256;
+
+	array = realloc(array, new_size * elem_size);
+	if (!array) {
+		log_err("can't allocate memory for %zu export rows\n", new_size);
+		exit(EXIT_FAILURE);
+	}
+
+	*size = new_size;
+	return array;
+}
+
+static uint32_t export_hash(uint32_t key)
+{
+	/* keys are 4 byte aligned addresses, Knuth's multiplicative hash */
+	return (key >> 2) * 2654435761u;
+}
+
+static uint32_t export_map_find(const struct export_map *map, uint32_t key)
+{
+	uint32_t i;
+
+	if (!map->keys)
+		return EXPORT_NO_ROW;
+
+	for (i = export_hash(key) & map->mask; map->rows[i] != EXPORT_NO_ROW;
+	     i = (i + 1) & map->mask)
+		if (map->keys[i] == key)
+			return map->rows[i];
+
+	return EXPORT_NO_ROW;
+}
+
+static void export_map_slot(struct export_map *map, uint32_t key, uint32_t row)
+{
+	uint32_t i = export_hash(key) & map->mask;
+
+	while (map->rows[i] != EXPORT_NO_ROW)
+		i = (i + 1) & map->mask;
+
+	map->keys[i] = key;
+	map->rows[i] = row;
+}
+
+static void export_map_insert(struct export_map *map, uint32_t key, uint32_t row)
+{
+	struct export_map old = *map;
+	uint32_t i;
+
+	/* keep the load factor at most 1/2 */
+	if ((map->count + 1) * 2 > map->mask + 1) {
+		map->mask = old.keys ? old.mask * 2 + 1 : 255;
+		map->keys = malloc((map->mask + 1) * sizeof(*map->keys));
+		map->rows = malloc((map->mask + 1) * sizeof(*map->rows));
+		if (!map->keys || !map->rows) {
+			log_err("can't allocate memory for export map\n");
+			exit(EXIT_FAILURE);
+		}
+
+		for (i = 0; i <= map->mask; i++)
+			map->rows[i] = EXPORT_NO_ROW;
+
+		for (i = 0; old.keys && i <= old.mask; i++)
+			if (old.rows[i] != EXPORT_NO_ROW)
+				export_map_slot(map, old.keys[i], old.rows[i]);
+
+		free(old.keys);
+		free(old.rows);
+	}
+
+	export_map_slot(map, key, row);
+	map->count++;
+}
+
+static void export_map_free(struct export_map *map)
+{
+	free(map->keys);
+	free(map->rows);
+	memset(map, 0, sizeof(*map));
+}
+
+static uint32_t export_site_row(const struct export_line *l)
+{
+	struct export_site *site;
+	size_t size = export.site_size;
+	uint32_t row;
+
+	row = export_map_find(&export.site_map, l->entry_address);
+	if (row != EXPORT_NO_ROW)
+		return row;
+
+	if (export.site_count == export.site_size) {
+		export.sites = export_grow(export.sites, &size, sizeof(*export.sites));
+		export.site_size = size;
+	}
+
+	row = export.site_count++;
+	site = &export.sites[row];
+	memset(site, 0, sizeof(*site));
+	site->entry_address = l->entry_address;
+	site->line = l->line;
+	site->level = l->level;
+	site->file = l->file;
+	site->format = l->format;
+	site->gap_min = UINT64_MAX;
+	export_map_insert(&export.site_map, l->entry_address, row);
+
+	return row;
+}
+
+static uint32_t export_comp_row(const struct export_line *l)
+{
+	struct export_comp *comp;
+	size_t size = export.comp_size;
+	uint32_t row;
+
+	row = export_map_find(&export.comp_map, l->uid);
+	if (row != EXPORT_NO_ROW)
+		return row;
+
+	if (export.comp_count == export.comp_size) {
+		export.comps = export_grow(export.comps, &size, sizeof(*export.comps));
+		export.comp_size = size;
+	}
+
+	row = export.comp_count++;
+	comp = &export.comps[row];
+	memset(comp, 0, sizeof(*comp));
+	comp->uid = l->uid;
+	comp->name = l->component;
+	comp->uuid = l->uuid;
+	export_map_insert(&export.comp_map, l->uid, row);
+
+	return row;
+}
+
+void export_add_line(const struct export_line *l)
+{
+	uint32_t site_row = export_site_row(l);
+	uint32_t comp_row = export_comp_row(l);
+	struct export_site *site = &export.sites[site_row];
+	struct export_comp *comp = &export.comps[comp_row];
+	struct export_row *row;
+	uint64_t gap;
+	int i;
+
+	/* inter-arrival time, ignoring timestamp wraps */
+	if (site->count && l->timestamp >= site->last_timestamp) {
+		gap = l->timestamp - site->last_timestamp;
+		site->gaps++;
+		site->gap_sum += gap;
+		if (gap < site->gap_min)
+			site->gap_min = gap;
+		if (gap > site->gap_max)
+			site->gap_max = gap;
+	}
+	site->last_timestamp = l->timestamp;
+	site->count++;
+
+	comp->count++;
+	if (l->level == LOG_LEVEL_CRITICAL)
+		comp->errors++;
+	else if (l->level == LOG_LEVEL_WARNING)
+		comp->warnings++;
+
+	if (global_config->output_format != LOGGER_FORMAT_COLUMNS)
+		return;
+
+	if (export.row_count == export.row_size)
+		export.rows = export_grow(export.rows, &export.row_size, sizeof(*export.rows));
+
+	row = &export.rows[export.row_count++];
+	row->timestamp = l->timestamp;
+	row->site = site_row;
+	row->comp = comp_row;
+	row->id_0 = l->id_0 == EXPORT_NO_ID ? UINT16_MAX : l->id_0;
+	row->id_1 = l->id_1 == EXPORT_NO_ID ? UINT16_MAX : l->id_1;
+	row->core = l->core;
+	row->level = l->level;
+	row->params_num = l->params_num;
+	for (i = 0; i < EXPORT_MAX_PARAMS; i++)
+		row->params[i] = i < l->params_num ? l->params[i] : 0;
+}
+
+static void format_uuid(char *s, size_t size, const struct sof_uuid *id)
+{
+	snprintf(s, size, "%08x-%04x-%04x-%02x%02x-%02x%02x%02x%02x%02x%02x",
+		 id->a, id->b, id->c, id->d[0], id->d[1], id->d[2], id->d[3],
+		 id->d[4], id->d[5], id->d[6], id->d[7]);
+}
+
+static void print_json_string(FILE *out_fd, const char *s)
+{
+	fputc('"', out_fd);
+	for (; *s; s++) {
+		switch (*s) {
+		case '"':
+			fputs("\\\"", out_fd);
+			break;
+		case '\\':
+			fputs("\\\\", out_fd);
+			break;
+		case '\n':
+			fputs("\\n", out_fd);
+			break;
+		case '\t':
+			fputs("\\t", out_fd);
+			break;
+		default:
+			if ((unsigned char)*s < 0x20)
+				fprintf(out_fd, "\\u%04x", *s);
+			else
+				fputc(*s, out_fd);
+			break;
+		}
+	}
+	fputc('"', out_fd);
+}
+
+void export_json_line(FILE *out_fd, const struct export_line *l)
+{
+	char uuid[40];
+	uint32_t i;
+
+	fprintf(out_fd, "{\"timestamp\":%" PRIu64 ",\"core\":%u,\"level\":%u,\"component\":",
+		l->timestamp, l->core, l->level);
+	print_json_string(out_fd, l->component);
+
+	fputs(",\"uuid\":", out_fd);
+	if (l->uuid) {
+		format_uuid(uuid, sizeof(uuid), &l->uuid->id);
+		fprintf(out_fd, "\"%s\"", uuid);
+	} else {
+		fputs("null", out_fd);
+	}
+
+	if (l->id_0 != EXPORT_NO_ID && l->id_1 != EXPORT_NO_ID)
+		fprintf(out_fd, ",\"id_0\":%d,\"id_1\":%d", l->id_0, l->id_1);
+	else
+		fputs(",\"id_0\":null,\"id_1\":null", out_fd);
+
+	fputs(",\"file\":", out_fd);
+	print_json_string(out_fd, l->file);
+	fprintf(out_fd, ",\"line\":%u,\"entry\":%u,\"params\":[", l->line, l->entry_address);
+	for (i = 0; i < l->params_num; i++)
+		fprintf(out_fd, i ? ",%u" : "%u", l->params[i]);
+	fputs("],\"format\":", out_fd);
+	print_json_string(out_fd, l->format);
+	fputs("}\n", out_fd);
+}
+
+static int write_column_header(FILE *out_fd, const char *name, uint32_t type,
+			       uint32_t count, uint64_t size)
+{
+	struct export_column_header hdr;
+
+	memset(&hdr, 0, sizeof(hdr));
+	snprintf(hdr.name, sizeof(hdr.name), "%s", name);
+	hdr.type = type;
+	hdr.count = count;
+	hdr.size = size;
+
+	return fwrite(&hdr, sizeof(hdr), 1, out_fd) == 1 ? 0 : -EIO;
+}
+
+static int write_column_padding(FILE *out_fd, uint64_t size)
+{
+	static const uint8_t zeros[EXPORT_COLUMN_ALIGN];
+	size_t pad = -size & (EXPORT_COLUMN_ALIGN - 1);
+
+	return !pad || fwrite(zeros, pad, 1, out_fd) == 1 ? 0 : -EIO;
+}
+
+static size_t column_type_size(uint32_t type)
+{
+	switch (type) {
+	case EXPORT_COLUMN_U8:
+		return sizeof(uint8_t);
+	case EXPORT_COLUMN_U16:
+		return sizeof(uint16_t);
+	case EXPORT_COLUMN_U32:
+		return sizeof(uint32_t);
+	default:
+		return sizeof(uint64_t);
+	}
+}
+
+/** Writes a numeric column gathered from a field of a table of structs */
+static int write_column(FILE *out_fd, const char *name, uint32_t type, const void *table,
+			size_t count, size_t stride, size_t offset)
+{
+	size_t elem_size = column_type_size(type);
+	const uint8_t *src;
+	void *data;
+	size_t i;
+	int ret;
+
+	data = malloc(count * elem_size + 1);
+	if (!data)
+		return -ENOMEM;
+
+	for (i = 0; i < count; i++) {
+		src = (const uint8_t *)table + i * stride + offset;
+		switch (type) {
+		case EXPORT_COLUMN_U8:
+			((uint8_t *)data)[i] = *src;
+			break;
+		case EXPORT_COLUMN_U16:
+			((uint16_t *)data)[i] = *(const uint16_t *)src;
+			break;
+		case EXPORT_COLUMN_U32:
+			((uint32_t *)data)[i] = *(const uint32_t *)src;
+			break;
+		default:
+			((uint64_t *)data)[i] = *(const uint64_t *)src;
+			break;
+		}
+	}
+
+	ret = write_column_header(out_fd, name, type, count, count * elem_size);
+	if (!ret && count && fwrite(data, count * elem_size, 1, out_fd) != 1)
+		ret = -EIO;
+	if (!ret)
+		ret = write_column_padding(out_fd, count * elem_size);
+
+	free(data);
+	return ret;
+}
+
+/** Writes a string column from a field of a table of structs */
+static int write_str_column(FILE *out_fd, const char *name, const void *table,
+			    size_t count, size_t stride, size_t offset)
+{
+	const char *s;
+	uint64_t size = 0;
+	size_t i;
+	int ret;
+
+	for (i = 0; i < count; i++)
+		size += strlen(*(const char **)((const uint8_t *)table + i * stride + offset)) + 1;
+
+	ret = write_column_header(out_fd, name, EXPORT_COLUMN_STR, count, size);
+	for (i = 0; !ret && i < count; i++) {
+		s = *(const char **)((const uint8_t *)table + i * stride + offset);
+		if (fwrite(s, strlen(s) + 1, 1, out_fd) != 1)
+			ret = -EIO;
+	}
+
+	return ret ? ret : write_column_padding(out_fd, size);
+}
+
+#define LOG_COLUMN(name, type, field) \
+	write_column(out_fd, name, type, export.rows, export.row_count, \
+		     sizeof(struct export_row), offsetof(struct export_row, field))
+#define SITE_COLUMN(name, type, field) \
+	write_column(out_fd, name, type, export.sites, export.site_count, \
+		     sizeof(struct export_site), offsetof(struct export_site, field))
+
+static int write_columns(FILE *out_fd)
+{
+	struct export_file_header hdr;
+	const char **uuids;
+	const char **names;
+	uint32_t *uids;
+	char uuid[40];
+	uint32_t i;
+	int ret;
+
+	memset(&hdr, 0, sizeof(hdr));
+	snprintf(hdr.magic, sizeof(hdr.magic), "%s", EXPORT_COLUMNS_MAGIC);
+	hdr.version = EXPORT_COLUMNS_VERSION;
+	hdr.columns = EXPORT_LOG_COLUMNS + EXPORT_SITE_COLUMNS + EXPORT_COMP_COLUMNS;
+	if (fwrite(&hdr, sizeof(hdr), 1, out_fd) != 1)
+		return -EIO;
+
+	ret = LOG_COLUMN("log.timestamp", EXPORT_COLUMN_U64, timestamp);
+	ret = ret ? ret : LOG_COLUMN("log.core", EXPORT_COLUMN_U8, core);
+	ret = ret ? ret : LOG_COLUMN("log.level", EXPORT_COLUMN_U8, level);
+	ret = ret ? ret : LOG_COLUMN("log.id_0", EXPORT_COLUMN_U16, id_0);
+	ret = ret ? ret : LOG_COLUMN("log.id_1", EXPORT_COLUMN_U16, id_1);
+	ret = ret ? ret : LOG_COLUMN("log.site", EXPORT_COLUMN_U32, site);
+	ret = ret ? ret : LOG_COLUMN("log.comp", EXPORT_COLUMN_U32, comp);
+	ret = ret ? ret : LOG_COLUMN("log.params_num", EXPORT_COLUMN_U8, params_num);
+	ret = ret ? ret : LOG_COLUMN("log.p0", EXPORT_COLUMN_U32, params[0]);
+	ret = ret ? ret : LOG_COLUMN("log.p1", EXPORT_COLUMN_U32, params[1]);
+	ret = ret ? ret : LOG_COLUMN("log.p2", EXPORT_COLUMN_U32, params[2]);
+	ret = ret ? ret : LOG_COLUMN("log.p3", EXPORT_COLUMN_U32, params[3]);
+
+	ret = ret ? ret : SITE_COLUMN("site.entry", EXPORT_COLUMN_U32, entry_address);
+	ret = ret ? ret : SITE_COLUMN("site.line", EXPORT_COLUMN_U32, line);
+	ret = ret ? ret : SITE_COLUMN("site.level", EXPORT_COLUMN_U32, level);
+	ret = ret ? ret : write_str_column(out_fd, "site.file", export.sites, export.site_count,
+					   sizeof(struct export_site),
+					   offsetof(struct export_site, file));
+	ret = ret ? ret : write_str_column(out_fd, "site.format", export.sites,
+					   export.site_count, sizeof(struct export_site),
+					   offsetof(struct export_site, format));
+	if (ret)
+		return ret;
+
+	/* the uuid strings are formatted only for the table */
+	uids = calloc(export.comp_count + 1, sizeof(*uids));
+	names = calloc(export.comp_count + 1, sizeof(*names));
+	uuids = calloc(export.comp_count + 1, sizeof(*uuids));
+	for (i = 0; uids && names && uuids && i < export.comp_count; i++) {
+		uids[i] = export.comps[i].uid;
+		names[i] = export.comps[i].name;
+		if (export.comps[i].uuid)
+			format_uuid(uuid, sizeof(uuid), &export.comps[i].uuid->id);
+		else
+			uuid[0] = '\0';
+		uuids[i] = strdup(uuid);
+		if (!uuids[i])
+			break;
+	}
+
+	if (i < export.comp_count || !uids || !names || !uuids)
+		ret = -ENOMEM;
+
+	ret = ret ? ret : write_column(out_fd, "comp.uid", EXPORT_COLUMN_U32, uids,
+				       export.comp_count, sizeof(*uids), 0);
+	ret = ret ? ret : write_str_column(out_fd, "comp.name", names, export.comp_count,
+					   sizeof(*names), 0);
+	ret = ret ? ret : write_str_column(out_fd, "comp.uuid", uuids, export.comp_count,
+					   sizeof(*uuids), 0);
+
+	for (i = 0; uuids && i < export.comp_count; i++)
+		free((void *)uuids[i]);
+	free(uuids);
+	free(names);
+	free(uids);
+
+	return ret;
+}
+
+static double ticks_to_usecs(double ticks)
+{
+	return ticks / global_config->clock;
+}
+
+static int cmp_site_count(const void *a, const void *b)
+{
+	const struct export_site *sa = a;
+	const struct export_site *sb = b;
+
+	if (sa->count != sb->count)
+		return sa->count < sb->count ? 1 : -1;
+
+	return sa->entry_address < sb->entry_address ? -1 : 1;
+}
+
+static int cmp_comp_count(const void *a, const void *b)
+{
+	const struct export_comp *ca = a;
+	const struct export_comp *cb = b;
+
+	if (ca->count != cb->count)
+		return ca->count < cb->count ? 1 : -1;
+
+	return ca->uid < cb->uid ? -1 : 1;
+}
+
+static void print_summary(FILE *out_fd)
+{
+	const struct export_site *site;
+	const struct export_comp *comp;
+	uint64_t lines = 0;
+	uint32_t i;
+
+	for (i = 0; i < export.site_count; i++)
+		lines += export.sites[i].count;
+
+	qsort(export.sites, export.site_count, sizeof(*export.sites), cmp_site_count);
+	qsort(export.comps, export.comp_count, sizeof(*export.comps), cmp_comp_count);
+
+	fprintf(out_fd, "Log lines %" PRIu64 ", log sites %u, components %u\n\n",
+		lines, export.site_count, export.comp_count);
+
+	/* inter-arrival times of the lines from the same site */
+	fprintf(out_fd, "%10s %-8s %14s %14s %14s %-29s %s\n", "COUNT", "LEVEL",
+		"MIN DELTA(us)", "AVG DELTA(us)", "MAX DELTA(us)", "LOCATION", "CONTENT");
+	for (i = 0; i < export.site_count; i++) {
+		site = &export.sites[i];
+		fprintf(out_fd, "%10" PRIu64 " %-8s ", site->count, get_level_name(site->level));
+		if (site->gaps)
+			fprintf(out_fd, "%14.3f %14.3f %14.3f ", ticks_to_usecs(site->gap_min),
+				ticks_to_usecs((double)site->gap_sum / site->gaps),
+				ticks_to_usecs(site->gap_max));
+		else
+			fprintf(out_fd, "%14s %14s %14s ", "-", "-", "-");
+		fprintf(out_fd, "%24s:%-4u %s\n", site->file, site->line, site->format);
+	}
+
+	fprintf(out_fd, "\n%10s %10s %10s %s\n", "COUNT", "ERROR", "WARN", "COMPONENT");
+	for (i = 0; i < export.comp_count; i++) {
+		comp = &export.comps[i];
+		fprintf(out_fd, "%10" PRIu64 " %10" PRIu64 " %10" PRIu64 " %s\n",
+			comp->count, comp->errors, comp->warnings, comp->name);
+	}
+}
+
+int export_finish(FILE *out_fd)
+{
+	int ret = 0;
+
+	if (global_config->output_format == LOGGER_FORMAT_COLUMNS)
+		ret = write_columns(out_fd);
+	else
+		print_summary(out_fd);
+
+	if (ret)
+		log_err("failed to write columnar export: %d\n", ret);
+
+	fflush(out_fd);
+
+	free(export.rows);
+	free(export.sites);
+	free(export.comps);
+	export_map_free(&export.site_map);
+	export_map_free(&export.comp_map);
+	memset(&export, 0, sizeof(export));
+
+	return ret;
+}
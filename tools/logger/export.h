@@ -0,0 +1,88 @@
+/* SPDX-License-Identifier: BSD-3-Clause
+ *
+ * Copyright(c) 2023 Intel Corporation. All rights reserved.
+ */
+
+/*
+ * Structured exports of the decoded log: JSON lines, a binary columnar
+ * file and a per log site summary.
+ */
+
+#ifndef __LOGGER_EXPORT_H__
+#define __LOGGER_EXPORT_H__
+
+#include <stdint.h>
+#include <stdio.h>
+#include <sof/lib/uuid.h>
+
+#define EXPORT_MAX_PARAMS	4
+#define EXPORT_NO_ID		-1
+
+/** One decoded log line. The strings point to the dictionary and must
+ * stay valid until export_finish().
+ */
+struct export_line {
+	uint64_t timestamp;		/**< ticks */
+	uint32_t entry_address;		/**< log site, dictionary entry address */
+	uint32_t uid;			/**< uuid key, 0 when not set */
+	const struct sof_uuid_entry *uuid;	/**< NULL if uid does not resolve */
+	const char *component;
+	const char *file;
+	const char *format;		/**< text as in the dictionary */
+	uint32_t line;
+	uint32_t level;
+	uint32_t params_num;
+	uint32_t params[EXPORT_MAX_PARAMS];
+	int id_0;			/**< EXPORT_NO_ID when not set */
+	int id_1;
+	unsigned int core;
+};
+
+/*
+ * Columnar file layout, all values in host byte order:
+ *
+ *   struct export_file_header
+ *   columns times:
+ *     struct export_column_header
+ *     data, size bytes padded with zeros to 8 bytes
+ *
+ * Column names start with the table name, "log." columns have a row per
+ * log line, "site." a row per log site and "comp." a row per component.
+ * log.site and log.comp are row indexes to the site and comp tables.
+ * String columns are count NUL terminated strings back to back.
+ */
+#define EXPORT_COLUMNS_MAGIC	"SOFLOGC"
+#define EXPORT_COLUMNS_VERSION	1
+#define EXPORT_COLUMN_NAME_LEN	16
+
+enum export_column_type {
+	EXPORT_COLUMN_U8 = 1,
+	EXPORT_COLUMN_U16,
+	EXPORT_COLUMN_U32,
+	EXPORT_COLUMN_U64,
+	EXPORT_COLUMN_STR,
+};
+
+struct export_file_header {
+	char magic[8];
+	uint32_t version;
+	uint32_t columns;
+};
+
+struct export_column_header {
+	char name[EXPORT_COLUMN_NAME_LEN];
+	uint32_t type;		/**< enum export_column_type */
+	uint32_t count;		/**< rows */
+	uint64_t size;		/**< bytes of data without padding */
+};
+
+/** Outputs one log line as a JSON object on a line */
+void export_json_line(FILE *out_fd, const struct export_line *l);
+
+/** Adds one log line to the columnar export or the summary */
+void export_add_line(const struct export_line *l);
+
+/** Writes out the columnar export or the summary and frees the lines */
+int export_finish(FILE *out_fd);
+
+#endif /* __LOGGER_EXPORT_H__ */
@@ -86,6 +86,12 @@ static void usage(void)
 	fprintf(stdout, "%s:\t -F filter\t\tUpdate trace filter, format: "
 		"<level>=<comp1>[, <comp2>]\n",
 		APP_NAME);
+	fprintf(stdout, "%s:\t -x format\t\tOutput format: text (default), csv, json (lines),\n",
+		APP_NAME);
+	fprintf(stdout, "%s:\t\t\t\tcolumns (binary, see export.h) or summary per log site\n",
+		APP_NAME);
+	fprintf(stdout, "%s:\t -j threads\t\tDecode input files on threads, 0 for all CPUs\n",
+		APP_NAME);
 	exit(0);
 }
 
@@ -287,7 +293,7 @@ struct convert_config * const global_config = &_global_config;
 
 int main(int argc, char *argv[])
 {
-	static const char optstring[] = "ho:i:l:ps:c:u:tv:rd:Le:f:gF:n";
+	static const char optstring[] = "ho:i:l:ps:c:u:tv:rd:Le:f:gF:nx:j:";
 	struct convert_config config;
 	unsigned int baud = 0;
 	const char *snapshot_file = 0;
@@ -314,6 +320,8 @@ int main(int argc, char *argv[])
 	config.time_precision = 6;
 	config.relative_timestamps = INT_MAX; /* unspecified */
 	config.filter_config = NULL;
+	config.output_format = LOGGER_FORMAT_TEXT;
+	config.threads = 1;
 
 	while ((opt = getopt(argc, argv, optstring)) != -1) {
 		switch (opt) {
@@ -392,6 +400,33 @@ int main(int argc, char *argv[])
 			if (ret < 0)
 				return ret;
 			break;
+		case 'x':
+			if (!strcmp(optarg, "text")) {
+				config.output_format = LOGGER_FORMAT_TEXT;
+			} else if (!strcmp(optarg, "csv")) {
+				config.output_format = LOGGER_FORMAT_CSV;
+			} else if (!strcmp(optarg, "json")) {
+				config.output_format = LOGGER_FORMAT_JSON;
+			} else if (!strcmp(optarg, "columns")) {
+				config.output_format = LOGGER_FORMAT_COLUMNS;
+			} else if (!strcmp(optarg, "summary")) {
+				config.output_format = LOGGER_FORMAT_SUMMARY;
+			} else {
+				fprintf(stderr, "%s: invalid option: -x %s\n",
+					APP_NAME, optarg);
+				return -EINVAL;
+			}
+			break;
+		case 'j':
+			config.threads = atoi(optarg);
+			if (config.threads < 0) {
+				fprintf(stderr, "%s: invalid option: -j %s\n",
+					APP_NAME, optarg);
+				return -EINVAL;
+			}
+			if (!config.threads)
+				config.threads = sysconf(_SC_NPROCESSORS_ONLN);
+			break;
 		case 'h':
 		default: /* '?' */
 			usage();
@@ -41,6 +41,13 @@ char *log_asprintf(const char *format, ...)
 	return result;
 }
 
+static __thread FILE *log_err_fd;
+
+void log_err_redirect(FILE *out_fd)
+{
+	log_err_fd = out_fd;
+}
+
 /** Prints 1. once to stderr. 2. a second time to the global out_fd if
  * out_fd is neither stderr nor stdout (because the -o option was used).
  */
@@ -66,6 +73,8 @@ void log_err(const char *fmt, ...)
 
 		/* take care about out_fd validity and duplicated logging */
 		if (out_fd && out_fd != stderr && out_fd != stdout) {
+			if (log_err_fd)
+				out_fd = log_err_fd;
 			fprintf(out_fd, "%s%s", prefix, buff);
 			fflush(out_fd);
 		}
@@ -6,6 +6,7 @@
  */
 
 #include <stdarg.h>
+#include <stdio.h>
 #include <stdlib.h>
 
 char *log_vasprintf(const char *format, va_list args);
@@ -20,6 +21,9 @@ __attribute__((format(printf, 1, 2)))
 #endif
 void log_err(const char *fmt, ...);
 
+/* redirect log_err() copies of the calling thread, NULL restores out_fd */
+void log_err_redirect(FILE *out_fd);
+
 /* trim whitespaces from string begin */
 char *ltrim(char *s);
 
@@ -8,12 +8,14 @@
 #include <ctype.h>
 #include <errno.h>
 #include <inttypes.h>
+#include <pthread.h>
 #include <stdbool.h>
 #include <stddef.h>
 #include <stdio.h>
 #include <stdint.h>
 #include <stdlib.h>
 #include <string.h>
+#include <time.h>
 #include <unistd.h>
 
 #include <ipc/probe_dma_frame.h>
@@ -26,6 +28,16 @@
 #define DATA_READ_LIMIT 4096	/**< Data limit for file read */
 #define FILES_LIMIT	32	/**< Maximum num of probe output files */
 #define FILE_PATH_LIMIT 128	/**< Path limit for probe output files */
+#define CHANNELS_LIMIT	((PROBE_MASK_NB_CHANNELS >> PROBE_SHIFT_NB_CHANNELS) + 1)
+#define QUEUE_LIMIT	(4 * 1024 * 1024)	/**< Default bytes queued per output file */
+#define HEADER_INTERVAL	1000	/**< Default ms between wave header updates */
+
+/** Packet handed over to the writer thread of a file */
+struct queued_packet {
+	struct queued_packet *next;
+	struct probe_data_packet *packet;
+	size_t size;				/**< allocated size of packet */
+};
 
 struct wave_files {
 	FILE *fd;
@@ -33,6 +45,19 @@ struct wave_files {
 	uint32_t fmt;
 	uint32_t size;
 	struct wave header;
+
+	/* writer thread, packets are written in the order they are queued */
+	pthread_t thread;
+	pthread_mutex_t lock;
+	pthread_cond_t queued;		/**< a packet was queued or the writer stops */
+	pthread_cond_t written;		/**< a packet was written */
+	struct queued_packet *head;
+	struct queued_packet *tail;
+	size_t queued_bytes;
+	size_t queue_limit;
+	uint32_t header_interval;	/**< ms between header updates, 0 for at end only */
+	struct timespec header_time;	/**< last header update */
+	bool stop;
 };
 
 enum p_state {
@@ -50,6 +75,8 @@ struct dma_frame_parser {
 	uint32_t total_data_to_copy;		/* Total bytes left to copy */
 	int start;				/* Start of unfilled data */
 	int len;				/* Data buffer fill level */
+	size_t queue_limit;			/* Bytes queued per file before blocking */
+	uint32_t header_interval;		/* ms between wave header updates */
 	uint8_t data[DATA_READ_LIMIT];
 	struct wave_files files[FILES_LIMIT];
 };
@@ -86,6 +113,206 @@ bool is_audio_format(uint32_t format)
 	return (format & PROBE_MASK_FMT_TYPE) != 0 && (format & PROBE_MASK_AUDIO_FMT) == 0;
 }
 
+/* Decodes compressed packet data to PCM and writes it, returns the PCM size */
+int write_compressed(struct probe_data_packet *packet, FILE *fd)
+{
+	uint32_t container = ((packet->format & PROBE_MASK_CONTAINER_SIZE) >>
+			      PROBE_SHIFT_CONTAINER_SIZE) + 1;
+	uint32_t channels = ((packet->format & PROBE_MASK_NB_CHANNELS) >>
+			     PROBE_SHIFT_NB_CHANNELS) + 1;
+	uint32_t prev[CHANNELS_LIMIT] = { 0 };
+	uint8_t out[DATA_READ_LIMIT];
+	uint32_t out_len = 0;
+	uint32_t size = 0;
+	uint32_t ch = 0;
+	uint32_t shift;
+	uint32_t z;
+	uint32_t i = 0;
+
+	while (i < packet->data_size_bytes) {
+		/* unsigned LEB128 varint of zigzag encoded delta */
+		z = 0;
+		shift = 0;
+		do {
+			if (i == packet->data_size_bytes || shift > 28) {
+				fprintf(stderr, "error: malformed compressed data for buffer %u\n",
+					packet->buffer_id);
+				return -EINVAL;
+			}
+			z |= (uint32_t)(packet->data[i] & 0x7f) << shift;
+			shift += 7;
+		} while (packet->data[i++] & 0x80);
+
+		prev[ch] += (z >> 1) ^ -(z & 1);
+		for (shift = 0; shift < container * 8; shift += 8)
+			out[out_len++] = prev[ch] >> shift;
+		ch = (ch + 1) % channels;
+
+		if (out_len > sizeof(out) - sizeof(uint32_t)) {
+			fwrite(out, 1, out_len, fd);
+			size += out_len;
+			out_len = 0;
+		}
+	}
+
+	fwrite(out, 1, out_len, fd);
+
+	return size + out_len;
+}
+
+void write_packet(struct probe_data_packet *packet, struct wave_files *file)
+{
+	int size;
+
+	if (is_audio_format(packet->format) && (packet->format & PROBE_MASK_COMPRESSION)) {
+		size = write_compressed(packet, file->fd);
+		if (size > 0)
+			file->size += size;
+		return;
+	}
+
+	fwrite(packet->data, 1, packet->data_size_bytes, file->fd);
+	file->size += packet->data_size_bytes;
+}
+
+/* Updates the sizes in the wave header, the file position stays at the end */
+void update_wave_header(struct wave_files *file)
+{
+	uint32_t chunk_size;
+
+	/* check wave struct to understand the offsets */
+	chunk_size = file->size + sizeof(struct wave) -
+		     offsetof(struct riff_chunk, format);
+
+	/* not possible when writing to a pipe */
+	if (fseek(file->fd, sizeof(uint32_t), SEEK_SET))
+		return;
+
+	fwrite(&chunk_size, sizeof(uint32_t), 1, file->fd);
+	fseek(file->fd, sizeof(struct wave) -
+	      offsetof(struct data_subchunk, subchunk_size),
+	      SEEK_SET);
+	fwrite(&file->size, sizeof(uint32_t), 1, file->fd);
+	fseek(file->fd, 0, SEEK_END);
+}
+
+/* Updates the header when the interval passed, so a file is valid during capture */
+void refresh_wave_header(struct wave_files *file)
+{
+	struct timespec now;
+	int64_t ms;
+
+	if (!file->header_interval || !is_audio_format(file->fmt))
+		return;
+
+	clock_gettime(CLOCK_MONOTONIC, &now);
+	ms = (now.tv_sec - file->header_time.tv_sec) * 1000 +
+	     (now.tv_nsec - file->header_time.tv_nsec) / 1000000;
+	if (ms < file->header_interval)
+		return;
+
+	update_wave_header(file);
+	fflush(file->fd);
+	file->header_time = now;
+}
+
+/* Writes the packets queued for a file until it is stopped */
+void *file_writer(void *arg)
+{
+	struct wave_files *file = arg;
+	struct queued_packet *qp;
+	size_t bytes;
+	bool drained;
+
+	pthread_mutex_lock(&file->lock);
+	for (;;) {
+		while (!file->head && !file->stop)
+			pthread_cond_wait(&file->queued, &file->lock);
+		qp = file->head;
+		if (!qp)
+			break;
+		file->head = qp->next;
+		drained = !file->head;
+		if (drained)
+			file->tail = NULL;
+		pthread_mutex_unlock(&file->lock);
+
+		write_packet(qp->packet, file);
+		/* flush once the queue drained, as sampled under the lock */
+		if (drained)
+			fflush(file->fd);
+		refresh_wave_header(file);
+		bytes = qp->size;
+		free(qp->packet);
+		free(qp);
+
+		pthread_mutex_lock(&file->lock);
+		file->queued_bytes -= bytes;
+		pthread_cond_signal(&file->written);
+	}
+	pthread_mutex_unlock(&file->lock);
+
+	return NULL;
+}
+
+/* Queues a valid packet to the writer of the file, which takes it over.
+ * Blocks while the queue is full so a slow disk slows down reading instead
+ * of growing the memory use.
+ */
+int queue_packet(struct wave_files *file, struct probe_data_packet *packet, size_t size)
+{
+	struct queued_packet *qp = malloc(sizeof(*qp));
+	size_t bytes = size;
+
+	if (!qp)
+		return -ENOMEM;
+
+	qp->packet = packet;
+	qp->size = size;
+	qp->next = NULL;
+
+	pthread_mutex_lock(&file->lock);
+	/* a packet larger than the limit is still queued when the queue is empty */
+	while (file->queued_bytes && file->queued_bytes + bytes > file->queue_limit)
+		pthread_cond_wait(&file->written, &file->lock);
+	if (file->tail)
+		file->tail->next = qp;
+	else
+		file->head = qp;
+	file->tail = qp;
+	file->queued_bytes += bytes;
+	pthread_cond_signal(&file->queued);
+	pthread_mutex_unlock(&file->lock);
+
+	return 0;
+}
+
+void init_wave_header(struct wave_files *file, uint32_t format)
+{
+	uint32_t channels = ((format & PROBE_MASK_NB_CHANNELS) >> PROBE_SHIFT_NB_CHANNELS) + 1;
+	uint32_t rate = (format & PROBE_MASK_SAMPLE_RATE) >> PROBE_SHIFT_SAMPLE_RATE;
+	uint32_t container = ((format & PROBE_MASK_CONTAINER_SIZE) >>
+			      PROBE_SHIFT_CONTAINER_SIZE) + 1;
+	uint32_t decimation = ((format & PROBE_MASK_DECIMATION) >> PROBE_SHIFT_DECIMATION) + 1;
+
+	file->header.riff.chunk_id = HEADER_RIFF;
+	file->header.riff.format = HEADER_WAVE;
+	file->header.fmt.subchunk_id = HEADER_FMT;
+	file->header.fmt.subchunk_size = 16;
+	file->header.fmt.audio_format = 1;
+	file->header.fmt.num_channels = channels;
+	file->header.fmt.sample_rate = sample_rate[rate] / decimation;
+	file->header.fmt.bits_per_sample = container * 8;
+	file->header.fmt.byte_rate = file->header.fmt.sample_rate *
+				     file->header.fmt.num_channels *
+				     file->header.fmt.bits_per_sample / 8;
+	file->header.fmt.block_align = file->header.fmt.num_channels *
+				       file->header.fmt.bits_per_sample / 8;
+	file->header.data.subchunk_id = HEADER_DATA;
+
+	fwrite(&file->header, sizeof(struct wave), 1, file->fd);
+}
+
 int init_wave(struct dma_frame_parser *p, uint32_t buffer_id, uint32_t format)
 {
 	bool audio = is_audio_format(format);
@@ -115,54 +342,57 @@ int init_wave(struct dma_frame_parser *p, uint32_t buffer_id, uint32_t format)
 
 	p->files[i].buffer_id = buffer_id;
 	p->files[i].fmt = format;
-
-	if (!audio)
-		return i;
-
-	p->files[i].header.riff.chunk_id = HEADER_RIFF;
-	p->files[i].header.riff.format = HEADER_WAVE;
-	p->files[i].header.fmt.subchunk_id = HEADER_FMT;
-	p->files[i].header.fmt.subchunk_size = 16;
-	p->files[i].header.fmt.audio_format = 1;
-	p->files[i].header.fmt.num_channels = ((format & PROBE_MASK_NB_CHANNELS) >> PROBE_SHIFT_NB_CHANNELS) + 1;
-	p->files[i].header.fmt.sample_rate = sample_rate[(format & PROBE_MASK_SAMPLE_RATE) >> PROBE_SHIFT_SAMPLE_RATE];
-	p->files[i].header.fmt.bits_per_sample = (((format & PROBE_MASK_CONTAINER_SIZE) >> PROBE_SHIFT_CONTAINER_SIZE) + 1) * 8;
-	p->files[i].header.fmt.byte_rate = p->files[i].header.fmt.sample_rate *
-					p->files[i].header.fmt.num_channels *
-					p->files[i].header.fmt.bits_per_sample / 8;
-	p->files[i].header.fmt.block_align = p->files[i].header.fmt.num_channels *
-					  p->files[i].header.fmt.bits_per_sample / 8;
-	p->files[i].header.data.subchunk_id = HEADER_DATA;
-
-	fwrite(&p->files[i].header, sizeof(struct wave), 1, p->files[i].fd);
+	p->files[i].size = 0;
+	p->files[i].head = NULL;
+	p->files[i].tail = NULL;
+	p->files[i].queued_bytes = 0;
+	p->files[i].queue_limit = p->queue_limit;
+	p->files[i].header_interval = p->header_interval;
+	p->files[i].stop = false;
+	clock_gettime(CLOCK_MONOTONIC, &p->files[i].header_time);
+
+	if (audio)
+		init_wave_header(&p->files[i], format);
+
+	pthread_mutex_init(&p->files[i].lock, NULL);
+	pthread_cond_init(&p->files[i].queued, NULL);
+	pthread_cond_init(&p->files[i].written, NULL);
+	if (pthread_create(&p->files[i].thread, NULL, file_writer, &p->files[i])) {
+		fprintf(stderr, "error: unable to start writer for %s\n", path);
+		exit(0);
+	}
 
 	return i;
 }
 
 void finalize_wave_files(struct wave_files *files)
 {
-	uint32_t i, chunk_size;
+	uint32_t i;
 
-	/* fill the header at the beginning of each file */
-	/* and close all opened files */
-	/* check wave struct to understand the offsets */
+	/* let the writers empty their queues, then fill the header */
+	/* at the beginning of each file and close all opened files */
 	for (i = 0; i < FILES_LIMIT; i++) {
-		if (!is_audio_format(files[i].fmt))
+		if (!files[i].fd)
 			continue;
 
-		if (files[i].fd) {
-			chunk_size = files[i].size + sizeof(struct wave) -
-				     offsetof(struct riff_chunk, format);
+		pthread_mutex_lock(&files[i].lock);
+		files[i].stop = true;
+		pthread_cond_signal(&files[i].queued);
+		pthread_mutex_unlock(&files[i].lock);
+		pthread_join(files[i].thread, NULL);
+
+		pthread_cond_destroy(&files[i].written);
+		pthread_cond_destroy(&files[i].queued);
+		pthread_mutex_destroy(&files[i].lock);
 
-			fseek(files[i].fd, sizeof(uint32_t), SEEK_SET);
-			fwrite(&chunk_size, sizeof(uint32_t), 1, files[i].fd);
-			fseek(files[i].fd, sizeof(struct wave) -
-			      offsetof(struct data_subchunk, subchunk_size),
-			      SEEK_SET);
-			fwrite(&files[i].size, sizeof(uint32_t), 1, files[i].fd);
+		if (is_audio_format(files[i].fmt))
+			update_wave_header(&files[i]);
 
+		if (files[i].fd == stdout)
+			fflush(stdout);
+		else
 			fclose(files[i].fd);
-		}
+		files[i].fd = NULL;
 	}
 }
 
@@ -189,6 +419,19 @@ int validate_data_packet(struct probe_data_packet *packet)
 	return 0;
 }
 
+/* Allocates the next packet after the previous one was queued for writing */
+int parser_new_packet(struct dma_frame_parser *p)
+{
+	p->packet = malloc(PACKET_MAX_SIZE);
+	if (!p->packet)
+		return -ENOMEM;
+
+	memset(p->packet, 0, PACKET_MAX_SIZE);
+	p->packet_size = PACKET_MAX_SIZE;
+
+	return 0;
+}
+
 int process_sync(struct dma_frame_parser *p)
 {
 	struct probe_data_packet *temp_packet;
@@ -223,20 +466,20 @@ struct dma_frame_parser *parser_init(void)
 		return NULL;
 	}
 	memset(p, 0, sizeof(*p));
-	p->packet = malloc(PACKET_MAX_SIZE);
-	if (!p) {
+	if (parser_new_packet(p) < 0) {
 		fprintf(stderr, "error: allocation failed, err %d\n",
 			errno);
 		free(p);
 		return NULL;
 	}
-	memset(p->packet, 0, PACKET_MAX_SIZE);
-	p->packet_size = PACKET_MAX_SIZE;
+	p->queue_limit = QUEUE_LIMIT;
+	p->header_interval = HEADER_INTERVAL;
 	return p;
 }
 
 void parser_free(struct dma_frame_parser *p)
 {
+	finalize_wave_files(p->files);
 	free(p->packet);
 	free(p);
 }
@@ -246,6 +489,16 @@ void parser_log_to_stdout(struct dma_frame_parser *p)
 	p->log_to_stdout = true;
 }
 
+void parser_set_queue_limit(struct dma_frame_parser *p, size_t bytes)
+{
+	p->queue_limit = bytes;
+}
+
+void parser_set_header_interval(struct dma_frame_parser *p, uint32_t ms)
+{
+	p->header_interval = ms;
+}
+
 void parser_fetch_free_buffer(struct dma_frame_parser *p, uint8_t **d, size_t *len)
 {
 	*d = &p->data[p->start];
@@ -257,8 +510,8 @@ int parser_parse_data(struct dma_frame_parser *p, size_t d_len)
 	uint i = 0;
 
 	p->len = p->start + d_len;
-	/* processing all loaded bytes */
-	while (i < p->len) {
+	/* processing all loaded bytes, and a packet completed by the last ones */
+	while (i < p->len || (p->total_data_to_copy == 0 && p->state != READY)) {
 		if (p->total_data_to_copy == 0) {
 			switch (p->state) {
 			case READY:
@@ -306,11 +559,13 @@ int parser_parse_data(struct dma_frame_parser *p, size_t d_len)
 						return -EIO;
 					}
 
-					fwrite(p->packet->data, 1,
-					       p->packet->data_size_bytes,
-					       p->files[file].fd);
-					p->files[file].size += p->packet->data_size_bytes;
+					if (queue_packet(&p->files[file], p->packet,
+							 p->packet_size) < 0 ||
+					    parser_new_packet(p) < 0) {
+						fprintf(stderr, "OOM, quitting\n");
+						return -ENOMEM;
 					}
+				}
 				p->state = READY;
 				break;
 			}
@@ -18,6 +18,13 @@ struct dma_frame_parser *parser_init(void);
 
 void parser_log_to_stdout(struct dma_frame_parser *p);
 
+/* Bytes of packets queued for writing per output file before parsing blocks */
+void parser_set_queue_limit(struct dma_frame_parser *p, size_t bytes);
+
+/* Interval of wave header updates during capture, 0 to update at the end only */
+void parser_set_header_interval(struct dma_frame_parser *p, uint32_t ms);
+
+/* Writes out the queued data, finalizes and closes the output files */
 void parser_free(struct dma_frame_parser *p);
 
 void parser_fetch_free_buffer(struct dma_frame_parser *p, uint8_t **d, size_t *len);
@@ -11,36 +11,102 @@
  *
  * Usage to parse data and create wave files: ./sof-probes -p data.bin
  *
+ * The stream can also be read live from a pipe, stdin or a TCP socket,
+ * e.g. ./sof-probes -n localhost:5000. Each buffer is written by its own
+ * thread and the wave headers are updated during the capture, so the
+ * files can be opened before the capture ends. SIGINT stops the capture
+ * and finalizes the files.
  */
 
 #include <errno.h>
+#include <fcntl.h>
+#include <netdb.h>
+#include <signal.h>
+#include <stdatomic.h>
 #include <stdbool.h>
 #include <stddef.h>
 #include <stdio.h>
 #include <stdint.h>
 #include <stdlib.h>
+#include <string.h>
+#include <sys/socket.h>
 #include <unistd.h>
 
 #include "probes_demux.h"
 
 #define APP_NAME "sof-probes"
 
+static atomic_bool stop_capture;
+
 static void usage(void)
 {
 	fprintf(stdout, "Usage %s <option(s)> <buffer_id/file>\n\n", APP_NAME);
-	fprintf(stdout, "%s:\t -p file\tParse extracted file\n\n", APP_NAME);
+	fprintf(stdout, "%s:\t -p file\tParse extracted file or pipe\n\n", APP_NAME);
+	fprintf(stdout, "%s:\t -n host:port\tParse stream from TCP socket\n\n", APP_NAME);
+	fprintf(stdout, "%s:\t -q MiB\tData queued per buffer before reading blocks, default 4\n\n",
+		APP_NAME);
+	fprintf(stdout, "%s:\t -i ms\t\tWave header update interval, 0 for at end only, %s\n\n",
+		APP_NAME, "default 1000");
 	fprintf(stdout, "%s:\t -l \t\tLog to stdout\n\n", APP_NAME);
 	fprintf(stdout, "%s:\t -h \t\tHelp, usage info\n", APP_NAME);
 	exit(0);
 }
 
-void parse_data(const char *file_in, bool log_to_stdout)
+static void on_signal(int sig)
+{
+	stop_capture = 1;
+}
+
+static int open_socket(const char *address)
+{
+	struct addrinfo hints = { .ai_family = AF_UNSPEC, .ai_socktype = SOCK_STREAM };
+	struct addrinfo *res, *ai;
+	char host[256];
+	const char *port;
+	int fd = -1;
+	int ret;
+
+	port = strrchr(address, ':');
+	if (!port || port == address || port - address >= sizeof(host)) {
+		fprintf(stderr, "error: invalid address %s, expected host:port\n", address);
+		exit(0);
+	}
+	snprintf(host, sizeof(host), "%.*s", (int)(port - address), address);
+
+	ret = getaddrinfo(host, port + 1, &hints, &res);
+	if (ret) {
+		fprintf(stderr, "error: unable to resolve %s, %s\n", address, gai_strerror(ret));
+		exit(0);
+	}
+
+	for (ai = res; ai; ai = ai->ai_next) {
+		fd = socket(ai->ai_family, ai->ai_socktype, ai->ai_protocol);
+		if (fd < 0)
+			continue;
+		if (!connect(fd, ai->ai_addr, ai->ai_addrlen))
+			break;
+		close(fd);
+		fd = -1;
+	}
+	freeaddrinfo(res);
+
+	if (fd < 0) {
+		fprintf(stderr, "error: unable to connect to %s, error %d\n", address, errno);
+		exit(0);
+	}
+
+	return fd;
+}
+
+void parse_data(const char *file_in, const char *address, bool log_to_stdout,
+		size_t queue_limit, uint32_t header_interval)
 {
 	struct dma_frame_parser *p = parser_init();
-	FILE *fd_in;
+	struct sigaction sa = { .sa_handler = on_signal };
 	uint8_t *data;
 	size_t len;
-	int ret;
+	ssize_t ret;
+	int fd;
 
 	if (!p) {
 		fprintf(stderr, "parser_init() failed\n");
@@ -49,36 +115,66 @@ void parse_data(const char *file_in, bool log_to_stdout)
 
 	if (log_to_stdout)
 		parser_log_to_stdout(p);
+	parser_set_queue_limit(p, queue_limit);
+	parser_set_header_interval(p, header_interval);
 
-	if (file_in) {
-		fd_in = fopen(file_in, "rb");
-		if (!fd_in) {
+	if (address) {
+		fd = open_socket(address);
+	} else if (file_in) {
+		fd = open(file_in, O_RDONLY);
+		if (fd < 0) {
 			fprintf(stderr, "error: unable to open file %s, error %d\n",
 				file_in, errno);
 			exit(0);
 		}
 	} else {
-		fd_in = stdin;
+		fd = STDIN_FILENO;
 	}
 
-	do {
+	/* no SA_RESTART, so the signal interrupts a blocking read */
+	sigaction(SIGINT, &sa, NULL);
+	sigaction(SIGTERM, &sa, NULL);
+
+	/* read what is available, instead of waiting for a full buffer */
+	while (!stop_capture) {
 		parser_fetch_free_buffer(p, &data, &len);
-		len = fread(data, 1, len, fd_in);
-		ret = parser_parse_data(p, len);
-	} while (!ret && !feof(fd_in));
+		ret = read(fd, data, len);
+		if (ret < 0 && errno == EINTR)
+			continue;
+		if (ret < 0)
+			fprintf(stderr, "error: read failed, error %d\n", errno);
+		if (ret <= 0 || parser_parse_data(p, ret))
+			break;
+	}
+
+	if (fd != STDIN_FILENO)
+		close(fd);
+	parser_free(p);
 }
 
 int main(int argc, char *argv[])
 {
 	const char *fname = NULL;
+	const char *address = NULL;
 	bool log_to_stdout = false;
+	size_t queue_limit = 4;
+	uint32_t header_interval = 1000;
 	int opt;
 
-	while ((opt = getopt(argc, argv, "lhp:")) != -1) {
+	while ((opt = getopt(argc, argv, "lhp:n:q:i:")) != -1) {
 		switch (opt) {
 		case 'p':
 			fname = optarg;
 			break;
+		case 'n':
+			address = optarg;
+			break;
+		case 'q':
+			queue_limit = strtoul(optarg, NULL, 0);
+			break;
+		case 'i':
+			header_interval = strtoul(optarg, NULL, 0);
+			break;
 		case 'l':
 			log_to_stdout = true;
 			break;
@@ -88,7 +184,7 @@ int main(int argc, char *argv[])
 			return 0;
 		}
 	}
-	parse_data(fname, log_to_stdout);
+	parse_data(fname, address, log_to_stdout, queue_limit * 1024 * 1024, header_interval);
 
 	return 0;
 }
@@ -1,8 +1,10 @@
-% [ceps, t, n] = decode_ceps(fn, num_ceps)
+% [ceps, t, n] = decode_ceps(fn, num_ceps, channels, frame_shift)
 %
 % Input
 %   fn - File with MFCC data in .raw or .wav format
 %   num_ceps - number of cepstral coefficients per frame
+%   channels - number of channels in stream, default 1
+%   frame_shift - MFCC frame shift in samples, default 160
 %
 % Outputs
 %   ceps - cepstral coefficients
@@ -12,12 +14,16 @@
 % SPDX-License-Identifier: BSD-3-Clause
 % Copyright(c) 2022 Intel Corporation. All rights reserved.
 
-function [ceps, t, n] = decode_ceps(fn, num_ceps, channels)
+function [ceps, t, n] = decode_ceps(fn, num_ceps, channels, frame_shift)
 
 if nargin < 3
 	channels = 1;
 end
 
+if nargin < 4
+	frame_shift = 160;
+end
+
 % MFCC stream
 fs = 16e3;
 qformat = 7;
@@ -38,9 +44,10 @@ if isempty(idx)
 	error('No magic value markers found from stream');
 end
 
-period_ceps = idx(2)-idx(1);
+% A period can contain several cepstral coefficients sets, one per analysis
+% frame, so the time step is the frame shift.
 num_frames = length(idx);
-t_ceps = period_ceps / channels / fs;
+t_ceps = frame_shift / fs;
 t = (0:num_frames -1) * t_ceps;
 n = 1:num_ceps;
 
@@ -100,8 +100,6 @@
 #define IDC_MSG_AMS	IDC_TYPE(0xB)
 #define IDC_MSG_AMS_EXT	IDC_EXTENSION(0x0)
 
-#define IDC_HEADER_TO_AMS_SLOT_MASK(x)	(x & 0xFFFF)
-
 #define IDC_MSG_BIND IDC_TYPE(0xD)
 #define IDC_MSG_UNBIND IDC_TYPE(0xE)
 #define IDC_MSG_GET_ATTRIBUTE IDC_TYPE(0xF)
@@ -144,6 +142,9 @@
 /** \brief Max IDC message payload size in bytes. */
 #define IDC_MAX_PAYLOAD_SIZE	(DCACHE_LINE_SIZE * 2)
 
+/** \brief Max IDC messages in a batch. */
+#define IDC_BATCH_MAX		8
+
 /** \brief IDC free function flags */
 #define IDC_FREE_IRQ_ONLY	BIT(0)	/**< disable only irqs */
 
@@ -199,4 +200,40 @@ void idc_init_thread(void);
 
 struct idc **idc_get(void);
 
+/** \brief Batch of IDC messages, run in order by the target core. */
+struct idc_batch;
+
+/**
+ * \brief Gets the empty batch of a target core.
+ * \param[in] core Target core id.
+ * \return Pointer to the batch.
+ *
+ * There is one batch per target core and only the IPC thread uses them.
+ */
+struct idc_batch *idc_batch_init(uint32_t core);
+
+/**
+ * \brief Adds a message to a batch, the payload is copied.
+ * \param[in,out] batch The batch, not yet submitted.
+ * \param[in] msg Message, msg->core must be the core of the batch.
+ * \return 0 or the status of the messages run to make room.
+ *
+ * A full batch is first submitted and waited for.
+ */
+int idc_batch_add(struct idc_batch *batch, const struct idc_msg *msg);
+
+/**
+ * \brief Sends a batch to its core with a single IDC, does not wait.
+ * \param[in,out] batch The batch, with at least one message.
+ */
+void idc_batch_submit(struct idc_batch *batch);
+
+/**
+ * \brief Waits for a submitted batch to complete.
+ * \param[in,out] batch The submitted batch.
+ * \return 0 or the status of the first failed message, the messages
+ *	   after it in the batch are not run.
+ */
+int idc_batch_wait(struct idc_batch *batch);
+
 #endif /* __ZEPHYR_RTOS_IDC_H__ */
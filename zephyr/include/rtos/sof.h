@@ -76,6 +76,7 @@ struct sof {
 #ifdef CONFIG_AMS
 	/* asynchronous messaging service */
 	struct ams_shared_context *ams_shared_ctx;
+	struct ams_slot_pool *ams_slot_pool;
 #endif
 
 	/* shared notifier data */